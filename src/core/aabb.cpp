@@ -2,7 +2,7 @@
 
 namespace NH3D {
 
-[[nodiscard]] AABB AABB::fromMesh(const std::vector<VertexData>& vertices, const std::vector<uint16>& indices)
+[[nodiscard]] AABB AABB::fromMesh(const std::vector<VertexData>& vertices, const std::vector<uint32>& indices)
 {
     if (vertices.empty()) {
         return AABB { .min = vec3 { 0.0f }, .max = vec3 { 0.0f } };
@@ -25,4 +25,28 @@ namespace NH3D {
     return AABB { .min = pMin, .max = pMax };
 }
 
+[[nodiscard]] AABB AABB::transform(const mat4& transform) const
+{
+    AABB result { .min = vec3 { transform[3] }, .max = vec3 { transform[3] } };
+    for (uint32 column = 0; column < 3; ++column) {
+        const vec3 a = vec3 { transform[column] } * min[column];
+        const vec3 b = vec3 { transform[column] } * max[column];
+        result.min += NH3D::min(a, b);
+        result.max += NH3D::max(a, b);
+    }
+
+    return result;
+}
+
+[[nodiscard]] AABB AABB::merge(const AABB& other) const
+{
+    return AABB { .min = NH3D::min(min, other.min), .max = NH3D::max(max, other.max) };
+}
+
+[[nodiscard]] float AABB::getSurfaceArea() const
+{
+    const vec3 extent = max - min;
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
 } // namespace NH3D
\ No newline at end of file
@@ -11,7 +11,14 @@ struct AABB {
     vec3 min;
     vec3 max;
 
-    [[nodiscard]] static AABB fromMesh(const std::vector<VertexData>& vertices, const std::vector<uint16>& indices);
+    [[nodiscard]] static AABB fromMesh(const std::vector<VertexData>& vertices, const std::vector<uint32>& indices);
+
+    // Bounds of the transformed box, same decomposition as transformAABB in common.inc.glsl
+    [[nodiscard]] AABB transform(const mat4& transform) const;
+
+    [[nodiscard]] AABB merge(const AABB& other) const;
+
+    [[nodiscard]] float getSurfaceArea() const;
 };
 
 } // namespace NH3D
\ No newline at end of file
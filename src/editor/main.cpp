@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <general/engine.hpp>
 #include <general/resource_mapper.hpp>
 #include <general/window.hpp>
@@ -8,15 +11,24 @@
 #include <rendering/core/enums.hpp>
 #include <rendering/core/mesh.hpp>
 #include <rendering/core/rhi.hpp>
+#include <scene/ecs/components/light_component.hpp>
 #include <scene/ecs/components/render_component.hpp>
 #include <scene/ecs/components/transform_component.hpp>
 #include <scene/scene.hpp>
 
 using namespace NH3D;
 
-int main()
+int main(int argc, char** argv)
 {
-    Engine engine;
+    // e.g. --frames-in-flight 3, to compare the latency stats of each setting
+    uint32 framesInFlight = IRHI::DefaultFramesInFlight;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--frames-in-flight") == 0) {
+            framesInFlight = std::clamp(std::atoi(argv[i + 1]), 1, static_cast<int>(IRHI::MaxFramesInFlight));
+        }
+    }
+
+    Engine engine { framesInFlight };
 
     Scene& scene = engine.getMainScene();
     IRHI& rhi = engine.getRHI();
@@ -58,6 +70,21 @@ int main()
         }
     }
 
+    // Point lights between the cubes, a few thousands to stress the light clusters
+    const vec3 lightColors[] = { { 1.0f, 0.4f, 0.2f }, { 0.3f, 1.0f, 0.4f }, { 0.3f, 0.5f, 1.0f }, { 1.0f, 0.9f, 0.6f } };
+    for (int i = 0; i < 12; ++i) {
+        for (int j = 0; j < 12; ++j) {
+            for (int k = 0; k < 25; ++k) {
+                const LightComponent light {
+                    .color = lightColors[(i + j + k) % std::size(lightColors)],
+                    .intensity = 20.0f,
+                    .range = 12.0f,
+                };
+                scene.create(LightComponent { light }, TransformComponent { { 16.0f * i - 92.0f, 16.0f * j - 92.0f, 80.0f * k - 596.0f } });
+            }
+        }
+    }
+
     const Window& window = engine.getWindow();
 
     ImGuiIO& io = ImGui::GetIO();
@@ -157,6 +184,35 @@ int main()
         ImGui::Text("FPS: %.2f", lastFPS);
         ImGui::PlotLines("Overall Frame Time (ms)", frameTimes.data(), frameTimes.size(), (frameTimesIndex + 1) & (frameTimes.size() - 1),
             nullptr, 0.0f, 16.0f, ImVec2(0, 80));
+        ImGui::Checkbox("Parallel command recording", &rhi.getSettings().parallelCommandRecording);
+        ImGui::Text("Command recording: %.3f ms", rhi.getStats().commandRecordingTime);
+        ImGui::Text("Frames in flight: %u", rhi.getFramesInFlight());
+        ImGui::Checkbox("Low latency", &rhi.getSettings().lowLatency);
+        ImGui::Text("CPU wait: %.3f ms, GPU idle: %.3f ms, input latency: %.3f ms", rhi.getStats().cpuWaitTime, rhi.getStats().gpuIdleTime,
+            rhi.getStats().inputLatency);
+        const RenderThreadStats renderThreadStats = engine.getRenderThreadStats();
+        ImGui::Text("Render thread: %.3f ms busy, %.3f ms overlapped, %.3f ms idle", renderThreadStats.renderTime,
+            renderThreadStats.overlapTime, renderThreadStats.renderThreadIdleTime);
+        ImGui::Text(
+            "Main thread: %.3f ms extraction, %.3f ms wait", renderThreadStats.extractionTime, renderThreadStats.mainThreadWaitTime);
+        ImGui::Checkbox("Occlusion culling", &rhi.getSettings().occlusionCulling);
+        ImGui::Checkbox("BVH culling", &rhi.getSettings().bvhCulling);
+        ImGui::Checkbox("Material binning", &rhi.getSettings().materialBinning);
+        ImGui::Checkbox("Visibility buffer", &rhi.getSettings().visibilityBuffer);
+        ImGui::SliderFloat("LOD error (px)", &rhi.getSettings().lodErrorThreshold, 0.0f, 16.0f);
+        ImGui::Checkbox("Workgroup size tuning", &rhi.getSettings().workgroupTuning);
+        const RenderStats& stats = rhi.getStats();
+        ImGui::Text("Instances: %u early, %u late, %u meshes", stats.earlyDrawCount, stats.lateDrawCount, stats.meshCount);
+        ImGui::Text("Lights: %u", stats.lightCount);
+        ImGui::Text("Culled: %u BVH, %u frustum, %u occlusion", stats.bvhCulledCount, stats.frustumCulledCount, stats.occlusionCulledCount);
+        ImGui::Text("Meshlets: %u drawn, %u culled", stats.meshletDrawCount, stats.clusterCulledCount);
+        ImGui::Text("LODs: %u / %u / %u / %u / %u", stats.lodDrawCounts[0], stats.lodDrawCounts[1], stats.lodDrawCounts[2],
+            stats.lodDrawCounts[3], stats.lodDrawCounts[4]);
+        ImGui::Text("GBuffer: %llu VS invocations, %llu primitives", static_cast<unsigned long long>(stats.vertexShaderInvocations),
+            static_cast<unsigned long long>(stats.inputAssemblyPrimitives));
+        for (const PassTiming& passTiming : stats.passTimings) {
+            ImGui::Text("%s: %.3f ms", passTiming.name.c_str(), passTiming.time);
+        }
 
         ImGui::End();
         ImGui::Render();
@@ -6,11 +6,15 @@
 
 namespace NH3D {
 
-Engine::Engine()
+Engine::Engine(const uint32 framesInFlight)
     : _window {}
-    , _rhi { std::make_unique<VulkanRHI>(_window) }
+    , _rhi { std::make_unique<VulkanRHI>(_window, framesInFlight) }
     , _mainScene { *_rhi.get() }
     , _resourceMapper { std::make_unique<ResourceMapper>() }
+    , _renderThread { [this](RenderSnapshot& snapshot) {
+        _rhi->render(snapshot);
+        _rhi->waitForNextFrame();
+    } }
 {
 }
 
@@ -31,13 +35,22 @@ bool Engine::update()
     _deltaTime = deltaTime.count() / 1000.0;
 
     _lastFrameStartTime = std::chrono::high_resolution_clock::now();
-    if (!_window.pollEvents()) {
-        _rhi->render(_mainScene);
-        return true;
+
+    // The render thread may still be busy with the previous snapshot, only the one before it has to be done
+    RenderSnapshot& snapshot = _renderThread.acquireSnapshot();
+    _rhi->extract(_mainScene, snapshot);
+    _renderThread.submitSnapshot();
+
+    // Nothing overlaps in low latency mode, the input is sampled once the frame was handed to the GPU
+    if (_rhi->getSettings().lowLatency) {
+        _renderThread.waitForIdle();
     }
-    return false;
+
+    return !_window.pollEvents();
 }
 
 float Engine::deltaTime() const { return _deltaTime; }
 
+RenderThreadStats Engine::getRenderThreadStats() const { return _renderThread.getStats(); }
+
 } // namespace NH3D
\ No newline at end of file
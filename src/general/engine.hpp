@@ -1,5 +1,6 @@
 #pragma once
 
+#include <general/render_thread.hpp>
 #include <general/resource_mapper.hpp>
 #include <general/window.hpp>
 #include <misc/types.hpp>
@@ -12,7 +13,8 @@ namespace NH3D {
 class Engine {
     NH3D_NO_COPY_MOVE(Engine)
 public:
-    Engine();
+    // The frames in flight are fixed for the lifetime of the engine, see IRHI
+    explicit Engine(const uint32 framesInFlight = IRHI::DefaultFramesInFlight);
 
     ~Engine();
 
@@ -24,11 +26,14 @@ public:
 
     ResourceMapper& getResourceMapper();
 
+    // End of the tick: extracts the scene for the render thread, which renders it while the caller simulates the next tick
     [[nodiscard]] bool update();
 
     // In seconds, only valid after the first update() call
     [[nodiscard]] float deltaTime() const;
 
+    [[nodiscard]] RenderThreadStats getRenderThreadStats() const;
+
 private:
     Window _window;
 
@@ -38,6 +43,9 @@ private:
 
     Uptr<ResourceMapper> _resourceMapper;
 
+    // Declared after the RHI so that it is stopped before the RHI is destroyed
+    RenderThread _renderThread;
+
     std::chrono::time_point<std::chrono::high_resolution_clock> _lastFrameStartTime {};
 
     // in seconds
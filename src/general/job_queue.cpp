@@ -0,0 +1,76 @@
+#include "job_queue.hpp"
+#include <algorithm>
+
+namespace NH3D {
+
+JobQueue::JobQueue(const uint32 workerCount)
+{
+    const uint32 actualWorkerCount = std::max(workerCount, 1u);
+    _workers.reserve(actualWorkerCount);
+    for (uint32 i = 0; i < actualWorkerCount; ++i) {
+        _workers.emplace_back(&JobQueue::workerLoop, this);
+    }
+}
+
+JobQueue::~JobQueue()
+{
+    {
+        std::lock_guard lock { _mutex };
+        _stop = true;
+        _jobs.clear();
+    }
+    _jobAvailable.notify_all();
+
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+}
+
+void JobQueue::submit(Job job)
+{
+    {
+        std::lock_guard lock { _mutex };
+        _jobs.emplace_back(std::move(job));
+    }
+    _jobAvailable.notify_one();
+}
+
+[[nodiscard]] uint32 JobQueue::getPendingCount() const
+{
+    std::lock_guard lock { _mutex };
+    return static_cast<uint32>(_jobs.size()) + _runningCount;
+}
+
+void JobQueue::waitForIdle() const
+{
+    std::unique_lock lock { _mutex };
+    _idle.wait(lock, [this] { return _jobs.empty() && _runningCount == 0; });
+}
+
+void JobQueue::workerLoop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock lock { _mutex };
+            _jobAvailable.wait(lock, [this] { return _stop || !_jobs.empty(); });
+
+            if (_stop) {
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            ++_runningCount;
+        }
+
+        job();
+
+        {
+            std::lock_guard lock { _mutex };
+            --_runningCount;
+        }
+        _idle.notify_all();
+    }
+}
+
+}
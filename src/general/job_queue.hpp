@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NH3D {
+
+// Background workers running independent jobs, the submitting thread never takes part in the work or blocks on it
+// Unlike ThreadPool::parallelFor, jobs can be submitted at any time from any thread, meant for long running work such as
+// pipeline compilation. Jobs start in submission order but may complete in any order
+class JobQueue {
+    NH3D_NO_COPY_MOVE(JobQueue)
+public:
+    using Job = std::function<void()>;
+
+    JobQueue() = delete;
+
+    // At least one worker
+    JobQueue(const uint32 workerCount);
+
+    // The jobs that didn't start yet are dropped, the running ones complete
+    ~JobQueue();
+
+    [[nodiscard]] inline uint32 getWorkerCount() const { return static_cast<uint32>(_workers.size()); }
+
+    void submit(Job job);
+
+    // Queued or running
+    [[nodiscard]] uint32 getPendingCount() const;
+
+    // Blocks until every submitted job completed
+    void waitForIdle() const;
+
+private:
+    void workerLoop();
+
+private:
+    std::vector<std::thread> _workers;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _jobAvailable;
+    mutable std::condition_variable _idle;
+
+    std::deque<Job> _jobs;
+    uint32 _runningCount = 0;
+    bool _stop = false;
+};
+
+}
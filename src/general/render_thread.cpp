@@ -0,0 +1,106 @@
+#include "render_thread.hpp"
+#include <algorithm>
+
+namespace NH3D {
+
+RenderThread::RenderThread(RenderFunction render)
+    : _render { std::move(render) }
+    , _thread { &RenderThread::renderLoop, this }
+{
+}
+
+RenderThread::~RenderThread()
+{
+    // Bumping the counter wakes the render thread up, the stop flag is visible to it once it sees the new count
+    _stop.store(true, std::memory_order_relaxed);
+    _submittedCount.fetch_add(1, std::memory_order_release);
+    _submittedCount.notify_one();
+
+    _thread.join();
+}
+
+[[nodiscard]] RenderSnapshot& RenderThread::acquireSnapshot()
+{
+    const auto waitStartTime = Clock::now();
+
+    // Snapshot N reuses the buffer of snapshot N - 2, which is done once the render thread moved on to N - 1
+    const uint64 snapshotId = _submittedCount.load(std::memory_order_relaxed);
+    uint64 renderedCount = _renderedCount.load(std::memory_order_acquire);
+    while (renderedCount + 1 < snapshotId) {
+        _renderedCount.wait(renderedCount, std::memory_order_acquire);
+        renderedCount = _renderedCount.load(std::memory_order_acquire);
+    }
+
+    _mainThreadWaitTime = getElapsedTime(waitStartTime);
+    _acquireTime = Clock::now();
+    return _snapshots[snapshotId % _snapshots.size()];
+}
+
+void RenderThread::submitSnapshot()
+{
+    _extractionTime = getElapsedTime(_acquireTime);
+
+    _submittedCount.fetch_add(1, std::memory_order_release);
+    _submittedCount.notify_one();
+}
+
+void RenderThread::waitForIdle()
+{
+    const auto waitStartTime = Clock::now();
+
+    const uint64 submittedCount = _submittedCount.load(std::memory_order_relaxed);
+    uint64 renderedCount = _renderedCount.load(std::memory_order_acquire);
+    while (renderedCount < submittedCount) {
+        _renderedCount.wait(renderedCount, std::memory_order_acquire);
+        renderedCount = _renderedCount.load(std::memory_order_acquire);
+    }
+
+    _mainThreadWaitTime += getElapsedTime(waitStartTime);
+}
+
+[[nodiscard]] RenderThreadStats RenderThread::getStats() const
+{
+    const float renderTime = _renderTime.load(std::memory_order_relaxed);
+
+    // The main thread only waits while the render thread is busy, the rest of the render time ran alongside the simulation
+    return RenderThreadStats {
+        .extractionTime = _extractionTime,
+        .mainThreadWaitTime = _mainThreadWaitTime,
+        .renderTime = renderTime,
+        .renderThreadIdleTime = _idleTime.load(std::memory_order_relaxed),
+        .overlapTime = std::max(renderTime - _mainThreadWaitTime, 0.0f),
+    };
+}
+
+void RenderThread::renderLoop()
+{
+    uint64 snapshotId = 0;
+    while (true) {
+        const auto idleStartTime = Clock::now();
+        uint64 submittedCount = _submittedCount.load(std::memory_order_acquire);
+        while (submittedCount == snapshotId) {
+            _submittedCount.wait(submittedCount, std::memory_order_acquire);
+            submittedCount = _submittedCount.load(std::memory_order_acquire);
+        }
+
+        if (_stop.load(std::memory_order_relaxed)) {
+            return;
+        }
+        _idleTime.store(getElapsedTime(idleStartTime), std::memory_order_relaxed);
+
+        const auto renderStartTime = Clock::now();
+        _render(_snapshots[snapshotId % _snapshots.size()]);
+        _renderTime.store(getElapsedTime(renderStartTime), std::memory_order_relaxed);
+
+        _renderedCount.store(++snapshotId, std::memory_order_release);
+        _renderedCount.notify_one();
+    }
+}
+
+[[nodiscard]] float RenderThread::getElapsedTime(const Clock::time_point startTime)
+{
+    const std::chrono::duration<float, std::milli> elapsedTime = Clock::now() - startTime;
+    return elapsedTime.count();
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <rendering/core/render_snapshot.hpp>
+#include <thread>
+
+namespace NH3D {
+
+// In milliseconds, measured over the last tick
+struct RenderThreadStats {
+    float extractionTime = 0.0f; // main thread, between acquireSnapshot and submitSnapshot
+    float mainThreadWaitTime = 0.0f; // main thread blocked on the render thread
+    float renderTime = 0.0f; // render thread, last snapshot
+    float renderThreadIdleTime = 0.0f; // render thread waiting for a snapshot
+    float overlapTime = 0.0f; // part of the render time hidden behind the main thread
+};
+
+// Renders the snapshots extracted by the main thread on a thread of its own, so frame N is recorded and submitted while the main
+// thread simulates frame N + 1
+// Two snapshots: the main thread extracts into one while the render thread consumes the other. The handoff is a pair of atomic
+// counters, a side only blocks (atomic wait) when the other one is a whole snapshot behind
+class RenderThread {
+    NH3D_NO_COPY_MOVE(RenderThread)
+public:
+    using RenderFunction = std::function<void(RenderSnapshot& snapshot)>;
+
+    RenderThread() = delete;
+
+    RenderThread(RenderFunction render);
+
+    // The snapshots that weren't rendered yet are dropped
+    ~RenderThread();
+
+    // Main thread, waits until the render thread is done with the snapshot extracted two ticks ago
+    [[nodiscard]] RenderSnapshot& acquireSnapshot();
+
+    // Main thread, hands the snapshot returned by acquireSnapshot over to the render thread
+    void submitSnapshot();
+
+    // Main thread, waits until every submitted snapshot was rendered
+    void waitForIdle();
+
+    // Main thread
+    [[nodiscard]] RenderThreadStats getStats() const;
+
+private:
+    void renderLoop();
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    [[nodiscard]] static float getElapsedTime(const Clock::time_point startTime);
+
+private:
+    RenderFunction _render;
+
+    std::array<RenderSnapshot, 2> _snapshots;
+
+    std::atomic<uint64> _submittedCount = 0; // written by the main thread
+    std::atomic<uint64> _renderedCount = 0; // written by the render thread
+    std::atomic<bool> _stop = false;
+
+    // Main thread only
+    Clock::time_point _acquireTime {};
+    float _extractionTime = 0.0f;
+    float _mainThreadWaitTime = 0.0f;
+
+    // Written by the render thread
+    std::atomic<float> _renderTime = 0.0f;
+    std::atomic<float> _idleTime = 0.0f;
+
+    std::thread _thread; // started last
+};
+
+}
@@ -4,6 +4,8 @@
 #include <misc/types.hpp>
 #include <misc/utils.hpp>
 #include <nlohmann/json.hpp>
+#include <rendering/core/mesh_optimizer.hpp>
+#include <rendering/core/mesh_simplifier.hpp>
 #include <sys/types.h>
 #define TINYGLTF_NO_INCLUDE_JSON
 #define TINYGLTF_IMPLEMENTATION
@@ -13,169 +15,196 @@
 
 namespace NH3D {
 
-bool ResourceMapper::loadModel(IRHI& rhi, const std::filesystem::path& path, MeshData& meshData, const vec3u swizzle) const
+bool ResourceMapper::loadModel(
+    IRHI& rhi, const std::filesystem::path& path, MeshData& meshData, const vec3u swizzle, const bool quantizeVertices)
 {
-    static std::vector<VertexData> vertexData;
-    static std::vector<uint16> indices;
-
-    // TODO: remove that
-    static std::filesystem::path previousPath;
-    if (path == previousPath) {
-        goto naughtyshit;
+    // Models are identified by path, the swizzle and the quantization change the vertex data so they are part of the identity
+    const std::string meshName = path.string() + '#' + std::to_string(swizzle.x) + std::to_string(swizzle.y) + std::to_string(swizzle.z)
+        + (quantizeVertices ? "q" : "");
+    if (const auto it = _meshMap.find(meshName); it != _meshMap.end()) {
+        meshData.mesh = it->second;
+        // TODO: load texture
+        meshData.material = Material { .albedoTexture = InvalidHandle<Texture> };
+        return true;
     }
 
-    {
-        // TODO: remove that
-        previousPath = path;
-        NH3D_DEBUGLOG("TODO: remove that shit and properly cache");
+    std::vector<VertexData> vertexData;
+    std::vector<uint32> indices; // narrowed to 16 bit on upload when the vertices fit
 
-        tinygltf::TinyGLTF loader;
+    tinygltf::TinyGLTF loader;
 
-        tinygltf::Model model;
-        std::string error;
-        std::string warning;
+    tinygltf::Model model;
+    std::string error;
+    std::string warning;
 
-        bool result;
-        if (path.extension() == ".glb") {
-            result = loader.LoadBinaryFromFile(&model, &error, &warning, path.string());
-        } else {
-            result = loader.LoadASCIIFromFile(&model, &error, &warning, path.string());
-        }
+    bool result;
+    if (path.extension() == ".glb") {
+        result = loader.LoadBinaryFromFile(&model, &error, &warning, path.string());
+    } else {
+        result = loader.LoadASCIIFromFile(&model, &error, &warning, path.string());
+    }
 
-        if (!warning.empty()) {
-            NH3D_WARN("tinyGLTF import warning: " << warning);
-        }
+    if (!warning.empty()) {
+        NH3D_WARN("tinyGLTF import warning: " << warning);
+    }
 
-        if (!error.empty()) {
-            NH3D_ERROR("tinyGLTF import error: " << error);
-        }
+    if (!error.empty()) {
+        NH3D_ERROR("tinyGLTF import error: " << error);
+    }
 
-        if (!result) {
-            NH3D_ERROR("Failed to import GLB/GLTF file from " << path);
-            return false;
-        }
+    if (!result) {
+        NH3D_ERROR("Failed to import GLB/GLTF file from " << path);
+        return false;
+    }
 
-        const tinygltf::Scene& scene = model.scenes[model.defaultScene];
-        if (scene.nodes.size() != 1) {
-            NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": multi nodes not supported");
-            return false;
-        }
+    const tinygltf::Scene& scene = model.scenes[model.defaultScene];
+    if (scene.nodes.size() != 1) {
+        NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": multi nodes not supported");
+        return false;
+    }
 
-        const tinygltf::Node& node = model.nodes[scene.nodes[0]];
-        const tinygltf::Mesh& mesh = model.meshes[node.mesh];
-        if (mesh.primitives.size() != 1) {
-            NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": multi-meshes not supported");
-            return false;
-        }
+    const tinygltf::Node& node = model.nodes[scene.nodes[0]];
+    const tinygltf::Mesh& mesh = model.meshes[node.mesh];
+    if (mesh.primitives.size() != 1) {
+        NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": multi-meshes not supported");
+        return false;
+    }
 
-        tinygltf::Primitive primitive = mesh.primitives[0];
-        if (primitive.mode != TINYGLTF_MODE_TRIANGLES) {
-            NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": only triangle meshes are supported");
-            return false;
-        }
+    tinygltf::Primitive primitive = mesh.primitives[0];
+    if (primitive.mode != TINYGLTF_MODE_TRIANGLES) {
+        NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": only triangle meshes are supported");
+        return false;
+    }
 
-        if (primitive.attributes.find("POSITION") == primitive.attributes.end()
-            || primitive.attributes.find("NORMAL") == primitive.attributes.end()
-            || primitive.attributes.find("TEXCOORD_0") == primitive.attributes.end()) {
-            NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": mesh attributes missing");
-            return false;
-        }
+    if (primitive.attributes.find("POSITION") == primitive.attributes.end()
+        || primitive.attributes.find("NORMAL") == primitive.attributes.end()
+        || primitive.attributes.find("TEXCOORD_0") == primitive.attributes.end()) {
+        NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": mesh attributes missing");
+        return false;
+    }
 
-        if (primitive.indices < 0) {
-            NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": mesh indices missing");
-            return false;
-        }
+    if (primitive.indices < 0) {
+        NH3D_ERROR("Failed to import GLB/GLTF file from " << path << ": mesh indices missing");
+        return false;
+    }
 
-        const tinygltf::Accessor& positionAccessor = model.accessors[primitive.attributes["POSITION"]];
-        const uint32 vertexCount = static_cast<uint32>(positionAccessor.count);
-
-        const tinygltf::BufferView& positionView = model.bufferViews[positionAccessor.bufferView];
-        const float* positions = reinterpret_cast<const float*>(
-            &(model.buffers[positionView.buffer].data[positionAccessor.byteOffset + positionView.byteOffset]));
-        const uint32 positionByteStride = positionAccessor.ByteStride(positionView)
-            ? (positionAccessor.ByteStride(positionView) / sizeof(float))
-            : tinygltf::GetNumComponentsInType(TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3);
-
-        const tinygltf::Accessor& normalAccessor = model.accessors[primitive.attributes["NORMAL"]];
-        const tinygltf::BufferView& normalView = model.bufferViews[normalAccessor.bufferView];
-        const float* normals
-            = reinterpret_cast<const float*>(&(model.buffers[normalView.buffer].data[normalAccessor.byteOffset + normalView.byteOffset]));
-        const uint32 normalByteStride = normalAccessor.ByteStride(normalView)
-            ? (normalAccessor.ByteStride(normalView) / sizeof(float))
-            : tinygltf::GetNumComponentsInType(TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3);
-
-        const tinygltf::Accessor& uvAccessor = model.accessors[primitive.attributes["TEXCOORD_0"]];
-        const tinygltf::BufferView& uvView = model.bufferViews[uvAccessor.bufferView];
-        const float* uvs = reinterpret_cast<const float*>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
-        const uint32 uvByteStride = uvAccessor.ByteStride(uvView) ? (uvAccessor.ByteStride(uvView) / sizeof(float))
-                                                                  : tinygltf::GetNumComponentsInType(TINYGLTF_PARAMETER_TYPE_FLOAT_VEC2);
-
-        vertexData.resize(vertexCount);
-
-        for (size_t i = 0; i < vertexCount; ++i) {
-            VertexData vertex;
-            vertex.position[swizzle.x] = positions[i * positionByteStride + 0];
-            vertex.position[swizzle.y] = positions[i * positionByteStride + 1];
-            vertex.position[swizzle.z] = positions[i * positionByteStride + 2];
-            vertex.normal[swizzle.x] = normals[i * normalByteStride + 0];
-            vertex.normal[swizzle.y] = normals[i * normalByteStride + 1];
-            vertex.normal[swizzle.z] = normals[i * normalByteStride + 2];
-            vertex.uv.x = uvs[i * uvByteStride + 0];
-            vertex.uv.y = uvs[i * uvByteStride + 1];
-
-            vertexData[i] = vertex;
-        }
+    const tinygltf::Accessor& positionAccessor = model.accessors[primitive.attributes["POSITION"]];
+    const uint32 vertexCount = static_cast<uint32>(positionAccessor.count);
+
+    const tinygltf::BufferView& positionView = model.bufferViews[positionAccessor.bufferView];
+    const float* positions = reinterpret_cast<const float*>(
+        &(model.buffers[positionView.buffer].data[positionAccessor.byteOffset + positionView.byteOffset]));
+    const uint32 positionByteStride = positionAccessor.ByteStride(positionView)
+        ? (positionAccessor.ByteStride(positionView) / sizeof(float))
+        : tinygltf::GetNumComponentsInType(TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3);
+
+    const tinygltf::Accessor& normalAccessor = model.accessors[primitive.attributes["NORMAL"]];
+    const tinygltf::BufferView& normalView = model.bufferViews[normalAccessor.bufferView];
+    const float* normals
+        = reinterpret_cast<const float*>(&(model.buffers[normalView.buffer].data[normalAccessor.byteOffset + normalView.byteOffset]));
+    const uint32 normalByteStride = normalAccessor.ByteStride(normalView)
+        ? (normalAccessor.ByteStride(normalView) / sizeof(float))
+        : tinygltf::GetNumComponentsInType(TINYGLTF_PARAMETER_TYPE_FLOAT_VEC3);
+
+    const tinygltf::Accessor& uvAccessor = model.accessors[primitive.attributes["TEXCOORD_0"]];
+    const tinygltf::BufferView& uvView = model.bufferViews[uvAccessor.bufferView];
+    const float* uvs = reinterpret_cast<const float*>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
+    const uint32 uvByteStride = uvAccessor.ByteStride(uvView) ? (uvAccessor.ByteStride(uvView) / sizeof(float))
+                                                              : tinygltf::GetNumComponentsInType(TINYGLTF_PARAMETER_TYPE_FLOAT_VEC2);
+
+    vertexData.resize(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        VertexData vertex;
+        vertex.position[swizzle.x] = positions[i * positionByteStride + 0];
+        vertex.position[swizzle.y] = positions[i * positionByteStride + 1];
+        vertex.position[swizzle.z] = positions[i * positionByteStride + 2];
+        vertex.normal[swizzle.x] = normals[i * normalByteStride + 0];
+        vertex.normal[swizzle.y] = normals[i * normalByteStride + 1];
+        vertex.normal[swizzle.z] = normals[i * normalByteStride + 2];
+        vertex.uv.x = uvs[i * uvByteStride + 0];
+        vertex.uv.y = uvs[i * uvByteStride + 1];
+
+        vertexData[i] = vertex;
+    }
+
+    const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
+    const tinygltf::BufferView& indexView = model.bufferViews[indexAccessor.bufferView];
+    const void* indexData = &(model.buffers[indexView.buffer].data[indexAccessor.byteOffset + indexView.byteOffset]);
 
-        const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
-        const tinygltf::BufferView& indexView = model.bufferViews[indexAccessor.bufferView];
-        const void* indexData = &(model.buffers[indexView.buffer].data[indexAccessor.byteOffset + indexView.byteOffset]);
-
-        indices.resize(indexAccessor.count);
-
-        // TODO: support returning more index types
-        switch (indexAccessor.componentType) {
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
-            const uint32* buffer = static_cast<const uint32*>(indexData);
-            for (size_t i = 0; i < indexAccessor.count; i++) {
-                NH3D_ASSERT(buffer[i] <= NH3D_MAX_T(uint16), "Index value exceeds uint16 max value");
-                indices[i] = buffer[i];
-            }
-            break;
+    indices.resize(indexAccessor.count);
+
+    switch (indexAccessor.componentType) {
+    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
+        const uint32* buffer = static_cast<const uint32*>(indexData);
+        memcpy(indices.data(), buffer, indexAccessor.count * sizeof(uint32)); // Can memcpy because both are uint32
+        break;
+    }
+    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
+        const uint16* buffer = static_cast<const uint16*>(indexData);
+        for (size_t i = 0; i < indexAccessor.count; i++) {
+            indices[i] = buffer[i];
         }
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
-            const uint16* buffer = static_cast<const uint16*>(indexData);
-            memcpy(indices.data(), buffer, indexAccessor.count * sizeof(uint16)); // Can memcpy because both are uint16
-            break;
+        break;
+    }
+    case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
+        const uint8* buffer = static_cast<const uint8*>(indexData);
+        for (size_t i = 0; i < indexAccessor.count; i++) {
+            indices[i] = buffer[i];
         }
-        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
-            const uint8* buffer = static_cast<const uint8*>(indexData);
-            for (size_t i = 0; i < indexAccessor.count; i++) {
-                indices[i] = buffer[i];
-            }
-            break;
+        break;
+    }
+    default:
+        NH3D_ABORT("Unsupported index component type in gltf mesh");
+        return false;
+    }
+
+    // Authoring order is usually bad for the post-transform cache, the meshlets built below also depend on the locality
+#if NH3D_DEBUG
+    // Simulates the cache over every index, only worth it for the debug log
+    const VertexCacheStatistics sourceStatistics = MeshOptimizer::analyzeVertexCache(indices, vertexCount);
+#endif
+    indices = MeshOptimizer::optimizeVertexCache(indices, vertexCount);
+    indices = MeshOptimizer::optimizeOverdraw(vertexData, indices);
+    MeshOptimizer::optimizeVertexFetch(vertexData, indices);
+#if NH3D_DEBUG
+    const VertexCacheStatistics optimizedStatistics = MeshOptimizer::analyzeVertexCache(indices, vertexData.size());
+    NH3D_DEBUGLOG("Optimized " << path << ": ACMR " << sourceStatistics.acmr << " -> " << optimizedStatistics.acmr << ", ATVR "
+                               << sourceStatistics.atvr << " -> " << optimizedStatistics.atvr);
+#endif
+
+    // The simplified LODs index the same vertices, each one gets its own meshlets
+    std::vector<MeshLOD> lodChain = MeshSimplifier::buildLODChain(vertexData, indices, Geometry::MaxLODs);
+    std::vector<std::vector<Meshlet>> lodMeshlets;
+    lodMeshlets.reserve(lodChain.size());
+    std::vector<Geometry::LOD> lods;
+    lods.reserve(lodChain.size() - 1);
+    for (MeshLOD& lod : lodChain) {
+        // Edge collapses break the triangle order of the LODs
+        if (!lodMeshlets.empty()) {
+            lod.indices = MeshOptimizer::optimizeVertexCache(lod.indices, vertexData.size());
         }
-        default:
-            NH3D_ABORT("Unsupported index component type in gltf mesh");
-            return false;
+        lodMeshlets.emplace_back(Meshlet::build(vertexData, lod.indices));
+        if (lodMeshlets.size() > 1) {
+            lods.emplace_back(Geometry::LOD { .indices = lod.indices, .meshlets = lodMeshlets.back(), .error = lod.error });
         }
     }
 
-naughtyshit:
     meshData.mesh = Mesh {
-        .vertexBuffer = rhi.createBuffer({ .size = static_cast<uint32>(vertexData.size() * sizeof(VertexData)),
-            .usageFlags = BufferUsageFlagBits::STORAGE_BUFFER_BIT | BufferUsageFlagBits::DST_TRANSFER_BIT,
-            .memoryUsage = BufferMemoryUsage::GPU_ONLY,
-            .initialData
-            = { reinterpret_cast<const byte*>(vertexData.data()), static_cast<uint32>(vertexData.size() * sizeof(VertexData)) } }),
-        .indexBuffer = rhi.createBuffer({ .size = static_cast<uint32>(indices.size() * sizeof(uint16)),
-            .usageFlags = BufferUsageFlagBits::INDEX_BUFFER_BIT | BufferUsageFlagBits::DST_TRANSFER_BIT,
-            .memoryUsage = BufferMemoryUsage::GPU_ONLY,
-            .initialData = { reinterpret_cast<const byte*>(indices.data()), static_cast<uint32>(indices.size() * sizeof(uint16)) } }),
+        .geometry = rhi.createGeometry({
+            .vertices = vertexData,
+            .indices = indices,
+            .meshlets = lodMeshlets[0],
+            .lods = lods,
+            .vertexFormat = quantizeVertices ? Geometry::VertexFormat::Quantized : Geometry::VertexFormat::Full,
+        }),
         .objectAABB = AABB::fromMesh(vertexData, indices),
     };
     // TODO: load texture
     meshData.material = Material { .albedoTexture = InvalidHandle<Texture> };
 
+    storeMesh(meshName, meshData.mesh);
+
     return true;
 }
 
@@ -185,10 +214,7 @@ Mesh ResourceMapper::getMesh(const std::string& name) const
 {
     auto it = _meshMap.find(name);
     if (it == _meshMap.end()) {
-        return Mesh {
-            .vertexBuffer = InvalidHandle<Buffer>,
-            .indexBuffer = InvalidHandle<Buffer>,
-        };
+        return Mesh { .geometry = InvalidHandle<Geometry> };
     }
     return it->second;
 }
@@ -25,9 +25,12 @@ public:
     ResourceMapper() = default;
     ~ResourceMapper() = default;
 
-    // TODO: support multiple index types
+    // Loading the same model again returns the mesh of the first load, the GPU buffers are shared
+    // Quantized vertices take half the memory for a precision of 1/65535 of the extent of the mesh, see QuantizedVertexData
+    // Opt-in, the precision loss shows on large meshes
     [[nodiscard]]
-    bool loadModel(IRHI& rhi, const std::filesystem::path& path, MeshData& meshData, const vec3u swizzle = { 0, 2, 1 }) const;
+    bool loadModel(IRHI& rhi, const std::filesystem::path& path, MeshData& meshData, const vec3u swizzle = { 0, 2, 1 },
+        const bool quantizeVertices = false);
 
     void storeMesh(const std::string& name, const Mesh& mesh);
     [[nodiscard]] Mesh getMesh(const std::string& name) const;
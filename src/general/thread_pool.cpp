@@ -0,0 +1,107 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace NH3D {
+
+ThreadPool::ThreadPool(const uint32 workerCount)
+{
+    _workers.reserve(workerCount);
+    for (uint32 i = 0; i < workerCount; ++i) {
+        _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock { _mutex };
+        _stop = true;
+    }
+    _workAvailable.notify_all();
+
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(const uint32 taskCount, const Job& job)
+{
+    if (taskCount == 0) {
+        return;
+    }
+
+    // Not worth waking anybody up
+    if (taskCount == 1 || _workers.empty()) {
+        for (uint32 i = 0; i < taskCount; ++i) {
+            job(i, getWorkerCount());
+        }
+        return;
+    }
+
+    {
+        std::lock_guard lock { _mutex };
+        NH3D_ASSERT(_job == nullptr, "ThreadPool::parallelFor is not reentrant");
+
+        _job = &job;
+        _taskCount = taskCount;
+        _nextTask.store(0, std::memory_order_relaxed);
+        _completedTasks = 0;
+        _activeWorkers = getWorkerCount();
+        ++_generation;
+    }
+    _workAvailable.notify_all();
+
+    runTasks(getWorkerCount());
+
+    // Waiting for the workers to leave the generation as well, so job can't be referenced after returning
+    std::unique_lock lock { _mutex };
+    _workDone.wait(lock, [this] { return _completedTasks == _taskCount && _activeWorkers == 0; });
+    _job = nullptr;
+}
+
+[[nodiscard]] uint32 ThreadPool::getDefaultWorkerCount()
+{
+    const uint32 hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void ThreadPool::workerLoop(const uint32 threadId)
+{
+    uint64 lastGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock lock { _mutex };
+            _workAvailable.wait(lock, [this, lastGeneration] { return _stop || _generation != lastGeneration; });
+
+            if (_stop) {
+                return;
+            }
+            lastGeneration = _generation;
+        }
+
+        runTasks(threadId);
+
+        {
+            std::lock_guard lock { _mutex };
+            --_activeWorkers;
+        }
+        _workDone.notify_one();
+    }
+}
+
+void ThreadPool::runTasks(const uint32 threadId)
+{
+    uint32 completedTasks = 0;
+    for (uint32 taskId = _nextTask.fetch_add(1, std::memory_order_relaxed); taskId < _taskCount;
+        taskId = _nextTask.fetch_add(1, std::memory_order_relaxed)) {
+        (*_job)(taskId, threadId);
+        ++completedTasks;
+    }
+
+    if (completedTasks > 0) {
+        std::lock_guard lock { _mutex };
+        _completedTasks += completedTasks;
+    }
+}
+
+}
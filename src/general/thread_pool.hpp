@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NH3D {
+
+// Fixed set of workers running one parallelFor at a time, the calling thread takes part in the work
+// Thread ids are stable for the lifetime of the pool: [0, getWorkerCount()) for workers, getWorkerCount() for the calling thread,
+// which makes it easy to index per-thread resources (command pools, scratch buffers...)
+class ThreadPool {
+    NH3D_NO_COPY_MOVE(ThreadPool)
+public:
+    using Job = std::function<void(const uint32 taskId, const uint32 threadId)>;
+
+    ThreadPool() = delete;
+
+    ThreadPool(const uint32 workerCount);
+
+    ~ThreadPool();
+
+    [[nodiscard]] inline uint32 getWorkerCount() const { return static_cast<uint32>(_workers.size()); }
+
+    // Workers + calling thread
+    [[nodiscard]] inline uint32 getThreadCount() const { return getWorkerCount() + 1; }
+
+    // Runs job for every task in [0, taskCount), blocks until all of them completed, not reentrant
+    void parallelFor(const uint32 taskCount, const Job& job);
+
+    // Leaves one hardware thread for the calling thread
+    [[nodiscard]] static uint32 getDefaultWorkerCount();
+
+private:
+    void workerLoop(const uint32 threadId);
+
+    void runTasks(const uint32 threadId);
+
+private:
+    std::vector<std::thread> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _workAvailable;
+    std::condition_variable _workDone;
+
+    const Job* _job = nullptr;
+    uint32 _taskCount = 0;
+    std::atomic<uint32> _nextTask = 0;
+    uint32 _completedTasks = 0; // protected by _mutex
+    uint64 _generation = 0; // bumped on every parallelFor to wake up the workers
+    uint32 _activeWorkers = 0; // workers that haven't left the current generation yet
+    bool _stop = false;
+};
+
+}
@@ -0,0 +1,221 @@
+#include "bvh.hpp"
+#include <algorithm>
+#include <array>
+#include <misc/math.hpp>
+
+namespace NH3D {
+
+namespace {
+
+    // Relative to the cost of testing an item
+    constexpr float TraversalCost = 1.0f;
+
+    const AABB EmptyAABB { .min = vec3 { NH3D_MAX_T(float) }, .max = vec3 { -NH3D_MAX_T(float) } };
+
+    struct Bin {
+        AABB bounds = EmptyAABB;
+        uint32 count = 0;
+    };
+
+    [[nodiscard]] vec3 getCentroid(const AABB& bounds) { return 0.5f * (bounds.min + bounds.max); }
+
+}
+
+void BVH::build(const ArrayWrapper<uint32> ids, const ArrayWrapper<AABB> bounds)
+{
+    NH3D_ASSERT(ids.size == bounds.size, "One AABB per BVH item expected");
+
+    _items.assign(ids.data, ids.data + ids.size);
+    for (uint32 i = 0; i < ids.size; ++i) {
+        if (ids[i] >= _bounds.size()) {
+            _bounds.resize(ids[i] + 1, EmptyAABB);
+        }
+        _bounds[ids[i]] = bounds[i];
+    }
+
+    _nodes.clear();
+    _refitNeeded = false;
+    if (_items.empty()) {
+        _buildCost = 0.0f;
+        return;
+    }
+
+    // The children are appended after their parent, so this also visits them
+    _nodes.reserve(2 * (_items.size() / MaxLeafSize + 1));
+    const uint32 itemCount = _items.size();
+    _nodes.emplace_back(Node { .bounds = computeBounds(0, itemCount), .firstItem = 0, .itemCount = itemCount, .firstChild = 0 });
+    for (uint32 nodeIndex = 0; nodeIndex < _nodes.size(); ++nodeIndex) {
+        split(nodeIndex);
+    }
+
+    _buildCost = getCost();
+}
+
+void BVH::setBounds(const uint32 id, const AABB& bounds)
+{
+    NH3D_ASSERT(id < _bounds.size(), "Unknown BVH item");
+
+    _bounds[id] = bounds;
+    _refitNeeded = true;
+}
+
+void BVH::refit()
+{
+    if (!_refitNeeded) {
+        return;
+    }
+
+    for (uint32 i = _nodes.size(); i-- > 0;) {
+        Node& node = _nodes[i];
+        node.bounds = node.firstChild == 0 ? computeBounds(node.firstItem, node.itemCount)
+                                           : _nodes[node.firstChild].bounds.merge(_nodes[node.firstChild + 1].bounds);
+    }
+    _refitNeeded = false;
+}
+
+void BVH::cull(const mat4& viewMatrix, const FrustumPlanes& frustum, std::vector<uint32>& ids) const
+{
+    if (_nodes.empty()) {
+        return;
+    }
+
+    std::vector<uint32> stack { 0 };
+    while (!stack.empty()) {
+        const Node& node = _nodes[stack.back()];
+        stack.pop_back();
+
+        const FrustumPlanes::Intersection intersection = frustum.intersect(node.bounds.transform(viewMatrix));
+        if (intersection == FrustumPlanes::Intersection::Outside) {
+            continue;
+        }
+
+        if (intersection == FrustumPlanes::Intersection::Inside || node.firstChild == 0) {
+            ids.insert(ids.end(), _items.begin() + node.firstItem, _items.begin() + node.firstItem + node.itemCount);
+        } else {
+            stack.emplace_back(node.firstChild);
+            stack.emplace_back(node.firstChild + 1);
+        }
+    }
+}
+
+[[nodiscard]] float BVH::getCost() const
+{
+    if (_nodes.empty()) {
+        return 0.0f;
+    }
+
+    float cost = 0.0f;
+    for (const Node& node : _nodes) {
+        cost += node.bounds.getSurfaceArea() * (node.firstChild == 0 ? node.itemCount : TraversalCost);
+    }
+
+    const float rootArea = _nodes[0].bounds.getSurfaceArea();
+    return rootArea > 0.0f ? cost / rootArea : 0.0f;
+}
+
+void BVH::split(const uint32 nodeIndex)
+{
+    const Node node = _nodes[nodeIndex]; // the vector grows below
+    if (node.itemCount <= 1) {
+        return;
+    }
+
+    vec3 centroidMin { NH3D_MAX_T(float) };
+    vec3 centroidMax { -NH3D_MAX_T(float) };
+    for (uint32 i = node.firstItem; i < node.firstItem + node.itemCount; ++i) {
+        const vec3 centroid = getCentroid(_bounds[_items[i]]);
+        centroidMin = min(centroidMin, centroid);
+        centroidMax = max(centroidMax, centroid);
+    }
+    const vec3 centroidExtent = centroidMax - centroidMin;
+
+    const auto getBin = [&](const uint32 id, const uint32 axis) {
+        const float offset = (getCentroid(_bounds[id])[axis] - centroidMin[axis]) / centroidExtent[axis];
+        return std::min(static_cast<uint32>(offset * BinCount), BinCount - 1);
+    };
+
+    // Cost of every split plane between two bins of every axis
+    float bestCost = NH3D_MAX_T(float);
+    uint32 bestAxis = 3;
+    uint32 bestSplit = 0; // last bin of the left child
+    for (uint32 axis = 0; axis < 3; ++axis) {
+        if (centroidExtent[axis] <= 0.0f) {
+            continue;
+        }
+
+        std::array<Bin, BinCount> bins;
+        for (uint32 i = node.firstItem; i < node.firstItem + node.itemCount; ++i) {
+            Bin& bin = bins[getBin(_items[i], axis)];
+            bin.bounds = bin.bounds.merge(_bounds[_items[i]]);
+            ++bin.count;
+        }
+
+        // Right to left sweep first, then the left to right one evaluates the planes
+        std::array<float, BinCount> rightCosts;
+        AABB rightBounds = EmptyAABB;
+        uint32 rightCount = 0;
+        for (uint32 bin = BinCount; bin-- > 1;) {
+            rightBounds = rightBounds.merge(bins[bin].bounds);
+            rightCount += bins[bin].count;
+            rightCosts[bin] = rightCount > 0 ? rightBounds.getSurfaceArea() * rightCount : 0.0f;
+        }
+
+        AABB leftBounds = EmptyAABB;
+        uint32 leftCount = 0;
+        const float nodeArea = node.bounds.getSurfaceArea();
+        for (uint32 bin = 0; bin + 1 < BinCount; ++bin) {
+            leftBounds = leftBounds.merge(bins[bin].bounds);
+            leftCount += bins[bin].count;
+            if (leftCount == 0 || leftCount == node.itemCount) {
+                continue;
+            }
+
+            const float leftCost = leftBounds.getSurfaceArea() * leftCount;
+            const float cost = nodeArea > 0.0f ? TraversalCost + (leftCost + rightCosts[bin + 1]) / nodeArea : TraversalCost;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = bin;
+            }
+        }
+    }
+
+    // Testing the items is cheaper than another level
+    if (node.itemCount <= MaxLeafSize && bestCost >= node.itemCount) {
+        return;
+    }
+
+    // No split plane if all the centroids are the same, the leaves are still kept small
+    uint32 leftCount = node.itemCount / 2;
+    if (bestAxis < 3) {
+        const auto first = _items.begin() + node.firstItem;
+        const auto last = first + node.itemCount;
+        leftCount = std::partition(first, last, [&](const uint32 id) { return getBin(id, bestAxis) <= bestSplit; }) - first;
+    }
+
+    const uint32 firstChild = _nodes.size();
+    _nodes[nodeIndex].firstChild = firstChild;
+    _nodes.emplace_back(Node {
+        .bounds = computeBounds(node.firstItem, leftCount),
+        .firstItem = node.firstItem,
+        .itemCount = leftCount,
+        .firstChild = 0,
+    });
+    _nodes.emplace_back(Node {
+        .bounds = computeBounds(node.firstItem + leftCount, node.itemCount - leftCount),
+        .firstItem = node.firstItem + leftCount,
+        .itemCount = node.itemCount - leftCount,
+        .firstChild = 0,
+    });
+}
+
+[[nodiscard]] AABB BVH::computeBounds(const uint32 firstItem, const uint32 itemCount) const
+{
+    AABB bounds = EmptyAABB;
+    for (uint32 i = firstItem; i < firstItem + itemCount; ++i) {
+        bounds = bounds.merge(_bounds[_items[i]]);
+    }
+    return bounds;
+}
+
+}
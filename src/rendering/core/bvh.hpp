@@ -0,0 +1,65 @@
+#pragma once
+
+#include <core/aabb.hpp>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <rendering/core/frustum_culler.hpp>
+#include <vector>
+
+namespace NH3D {
+
+// Bounding volume hierarchy over world space AABBs identified by an id (GPU scene slots), built top-down with binned SAH
+// Every node covers a contiguous range of the item array, so a subtree fully inside the frustum is accepted in one go
+// Moving items only refits the bounds, the tree quality degrades with the movement until the next build
+class BVH {
+public:
+    static constexpr uint32 BinCount = 16;
+    static constexpr uint32 MaxLeafSize = 16;
+
+    // Flat array, the children of a node are stored next to each other after their parent
+    struct Node {
+        AABB bounds;
+        uint32 firstItem;
+        uint32 itemCount; // whole subtree
+        uint32 firstChild; // 0 for leaves, the root is nobody's child
+    };
+
+    BVH() = default;
+
+    // ids and bounds are parallel arrays
+    void build(const ArrayWrapper<uint32> ids, const ArrayWrapper<AABB> bounds);
+
+    // The nodes are only updated by the next refit
+    void setBounds(const uint32 id, const AABB& bounds);
+
+    // Bottom-up pass over the whole tree, does nothing if no bounds changed since the last build or refit
+    void refit();
+
+    // Appends the ids of the items of the leaves that may intersect the frustum, the items still need their own test
+    void cull(const mat4& viewMatrix, const FrustumPlanes& frustum, std::vector<uint32>& ids) const;
+
+    // Expected cost of a random ray relative to the cost of the root box, compared to the cost after the last build to know
+    // when refitting degraded the tree enough to rebuild it
+    [[nodiscard]] float getCost() const;
+
+    [[nodiscard]] inline float getBuildCost() const { return _buildCost; }
+
+    [[nodiscard]] inline uint32 getItemCount() const { return _items.size(); }
+
+    [[nodiscard]] inline const std::vector<Node>& getNodes() const { return _nodes; }
+
+private:
+    // Splits the node in two if the SAH says it's worth it
+    void split(const uint32 nodeIndex);
+
+    [[nodiscard]] AABB computeBounds(const uint32 firstItem, const uint32 itemCount) const;
+
+private:
+    std::vector<Node> _nodes;
+    std::vector<uint32> _items; // ids, in leaf order
+    std::vector<AABB> _bounds; // indexed by id
+    bool _refitNeeded = false;
+    float _buildCost = 0.0f;
+};
+
+}
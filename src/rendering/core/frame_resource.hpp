@@ -1,8 +1,9 @@
 #pragma once
 
-#include <array>
+#include <algorithm>
 #include <rendering/core/handle.hpp>
 #include <rendering/core/rhi.hpp>
+#include <vector>
 
 namespace NH3D {
 
@@ -14,17 +15,24 @@ template <template <class> class U, class V> inline constexpr bool is_instance_o
 template <typename T>
 concept ResourceType = std::is_same_v<T, std::remove_cvref_t<T>>;
 
-// Helper to store per-frame resources
+// Helper to store per-frame resources, one per frame in flight of the RHI (see IRHI::getFramesInFlight)
 template <ResourceType T> struct FrameResource {
-    std::array<T, IRHI::MaxFramesInFlight> resources = {};
+    std::vector<T> resources;
 
-    FrameResource()
+    // Empty, for the resources assigned later on (resource manager slots...)
+    FrameResource() = default;
+
+    explicit FrameResource(const uint32 framesInFlight)
+        : resources(framesInFlight)
     {
+        NH3D_ASSERT(framesInFlight >= 1 && framesInFlight <= IRHI::MaxFramesInFlight, "Unsupported frames in flight count");
         if constexpr (is_instance_of_v<T, Handle>) {
-            resources.fill(InvalidHandle<typename T::ResourceType>);
+            std::fill(resources.begin(), resources.end(), InvalidHandle<typename T::ResourceType>);
         }
     }
 
+    [[nodiscard]] inline uint32 size() const { return static_cast<uint32>(resources.size()); }
+
     T& operator[](const uint32_t frameInFlightId) { return resources[frameInFlightId]; }
 
     const T& operator[](const uint32_t frameInFlightId) const { return resources[frameInFlightId]; }
@@ -0,0 +1,239 @@
+#include "frustum_culler.hpp"
+#include <algorithm>
+#include <general/thread_pool.hpp>
+#include <immintrin.h>
+
+namespace NH3D {
+
+[[nodiscard]] FrustumPlanes FrustumPlanes::fromProjection(const mat4& projectionMatrix)
+{
+    FrustumPlanes frustumPlanes;
+
+    // Dropping the Y component for left and right planes as it is zero, and the X component for top and bottom planes as it is zero
+
+    frustumPlanes.left = vec2 {
+        projectionMatrix[0][3] + projectionMatrix[0][0],
+        // projectionMatrix[1][3] + projectionMatrix[1][0],
+        projectionMatrix[2][3] + projectionMatrix[2][0],
+    };
+
+    frustumPlanes.right = vec2 {
+        projectionMatrix[0][3] - projectionMatrix[0][0],
+        // projectionMatrix[1][3] - projectionMatrix[1][0],
+        projectionMatrix[2][3] - projectionMatrix[2][0],
+    };
+
+    frustumPlanes.top = vec2 {
+        // projectionMatrix[0][3] - projectionMatrix[0][1],
+        projectionMatrix[1][3] + projectionMatrix[1][1], // sign flipped due to Vulkan NDC
+        projectionMatrix[2][3] - projectionMatrix[2][1],
+    };
+
+    frustumPlanes.bottom = vec2 {
+        // projectionMatrix[0][3] + projectionMatrix[0][1],
+        projectionMatrix[1][3] - projectionMatrix[1][1], // sign flipped due to Vulkan NDC
+        projectionMatrix[2][3] + projectionMatrix[2][1],
+    };
+
+    return frustumPlanes;
+}
+
+[[nodiscard]] FrustumPlanes::Intersection FrustumPlanes::intersect(const AABB& viewAABB) const
+{
+    // Farthest and nearest corners along the plane normal, for the planes of fromProjection they are the corners used by inFrustum
+    const auto farthest = [](const float min, const float max, const float z, const vec2& plane) {
+        return (plane.x > 0.0f ? max : min) * plane.x + z * plane.y;
+    };
+    const auto nearest = [](const float min, const float max, const float z, const vec2& plane) {
+        return (plane.x > 0.0f ? min : max) * plane.x + z * plane.y;
+    };
+
+    const vec3& min = viewAABB.min;
+    const vec3& max = viewAABB.max;
+    if (max.z < 0.0f || farthest(min.x, max.x, max.z, left) < 0.0f || farthest(min.x, max.x, max.z, right) < 0.0f
+        || farthest(min.y, max.y, max.z, bottom) < 0.0f || farthest(min.y, max.y, max.z, top) < 0.0f) {
+        return Intersection::Outside;
+    }
+
+    if (min.z >= 0.0f && nearest(min.x, max.x, min.z, left) >= 0.0f && nearest(min.x, max.x, min.z, right) >= 0.0f
+        && nearest(min.y, max.y, min.z, bottom) >= 0.0f && nearest(min.y, max.y, min.z, top) >= 0.0f) {
+        return Intersection::Inside;
+    }
+
+    return Intersection::Intersecting;
+}
+
+void FrustumCuller::resize(const uint32 objectCount)
+{
+    _objectCount = objectCount;
+
+    const uint32 paddedCount = getWordCount() * WordSize;
+    for (std::vector<float>& elements : _transforms) {
+        elements.resize(paddedCount, 0.0f);
+    }
+    for (uint32 i = 0; i < 3; ++i) {
+        _aabbMins[i].resize(paddedCount, 0.0f);
+        _aabbMaxs[i].resize(paddedCount, 0.0f);
+    }
+}
+
+void FrustumCuller::setObject(const uint32 index, const mat4& objectToWorld, const AABB& objectAABB)
+{
+    NH3D_ASSERT(index < _objectCount, "Out of bound FrustumCuller object");
+
+    for (uint32 column = 0; column < 4; ++column) {
+        for (uint32 row = 0; row < 3; ++row) {
+            _transforms[3 * column + row][index] = objectToWorld[column][row];
+        }
+    }
+    for (uint32 i = 0; i < 3; ++i) {
+        _aabbMins[i][index] = objectAABB.min[i];
+        _aabbMaxs[i][index] = objectAABB.max[i];
+    }
+}
+
+void FrustumCuller::cull(const mat4& viewMatrix, const FrustumPlanes& frustum, DynamicBitset& visibility) const
+{
+    visibility.reserve(getWordCount() * WordSize);
+    cullWords(viewMatrix, frustum, 0, getWordCount(), visibility);
+}
+
+void FrustumCuller::cull(ThreadPool& threadPool, const mat4& viewMatrix, const FrustumPlanes& frustum, DynamicBitset& visibility) const
+{
+    // Growing the bitset from the workers would be a race
+    visibility.reserve(getWordCount() * WordSize);
+
+    const uint32 taskCount = (getWordCount() + WordsPerTask - 1) / WordsPerTask;
+    threadPool.parallelFor(taskCount, [&](const uint32 taskId, const uint32) {
+        const uint32 firstWord = taskId * WordsPerTask;
+        cullWords(viewMatrix, frustum, firstWord, std::min(WordsPerTask, getWordCount() - firstWord), visibility);
+    });
+}
+
+void FrustumCuller::cullScalar(const mat4& viewMatrix, const FrustumPlanes& frustum, DynamicBitset& visibility) const
+{
+    visibility.reserve(getWordCount() * WordSize);
+    for (uint32 index = 0; index < getWordCount() * WordSize; ++index) {
+        visibility.setFlag(index, index < _objectCount && isVisible(index, viewMatrix, frustum));
+    }
+}
+
+void FrustumCuller::cullWords(
+    const mat4& viewMatrix, const FrustumPlanes& frustum, const uint32 firstWord, const uint32 wordCount, DynamicBitset& visibility) const
+{
+    __m256 view[4][3];
+    for (uint32 column = 0; column < 4; ++column) {
+        for (uint32 row = 0; row < 3; ++row) {
+            view[column][row] = _mm256_set1_ps(viewMatrix[column][row]);
+        }
+    }
+    const __m256 left[2] = { _mm256_set1_ps(frustum.left.x), _mm256_set1_ps(frustum.left.y) };
+    const __m256 right[2] = { _mm256_set1_ps(frustum.right.x), _mm256_set1_ps(frustum.right.y) };
+    const __m256 bottom[2] = { _mm256_set1_ps(frustum.bottom.x), _mm256_set1_ps(frustum.bottom.y) };
+    const __m256 top[2] = { _mm256_set1_ps(frustum.top.x), _mm256_set1_ps(frustum.top.y) };
+    const __m256 zero = _mm256_setzero_ps();
+
+    // Not FMAs, the scalar path has to round the same way
+    const auto dot2 = [](const __m256 ax, const __m256 ay, const __m256 b[2]) {
+        return _mm256_add_ps(_mm256_mul_ps(ax, b[0]), _mm256_mul_ps(ay, b[1]));
+    };
+
+    for (uint32 word = firstWord; word < firstWord + wordCount; ++word) {
+        uint32 flags = 0;
+        for (uint32 batch = 0; batch < WordSize / BatchSize; ++batch) {
+            const uint32 first = word * WordSize + batch * BatchSize;
+
+            // View space transform, the last row of the object transform is (0, 0, 0, 1)
+            __m256 transform[4][3];
+            for (uint32 column = 0; column < 4; ++column) {
+                __m256 objectColumn[3];
+                for (uint32 row = 0; row < 3; ++row) {
+                    objectColumn[row] = _mm256_loadu_ps(&_transforms[3 * column + row][first]);
+                }
+                for (uint32 row = 0; row < 3; ++row) {
+                    __m256 element = _mm256_mul_ps(view[0][row], objectColumn[0]);
+                    element = _mm256_add_ps(element, _mm256_mul_ps(view[1][row], objectColumn[1]));
+                    element = _mm256_add_ps(element, _mm256_mul_ps(view[2][row], objectColumn[2]));
+                    transform[column][row] = column == 3 ? _mm256_add_ps(element, view[3][row]) : element;
+                }
+            }
+
+            // transformAABB
+            __m256 aabbMin[3];
+            __m256 aabbMax[3];
+            for (uint32 i = 0; i < 3; ++i) {
+                aabbMin[i] = _mm256_loadu_ps(&_aabbMins[i][first]);
+                aabbMax[i] = _mm256_loadu_ps(&_aabbMaxs[i][first]);
+            }
+            __m256 viewMin[3];
+            __m256 viewMax[3];
+            for (uint32 row = 0; row < 3; ++row) {
+                __m256 minSum = zero;
+                __m256 maxSum = zero;
+                for (uint32 column = 0; column < 3; ++column) {
+                    const __m256 a = _mm256_mul_ps(transform[column][row], aabbMin[column]);
+                    const __m256 b = _mm256_mul_ps(transform[column][row], aabbMax[column]);
+                    minSum = column == 0 ? _mm256_min_ps(a, b) : _mm256_add_ps(minSum, _mm256_min_ps(a, b));
+                    maxSum = column == 0 ? _mm256_max_ps(a, b) : _mm256_add_ps(maxSum, _mm256_max_ps(a, b));
+                }
+                viewMin[row] = _mm256_add_ps(transform[3][row], minSum);
+                viewMax[row] = _mm256_add_ps(transform[3][row], maxSum);
+            }
+
+            // inFrustum, the culling pass rejects on "< 0" so NaNs are kept
+            __m256 visible = _mm256_cmp_ps(viewMax[2], zero, _CMP_NLT_UQ);
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(dot2(viewMax[0], viewMax[2], left), zero, _CMP_NLT_UQ));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(dot2(viewMin[0], viewMax[2], right), zero, _CMP_NLT_UQ));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(dot2(viewMax[1], viewMax[2], bottom), zero, _CMP_NLT_UQ));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(dot2(viewMin[1], viewMax[2], top), zero, _CMP_NLT_UQ));
+
+            flags |= static_cast<uint32>(_mm256_movemask_ps(visible)) << (batch * BatchSize);
+        }
+
+        // Padding objects
+        const uint32 remainingObjects = _objectCount - word * WordSize;
+        if (remainingObjects < WordSize) {
+            flags &= (1U << remainingObjects) - 1;
+        }
+
+        visibility.setWord(word, flags);
+    }
+}
+
+[[nodiscard]] bool FrustumCuller::isVisible(const uint32 index, const mat4& viewMatrix, const FrustumPlanes& frustum) const
+{
+    mat4x3 transform;
+    for (uint32 column = 0; column < 4; ++column) {
+        for (uint32 row = 0; row < 3; ++row) {
+            float element = viewMatrix[0][row] * _transforms[3 * column][index];
+            element += viewMatrix[1][row] * _transforms[3 * column + 1][index];
+            element += viewMatrix[2][row] * _transforms[3 * column + 2][index];
+            transform[column][row] = column == 3 ? element + viewMatrix[3][row] : element;
+        }
+    }
+
+    vec3 viewMin;
+    vec3 viewMax;
+    for (uint32 row = 0; row < 3; ++row) {
+        float minSum = 0.0f;
+        float maxSum = 0.0f;
+        for (uint32 column = 0; column < 3; ++column) {
+            const float a = transform[column][row] * _aabbMins[column][index];
+            const float b = transform[column][row] * _aabbMaxs[column][index];
+            // Same NaN and signed zero behaviour as _mm256_min_ps/_mm256_max_ps
+            const float min = a < b ? a : b;
+            const float max = a > b ? a : b;
+            minSum = column == 0 ? min : minSum + min;
+            maxSum = column == 0 ? max : maxSum + max;
+        }
+        viewMin[row] = transform[3][row] + minSum;
+        viewMax[row] = transform[3][row] + maxSum;
+    }
+
+    const auto dot2 = [](const float ax, const float ay, const vec2& b) { return ax * b.x + ay * b.y; };
+    return !(viewMax.z < 0.0f) && !(dot2(viewMax.x, viewMax.z, frustum.left) < 0.0f)
+        && !(dot2(viewMin.x, viewMax.z, frustum.right) < 0.0f) && !(dot2(viewMax.y, viewMax.z, frustum.bottom) < 0.0f)
+        && !(dot2(viewMin.y, viewMax.z, frustum.top) < 0.0f);
+}
+
+}
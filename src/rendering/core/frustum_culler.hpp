@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <core/aabb.hpp>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <scene/ecs/dynamic_bitset.hpp>
+#include <vector>
+
+namespace NH3D {
+
+class ThreadPool;
+
+// View space side planes of a symmetric perspective projection, must match FrustumPlanes in culling.inc.glsl
+// The components equal to zero are dropped: left/right planes are (x, z) pairs, bottom/top planes are (y, z) pairs
+// Small optimization: assumes an infinite far plane and d = 0 for the near plane
+struct FrustumPlanes {
+    vec2 left;
+    vec2 right;
+    vec2 bottom;
+    vec2 top;
+
+    enum class Intersection {
+        Outside,
+        Intersecting,
+        Inside, // doesn't cross any plane, everything it contains is visible
+    };
+
+    [[nodiscard]] static FrustumPlanes fromProjection(const mat4& projectionMatrix);
+
+    // Outside exactly when inFrustum rejects the AABB
+    [[nodiscard]] Intersection intersect(const AABB& viewAABB) const;
+};
+
+// CPU version of the frustum test of the culling pass (transformAABB + inFrustum), for the consumers that don't go through
+// the GPU culling
+// The objects are stored as structure of arrays so the AVX2 path tests 8 of them per iteration
+class FrustumCuller {
+    NH3D_NO_COPY(FrustumCuller)
+public:
+    static constexpr uint32 BatchSize = 8; // objects per AVX2 iteration
+
+    FrustumCuller() = default;
+
+    void resize(const uint32 objectCount);
+
+    [[nodiscard]] inline uint32 getObjectCount() const { return _objectCount; }
+
+    void setObject(const uint32 index, const mat4& objectToWorld, const AABB& objectAABB);
+
+    // Bit i of visibility is set if object i intersects the frustum, the bits past the object count are cleared
+    // The thread pool version splits the objects in tasks of whole bitset words so the workers never write the same word
+    void cull(const mat4& viewMatrix, const FrustumPlanes& frustum, DynamicBitset& visibility) const;
+
+    void cull(ThreadPool& threadPool, const mat4& viewMatrix, const FrustumPlanes& frustum, DynamicBitset& visibility) const;
+
+    // One object at a time, same operations in the same order as the AVX2 path so the results are identical
+    void cullScalar(const mat4& viewMatrix, const FrustumPlanes& frustum, DynamicBitset& visibility) const;
+
+private:
+    static constexpr uint32 WordSize = 32; // objects per bitset word
+    static constexpr uint32 WordsPerTask = 64;
+
+    // AVX2 path over the words [firstWord, firstWord + wordCount)
+    void cullWords(const mat4& viewMatrix, const FrustumPlanes& frustum, const uint32 firstWord, const uint32 wordCount,
+        DynamicBitset& visibility) const;
+
+    [[nodiscard]] bool isVisible(const uint32 index, const mat4& viewMatrix, const FrustumPlanes& frustum) const;
+
+    [[nodiscard]] inline uint32 getWordCount() const { return (_objectCount + WordSize - 1) / WordSize; }
+
+private:
+    uint32 _objectCount = 0;
+
+    // Padded to a whole bitset word so the SIMD loads never need a tail loop
+    std::array<std::vector<float>, 12> _transforms; // object to world 4x3 matrices, column major, one array per element
+    std::array<std::vector<float>, 3> _aabbMins;
+    std::array<std::vector<float>, 3> _aabbMaxs;
+};
+
+}
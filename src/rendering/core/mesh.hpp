@@ -2,14 +2,46 @@
 
 #include <core/aabb.hpp>
 #include <misc/types.hpp>
-#include <rendering/core/buffer.hpp>
 #include <rendering/core/handle.hpp>
+#include <rendering/core/meshlet.hpp>
 
 namespace NH3D {
 
+// Vertices, indices and meshlets suballocated from the geometry arenas of the RHI
+// The simplified LODs only add indices and meshlets, they index the vertices of the full resolution mesh
+// The index width is picked per geometry, 16 bit indices unless the vertices don't fit
+struct Geometry {
+    static constexpr uint32 MaxLODs = 5; // including the full resolution mesh
+
+    enum class IndexType : uint32 {
+        Uint16,
+        Uint32,
+    };
+
+    enum class VertexFormat : uint32 {
+        Full, // VertexData
+        Quantized, // QuantizedVertexData
+    };
+
+    struct LOD {
+        const ArrayWrapper<uint32> indices;
+        const ArrayWrapper<Meshlet> meshlets = {};
+        const float error; // object space, see MeshSimplifier
+    };
+
+    struct CreateInfo {
+        const ArrayWrapper<VertexData> vertices;
+        const ArrayWrapper<uint32> indices;
+        // Optional, see Meshlet::build. Without them the visibility buffer can't resolve LODs of more than Meshlet::MaxTriangles
+        // triangles, each draw has 7 bits for its triangle
+        const ArrayWrapper<Meshlet> meshlets = {};
+        const ArrayWrapper<LOD> lods = {}; // optional, coarser and coarser, at most MaxLODs - 1
+        const VertexFormat vertexFormat = VertexFormat::Full; // the vertices are quantized on upload
+    };
+};
+
 struct Mesh {
-    Handle<Buffer> vertexBuffer;
-    Handle<Buffer> indexBuffer;
+    Handle<Geometry> geometry;
 
     AABB objectAABB;
 };
@@ -0,0 +1,275 @@
+#include "mesh_optimizer.hpp"
+#include <algorithm>
+#include <misc/math.hpp>
+#include <numeric>
+
+namespace NH3D {
+
+namespace {
+
+    constexpr uint32 InvalidVertex = NH3D_MAX_T(uint32);
+
+    // FIFO cache using insertion timestamps, a vertex is cached if less than size vertices were inserted after it
+    struct FIFOCache {
+        std::vector<uint32> timestamps;
+        uint32 time;
+        uint32 size;
+
+        FIFOCache(const uint32 vertexCount, const uint32 cacheSize)
+            : timestamps(vertexCount, 0)
+            , time(cacheSize + 1)
+            , size(cacheSize)
+        {
+        }
+
+        [[nodiscard]] uint32 getAge(const uint32 vertex) const { return time - timestamps[vertex]; }
+
+        // Returns true on a cache miss
+        bool access(const uint32 vertex)
+        {
+            if (getAge(vertex) <= size) {
+                return false;
+            }
+
+            timestamps[vertex] = time++;
+            return true;
+        }
+
+        void flush() { time += size + 1; }
+    };
+
+    // Cache misses of the triangle starting at indices[i], the accesses have to happen in order
+    uint32 accessTriangle(FIFOCache& cache, const std::vector<uint32>& indices, const uint32 i)
+    {
+        uint32 misses = cache.access(indices[i]);
+        misses += cache.access(indices[i + 1]);
+        misses += cache.access(indices[i + 2]);
+        return misses;
+    }
+
+}
+
+[[nodiscard]] std::vector<uint32> MeshOptimizer::optimizeVertexCache(
+    const std::vector<uint32>& indices, const uint32 vertexCount, const uint32 cacheSize)
+{
+    NH3D_ASSERT(indices.size() % 3 == 0, "Only triangle lists can be optimized");
+
+    std::vector<uint32> result;
+    result.reserve(indices.size());
+    if (indices.empty()) {
+        return result;
+    }
+
+    // Vertex to triangle adjacency
+    std::vector<uint32> triangleOffsets(vertexCount + 1, 0);
+    for (const uint32 vertex : indices) {
+        NH3D_ASSERT(vertex < vertexCount, "Index out of the vertex range");
+        ++triangleOffsets[vertex + 1];
+    }
+    std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+    std::vector<uint32> vertexTriangles(indices.size());
+    std::vector<uint32> liveTriangleCounts(vertexCount); // triangles not emitted yet
+    for (uint32 i = 0; i < indices.size(); ++i) {
+        vertexTriangles[triangleOffsets[indices[i]] + liveTriangleCounts[indices[i]]++] = i / 3;
+    }
+
+    std::vector<bool> emitted(indices.size() / 3, false);
+    std::vector<uint32> deadEnds; // recently used vertices, to restart nearby when the fanning vertex has no candidate
+    std::vector<uint32> candidates;
+    FIFOCache cache(vertexCount, cacheSize);
+    uint32 cursor = 0;
+
+    uint32 fanningVertex = indices[0];
+    while (fanningVertex != InvalidVertex) {
+        candidates.clear();
+        for (uint32 t = triangleOffsets[fanningVertex]; t < triangleOffsets[fanningVertex + 1]; ++t) {
+            const uint32 triangle = vertexTriangles[t];
+            if (emitted[triangle]) {
+                continue;
+            }
+
+            for (uint32 corner = 0; corner < 3; ++corner) {
+                const uint32 vertex = indices[3 * triangle + corner];
+                result.emplace_back(vertex);
+                deadEnds.emplace_back(vertex);
+                candidates.emplace_back(vertex);
+                --liveTriangleCounts[vertex];
+                cache.access(vertex);
+            }
+            emitted[triangle] = true;
+        }
+
+        // The oldest candidate that stays in cache while its remaining triangles are fanned, any live one otherwise
+        fanningVertex = InvalidVertex;
+        int64 bestPriority = -1;
+        for (const uint32 vertex : candidates) {
+            if (liveTriangleCounts[vertex] == 0) {
+                continue;
+            }
+
+            const uint32 age = cache.getAge(vertex);
+            const int64 priority = age + 2 * liveTriangleCounts[vertex] <= cacheSize ? age : 0;
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanningVertex = vertex;
+            }
+        }
+
+        while (fanningVertex == InvalidVertex && !deadEnds.empty()) {
+            const uint32 vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangleCounts[vertex] > 0) {
+                fanningVertex = vertex;
+            }
+        }
+
+        for (; fanningVertex == InvalidVertex && cursor < vertexCount; ++cursor) {
+            if (liveTriangleCounts[cursor] > 0) {
+                fanningVertex = cursor;
+            }
+        }
+    }
+
+    return result;
+}
+
+[[nodiscard]] std::vector<uint32> MeshOptimizer::optimizeOverdraw(
+    const std::vector<VertexData>& vertices, const std::vector<uint32>& indices, const float threshold, const uint32 cacheSize)
+{
+    NH3D_ASSERT(indices.size() % 3 == 0, "Only triangle lists can be optimized");
+
+    const uint32 triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return indices;
+    }
+
+    // Hard boundaries, triangles missing all their vertices are where the cache optimizer jumped to another part of the mesh
+    std::vector<uint32> hardClusterStarts;
+    std::vector<uint32> triangleMisses(triangleCount);
+    FIFOCache cache(vertices.size(), cacheSize);
+    for (uint32 triangle = 0; triangle < triangleCount; ++triangle) {
+        triangleMisses[triangle] = accessTriangle(cache, indices, 3 * triangle);
+        if (triangleMisses[triangle] == 3) {
+            hardClusterStarts.emplace_back(triangle);
+        }
+    }
+    hardClusterStarts.emplace_back(triangleCount);
+
+    // Soft boundaries, the hard clusters are cut as soon as a cluster, starting from a cold cache, is almost as cache
+    // efficient as the whole hard cluster
+    std::vector<uint32> clusterStarts;
+    for (uint32 hardCluster = 0; hardCluster + 1 < hardClusterStarts.size(); ++hardCluster) {
+        const uint32 start = hardClusterStarts[hardCluster];
+        const uint32 end = hardClusterStarts[hardCluster + 1];
+        const uint32 hardMisses = std::accumulate(triangleMisses.begin() + start, triangleMisses.begin() + end, 0u);
+        const float maxACMR = threshold * hardMisses / (end - start);
+
+        clusterStarts.emplace_back(start);
+        cache.flush();
+        uint32 clusterMisses = 0;
+        for (uint32 triangle = start; triangle + 1 < end; ++triangle) {
+            clusterMisses += accessTriangle(cache, indices, 3 * triangle);
+            if (clusterMisses <= maxACMR * (triangle + 1 - clusterStarts.back())) {
+                clusterStarts.emplace_back(triangle + 1);
+                cache.flush();
+                clusterMisses = 0;
+            }
+        }
+    }
+    clusterStarts.emplace_back(triangleCount);
+
+    // Area weighted centroids and normals
+    const uint32 clusterCount = clusterStarts.size() - 1;
+    std::vector<vec3> clusterCentroids(clusterCount, vec3 { 0.0f });
+    std::vector<vec3> clusterNormals(clusterCount, vec3 { 0.0f });
+    std::vector<float> clusterAreas(clusterCount, 0.0f);
+    vec3 meshCentroid { 0.0f };
+    float meshArea = 0.0f;
+    for (uint32 cluster = 0; cluster < clusterCount; ++cluster) {
+        for (uint32 triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle) {
+            const vec3& p0 = vertices[indices[3 * triangle]].position;
+            const vec3& p1 = vertices[indices[3 * triangle + 1]].position;
+            const vec3& p2 = vertices[indices[3 * triangle + 2]].position;
+            const vec3 normal = cross(p1 - p0, p2 - p0); // length is twice the area
+            const float area = 0.5f * length(normal);
+
+            clusterCentroids[cluster] += area * (p0 + p1 + p2) / 3.0f;
+            clusterNormals[cluster] += normal;
+            clusterAreas[cluster] += area;
+        }
+
+        meshCentroid += clusterCentroids[cluster];
+        meshArea += clusterAreas[cluster];
+        if (clusterAreas[cluster] > 0.0f) {
+            clusterCentroids[cluster] /= clusterAreas[cluster];
+        }
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    // Clusters facing away from the center first
+    std::vector<float> sortKeys(clusterCount);
+    for (uint32 cluster = 0; cluster < clusterCount; ++cluster) {
+        const float normalLength = length(clusterNormals[cluster]);
+        const vec3 normal = normalLength > 0.0f ? clusterNormals[cluster] / normalLength : vec3 { 0.0f };
+        sortKeys[cluster] = dot(clusterCentroids[cluster] - meshCentroid, normal);
+    }
+    std::vector<uint32> clusterOrder(clusterCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(
+        clusterOrder.begin(), clusterOrder.end(), [&sortKeys](const uint32 a, const uint32 b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32> result;
+    result.reserve(indices.size());
+    for (const uint32 cluster : clusterOrder) {
+        result.insert(result.end(), indices.begin() + 3 * clusterStarts[cluster], indices.begin() + 3 * clusterStarts[cluster + 1]);
+    }
+
+    return result;
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<VertexData>& vertices, std::vector<uint32>& indices)
+{
+    std::vector<uint32> remap(vertices.size(), InvalidVertex);
+    std::vector<VertexData> result;
+    result.reserve(vertices.size());
+    for (uint32& index : indices) {
+        NH3D_ASSERT(index < vertices.size(), "Index out of the vertex range");
+        if (remap[index] == InvalidVertex) {
+            remap[index] = result.size();
+            result.emplace_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(result);
+}
+
+[[nodiscard]] VertexCacheStatistics MeshOptimizer::analyzeVertexCache(
+    const std::vector<uint32>& indices, const uint32 vertexCount, const uint32 cacheSize)
+{
+    NH3D_ASSERT(indices.size() % 3 == 0, "Only triangle lists can be analyzed");
+
+    VertexCacheStatistics statistics { .transformedVertexCount = 0, .acmr = 0.0f, .atvr = 0.0f };
+    if (indices.empty()) {
+        return statistics;
+    }
+
+    FIFOCache cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32 referencedVertexCount = 0;
+    for (uint32 i = 0; i < indices.size(); i += 3) {
+        statistics.transformedVertexCount += accessTriangle(cache, indices, i);
+        for (uint32 corner = 0; corner < 3; ++corner) {
+            referencedVertexCount += !referenced[indices[i + corner]];
+            referenced[indices[i + corner]] = true;
+        }
+    }
+
+    statistics.acmr = static_cast<float>(statistics.transformedVertexCount) / (indices.size() / 3);
+    statistics.atvr = static_cast<float>(statistics.transformedVertexCount) / referencedVertexCount;
+    return statistics;
+}
+
+}
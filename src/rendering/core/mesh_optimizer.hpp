@@ -0,0 +1,43 @@
+#pragma once
+
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <vector>
+
+namespace NH3D {
+
+// Result of a FIFO post-transform cache simulation over a triangle list
+struct VertexCacheStatistics {
+    uint32 transformedVertexCount; // cache misses
+    float acmr; // average cache miss ratio, transformed vertices per triangle, 0.5 at best for a regular grid, 3 at worst
+    float atvr; // average transformed vertex ratio, transformed vertices per referenced vertex, 1 at best
+};
+
+// Import time reordering of the triangles and vertices of a mesh, the rendered result is unchanged
+// Meant to be chained: optimizeVertexCache, then optimizeOverdraw on its result, then optimizeVertexFetch
+class MeshOptimizer {
+public:
+    // Roughly the post-transform cache of current GPUs, the exact size barely matters to Tipsify
+    static constexpr uint32 DefaultCacheSize = 16;
+
+    // Tipsify (Sander, Nehab & Barczak 2007), fans the triangles around each vertex and picks the next fanning vertex among
+    // the ones still in cache, linear in the triangle count
+    [[nodiscard]] static std::vector<uint32> optimizeVertexCache(
+        const std::vector<uint32>& indices, const uint32 vertexCount, const uint32 cacheSize = DefaultCacheSize);
+
+    // View-independent overdraw reduction of a cache optimized list: it is cut in clusters that keep an ACMR below
+    // threshold times the one of the whole list, the clusters are then sorted so that the ones facing away from the center
+    // of the mesh are drawn first, they're the most likely to occlude the rest
+    [[nodiscard]] static std::vector<uint32> optimizeOverdraw(const std::vector<VertexData>& vertices, const std::vector<uint32>& indices,
+        const float threshold = 1.05f, const uint32 cacheSize = DefaultCacheSize);
+
+    // Renumbers the vertices in order of first use so the vertex fetches walk the buffer linearly, unreferenced vertices
+    // are dropped
+    static void optimizeVertexFetch(std::vector<VertexData>& vertices, std::vector<uint32>& indices);
+
+    // CPU simulation of a FIFO post-transform cache of cacheSize vertices
+    [[nodiscard]] static VertexCacheStatistics analyzeVertexCache(
+        const std::vector<uint32>& indices, const uint32 vertexCount, const uint32 cacheSize = DefaultCacheSize);
+};
+
+}
@@ -0,0 +1,282 @@
+#include "mesh_simplifier.hpp"
+#include <algorithm>
+#include <misc/math.hpp>
+#include <numeric>
+#include <tuple>
+
+namespace NH3D {
+
+namespace {
+
+    // Sum of the area weighted squared distances to the planes of the triangles around a vertex
+    struct Quadric {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        void addPlane(const vec3& n, const float d, const float area)
+        {
+            a00 += area * n.x * n.x;
+            a01 += area * n.x * n.y;
+            a02 += area * n.x * n.z;
+            a11 += area * n.y * n.y;
+            a12 += area * n.y * n.z;
+            a22 += area * n.z * n.z;
+            b0 += area * n.x * d;
+            b1 += area * n.y * d;
+            b2 += area * n.z * d;
+            c += area * d * d;
+            weight += area;
+        }
+
+        Quadric operator+(const Quadric& other) const
+        {
+            return Quadric { a00 + other.a00, a01 + other.a01, a02 + other.a02, a11 + other.a11, a12 + other.a12, a22 + other.a22,
+                b0 + other.b0, b1 + other.b1, b2 + other.b2, c + other.c, weight + other.weight };
+        }
+
+        // Mean squared distance of p to the planes
+        [[nodiscard]] double evaluate(const vec3& p) const
+        {
+            if (weight <= 0.0) {
+                return 0.0;
+            }
+
+            const double x = p.x, y = p.y, z = p.z;
+            const double error = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return std::max(error, 0.0) / weight;
+        }
+    };
+
+    struct Collapse {
+        uint32 from;
+        uint32 to;
+        double cost;
+    };
+
+    // Representative vertex of every vertex position, the topology ignores attribute seams
+    std::vector<uint32> weldPositions(const std::vector<VertexData>& vertices)
+    {
+        std::vector<uint32> order(vertices.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&vertices](const uint32 a, const uint32 b) {
+            const vec3& pa = vertices[a].position;
+            const vec3& pb = vertices[b].position;
+            return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+        });
+
+        std::vector<uint32> positionIds(vertices.size());
+        for (uint32 i = 0; i < order.size(); ++i) {
+            const bool samePosition = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+            positionIds[order[i]] = samePosition ? positionIds[order[i - 1]] : order[i];
+        }
+
+        return positionIds;
+    }
+
+    // Seams, open borders and non-manifold edges, collapsing them would tear the mesh or mix attributes
+    std::vector<bool> findLockedPositions(const std::vector<uint32>& indices, const std::vector<uint32>& positionIds)
+    {
+        std::vector<bool> locked(positionIds.size(), false);
+
+        std::vector<uint32> vertexCounts(positionIds.size(), 0);
+        for (const uint32 positionId : positionIds) {
+            locked[positionId] = ++vertexCounts[positionId] > 1;
+        }
+
+        std::vector<uint64> edges;
+        edges.reserve(indices.size());
+        for (uint32 i = 0; i < indices.size(); i += 3) {
+            for (uint32 corner = 0; corner < 3; ++corner) {
+                const uint64 a = positionIds[indices[i + corner]];
+                const uint64 b = positionIds[indices[i + (corner + 1) % 3]];
+                edges.emplace_back(a < b ? (a << 32) | b : (b << 32) | a);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        for (uint32 first = 0, last = 0; first < edges.size(); first = last) {
+            while (last < edges.size() && edges[last] == edges[first]) {
+                ++last;
+            }
+            if (last - first != 2) {
+                locked[edges[first] >> 32] = true;
+                locked[edges[first] & NH3D_MAX_T(uint32)] = true;
+            }
+        }
+
+        return locked;
+    }
+
+}
+
+[[nodiscard]] std::vector<uint32> MeshSimplifier::simplify(
+    const std::vector<VertexData>& vertices, const std::vector<uint32>& indices, const uint32 targetIndexCount, float& error)
+{
+    NH3D_ASSERT(indices.size() % 3 == 0, "Only triangle lists can be simplified");
+
+    error = 0.0f;
+    std::vector<uint32> result = indices;
+    if (result.size() <= targetIndexCount) {
+        return result;
+    }
+
+    const std::vector<uint32> positionIds = weldPositions(vertices);
+    const std::vector<bool> locked = findLockedPositions(indices, positionIds);
+    const auto position = [&vertices](const uint32 vertex) -> const vec3& { return vertices[vertex].position; };
+
+    std::vector<Quadric> quadrics(vertices.size()); // indexed by position id
+    for (uint32 i = 0; i < indices.size(); i += 3) {
+        const vec3& p0 = position(indices[i]);
+        const vec3 normal = cross(position(indices[i + 1]) - p0, position(indices[i + 2]) - p0);
+        const float doubleArea = length(normal);
+        if (doubleArea <= 0.0f) {
+            continue;
+        }
+
+        const vec3 n = normal / doubleArea;
+        for (uint32 corner = 0; corner < 3; ++corner) {
+            quadrics[positionIds[indices[i + corner]]].addPlane(n, -dot(n, p0), 0.5f * doubleArea);
+        }
+    }
+
+    std::vector<uint32> triangleOffsets(vertices.size() + 1);
+    std::vector<uint32> vertexTriangles;
+    std::vector<uint32> remap(vertices.size());
+    std::vector<bool> touched(vertices.size());
+    std::vector<Collapse> collapses;
+    double maxCost = 0.0;
+
+    // Each pass collapses a set of independent edges, their neighbourhoods can't overlap so the costs stay valid within a pass
+    while (result.size() > targetIndexCount) {
+        // Vertex to triangle adjacency of the current mesh
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (const uint32 vertex : result) {
+            ++triangleOffsets[vertex + 1];
+        }
+        std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+        vertexTriangles.resize(result.size());
+        std::vector<uint32> fillOffsets(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (uint32 i = 0; i < result.size(); ++i) {
+            vertexTriangles[fillOffsets[result[i]]++] = i / 3;
+        }
+
+        collapses.clear();
+        for (uint32 i = 0; i < result.size(); i += 3) {
+            for (uint32 corner = 0; corner < 3; ++corner) {
+                const uint32 a = result[i + corner];
+                const uint32 b = result[i + (corner + 1) % 3];
+                const Quadric quadric = quadrics[positionIds[a]] + quadrics[positionIds[b]];
+                if (!locked[positionIds[a]]) {
+                    collapses.emplace_back(Collapse { .from = a, .to = b, .cost = quadric.evaluate(position(b)) });
+                }
+                if (!locked[positionIds[b]]) {
+                    collapses.emplace_back(Collapse { .from = b, .to = a, .cost = quadric.evaluate(position(a)) });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+        uint32 indexCount = result.size();
+        bool collapsed = false;
+        for (const Collapse& collapse : collapses) {
+            if (indexCount <= targetIndexCount) {
+                break;
+            }
+
+            const uint32 fromId = positionIds[collapse.from];
+            const uint32 toId = positionIds[collapse.to];
+            if (touched[fromId] || touched[toId]) {
+                continue;
+            }
+
+            // Moving the vertex must not flip or fold the triangles that survive the collapse
+            bool flips = false;
+            uint32 removedTriangleCount = 0;
+            for (uint32 t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && !flips; ++t) {
+                const uint32* triangle = &result[3 * vertexTriangles[t]];
+                if (positionIds[triangle[0]] == toId || positionIds[triangle[1]] == toId || positionIds[triangle[2]] == toId) {
+                    ++removedTriangleCount;
+                    continue;
+                }
+
+                vec3 p[3] = { position(triangle[0]), position(triangle[1]), position(triangle[2]) };
+                const vec3 normal = cross(p[1] - p[0], p[2] - p[0]);
+                for (vec3& corner : p) {
+                    corner = corner == position(collapse.from) ? position(collapse.to) : corner;
+                }
+                const vec3 newNormal = cross(p[1] - p[0], p[2] - p[0]);
+                flips = dot(normal, newNormal) <= 0.25f * length(normal) * length(newNormal);
+            }
+            if (flips) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[toId] = quadrics[toId] + quadrics[fromId];
+            maxCost = std::max(maxCost, collapse.cost);
+            indexCount -= 3 * removedTriangleCount;
+            collapsed = true;
+
+            for (uint32 t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; ++t) {
+                const uint32* triangle = &result[3 * vertexTriangles[t]];
+                touched[positionIds[triangle[0]]] = true;
+                touched[positionIds[triangle[1]]] = true;
+                touched[positionIds[triangle[2]]] = true;
+            }
+        }
+
+        if (!collapsed) {
+            break;
+        }
+
+        // Triangles that lost an edge are dropped
+        uint32 writeIndex = 0;
+        for (uint32 i = 0; i < result.size(); i += 3) {
+            const uint32 a = remap[result[i]];
+            const uint32 b = remap[result[i + 1]];
+            const uint32 c = remap[result[i + 2]];
+            if (positionIds[a] != positionIds[b] && positionIds[b] != positionIds[c] && positionIds[a] != positionIds[c]) {
+                result[writeIndex++] = a;
+                result[writeIndex++] = b;
+                result[writeIndex++] = c;
+            }
+        }
+        result.resize(writeIndex);
+    }
+
+    error = static_cast<float>(std::sqrt(maxCost));
+    return result;
+}
+
+[[nodiscard]] std::vector<MeshLOD> MeshSimplifier::buildLODChain(
+    const std::vector<VertexData>& vertices, const std::vector<uint32>& indices, const uint32 maxLODCount)
+{
+    std::vector<MeshLOD> lods;
+    lods.reserve(maxLODCount);
+    lods.emplace_back(MeshLOD { .indices = indices, .error = 0.0f });
+
+    while (lods.size() < maxLODCount) {
+        const std::vector<uint32>& previousIndices = lods.back().indices;
+        const float previousError = lods.back().error;
+
+        float error;
+        std::vector<uint32> simplifiedIndices = simplify(vertices, previousIndices, previousIndices.size() / 6 * 3, error);
+
+        // Not worth a LOD if locked vertices stop the simplification early
+        if (simplifiedIndices.empty() || 4 * simplifiedIndices.size() > 3 * previousIndices.size()) {
+            break;
+        }
+
+        // Each LOD is simplified from the previous one, the distances add up
+        lods.emplace_back(MeshLOD { .indices = std::move(simplifiedIndices), .error = previousError + error });
+    }
+
+    return lods;
+}
+
+}
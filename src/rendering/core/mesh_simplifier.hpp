@@ -0,0 +1,31 @@
+#pragma once
+
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <vector>
+
+namespace NH3D {
+
+// Simplified index list of a mesh, it keeps using the vertices of the full resolution mesh
+struct MeshLOD {
+    std::vector<uint32> indices;
+    float error; // object space distance to the full resolution mesh, 0 for the mesh itself
+};
+
+// Quadric edge collapse simplification (Garland & Heckbert), vertices are only ever collapsed onto other vertices so the
+// simplified meshes can share the vertex buffer of the original one
+// Vertices on open borders and attribute seams (several vertices at the same position) are locked
+class MeshSimplifier {
+public:
+    // Collapses edges in order of increasing error until the mesh has at most targetIndexCount indices or nothing can be
+    // collapsed anymore, error is the largest collapse error
+    [[nodiscard]] static std::vector<uint32> simplify(
+        const std::vector<VertexData>& vertices, const std::vector<uint32>& indices, const uint32 targetIndexCount, float& error);
+
+    // LOD 0 is the mesh itself, each LOD halves the triangle count of the previous one
+    // Stops early when the simplification stalls, so the chain can be shorter than maxLODCount
+    [[nodiscard]] static std::vector<MeshLOD> buildLODChain(
+        const std::vector<VertexData>& vertices, const std::vector<uint32>& indices, const uint32 maxLODCount);
+};
+
+}
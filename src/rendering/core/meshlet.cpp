@@ -0,0 +1,127 @@
+#include "meshlet.hpp"
+#include <misc/math.hpp>
+
+namespace NH3D {
+
+namespace {
+
+    constexpr uint32 NotInMeshlet = NH3D_MAX_T(uint32);
+
+    // Bounding sphere centered on the AABB of the vertices and normal cone of the triangles
+    Meshlet computeBounds(const std::vector<VertexData>& vertices, const std::vector<uint32>& indices, const uint32 firstIndex,
+        const uint32 triangleCount, const std::vector<uint32>& meshletVertices)
+    {
+        vec3 pMin = vertices[meshletVertices[0]].position;
+        vec3 pMax = pMin;
+        for (const uint32 vertex : meshletVertices) {
+            pMin = min(pMin, vertices[vertex].position);
+            pMax = max(pMax, vertices[vertex].position);
+        }
+
+        const vec3 center = 0.5f * (pMin + pMax);
+        float radius = 0.0f;
+        for (const uint32 vertex : meshletVertices) {
+            radius = max(radius, distance(center, vertices[vertex].position));
+        }
+
+        const auto triangleNormal = [&](const uint32 i) {
+            const vec3& p0 = vertices[indices[i]].position;
+            return cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+        };
+        const uint32 lastIndex = firstIndex + 3 * triangleCount;
+
+        // Area weighted average normal, degenerate triangles don't contribute
+        vec3 axis { 0.0f };
+        for (uint32 i = firstIndex; i < lastIndex; i += 3) {
+            axis += triangleNormal(i);
+        }
+
+        // The cone can't cull anything if the normals span more than a hemisphere, a cutoff of 1 disables the test
+        float coneCutoff = 1.0f;
+        const float axisLength = length(axis);
+        if (axisLength > 0.0f) {
+            axis /= axisLength;
+
+            float minDot = 1.0f;
+            for (uint32 i = firstIndex; i < lastIndex; i += 3) {
+                const vec3 normal = triangleNormal(i);
+                const float area = length(normal);
+                if (area > 0.0f) {
+                    minDot = min(minDot, dot(normal, axis) / area);
+                }
+            }
+
+            // Widening the normal cone by 90 degrees gives the cone of view directions that only see back faces
+            if (minDot > 0.0f) {
+                coneCutoff = std::sqrt(1.0f - minDot * minDot);
+            }
+        }
+
+        return Meshlet {
+            .center = center,
+            .radius = radius,
+            .coneAxis = axis,
+            .coneCutoff = coneCutoff,
+            .firstIndex = firstIndex,
+            .triangleCount = triangleCount,
+        };
+    }
+
+}
+
+[[nodiscard]] std::vector<Meshlet> Meshlet::build(const std::vector<VertexData>& vertices, const std::vector<uint32>& indices)
+{
+    NH3D_ASSERT(indices.size() % 3 == 0, "Meshlets can only be built from triangle lists");
+
+    std::vector<Meshlet> meshlets;
+    meshlets.reserve(indices.size() / (3 * MaxTriangles) + 1);
+
+    // Meshlet id of the last meshlet that used each vertex, avoids clearing a set for every meshlet
+    std::vector<uint32> vertexMeshlets(vertices.size(), NotInMeshlet);
+    std::vector<uint32> meshletVertices;
+    meshletVertices.reserve(MaxVertices);
+
+    uint32 firstIndex = 0;
+    uint32 triangleCount = 0;
+    for (uint32 i = 0; i < indices.size(); i += 3) {
+        uint32 newVertexCount = 0;
+        for (uint32 corner = 0; corner < 3; ++corner) {
+            const uint32 vertex = indices[i + corner];
+            // Duplicated corners of degenerate triangles are only counted once
+            newVertexCount += vertexMeshlets[vertex] != meshlets.size() && (corner == 0 || indices[i] != vertex)
+                && (corner < 2 || indices[i + 1] != vertex);
+        }
+
+        if (triangleCount == MaxTriangles || meshletVertices.size() + newVertexCount > MaxVertices) {
+            meshlets.emplace_back(computeBounds(vertices, indices, firstIndex, triangleCount, meshletVertices));
+            meshletVertices.clear();
+            firstIndex = i;
+            triangleCount = 0;
+        }
+
+        // The meshlet id changes with every new meshlet, the vertices of the previous ones don't match it
+        const uint32 meshletId = meshlets.size();
+        for (uint32 corner = 0; corner < 3; ++corner) {
+            const uint32 vertex = indices[i + corner];
+            if (vertexMeshlets[vertex] != meshletId) {
+                vertexMeshlets[vertex] = meshletId;
+                meshletVertices.emplace_back(vertex);
+            }
+        }
+        ++triangleCount;
+    }
+
+    if (triangleCount > 0) {
+        meshlets.emplace_back(computeBounds(vertices, indices, firstIndex, triangleCount, meshletVertices));
+    }
+
+    return meshlets;
+}
+
+[[nodiscard]] bool Meshlet::isBackfacing(const vec3& eye) const
+{
+    const vec3 direction = center - eye;
+    return dot(direction, coneAxis) >= coneCutoff * length(direction) + radius;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <vector>
+
+namespace NH3D {
+
+// Small cluster of triangles culled on its own by the cluster culling pass, in object space
+// The triangles of a meshlet are a contiguous range of the mesh's index buffer
+struct Meshlet {
+    static constexpr uint32 MaxVertices = 64;
+    static constexpr uint32 MaxTriangles = 124;
+
+    vec3 center; // bounding sphere
+    float radius;
+    vec3 coneAxis; // average normal of the triangles
+    float coneCutoff; // the meshlet is backfacing if dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius
+    uint32 firstIndex; // relative to the mesh
+    uint32 triangleCount;
+
+    // Splits the triangle list in meshlets without reordering it, a new meshlet starts whenever the current one would exceed
+    // MaxVertices unique vertices or MaxTriangles triangles, so the quality depends on the locality of the index order
+    [[nodiscard]] static std::vector<Meshlet> build(const std::vector<VertexData>& vertices, const std::vector<uint32>& indices);
+
+    // CPU version of the cone test of the cluster culling pass
+    [[nodiscard]] bool isBackfacing(const vec3& eye) const;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "quantized_vertex.hpp"
+#include <glm/gtc/packing.hpp>
+#include <misc/math.hpp>
+
+namespace NH3D {
+
+namespace {
+
+    // Reference: https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/
+    vec2 octEncode(const vec3& n)
+    {
+        const vec2 p = vec2(n) / (abs(n.x) + abs(n.y) + abs(n.z));
+        if (n.z >= 0.0f) {
+            return p;
+        }
+
+        return (1.0f - abs(vec2(p.y, p.x))) * vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    vec3 octDecode(const vec2& e)
+    {
+        vec3 n { e.x, e.y, 1.0f - abs(e.x) - abs(e.y) };
+        const float t = clamp(-n.z, 0.0f, 1.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return normalize(n);
+    }
+
+}
+
+[[nodiscard]] std::vector<QuantizedVertexData> QuantizedVertexData::quantize(const ArrayWrapper<VertexData> vertices, const AABB& bounds)
+{
+    const vec3 inverseScale = 1.0f / getPositionScale(bounds);
+
+    std::vector<QuantizedVertexData> quantizedVertices(vertices.size);
+    for (uint32 i = 0; i < vertices.size; ++i) {
+        const VertexData& vertex = vertices[i];
+        QuantizedVertexData& quantizedVertex = quantizedVertices[i];
+
+        const vec3 position = clamp((vertex.position - bounds.min) * inverseScale, 0.0f, 1.0f);
+        for (uint32 axis = 0; axis < 3; ++axis) {
+            quantizedVertex.position[axis] = glm::packUnorm1x16(position[axis]);
+        }
+        quantizedVertex.position[3] = 0;
+
+        const vec2 normal = octEncode(normalize(vertex.normal));
+        quantizedVertex.normal[0] = static_cast<int16>(glm::packSnorm1x16(normal.x));
+        quantizedVertex.normal[1] = static_cast<int16>(glm::packSnorm1x16(normal.y));
+
+        quantizedVertex.uv[0] = glm::packHalf1x16(vertex.uv.x);
+        quantizedVertex.uv[1] = glm::packHalf1x16(vertex.uv.y);
+    }
+
+    return quantizedVertices;
+}
+
+[[nodiscard]] vec3 QuantizedVertexData::getPositionScale(const AABB& bounds)
+{
+    const vec3 extent = bounds.max - bounds.min;
+    return { extent.x > 0.0f ? extent.x : 1.0f, extent.y > 0.0f ? extent.y : 1.0f, extent.z > 0.0f ? extent.z : 1.0f };
+}
+
+[[nodiscard]] VertexData QuantizedVertexData::decode(const AABB& bounds) const
+{
+    const vec3 position { glm::unpackUnorm1x16(this->position[0]), glm::unpackUnorm1x16(this->position[1]),
+        glm::unpackUnorm1x16(this->position[2]) };
+
+    return VertexData {
+        .position = bounds.min + position * getPositionScale(bounds),
+        .normal = octDecode({ glm::unpackSnorm1x16(static_cast<uint16>(normal[0])), glm::unpackSnorm1x16(static_cast<uint16>(normal[1])) }),
+        .uv = { glm::unpackHalf1x16(uv[0]), glm::unpackHalf1x16(uv[1]) },
+    };
+}
+
+}
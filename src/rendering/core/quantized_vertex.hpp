@@ -0,0 +1,26 @@
+#pragma once
+
+#include <core/aabb.hpp>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <vector>
+
+namespace NH3D {
+
+// Half the size of VertexData, decoded by default_gbuffer_deferred.vert
+// Positions are normalized in the AABB of the vertices, the culling pass folds the dequantization in the model view matrix
+struct QuantizedVertexData {
+    uint16 position[4]; // unorm, w is padding so that each attribute unpacks from 32 bit words
+    int16 normal[2]; // octahedral encoding, snorm
+    uint16 uv[2]; // half floats
+
+    [[nodiscard]] static std::vector<QuantizedVertexData> quantize(const ArrayWrapper<VertexData> vertices, const AABB& bounds);
+
+    // Extent of the bounds, flat axes get a scale of 1 since every position maps to 0 on them anyway
+    [[nodiscard]] static vec3 getPositionScale(const AABB& bounds);
+
+    // CPU version of the decoding of the GBuffer vertex shader
+    [[nodiscard]] VertexData decode(const AABB& bounds) const;
+};
+
+}
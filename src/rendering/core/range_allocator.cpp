@@ -0,0 +1,102 @@
+#include "range_allocator.hpp"
+#include <algorithm>
+
+namespace NH3D {
+
+RangeAllocator::RangeAllocator(const uint32 capacity)
+    : _capacity { capacity }
+    , _freeSize { capacity }
+{
+    if (capacity > 0) {
+        _freeRanges.emplace(0, capacity);
+    }
+}
+
+[[nodiscard]] uint32 RangeAllocator::allocate(const uint32 size)
+{
+    NH3D_ASSERT(size > 0, "Empty range allocation");
+
+    // First fit keeps the live ranges packed towards the beginning, which makes compactions cheaper
+    const auto it = std::find_if(_freeRanges.begin(), _freeRanges.end(), [size](const auto& range) { return range.second >= size; });
+    if (it == _freeRanges.end()) {
+        return InvalidOffset;
+    }
+
+    const uint32 offset = it->first;
+    const uint32 remainingSize = it->second - size;
+    _freeRanges.erase(it);
+    if (remainingSize > 0) {
+        _freeRanges.emplace(offset + size, remainingSize);
+    }
+
+    _allocatedRanges.emplace(offset, size);
+    _freeSize -= size;
+
+    return offset;
+}
+
+void RangeAllocator::free(const uint32 offset)
+{
+    const auto allocatedIt = _allocatedRanges.find(offset);
+    NH3D_ASSERT(allocatedIt != _allocatedRanges.end(), "Freeing a range that wasn't allocated");
+
+    uint32 freeOffset = offset;
+    uint32 freeSize = allocatedIt->second;
+    _freeSize += freeSize;
+    _allocatedRanges.erase(allocatedIt);
+
+    // Merge with the next free range
+    const auto nextIt = _freeRanges.find(offset + freeSize);
+    if (nextIt != _freeRanges.end()) {
+        freeSize += nextIt->second;
+        _freeRanges.erase(nextIt);
+    }
+
+    // Merge with the previous free range
+    const auto followingIt = _freeRanges.lower_bound(offset);
+    if (followingIt != _freeRanges.begin()) {
+        const auto previousIt = std::prev(followingIt);
+        if (previousIt->first + previousIt->second == offset) {
+            freeOffset = previousIt->first;
+            freeSize += previousIt->second;
+            _freeRanges.erase(previousIt);
+        }
+    }
+
+    _freeRanges.emplace(freeOffset, freeSize);
+}
+
+[[nodiscard]] std::vector<RangeAllocator::Move> RangeAllocator::compact()
+{
+    std::vector<Move> moves;
+
+    std::map<uint32, uint32> compactedRanges;
+    uint32 offset = 0;
+    for (const auto& [oldOffset, size] : _allocatedRanges) {
+        if (oldOffset != offset) {
+            moves.emplace_back(Move { .oldOffset = oldOffset, .newOffset = offset, .size = size });
+        }
+        compactedRanges.emplace_hint(compactedRanges.end(), offset, size);
+        offset += size;
+    }
+    _allocatedRanges = std::move(compactedRanges);
+
+    _freeRanges.clear();
+    if (offset < _capacity) {
+        _freeRanges.emplace(offset, _capacity - offset);
+    }
+
+    return moves;
+}
+
+[[nodiscard]] uint32 RangeAllocator::getLargestFreeRange() const
+{
+    uint32 largestSize = 0;
+    for (const auto& [offset, size] : _freeRanges) {
+        largestSize = std::max(largestSize, size);
+    }
+
+    return largestSize;
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <map>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <vector>
+
+namespace NH3D {
+
+// First-fit suballocator of [0, capacity), API agnostic so that it can back any kind of arena (elements, bytes...)
+// Freed ranges are merged with their free neighbours, compaction packs the live ranges at the beginning
+class RangeAllocator {
+public:
+    static constexpr uint32 InvalidOffset = NH3D_MAX_T(uint32);
+
+    // A live range moved by compact()
+    struct Move {
+        uint32 oldOffset;
+        uint32 newOffset;
+        uint32 size;
+    };
+
+    RangeAllocator() = delete;
+
+    RangeAllocator(const uint32 capacity);
+
+    // Returns InvalidOffset if no free range is large enough, compacting may help if getFreeSize() is large enough
+    [[nodiscard]] uint32 allocate(const uint32 size);
+
+    void free(const uint32 offset);
+
+    // Moves are sorted by increasing offsets, newOffset <= oldOffset
+    [[nodiscard]] std::vector<Move> compact();
+
+    [[nodiscard]] inline uint32 getCapacity() const { return _capacity; }
+
+    [[nodiscard]] inline uint32 getFreeSize() const { return _freeSize; }
+
+    [[nodiscard]] uint32 getLargestFreeRange() const;
+
+    [[nodiscard]] inline uint32 getAllocationCount() const { return _allocatedRanges.size(); }
+
+private:
+    uint32 _capacity;
+    uint32 _freeSize;
+
+    // offset -> size, sorted by offset to find the neighbours of a freed range
+    std::map<uint32, uint32> _freeRanges;
+    std::map<uint32, uint32> _allocatedRanges;
+};
+
+}
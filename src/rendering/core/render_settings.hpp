@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <misc/types.hpp>
+#include <rendering/core/mesh.hpp>
+#include <string>
+#include <vector>
+
+namespace NH3D {
+
+// Runtime tweakables, read by the RHI at the beginning of every frame
+struct RenderSettings {
+    // Passes are recorded into separate command buffers on worker threads, serial recording is kept for comparison
+    bool parallelCommandRecording = true;
+    // Two-phase culling against a depth pyramid, everything in the frustum is drawn in the first phase when disabled
+    bool occlusionCulling = true;
+    // Frustum culling of the GPU scene BVH on the CPU, only the objects of the intersecting leaves are uploaded to the culling pass
+    bool bvhCulling = true;
+    // The instances of every per-mesh draw are grouped by albedo texture so that neighbouring instances share their texture
+    bool materialBinning = true;
+    // The geometry passes only write the instance and triangle of every pixel, a compute pass then fetches the attributes and
+    // textures once per pixel, which makes overdraw cheaper. Switching rebuilds the render graph
+    bool visibilityBuffer = false;
+    // Waits for the previous frame before sampling the input, so that nothing is queued ahead of the frame: lower latency but the
+    // GPU idles while the CPU prepares the frame. The number of frames in flight is an engine setting, see IRHI
+    bool lowLatency = false;
+    // Largest screen space error allowed when picking a LOD, in pixels, 0 draws everything at full resolution
+    float lodErrorThreshold = 1.0f;
+    // Times the candidate workgroup sizes of the tuned compute passes on the current scene, the fastest ones are kept and persisted
+    // for the next launches on this device. Runs once per activation, see WorkgroupTuner
+    bool workgroupTuning = false;
+};
+
+struct PassTiming {
+    std::string name;
+    float time; // in milliseconds
+};
+
+// Measurements of the last rendered frame, CPU times are in milliseconds
+struct RenderStats {
+    float commandRecordingTime = 0.0f;
+    uint32 meshCount = 0; // unique meshes, each one is a single instanced draw per phase
+    uint32 lightCount = 0;
+    float cpuWaitTime = 0.0f; // previous frames and swapchain image
+
+    // GPU side, from the last frame the GPU completed
+    float gpuIdleTime = 0.0f; // between the end of the previous frame and the start of this one
+    float inputLatency = 0.0f; // from the input sampling to the end of the GPU work, 0 without calibrated timestamps
+    std::vector<PassTiming> passTimings;
+    uint32 earlyDrawCount = 0; // instances
+    uint32 lateDrawCount = 0; // instances
+    uint32 bvhCulledCount = 0; // CPU side, current frame
+    uint32 frustumCulledCount = 0;
+    uint32 occlusionCulledCount = 0;
+    uint32 meshletDrawCount = 0; // both phases, meshes with more than one meshlet
+    uint32 clusterCulledCount = 0; // meshlets
+    std::array<uint32, Geometry::MaxLODs> lodDrawCounts {}; // visible objects per LOD, both phases
+    uint64 vertexShaderInvocations = 0; // GBuffer passes, 0 if pipeline statistics aren't supported
+    uint64 inputAssemblyPrimitives = 0;
+};
+
+}
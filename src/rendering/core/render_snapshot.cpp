@@ -0,0 +1,49 @@
+#include "render_snapshot.hpp"
+#include <scene/ecs/components/render_component.hpp>
+
+namespace NH3D {
+
+void RenderSnapshot::extract(Scene& scene)
+{
+    removedEntities.clear();
+    objectChanges.clear();
+    lights.clear();
+
+    const Entity mainCamera = scene.getMainCamera();
+    hasCamera = mainCamera != InvalidEntity;
+    if (!hasCamera) {
+        return;
+    }
+
+    camera = scene.get<CameraComponent>(mainCamera);
+    cameraTransform = scene.get<TransformComponent>(mainCamera);
+
+    const std::vector<Entity>& removedRenderEntities = scene.getRemovedRenderEntities();
+    removedEntities.assign(removedRenderEntities.begin(), removedRenderEntities.end());
+
+    for (const Entity entity : scene.getDirtyRenderEntities()) {
+        // Also filters out duplicates and entities removed after being marked dirty
+        const RenderDirtyFlags flags = scene.consumeRenderDirtyFlags(entity);
+        if (flags == 0 || !scene.checkComponents<RenderComponent, TransformComponent>(entity)) {
+            continue;
+        }
+
+        const RenderComponent& renderComponent = scene.get<RenderComponent>(entity);
+        objectChanges.emplace_back(ObjectChange {
+            .entity = entity,
+            .flags = flags,
+            .visible = scene.isVisible(entity),
+            .mesh = renderComponent.getMesh(),
+            .material = renderComponent.getMaterial(),
+            .transform = scene.get<TransformComponent>(entity),
+        });
+    }
+    scene.clearRenderChanges();
+
+    // Few enough to be copied every tick
+    for (const auto [entity, light, transform] : scene.makeView<const LightComponent&, const TransformComponent&>()) {
+        lights.emplace_back(Light { .light = light, .transform = transform });
+    }
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <misc/math.hpp>
+#include <misc/types.hpp>
+#include <rendering/core/material.hpp>
+#include <rendering/core/mesh.hpp>
+#include <rendering/core/render_settings.hpp>
+#include <scene/ecs/components/camera_component.hpp>
+#include <scene/ecs/components/light_component.hpp>
+#include <scene/ecs/components/transform_component.hpp>
+#include <scene/ecs/entity.hpp>
+#include <scene/scene.hpp>
+#include <vector>
+
+namespace NH3D {
+
+// Copy of everything the renderer reads from the main thread, extracted at the end of a tick so the render thread never touches
+// the live scene while the next tick is simulated
+// The object changes are incremental like the dirty lists they are taken from, every extracted snapshot has to be rendered
+struct RenderSnapshot {
+    // Drawable entity whose render data or transform changed since the previous snapshot
+    struct ObjectChange {
+        Entity entity;
+        RenderDirtyFlags flags;
+        bool visible;
+        Mesh mesh;
+        Material material;
+        TransformComponent transform;
+    };
+
+    struct Light {
+        LightComponent light;
+        TransformComponent transform;
+    };
+
+    // Draws the indexCount indices following the ones of the previous command
+    struct UIDrawCommand {
+        vec4 clipRect; // min x, min y, max x, max y in pixels
+        uint32 indexCount;
+        int32 vertexOffset;
+    };
+
+    // Flattened ImGui draw data, ImGui reuses its draw lists as soon as the next tick starts a new UI frame
+    struct UI {
+        vec2 displaySize { 0.0f };
+        std::vector<byte> vertices; // ImDrawVert
+        std::vector<uint16> indices;
+        std::vector<UIDrawCommand> commands;
+    };
+
+    // The changes are left in the scene when there's no camera, nothing is rendered and they would be lost otherwise
+    bool hasCamera = false;
+    CameraComponent camera;
+    TransformComponent cameraTransform;
+
+    std::vector<Entity> removedEntities; // applied before the changes, an entity may be removed and recreated in the same tick
+    std::vector<ObjectChange> objectChanges;
+    std::vector<Light> lights;
+
+    UI ui;
+
+    // The settings go to the render thread with the snapshot, the stats of the frame it produced come back with it
+    RenderSettings settings;
+    RenderStats stats;
+
+    // Consumes the render changes of the scene, the buffers of the previous extraction are reused
+    void extract(Scene& scene);
+};
+
+}
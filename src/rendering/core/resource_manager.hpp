@@ -28,6 +28,11 @@ public:
 
     [[nodiscard]] inline HandleType create(IRHI& rhi, const CreateInfoType& createInfo);
 
+    // Handle of a resource created later on, see assign. Holds default constructed (invalid) data until then
+    [[nodiscard]] inline HandleType reserve();
+
+    inline void assign(HandleType handle, HotType hotData, ColdType coldData);
+
     inline void release(const IRHI& rhi, HandleType handle);
 
     inline void clear(const IRHI& rhi);
@@ -63,22 +68,38 @@ template <typename T>
 {
     auto [hotData, coldData] = T::create(rhi, createInfo);
 
+    const HandleType handle = reserve();
+    assign(handle, std::move(hotData), std::move(coldData));
+
+    return handle;
+}
+
+template <typename T> [[nodiscard]] inline ResourceManager<T>::HandleType ResourceManager<T>::reserve()
+{
     HandleType handle;
     if (!_availableHandles.empty()) {
         handle = _availableHandles.back();
         _availableHandles.pop_back();
 
-        _hot[handle.index] = std::move(hotData);
-        _cold[handle.index] = std::move(coldData);
+        _hot[handle.index] = HotType {};
+        _cold[handle.index] = ColdType {};
     } else {
         handle = { static_cast<uint32>(_hot.size()) };
-        _hot.emplace_back(std::move(hotData));
-        _cold.emplace_back(std::move(coldData));
+        _hot.emplace_back();
+        _cold.emplace_back();
     }
 
     return handle;
 }
 
+template <typename T> inline void ResourceManager<T>::assign(HandleType handle, HotType hotData, ColdType coldData)
+{
+    NH3D_ASSERT(handle.index < _hot.size(), "Invalid handle index");
+
+    _hot[handle.index] = std::move(hotData);
+    _cold[handle.index] = std::move(coldData);
+}
+
 template <typename T> inline void ResourceManager<T>::release(const IRHI& rhi, HandleType handle)
 {
     NH3D_ASSERT(handle.index < _cold.size(), "Invalid handle index");
@@ -4,21 +4,32 @@
 #include <misc/utils.hpp>
 #include <rendering/core/buffer.hpp>
 #include <rendering/core/handle.hpp>
+#include <rendering/core/mesh.hpp>
+#include <rendering/core/render_settings.hpp>
 #include <rendering/core/texture.hpp>
 
 namespace NH3D {
 
 class Scene;
 class RenderGraph;
+struct RenderSnapshot;
 class Window;
 
 class IRHI {
     NH3D_NO_COPY_MOVE(IRHI)
 public:
-    static constexpr uint32 MaxFramesInFlight = 2;
+    static constexpr uint32 MaxFramesInFlight = 4;
+    static constexpr uint32 DefaultFramesInFlight = 2;
 
 public:
-    IRHI() = default;
+    IRHI() = delete;
+
+    // The FrameResources of the RHI are sized with it, the count can't change for the lifetime of the RHI
+    explicit IRHI(const uint32 framesInFlight)
+        : _framesInFlight { framesInFlight }
+    {
+        NH3D_ASSERT(framesInFlight >= 1 && framesInFlight <= MaxFramesInFlight, "Unsupported frames in flight count");
+    }
 
     virtual ~IRHI() = default;
 
@@ -30,7 +41,35 @@ public:
 
     virtual void destroyBuffer(const Handle<Buffer> handle) = 0;
 
-    virtual void render(Scene& scene) = 0;
+    [[nodiscard]] virtual Handle<Geometry> createGeometry(const Geometry::CreateInfo& info) = 0;
+
+    virtual void destroyGeometry(const Handle<Geometry> handle) = 0;
+
+    // Main thread, end of the tick: copies the scene and the settings into the snapshot and takes back the stats the render
+    // thread left in it
+    virtual void extract(Scene& scene, RenderSnapshot& snapshot) = 0;
+
+    // Render thread, only reads the snapshot and writes the stats of the frame into it
+    // Resources may still be created and destroyed from the main thread meanwhile, they wait for the frame to be recorded
+    virtual void render(RenderSnapshot& snapshot) = 0;
+
+    // Render thread, blocks until a frame in flight is available. Called right after render() so that the wait happens before
+    // the main thread gets the next snapshot and samples its input, instead of between the input and the frame that uses it
+    virtual void waitForNextFrame() = 0;
+
+    [[nodiscard]] inline uint32 getFramesInFlight() const { return _framesInFlight; }
+
+    // Main thread copies, see extract
+    [[nodiscard]] inline RenderSettings& getSettings() { return _settings; }
+
+    [[nodiscard]] inline const RenderStats& getStats() const { return _stats; }
+
+protected:
+    RenderSettings _settings;
+    RenderStats _stats; // lags a couple of frames behind the render thread
+
+private:
+    const uint32 _framesInFlight;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "ring_allocator.hpp"
+
+namespace NH3D {
+
+RingAllocator::RingAllocator(const uint64 capacity)
+    : _capacity { capacity }
+{
+}
+
+[[nodiscard]] uint64 RingAllocator::allocate(const uint64 size, const uint64 alignment, const uint64 retireValue)
+{
+    NH3D_ASSERT(size > 0, "Empty ring allocation");
+    NH3D_ASSERT((alignment & (alignment - 1)) == 0, "The alignment must be a power of 2");
+    NH3D_ASSERT(_allocations.empty() || retireValue >= _allocations.back().retireValue, "Ring allocations must retire in order");
+
+    uint64 offset = InvalidOffset;
+    if (_allocations.empty()) {
+        offset = size <= _capacity ? 0 : InvalidOffset;
+    } else {
+        const uint64 tail = _allocations.front().offset;
+        const uint64 alignedHead = (_head + alignment - 1) & ~(alignment - 1);
+        if (_head > tail) {
+            // The end of the ring first, then wrap around, the padding at the end is reclaimed with the allocation before it
+            if (alignedHead + size <= _capacity) {
+                offset = alignedHead;
+            } else if (size <= tail) {
+                offset = 0;
+            }
+        } else if (alignedHead + size <= tail) {
+            offset = alignedHead;
+        }
+    }
+
+    if (offset != InvalidOffset) {
+        _allocations.emplace_back(Allocation { .offset = offset, .retireValue = retireValue });
+        _head = offset + size;
+    }
+
+    return offset;
+}
+
+void RingAllocator::reclaim(const uint64 retiredValue)
+{
+    while (!_allocations.empty() && _allocations.front().retireValue <= retiredValue) {
+        _allocations.pop_front();
+    }
+
+    if (_allocations.empty()) {
+        _head = 0;
+    }
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <deque>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+
+namespace NH3D {
+
+// Suballocator of [0, capacity) for memory consumed in allocation order (staging memory...), API agnostic
+// Every allocation is tagged with the value that retires it (timeline value, frame id...), the oldest allocations are reclaimed
+// once that value is reached. The tags must not decrease from one allocation to the next
+class RingAllocator {
+public:
+    static constexpr uint64 InvalidOffset = NH3D_MAX_T(uint64);
+
+    RingAllocator() = delete;
+
+    RingAllocator(const uint64 capacity);
+
+    // Returns InvalidOffset if there is no contiguous free range large enough until older allocations are reclaimed
+    // alignment must be a power of 2
+    [[nodiscard]] uint64 allocate(const uint64 size, const uint64 alignment, const uint64 retireValue);
+
+    // Frees the allocations tagged with a value up to retiredValue
+    void reclaim(const uint64 retiredValue);
+
+    [[nodiscard]] inline uint64 getCapacity() const { return _capacity; }
+
+    [[nodiscard]] inline uint32 getAllocationCount() const { return _allocations.size(); }
+
+    // Value to wait for to reclaim anything, 0 when empty
+    [[nodiscard]] inline uint64 getOldestRetireValue() const { return _allocations.empty() ? 0 : _allocations.front().retireValue; }
+
+private:
+    struct Allocation {
+        uint64 offset;
+        uint64 retireValue;
+    };
+
+    uint64 _capacity;
+    uint64 _head = 0; // end of the newest allocation
+
+    std::deque<Allocation> _allocations; // oldest first
+};
+
+}
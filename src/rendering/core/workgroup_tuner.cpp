@@ -0,0 +1,159 @@
+#include "workgroup_tuner.hpp"
+#include <algorithm>
+#include <fstream>
+#include <misc/utils.hpp>
+
+namespace NH3D {
+
+WorkgroupTuner::WorkgroupTuner(const std::filesystem::path& path, const uint32 version)
+    : _path { path }
+    , _version { version }
+{
+    load();
+}
+
+[[nodiscard]] uint32 WorkgroupTuner::addKernel(const std::string& name, const ArrayWrapper<vec3u> candidates)
+{
+    NH3D_ASSERT(candidates.size > 0, "A tuned kernel needs at least one candidate workgroup size");
+
+    Kernel& kernel = _kernels.emplace_back(Kernel {
+        .name = name,
+        .candidates = { candidates.data, candidates.data + candidates.size },
+    });
+
+    const auto persistedWinner = _persistedWinners.find(name);
+    if (persistedWinner != _persistedWinners.end()) {
+        const auto candidate = std::find(kernel.candidates.begin(), kernel.candidates.end(), persistedWinner->second);
+        if (candidate != kernel.candidates.end()) {
+            kernel.winner = static_cast<uint32>(candidate - kernel.candidates.begin());
+            kernel.selectedCandidate = kernel.winner;
+        }
+    }
+
+    return _kernels.size() - 1;
+}
+
+void WorkgroupTuner::startTuning()
+{
+    if (_tuning) {
+        return;
+    }
+
+    for (Kernel& kernel : _kernels) {
+        kernel.candidateTimes.assign(kernel.candidates.size(), 0.0f);
+        kernel.frameCount = 0;
+        kernel.selectedCandidate = 0;
+        kernel.tuned = kernel.candidates.size() == 1;
+    }
+    _tuning = true;
+
+    NH3D_LOG("Tuning the workgroup sizes of " << _kernels.size() << " compute kernels");
+    if (std::all_of(_kernels.begin(), _kernels.end(), [](const Kernel& kernel) { return kernel.tuned; })) {
+        finishTuning();
+    }
+}
+
+void WorkgroupTuner::stopTuning()
+{
+    if (!_tuning) {
+        return;
+    }
+
+    for (Kernel& kernel : _kernels) {
+        kernel.selectedCandidate = kernel.winner;
+        kernel.tuned = true;
+    }
+    finishTuning();
+}
+
+void WorkgroupTuner::recordPassTimings(const std::vector<PassTiming>& passTimings)
+{
+    if (!_tuning) {
+        return;
+    }
+
+    bool tuned = true;
+    for (Kernel& kernel : _kernels) {
+        if (kernel.tuned) {
+            continue;
+        }
+
+        const auto passTiming = std::find_if(
+            passTimings.begin(), passTimings.end(), [&kernel](const PassTiming& timing) { return timing.name == kernel.name; });
+        if (passTiming != passTimings.end()) {
+            ++kernel.frameCount;
+            if (kernel.frameCount > DiscardedFrameCount) {
+                kernel.candidateTimes[kernel.selectedCandidate] += passTiming->time;
+            }
+
+            if (kernel.frameCount == DiscardedFrameCount + TimedFrameCount) {
+                kernel.frameCount = 0;
+                ++kernel.selectedCandidate;
+                if (kernel.selectedCandidate == kernel.candidates.size()) {
+                    kernel.winner = static_cast<uint32>(
+                        std::min_element(kernel.candidateTimes.begin(), kernel.candidateTimes.end()) - kernel.candidateTimes.begin());
+                    kernel.selectedCandidate = kernel.winner;
+                    kernel.tuned = true;
+
+                    const vec3u size = kernel.candidates[kernel.winner];
+                    NH3D_LOG("Tuned " << kernel.name << ": " << size.x << "x" << size.y << "x" << size.z << " workgroups, "
+                                      << kernel.candidateTimes[kernel.winner] / TimedFrameCount << " ms");
+                }
+            }
+        }
+        tuned &= kernel.tuned;
+    }
+
+    if (tuned) {
+        finishTuning();
+    }
+}
+
+void WorkgroupTuner::finishTuning()
+{
+    _tuning = false;
+    for (const Kernel& kernel : _kernels) {
+        _persistedWinners[kernel.name] = kernel.candidates[kernel.winner];
+    }
+    save();
+}
+
+void WorkgroupTuner::load()
+{
+    std::ifstream file { _path };
+    if (!file.is_open()) {
+        return;
+    }
+
+    // The winners of a driver depend on its compiler, tuned again after an update
+    uint32 version;
+    file >> version;
+    if (!file || version != _version) {
+        NH3D_WARN("Workgroup sizes at " << _path << " were tuned for another version, ignoring them");
+        return;
+    }
+
+    std::string name;
+    vec3u size;
+    while (file >> name >> size.x >> size.y >> size.z) {
+        _persistedWinners[name] = size;
+    }
+    NH3D_LOG("Loaded " << _persistedWinners.size() << " tuned workgroup sizes from " << _path);
+}
+
+void WorkgroupTuner::save() const
+{
+    std::ofstream file { _path, std::ios::trunc };
+    file << _version << "\n";
+    for (const auto& [name, size] : _persistedWinners) {
+        file << name << " " << size.x << " " << size.y << " " << size.z << "\n";
+    }
+
+    if (!file) {
+        NH3D_WARN("Failed to save the tuned workgroup sizes to " << _path);
+        return;
+    }
+    NH3D_LOG("Saved the tuned workgroup sizes to " << _path);
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <filesystem>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <rendering/core/render_settings.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace NH3D {
+
+// Picks the workgroup size of the compute kernels whose best size depends on the device and the scene, API agnostic
+// Every kernel has a list of candidate sizes, the first one being the default. While tuning, the candidates are used one after
+// the other and timed with the GPU timings of the pass dispatching the kernel, the fastest one is then kept. The winners are
+// persisted in a file per device and used from the next launch on
+class WorkgroupTuner {
+public:
+    // Timings dropped after switching candidates, the frames in flight may have been recorded with the previous one
+    static constexpr uint32 DiscardedFrameCount = 8;
+    // Timings averaged per candidate
+    static constexpr uint32 TimedFrameCount = 64;
+
+    WorkgroupTuner() = delete;
+
+    // The winners are ignored when the file was written for another version (driver update...)
+    WorkgroupTuner(const std::filesystem::path& path, const uint32 version);
+
+    // The name is the one of the pass dispatching the kernel. Starts with the persisted winner if it is still a candidate
+    [[nodiscard]] uint32 addKernel(const std::string& name, const ArrayWrapper<vec3u> candidates);
+
+    [[nodiscard]] inline uint32 getCandidateCount(const uint32 kernelId) const { return _kernels[kernelId].candidates.size(); }
+
+    [[nodiscard]] inline vec3u getCandidate(const uint32 kernelId, const uint32 candidateId) const
+    {
+        return _kernels[kernelId].candidates[candidateId];
+    }
+
+    // The one being timed while tuning, the winner otherwise
+    [[nodiscard]] inline uint32 getSelectedCandidate(const uint32 kernelId) const { return _kernels[kernelId].selectedCandidate; }
+
+    [[nodiscard]] inline vec3u getWorkgroupSize(const uint32 kernelId) const
+    {
+        return getCandidate(kernelId, getSelectedCandidate(kernelId));
+    }
+
+    // Until every kernel is tuned or stopTuning is called
+    [[nodiscard]] inline bool isTuning() const { return _tuning; }
+
+    void startTuning();
+
+    // The kernels that weren't tuned yet keep their previous winner
+    void stopTuning();
+
+    // GPU timings of a completed frame, the kernels whose pass didn't run aren't timed
+    void recordPassTimings(const std::vector<PassTiming>& passTimings);
+
+private:
+    struct Kernel {
+        std::string name;
+        std::vector<vec3u> candidates;
+        uint32 selectedCandidate = 0;
+        uint32 winner = 0;
+
+        // Tuning state
+        std::vector<float> candidateTimes; // in milliseconds, sum of the timed frames
+        uint32 frameCount = 0; // since the current candidate was selected
+        bool tuned = true;
+    };
+
+    void finishTuning();
+
+    void load();
+
+    void save() const;
+
+private:
+    std::filesystem::path _path;
+    uint32 _version;
+
+    std::vector<Kernel> _kernels;
+    std::unordered_map<std::string, vec3u> _persistedWinners;
+    bool _tuning = false;
+};
+
+}
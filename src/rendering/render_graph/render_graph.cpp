@@ -0,0 +1,543 @@
+#include "render_graph.hpp"
+#include <algorithm>
+#include <tuple>
+#include <misc/utils.hpp>
+
+namespace NH3D {
+
+RenderGraph::RenderGraph(const uint32 framesInFlight)
+    : _physicalTextures { framesInFlight }
+    , _physicalBuffers { framesInFlight }
+{
+}
+
+[[nodiscard]] RGTexture RenderGraph::createTexture(const char* name, const TransientTextureInfo& info)
+{
+    NH3D_ASSERT(!_compiled, "Resources must be declared before compiling the render graph");
+
+    _textures.emplace_back(ResourceNode { .name = name, .transient = true, .transientInfo = info });
+    return RGTexture { static_cast<uint32>(_textures.size() - 1) };
+}
+
+[[nodiscard]] RGTexture RenderGraph::importTexture(const char* name, const ImportInfo& info)
+{
+    NH3D_ASSERT(!_compiled, "Resources must be declared before compiling the render graph");
+
+    _textures.emplace_back(ResourceNode { .name = name, .transient = false, .importInfo = info });
+    return RGTexture { static_cast<uint32>(_textures.size() - 1) };
+}
+
+[[nodiscard]] RGBuffer RenderGraph::importBuffer(const char* name, const ImportInfo& info)
+{
+    NH3D_ASSERT(!_compiled, "Resources must be declared before compiling the render graph");
+
+    _buffers.emplace_back(ResourceNode { .name = name, .transient = false, .importInfo = info });
+    return RGBuffer { static_cast<uint32>(_buffers.size() - 1) };
+}
+
+void RenderGraph::addPass(const PassInfo& info)
+{
+    NH3D_ASSERT(!_compiled, "Passes must be added before compiling the render graph");
+    NH3D_ASSERT(_passes.size() < MaxPasses, "Too many render graph passes");
+    NH3D_ASSERT(info.record, "Render graph pass without record function");
+
+    PassNode pass {
+        .name = info.name,
+        .record = info.record,
+        .sideEffects = info.sideEffects,
+    };
+
+    for (uint32 i = 0; i < info.textures.size; ++i) {
+        const TextureAccess& textureAccess = info.textures.data[i];
+        NH3D_ASSERT(textureAccess.texture.id < _textures.size(), "Unknown render graph texture");
+        addUse(pass.uses, textureAccess.texture.id, true, getAccessInfo(textureAccess.access));
+    }
+
+    for (uint32 i = 0; i < info.buffers.size; ++i) {
+        const BufferAccess& bufferAccess = info.buffers.data[i];
+        NH3D_ASSERT(bufferAccess.buffer.id < _buffers.size(), "Unknown render graph buffer");
+        addUse(pass.uses, bufferAccess.buffer.id, false, getAccessInfo(bufferAccess.access));
+    }
+
+    _passes.emplace_back(std::move(pass));
+}
+
+void RenderGraph::compile()
+{
+    NH3D_ASSERT(!_compiled, "Render graph already compiled");
+
+    cullPasses();
+    computeLifetimes();
+    assignAliasingGroups();
+    computeBarriers();
+
+    for (uint32 i = 0; i < _physicalTextures.size(); ++i) {
+        _physicalTextures[i].resize(_textures.size());
+        _physicalBuffers[i].resize(_buffers.size());
+    }
+
+    _compiled = true;
+}
+
+[[nodiscard]] const std::string& RenderGraph::getPassName(const uint32 compiledPassId) const
+{
+    NH3D_ASSERT(compiledPassId < _compiledPasses.size(), "Compiled pass id out of bounds");
+    return _passes[_compiledPasses[compiledPassId]].name;
+}
+
+[[nodiscard]] const std::vector<RenderGraph::Barrier>& RenderGraph::getPassBarriers(const uint32 compiledPassId) const
+{
+    NH3D_ASSERT(compiledPassId < _compiledPasses.size(), "Compiled pass id out of bounds");
+    return _passes[_compiledPasses[compiledPassId]].barriers;
+}
+
+[[nodiscard]] const std::vector<RenderGraph::Barrier>& RenderGraph::getPassFinalBarriers(const uint32 compiledPassId) const
+{
+    NH3D_ASSERT(compiledPassId < _compiledPasses.size(), "Compiled pass id out of bounds");
+    return _passes[_compiledPasses[compiledPassId]].finalBarriers;
+}
+
+void RenderGraph::bindTexture(const uint32 frameInFlightId, const RGTexture texture, const PhysicalTexture& physicalTexture)
+{
+    NH3D_ASSERT(_compiled, "Physical resources are bound after compilation");
+    NH3D_ASSERT(texture.id < _textures.size(), "Unknown render graph texture");
+    _physicalTextures[frameInFlightId][texture.id] = physicalTexture;
+}
+
+void RenderGraph::bindBuffer(const uint32 frameInFlightId, const RGBuffer buffer, const PhysicalBuffer& physicalBuffer)
+{
+    NH3D_ASSERT(_compiled, "Physical resources are bound after compilation");
+    NH3D_ASSERT(buffer.id < _buffers.size(), "Unknown render graph buffer");
+    _physicalBuffers[frameInFlightId][buffer.id] = physicalBuffer;
+}
+
+[[nodiscard]] Handle<Texture> RenderGraph::getTexture(const uint32 frameInFlightId, const RGTexture texture) const
+{
+    NH3D_ASSERT(texture.id < _physicalTextures[frameInFlightId].size(), "Unknown render graph texture");
+    return _physicalTextures[frameInFlightId][texture.id].handle;
+}
+
+[[nodiscard]] Handle<Buffer> RenderGraph::getBuffer(const uint32 frameInFlightId, const RGBuffer buffer) const
+{
+    NH3D_ASSERT(buffer.id < _physicalBuffers[frameInFlightId].size(), "Unknown render graph buffer");
+    return _physicalBuffers[frameInFlightId][buffer.id].handle;
+}
+
+void RenderGraph::recordPass(const uint32 compiledPassId, VkCommandBuffer commandBuffer, const uint32 frameInFlightId) const
+{
+    NH3D_ASSERT(compiledPassId < _compiledPasses.size(), "Compiled pass id out of bounds");
+    const PassNode& pass = _passes[_compiledPasses[compiledPassId]];
+
+    insertBarriers(commandBuffer, frameInFlightId, pass.barriers);
+    pass.record(commandBuffer, *this, frameInFlightId);
+    insertBarriers(commandBuffer, frameInFlightId, pass.finalBarriers);
+}
+
+[[nodiscard]] RenderGraph::AccessInfo RenderGraph::getAccessInfo(const RGAccess access)
+{
+    switch (access) {
+    case RGAccess::None:
+        return { VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_UNDEFINED, 0, false, false };
+    case RGAccess::TransferRead:
+        return { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, false };
+    case RGAccess::TransferWrite:
+        return { VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT, false, true };
+    case RGAccess::IndirectRead:
+        return { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, true, false };
+    case RGAccess::VertexStorageRead:
+        return { VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_USAGE_STORAGE_BIT, true, false };
+    case RGAccess::FragmentSampledRead:
+        return { VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_USAGE_SAMPLED_BIT, true, false };
+    case RGAccess::ComputeSampledRead:
+        // The deferred shading descriptors are written with the general layout
+        return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_USAGE_SAMPLED_BIT, true, false };
+    case RGAccess::ComputeStorageRead:
+        return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_USAGE_STORAGE_BIT, true, false };
+    case RGAccess::ComputeStorageWrite:
+        return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_USAGE_STORAGE_BIT, false, true };
+    case RGAccess::ComputeStorageReadWrite:
+        return { VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true, true };
+    case RGAccess::ColorAttachmentWrite:
+        return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, false, true };
+    case RGAccess::ColorAttachmentReadWrite:
+        return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true, true };
+    case RGAccess::DepthAttachmentWrite:
+        // The depth test reads the attachment but the content is cleared first
+        return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false, true };
+    case RGAccess::DepthAttachmentReadWrite:
+        return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true, true };
+    case RGAccess::DepthAttachmentRead:
+        return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true, false };
+    case RGAccess::HostRead:
+        return { VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, 0, true, false };
+    case RGAccess::Present:
+        return { VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, true, false };
+    }
+
+    NH3D_ABORT("Unknown render graph access");
+    return {};
+}
+
+void RenderGraph::addUse(std::vector<ResourceUse>& uses, const uint32 resource, const bool isTexture, const AccessInfo& info)
+{
+    for (ResourceUse& use : uses) {
+        if (use.resource == resource && use.isTexture == isTexture) {
+            NH3D_ASSERT(!isTexture || use.info.layout == info.layout, "A texture can only be used with one layout in a pass");
+            use.info.stage |= info.stage;
+            use.info.access |= info.access;
+            use.info.usage |= info.usage;
+            use.info.read |= info.read;
+            use.info.write |= info.write;
+            return;
+        }
+    }
+
+    uses.emplace_back(ResourceUse { .resource = resource, .isTexture = isTexture, .info = info });
+}
+
+void RenderGraph::cullPasses()
+{
+    // Walk the passes backward, a pass is needed if it writes something read later or exported
+    std::vector<bool> neededTextures(_textures.size());
+    std::vector<bool> neededBuffers(_buffers.size());
+    for (uint32 i = 0; i < _textures.size(); ++i) {
+        neededTextures[i] = !_textures[i].transient && _textures[i].importInfo.finalAccess != RGAccess::None;
+    }
+    for (uint32 i = 0; i < _buffers.size(); ++i) {
+        neededBuffers[i] = _buffers[i].importInfo.finalAccess != RGAccess::None;
+    }
+
+    std::vector<bool> keptPasses(_passes.size(), false);
+    for (int32 passId = static_cast<int32>(_passes.size()) - 1; passId >= 0; --passId) {
+        const PassNode& pass = _passes[passId];
+
+        bool kept = pass.sideEffects;
+        for (const ResourceUse& use : pass.uses) {
+            const bool needed = use.isTexture ? neededTextures[use.resource] : neededBuffers[use.resource];
+            kept |= use.info.write && needed;
+        }
+
+        if (!kept) {
+            continue;
+        }
+        keptPasses[passId] = true;
+
+        // A write-only access overwrites the resource, earlier writers don't matter anymore
+        for (const ResourceUse& use : pass.uses) {
+            std::vector<bool>& needed = use.isTexture ? neededTextures : neededBuffers;
+            if (use.info.read) {
+                needed[use.resource] = true;
+            } else if (use.info.write) {
+                needed[use.resource] = false;
+            }
+        }
+    }
+
+    _compiledPasses.clear();
+    for (uint32 passId = 0; passId < _passes.size(); ++passId) {
+        if (keptPasses[passId]) {
+            _compiledPasses.emplace_back(passId);
+        }
+    }
+}
+
+void RenderGraph::computeLifetimes()
+{
+    for (uint32 compiledPassId = 0; compiledPassId < _compiledPasses.size(); ++compiledPassId) {
+        for (const ResourceUse& use : _passes[_compiledPasses[compiledPassId]].uses) {
+            ResourceNode& node = use.isTexture ? _textures[use.resource] : _buffers[use.resource];
+            node.firstPass = std::min(node.firstPass, compiledPassId);
+            node.lastPass = std::max(node.lastPass, compiledPassId);
+            node.usage |= use.info.usage;
+        }
+    }
+}
+
+void RenderGraph::assignAliasingGroups()
+{
+    std::vector<uint32> transients;
+    for (uint32 i = 0; i < _textures.size(); ++i) {
+        if (_textures[i].transient && _textures[i].firstPass != NH3D_MAX_T(uint32)) {
+            transients.emplace_back(i);
+        }
+    }
+    std::stable_sort(transients.begin(), transients.end(),
+        [this](const uint32 a, const uint32 b) { return _textures[a].firstPass < _textures[b].firstPass; });
+
+    // Greedy interval coloring, a texture joins the first group whose last texture is dead before its first use
+    struct AliasingGroup {
+        uint32 lastPass;
+        uint32 lastTexture;
+    };
+    std::vector<AliasingGroup> groups;
+    for (const uint32 textureId : transients) {
+        ResourceNode& node = _textures[textureId];
+
+        uint32 groupId = 0;
+        while (groupId < groups.size() && groups[groupId].lastPass >= node.firstPass) {
+            ++groupId;
+        }
+
+        if (groupId == groups.size()) {
+            groups.emplace_back(AliasingGroup { .lastPass = node.lastPass, .lastTexture = textureId });
+        } else {
+            node.aliasPredecessor = groups[groupId].lastTexture;
+            groups[groupId] = AliasingGroup { .lastPass = node.lastPass, .lastTexture = textureId };
+        }
+        node.aliasingGroup = groupId;
+
+        _transientTextures.emplace_back(TransientTexture {
+            .texture = RGTexture { textureId },
+            .info = node.transientInfo,
+            .usage = node.usage,
+            .aliasingGroup = groupId,
+        });
+    }
+    _aliasingGroupCount = static_cast<uint32>(groups.size());
+}
+
+[[nodiscard]] std::pair<VkPipelineStageFlags2, VkAccessFlags2> RenderGraph::getPendingAccess(const ResourceState& state)
+{
+    if (state.readStages != VK_PIPELINE_STAGE_2_NONE) {
+        return { state.readStages, VK_ACCESS_2_NONE };
+    }
+
+    return { state.writeStage, state.writeAccess };
+}
+
+[[nodiscard]] RenderGraph::ResourceState RenderGraph::makeInitialState(
+    const uint32 resource, const bool isTexture, const std::vector<ResourceState>& textureStates) const
+{
+    const ResourceNode& node = isTexture ? _textures[resource] : _buffers[resource];
+
+    ResourceState state;
+    if (node.transient) {
+        // The memory may still be in use by the previous texture of the aliasing group
+        if (node.aliasPredecessor != NH3D_MAX_T(uint32)) {
+            std::tie(state.writeStage, state.writeAccess) = getPendingAccess(textureStates[node.aliasPredecessor]);
+        }
+        return state;
+    }
+
+    const AccessInfo info = getAccessInfo(node.importInfo.initialAccess);
+    if (info.write) {
+        state.writeStage = info.stage;
+        state.writeAccess = info.access;
+    } else {
+        state.readStages = info.stage;
+        state.readAccess = info.access;
+    }
+    state.layout = info.layout;
+
+    return state;
+}
+
+void RenderGraph::computeBarriers()
+{
+    std::vector<ResourceState> textureStates(_textures.size());
+    std::vector<ResourceState> bufferStates(_buffers.size());
+    std::vector<bool> touchedTextures(_textures.size(), false);
+    std::vector<bool> touchedBuffers(_buffers.size(), false);
+
+    // Union of the reads following compiledPassId until the next write or layout change, they all get covered by one barrier
+    const auto mergeFollowingReads = [this](const uint32 compiledPassId, const ResourceUse& use) {
+        AccessInfo merged = use.info;
+        for (uint32 nextPassId = compiledPassId + 1; nextPassId < _compiledPasses.size(); ++nextPassId) {
+            for (const ResourceUse& nextUse : _passes[_compiledPasses[nextPassId]].uses) {
+                if (nextUse.resource != use.resource || nextUse.isTexture != use.isTexture) {
+                    continue;
+                }
+
+                if (nextUse.info.write || (use.isTexture && nextUse.info.layout != merged.layout)) {
+                    return merged;
+                }
+
+                merged.stage |= nextUse.info.stage;
+                merged.access |= nextUse.info.access;
+            }
+        }
+        return merged;
+    };
+
+    for (uint32 compiledPassId = 0; compiledPassId < _compiledPasses.size(); ++compiledPassId) {
+        PassNode& pass = _passes[_compiledPasses[compiledPassId]];
+        pass.barriers.clear();
+        pass.finalBarriers.clear();
+
+        for (const ResourceUse& use : pass.uses) {
+            std::vector<bool>& touched = use.isTexture ? touchedTextures : touchedBuffers;
+            ResourceState& state = use.isTexture ? textureStates[use.resource] : bufferStates[use.resource];
+            if (!touched[use.resource]) {
+                state = makeInitialState(use.resource, use.isTexture, textureStates);
+                touched[use.resource] = true;
+            }
+
+            const AccessInfo& info = use.info;
+            const bool layoutChange = use.isTexture && info.layout != state.layout;
+
+            if (info.write || layoutChange) {
+                // WAW, WAR or layout transition
+                const auto [srcStage, srcAccess] = getPendingAccess(state);
+                const AccessInfo dst = info.write ? info : mergeFollowingReads(compiledPassId, use);
+                if (srcStage != VK_PIPELINE_STAGE_2_NONE || layoutChange) {
+                    pass.barriers.emplace_back(Barrier {
+                        .resource = use.resource,
+                        .isTexture = use.isTexture,
+                        .srcStage = srcStage,
+                        .srcAccess = srcAccess,
+                        .dstStage = dst.stage,
+                        .dstAccess = dst.access,
+                        // The previous content is discarded by write-only accesses, no need to preserve it
+                        .oldLayout = info.read ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED,
+                        .newLayout = info.layout,
+                    });
+                }
+
+                if (info.write) {
+                    state = ResourceState { .writeStage = info.stage, .writeAccess = info.access, .layout = info.layout };
+                } else {
+                    state.readStages = dst.stage;
+                    state.readAccess = dst.access;
+                    state.layout = info.layout;
+                }
+                continue;
+            }
+
+            // Read in the current layout, skipped if already covered by a merged barrier
+            if ((info.stage & ~state.readStages) == 0 && (info.access & ~state.readAccess) == 0) {
+                continue;
+            }
+
+            if (state.writeStage == VK_PIPELINE_STAGE_2_NONE) {
+                // Nothing to wait for
+                state.readStages |= info.stage;
+                state.readAccess |= info.access;
+                continue;
+            }
+
+            const AccessInfo dst = mergeFollowingReads(compiledPassId, use);
+            pass.barriers.emplace_back(Barrier {
+                .resource = use.resource,
+                .isTexture = use.isTexture,
+                .srcStage = state.writeStage,
+                .srcAccess = state.writeAccess,
+                .dstStage = dst.stage,
+                .dstAccess = dst.access,
+                .oldLayout = state.layout,
+                .newLayout = state.layout,
+            });
+            state.readStages |= dst.stage;
+            state.readAccess |= dst.access;
+        }
+    }
+
+    // Transition the exported resources to their final state after their last use
+    const auto addFinalBarrier = [this](const ResourceNode& node, const uint32 resource, const bool isTexture, const ResourceState& state) {
+        if (node.transient || node.importInfo.finalAccess == RGAccess::None) {
+            return;
+        }
+
+        const AccessInfo info = getAccessInfo(node.importInfo.finalAccess);
+        const bool layoutChange = isTexture && info.layout != state.layout;
+        if (!layoutChange && info.stage == VK_PIPELINE_STAGE_2_NONE) {
+            return;
+        }
+
+        const auto [srcStage, srcAccess] = getPendingAccess(state);
+        _passes[_compiledPasses[node.lastPass]].finalBarriers.emplace_back(Barrier {
+            .resource = resource,
+            .isTexture = isTexture,
+            .srcStage = srcStage,
+            .srcAccess = srcAccess,
+            .dstStage = info.stage,
+            .dstAccess = info.access,
+            .oldLayout = state.layout,
+            .newLayout = isTexture ? info.layout : state.layout,
+        });
+    };
+
+    for (uint32 i = 0; i < _textures.size(); ++i) {
+        if (touchedTextures[i]) {
+            addFinalBarrier(_textures[i], i, true, textureStates[i]);
+        }
+    }
+    for (uint32 i = 0; i < _buffers.size(); ++i) {
+        if (touchedBuffers[i]) {
+            addFinalBarrier(_buffers[i], i, false, bufferStates[i]);
+        }
+    }
+}
+
+void RenderGraph::insertBarriers(VkCommandBuffer commandBuffer, const uint32 frameInFlightId, const std::vector<Barrier>& barriers) const
+{
+    if (barriers.empty()) {
+        return;
+    }
+
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+    std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+    for (const Barrier& barrier : barriers) {
+        if (barrier.isTexture) {
+            const PhysicalTexture& texture = _physicalTextures[frameInFlightId][barrier.resource];
+            NH3D_ASSERT(texture.image != VK_NULL_HANDLE, "Render graph texture used without physical texture bound");
+
+            imageBarriers.emplace_back(VkImageMemoryBarrier2 {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask = barrier.srcStage,
+                .srcAccessMask = barrier.srcAccess,
+                .dstStageMask = barrier.dstStage,
+                .dstAccessMask = barrier.dstAccess,
+                .oldLayout = barrier.oldLayout,
+                .newLayout = barrier.newLayout,
+                .image = texture.image,
+                .subresourceRange = {
+                    .aspectMask = texture.aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = VK_REMAINING_MIP_LEVELS,
+                    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+                },
+            });
+        } else {
+            const PhysicalBuffer& buffer = _physicalBuffers[frameInFlightId][barrier.resource];
+            NH3D_ASSERT(buffer.buffer != VK_NULL_HANDLE, "Render graph buffer used without physical buffer bound");
+
+            bufferBarriers.emplace_back(VkBufferMemoryBarrier2 {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                .srcStageMask = barrier.srcStage,
+                .srcAccessMask = barrier.srcAccess,
+                .dstStageMask = barrier.dstStage,
+                .dstAccessMask = barrier.dstAccess,
+                .buffer = buffer.buffer,
+                .size = VK_WHOLE_SIZE,
+            });
+        }
+    }
+
+    const VkDependencyInfo dependencyInfo {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .bufferMemoryBarrierCount = static_cast<uint32>(bufferBarriers.size()),
+        .pBufferMemoryBarriers = bufferBarriers.data(),
+        .imageMemoryBarrierCount = static_cast<uint32>(imageBarriers.size()),
+        .pImageMemoryBarriers = imageBarriers.data(),
+    };
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+}
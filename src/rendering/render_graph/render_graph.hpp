@@ -0,0 +1,243 @@
+#pragma once
+
+#include <functional>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <rendering/core/buffer.hpp>
+#include <rendering/core/frame_resource.hpp>
+#include <rendering/core/handle.hpp>
+#include <rendering/core/texture.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace NH3D {
+
+// Logical resources, only meaningful for the graph that declared them
+struct RGTexture {
+    uint32 id = NH3D_MAX_T(uint32);
+};
+
+struct RGBuffer {
+    uint32 id = NH3D_MAX_T(uint32);
+};
+
+// How a pass uses a resource, write-only accesses are assumed to overwrite the previous content entirely
+enum class RGAccess : uint32 {
+    None,
+    TransferRead,
+    TransferWrite,
+    IndirectRead,
+    VertexStorageRead,
+    FragmentSampledRead,
+    ComputeSampledRead,
+    ComputeStorageRead,
+    ComputeStorageWrite,
+    ComputeStorageReadWrite,
+    ColorAttachmentWrite,
+    ColorAttachmentReadWrite,
+    DepthAttachmentWrite,
+    DepthAttachmentReadWrite,
+    DepthAttachmentRead,
+    HostRead,
+    Present,
+};
+
+// Passes declare the resources they read and write, the graph then:
+// - culls the passes that don't contribute to an output of the graph (exported resource or pass with side effects)
+// - computes the barriers between passes, consecutive reads of a resource are merged into a single barrier
+// - computes the lifetime of the transient textures and groups the ones that never overlap so they can share memory
+// Passes are executed in declaration order, the graph doesn't reorder them
+// Physical resources are provided by the RHI, per frame in flight, after compilation
+class RenderGraph {
+    NH3D_NO_COPY_MOVE(RenderGraph)
+public:
+    static constexpr uint32 MaxPasses = 32;
+
+    static constexpr uint32 InvalidAliasingGroup = NH3D_MAX_T(uint32);
+
+    using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, const RenderGraph& graph, const uint32 frameInFlightId)>;
+
+    struct TextureAccess {
+        RGTexture texture;
+        RGAccess access;
+    };
+
+    struct BufferAccess {
+        RGBuffer buffer;
+        RGAccess access;
+    };
+
+    struct PassInfo {
+        const char* name;
+        ArrayWrapper<TextureAccess> textures;
+        ArrayWrapper<BufferAccess> buffers;
+        RecordFunction record;
+        bool sideEffects = false; // never culled
+    };
+
+    struct TransientTextureInfo {
+        VkFormat format;
+        VkExtent2D extent;
+        uint32 mipLevels = 1; // barriers always cover every mip, transitions between mips are up to the pass
+    };
+
+    // State of an imported resource before the first and after the last pass using it
+    struct ImportInfo {
+        RGAccess initialAccess = RGAccess::None;
+        RGAccess finalAccess = RGAccess::None; // anything but None makes the resource an output of the graph
+    };
+
+    struct TransientTexture {
+        RGTexture texture;
+        TransientTextureInfo info;
+        VkImageUsageFlags usage; // derived from the accesses
+        uint32 aliasingGroup;
+    };
+
+    struct Barrier {
+        uint32 resource;
+        bool isTexture;
+        VkPipelineStageFlags2 srcStage;
+        VkAccessFlags2 srcAccess;
+        VkPipelineStageFlags2 dstStage;
+        VkAccessFlags2 dstAccess;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+    };
+
+    struct PhysicalTexture {
+        Handle<Texture> handle = InvalidHandle<Texture>;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    };
+
+    struct PhysicalBuffer {
+        Handle<Buffer> handle = InvalidHandle<Buffer>;
+        VkBuffer buffer = VK_NULL_HANDLE;
+    };
+
+public:
+    RenderGraph() = delete;
+
+    // The physical resources are bound per frame in flight
+    explicit RenderGraph(const uint32 framesInFlight);
+
+    // Transient textures only live for the duration of the frame, their content is undefined at the first use
+    [[nodiscard]] RGTexture createTexture(const char* name, const TransientTextureInfo& info);
+
+    [[nodiscard]] RGTexture importTexture(const char* name, const ImportInfo& info);
+
+    [[nodiscard]] RGBuffer importBuffer(const char* name, const ImportInfo& info);
+
+    void addPass(const PassInfo& info);
+
+    void compile();
+
+    [[nodiscard]] inline uint32 getCompiledPassCount() const { return static_cast<uint32>(_compiledPasses.size()); }
+
+    [[nodiscard]] const std::string& getPassName(const uint32 compiledPassId) const;
+
+    [[nodiscard]] const std::vector<Barrier>& getPassBarriers(const uint32 compiledPassId) const;
+
+    // Transitions to the final state of the exported resources, recorded after the pass
+    [[nodiscard]] const std::vector<Barrier>& getPassFinalBarriers(const uint32 compiledPassId) const;
+
+    // Transient textures used by at least one pass that wasn't culled
+    [[nodiscard]] inline const std::vector<TransientTexture>& getTransientTextures() const { return _transientTextures; }
+
+    [[nodiscard]] inline uint32 getAliasingGroupCount() const { return _aliasingGroupCount; }
+
+    void bindTexture(const uint32 frameInFlightId, const RGTexture texture, const PhysicalTexture& physicalTexture);
+
+    void bindBuffer(const uint32 frameInFlightId, const RGBuffer buffer, const PhysicalBuffer& physicalBuffer);
+
+    [[nodiscard]] Handle<Texture> getTexture(const uint32 frameInFlightId, const RGTexture texture) const;
+
+    [[nodiscard]] Handle<Buffer> getBuffer(const uint32 frameInFlightId, const RGBuffer buffer) const;
+
+    // Records the barriers and the pass, doesn't modify the graph so passes can be recorded in parallel
+    void recordPass(const uint32 compiledPassId, VkCommandBuffer commandBuffer, const uint32 frameInFlightId) const;
+
+private:
+    struct AccessInfo {
+        VkPipelineStageFlags2 stage;
+        VkAccessFlags2 access;
+        VkImageLayout layout;
+        VkImageUsageFlags usage;
+        bool read;
+        bool write;
+    };
+
+    struct ResourceUse {
+        uint32 resource;
+        bool isTexture;
+        AccessInfo info;
+    };
+
+    struct PassNode {
+        std::string name;
+        std::vector<ResourceUse> uses; // one entry per resource, multiple accesses are merged
+        RecordFunction record;
+        bool sideEffects;
+        std::vector<Barrier> barriers;
+        std::vector<Barrier> finalBarriers;
+    };
+
+    struct ResourceNode {
+        std::string name;
+        bool transient;
+        TransientTextureInfo transientInfo;
+        ImportInfo importInfo;
+        VkImageUsageFlags usage = 0;
+        uint32 firstPass = NH3D_MAX_T(uint32); // compiled pass ids
+        uint32 lastPass = 0;
+        uint32 aliasingGroup = InvalidAliasingGroup;
+        uint32 aliasPredecessor = NH3D_MAX_T(uint32); // previous texture of the aliasing group
+    };
+
+    struct ResourceState {
+        VkPipelineStageFlags2 writeStage = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 writeAccess = VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2 readStages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 readAccess = VK_ACCESS_2_NONE;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+
+private:
+    [[nodiscard]] static AccessInfo getAccessInfo(const RGAccess access);
+
+    static void addUse(std::vector<ResourceUse>& uses, const uint32 resource, const bool isTexture, const AccessInfo& info);
+
+    void cullPasses();
+
+    void computeLifetimes();
+
+    void assignAliasingGroups();
+
+    void computeBarriers();
+
+    // Stages and writes the next write has to wait for, the reads since the last write already waited for it
+    [[nodiscard]] static std::pair<VkPipelineStageFlags2, VkAccessFlags2> getPendingAccess(const ResourceState& state);
+
+    [[nodiscard]] ResourceState makeInitialState(
+        const uint32 resource, const bool isTexture, const std::vector<ResourceState>& textureStates) const;
+
+    void insertBarriers(VkCommandBuffer commandBuffer, const uint32 frameInFlightId, const std::vector<Barrier>& barriers) const;
+
+private:
+    std::vector<PassNode> _passes;
+    std::vector<ResourceNode> _textures;
+    std::vector<ResourceNode> _buffers;
+
+    std::vector<uint32> _compiledPasses; // indices in _passes, in execution order
+    std::vector<TransientTexture> _transientTextures;
+    uint32 _aliasingGroupCount = 0;
+    bool _compiled = false;
+
+    FrameResource<std::vector<PhysicalTexture>> _physicalTextures;
+    FrameResource<std::vector<PhysicalBuffer>> _physicalBuffers;
+};
+
+}
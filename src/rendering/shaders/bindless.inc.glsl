@@ -0,0 +1,18 @@
+#ifndef BINDLESS_INC_GLSL
+#define BINDLESS_INC_GLSL
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Global bindless table, see VulkanBindlessTable. The textures are indexed by their handle (Material::albedoTexture...)
+// BINDLESS_SET is the set the including shader gets the table bound to
+#ifndef BINDLESS_SET
+#error "BINDLESS_SET must be defined before including bindless.inc.glsl"
+#endif
+
+#define LINEAR_SAMPLER 0 // first sampler of the table
+
+layout(set = BINDLESS_SET, binding = 0) uniform sampler bindlessSamplers[];
+layout(set = BINDLESS_SET, binding = 1) uniform texture2D bindlessTextures[];
+// binding = 2: storage images, to be declared with their format by the shaders that write them
+
+#endif
@@ -99,4 +99,52 @@ AABB transformAABB(mat4 transform, AABB objectAABB) {
     return AABB(nmin, nmax);
 }
 
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
+// The positions stay normalized, the draw record matrix maps them back to the AABB of the mesh
+VertexInput decodeVertex(QuantizedVertexInput vertex)
+{
+    VertexInput decoded;
+    decoded.position = vec3(unpackUnorm2x16(vertex.position.x), unpackUnorm2x16(vertex.position.y).x);
+    decoded.normal = octDecode(unpackSnorm2x16(vertex.normal));
+    decoded.uv = unpackHalf2x16(vertex.uv);
+    return decoded;
+}
+
+// Same vertex, whatever its format, gl_VertexIndex equivalent
+VertexInput fetchVertex(VertexBuffer vertices, QuantizedVertexBuffer quantizedVertices, uint vertexFormat, uint index)
+{
+    if (vertexFormat == VERTEX_FORMAT_QUANTIZED) {
+        return decodeVertex(quantizedVertices.vertices[index]);
+    }
+    return vertices.vertices[index];
+}
+
+// Cofactor matrix: the inverse transpose scaled by the determinant, fine for normals since they are normalized afterwards
+// Handles the non-uniform scale of the dequantization, and even a zero scale on one axis
+mat3 getNormalMatrix(mat3 m)
+{
+    return mat3(cross(m[1], m[2]), cross(m[2], m[0]), cross(m[0], m[1]));
+}
+
+// Reference: https://johnwhite3d.blogspot.com/2017/10/signed-octahedron-normal-encoding.html
+vec3 signedOctEncode(vec3 n)
+{
+    vec3 normal;
+    n /= (abs(n.x) + abs(n.y) + abs(n.z));
+
+    normal.y = n.y * 0.5 + 0.5;
+    normal.x = n.x * 0.5 + normal.y;
+    normal.y = n.x * -0.5 + normal.y;
+
+    normal.z = step(0.0, n.z);
+    return normal;
+}
+
 #endif // COMMON_INC_GLSL
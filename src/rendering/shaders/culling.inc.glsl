@@ -10,19 +10,121 @@ struct FrustumPlanes {
 
 struct CullingParameters {
     mat4 viewMatrix;
+    vec4 projection; // P[0][0], P[1][1], P[2][2], P[3][2]
     FrustumPlanes frustum;
-    uint objectCount;
+    uint objectCount; // slots, or entries of the object list
+    uint flags;
+    uint depthPyramidLevelCount;
+    float lodErrorScale; // 0 forces LOD 0
 };
 
+// Must match VulkanGPUScene, the late phase writes its draws and instances after the early ones
+// Within a phase, the draws of the meshes with 16 bit indices come first
+#define MAX_OBJECTS 640000
+#define MAX_MESHES 4096
+#define MAX_MESHLET_DRAWS 262144
+#define MAX_LODS 5
+#define MAX_INSTANCES (MAX_LODS * MAX_OBJECTS)
+
+// Instances of the objects drawn per meshlet, after the per-mesh instances of both phases
+#define CLUSTER_INSTANCES_OFFSET (2 * MAX_INSTANCES)
+
+// Then one instance per meshlet draw, so that the instance of a pixel in the visibility buffer leads back to its meshlet
+#define MESHLET_INSTANCES_OFFSET (CLUSTER_INSTANCES_OFFSET + 2 * MAX_OBJECTS)
+
+// The visibility buffer packs the instance and the triangle of the draw, no draw has more triangles than a meshlet
+#define VISIBILITY_TRIANGLE_BITS 7
+#define VISIBILITY_INVALID_ID 0xFFFFFFFFu
+
+// The instances of each per-mesh draw are grouped by material bin, see material_binning.comp
+// The bindless index of the albedo texture is the key, the textures sharing a bin still interleave
+#define MATERIAL_BINS 32
+#define DRAW_LISTS 4
+
+// Lower bound of maxComputeWorkGroupCount[0], the cluster culling loops over the remaining objects
+#define MAX_CLUSTER_WORKGROUPS 65535
+
+// Reset at the beginning of the frame, read back on the CPU for stats
+struct CullingCounters {
+    uint drawCounts[2]; // drawn instances, early and late
+    uint frustumCulledCount;
+    uint occlusionCulledCount;
+    uint meshletDrawCount;
+    uint clusterCulledCount;
+    uint lodDrawCounts[MAX_LODS];
+};
+
+#define OBJECT_VISIBLE_BIT 1
+
+// CullingParameters::flags
+#define CULLING_OCCLUSION_BIT 1
+#define CULLING_OBJECT_LIST_BIT 2
+#define CULLING_MATERIAL_BINNING_BIT 4
+
 struct RenderData {
-    VertexBuffer vertexBuffer;
-    IndexBuffer indexBuffer;
     Material material;
+    uint flags; // 0 for dead GPU scene slots
+    uint meshSlot;
+};
+
+// The geometry of a LOD in the geometry arena, see VulkanGeometryArena
+struct MeshLOD {
     uint indexCount;
+    uint firstIndex;
+    uint firstMeshlet;
+    uint meshletCount; // objects whose LOD has a single meshlet are drawn per mesh
+    uint firstInstance;
+    float error; // object space
 };
 
-// glsl doesn't allow for unsized arrays as function parameters, macro workaround
-#define isVisibleFlagSet(flags, index) ((flags[index >> 5] & (1 << (index & 31))) != 0)
+struct MeshDraw {
+    int vertexOffset;
+    uint instanceCapacity;
+    uint lodCount;
+    uint indexType; // each index width has its own draws
+    uint vertexFormat;
+    vec3 positionOffset; // dequantization of the positions, identity for full vertices
+    vec3 positionScale;
+    MeshLOD lods[MAX_LODS];
+};
+
+// See Meshlet in meshlet.hpp, firstIndex is relative to the mesh
+struct Meshlet {
+    vec3 center;
+    float radius;
+    vec3 coneAxis;
+    float coneCutoff;
+    uint firstIndex;
+    uint triangleCount;
+};
+
+struct VkDrawIndexedIndirectCommand {
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+struct VkDispatchIndirectCommand {
+    uint x;
+    uint y;
+    uint z;
+};
+
+layout(buffer_reference, scalar) readonly buffer MeshletBuffer
+{
+    Meshlet meshlets[];
+};
+
+// One per-mesh draw per mesh slot and LOD in each draw list
+uint getDrawIndex(uint latePhase, uint indexType, uint meshSlot, uint lod) {
+    return ((latePhase * 2 + indexType) * MAX_MESHES + meshSlot) * MAX_LODS + lod;
+}
+
+uint getMaterialBin(Material material) {
+    return material.albedoTexture % MATERIAL_BINS;
+}
 
 bool inFrustum(AABB viewAABB, CullingParameters cullingParams) {
     // Near
@@ -55,4 +157,29 @@ bool inFrustum(AABB viewAABB, CullingParameters cullingParams) {
     return true;
 }
 
+// Coarsest LOD whose error stays below the threshold once projected, the error is measured from the closest point of the AABB
+uint selectLOD(MeshDraw meshDraw, AABB viewAABB, float scale, float lodErrorScale) {
+    float distance = length(clamp(vec3(0.0), viewAABB.min, viewAABB.max));
+
+    uint lod = 0;
+    while (lod + 1 < meshDraw.lodCount && meshDraw.lods[lod + 1].error * scale * lodErrorScale <= distance) {
+        ++lod;
+    }
+
+    return lod;
+}
+
+bool sphereInFrustum(vec3 center, float radius, FrustumPlanes frustum) {
+    // Near
+    if (center.z + radius < 0.0) {
+        return false;
+    }
+
+    // Same planes as above, the distances have to be scaled by the length of the unnormalized normals
+    return dot(center.xz, frustum.left) >= -radius * length(frustum.left)
+        && dot(center.xz, frustum.right) >= -radius * length(frustum.right)
+        && dot(center.yz, frustum.bottom) >= -radius * length(frustum.bottom)
+        && dot(center.yz, frustum.top) >= -radius * length(frustum.top);
+}
+
 #endif // CULLING_INC_GLSL
@@ -0,0 +1,238 @@
+#ifndef CULLING_PASS_INC_GLSL
+#define CULLING_PASS_INC_GLSL
+
+// Shared by both culling phases, LATE_CULLING selects the phase:
+// - early: objects visible last frame and inside the frustum
+// - late: every object, tested against the depth pyramid built from the early draws, only the newly visible ones are drawn
+
+#include "structs.inc.glsl"
+#include "culling.inc.glsl"
+#include "common.inc.glsl"
+
+// Tuned per device, see WorkgroupTuner
+layout(local_size_x_id = 0) in;
+
+// Workgroup size of the material binning pass, its scatter dispatches are counted here
+layout(constant_id = 3) const uint MATERIAL_BINNING_WORKGROUP_SIZE = 64;
+
+layout(set = 0, binding = 0, scalar) readonly buffer RenderDataBuffer {
+    RenderData objects[];
+} renderData;
+
+// Separate buffer for debugging purposes
+layout(set = 0, binding = 1, scalar) readonly buffer AABBBuffer {
+    AABB aabb[];
+} objectAABBs;
+
+layout(set = 0, binding = 2, scalar) readonly buffer TransformBuffer {
+    TransformData transforms[];
+} transformBuffer;
+
+layout(set = 0, binding = 3, scalar) readonly buffer MeshTableBuffer {
+    MeshDraw draws[];
+} meshTable;
+
+layout(set = 1, binding = 0, scalar) buffer CullingCountersBuffer {
+    CullingCounters counters;
+} cullingCounters;
+
+// Persistent across frames, 1 if the object was visible at the end of the last frame
+layout(set = 1, binding = 1, scalar) buffer VisibilityBuffer {
+    uint visible[];
+} visibility;
+
+// Slots that survived the BVH culling on the CPU, only read with CULLING_OBJECT_LIST_BIT
+layout(set = 1, binding = 2, scalar) readonly buffer ObjectListBuffer {
+    uint slots[];
+} objectList;
+
+layout(set = 2, binding = 0, scalar) buffer DrawIndirectCommandBuffer {
+    VkDrawIndexedIndirectCommand commands[];
+} drawIndirectCommands;
+
+// One workgroup per object drawn per meshlet, zeroed at the beginning of the frame
+layout(set = 2, binding = 2, scalar) buffer ClusterDispatchBuffer {
+    VkDispatchIndirectCommand dispatches[2];
+    uint objectCounts[2];
+} clusterDispatch;
+
+// Counted here, turned into instance offsets and filled by the material binning pass
+layout(set = 2, binding = 3, scalar) buffer MaterialBinBuffer {
+    uint stagedCounts[2]; // zeroed at the beginning of the frame, with the scatter dispatches and the bins
+    VkDispatchIndirectCommand scatterDispatches[2];
+    uint binInstances[DRAW_LISTS * MAX_MESHES * MAX_LODS * MATERIAL_BINS];
+    uint stagedObjects[]; // MAX_OBJECTS per phase
+} materialBins;
+
+// One instanced draw per mesh LOD, zeroed at the beginning of the frame
+// Indexed by object, the instances find their record through the instance indices
+layout(set = 3, binding = 0, scalar) buffer DrawRecordBuffer {
+    DrawRecord drawRecords[];
+} drawRecordBuffer;
+
+layout(set = 3, binding = 1, scalar) buffer InstanceIndexBuffer {
+    uint objectIndices[];
+} instanceIndexBuffer;
+
+#if LATE_CULLING
+layout(set = 4, binding = 0) uniform texture2D depthPyramid;
+#endif
+
+layout(push_constant) uniform CullingParametersData
+{
+    CullingParameters parameters;
+} cullingData;
+
+#if LATE_CULLING
+bool isOccluded(AABB viewAABB)
+{
+    vec4 projection = cullingData.parameters.projection;
+
+    vec2 ndcMin = vec2(1.0);
+    vec2 ndcMax = vec2(-1.0);
+    float nearestDepth = 1.0;
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = vec3((i & 1) == 0 ? viewAABB.min.x : viewAABB.max.x, (i & 2) == 0 ? viewAABB.min.y : viewAABB.max.y,
+            (i & 4) == 0 ? viewAABB.min.z : viewAABB.max.z);
+
+        // Symmetric left-handed perspective, w is the view depth
+        vec4 clip = vec4(corner.x * projection.x, corner.y * projection.y, corner.z * projection.z + projection.w, corner.z);
+
+        // Crossing the near plane, can't be projected reliably
+        if (clip.z < 0.0) {
+            return false;
+        }
+
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc.xy);
+        ndcMax = max(ndcMax, ndc.xy);
+        nearestDepth = min(nearestDepth, ndc.z);
+    }
+
+    ivec2 size = textureSize(depthPyramid, 0);
+    ivec2 pixelMin = clamp(ivec2((ndcMin * 0.5 + 0.5) * size), ivec2(0), size - 1);
+    ivec2 pixelMax = clamp(ivec2((ndcMax * 0.5 + 0.5) * size), ivec2(0), size - 1);
+
+    // Coarsest level where the rectangle spans at most 2x2 texels, the last texel of odd levels covers the leftover pixels
+    int level = 0;
+    while (level < int(cullingData.parameters.depthPyramidLevelCount) - 1
+        && any(greaterThan((pixelMax >> level) - (pixelMin >> level), ivec2(1)))) {
+        ++level;
+    }
+
+    ivec2 levelSize = textureSize(depthPyramid, level);
+    ivec2 texelMin = min(pixelMin >> level, levelSize - 1);
+    ivec2 texelMax = min(pixelMax >> level, levelSize - 1);
+
+    float farthestDepth = max(
+        max(texelFetch(depthPyramid, texelMin, level).x, texelFetch(depthPyramid, ivec2(texelMax.x, texelMin.y), level).x),
+        max(texelFetch(depthPyramid, ivec2(texelMin.x, texelMax.y), level).x, texelFetch(depthPyramid, texelMax, level).x));
+
+    return nearestDepth > farthestDepth;
+}
+#endif
+
+void main()
+{
+    if (gl_GlobalInvocationID.x >= cullingData.parameters.objectCount) {
+        return;
+    }
+
+    uint index = (cullingData.parameters.flags & CULLING_OBJECT_LIST_BIT) != 0 ? objectList.slots[gl_GlobalInvocationID.x]
+                                                                               : gl_GlobalInvocationID.x;
+
+    RenderData obj = renderData.objects[index];
+
+    if ((obj.flags & OBJECT_VISIBLE_BIT) == 0) {
+        return;
+    }
+
+    // Without occlusion culling everything goes through the early phase
+    bool occlusionCulling = (cullingData.parameters.flags & CULLING_OCCLUSION_BIT) != 0;
+    bool drawnEarly = !occlusionCulling || visibility.visible[index] != 0;
+#if !LATE_CULLING
+    if (!drawnEarly) {
+        return;
+    }
+#endif
+
+    mat4 viewSpaceTransform = cullingData.parameters.viewMatrix * computeTransform(transformBuffer.transforms[index]);
+
+    AABB viewAABB = transformAABB(viewSpaceTransform, objectAABBs.aabb[index]);
+
+    bool visible = inFrustum(viewAABB, cullingData.parameters);
+#if LATE_CULLING
+    // Early drawn objects are tested again to update their visibility for the next frame
+    if (!visible) {
+        atomicAdd(cullingCounters.counters.frustumCulledCount, 1);
+    } else if (occlusionCulling && isOccluded(viewAABB)) {
+        atomicAdd(cullingCounters.counters.occlusionCulledCount, 1);
+        visible = false;
+    }
+    visibility.visible[index] = visible ? 1 : 0;
+
+    if (drawnEarly) {
+        return;
+    }
+#endif
+
+    if (visible) {
+        atomicAdd(cullingCounters.counters.drawCounts[LATE_CULLING], 1);
+
+        MeshDraw meshDraw = meshTable.draws[obj.meshSlot];
+        // Largest axis scale of the view space transform, the errors are in object space
+        float scale = max(length(viewSpaceTransform[0].xyz), max(length(viewSpaceTransform[1].xyz), length(viewSpaceTransform[2].xyz)));
+        float lodErrorScale = cullingData.parameters.lodErrorScale;
+        uint lod = lodErrorScale > 0.0 ? selectLOD(meshDraw, viewAABB, scale, lodErrorScale) : 0;
+        MeshLOD meshLOD = meshDraw.lods[lod];
+        atomicAdd(cullingCounters.counters.lodDrawCounts[lod], 1);
+
+        if (meshLOD.meshletCount > 1) {
+            // The meshlets are culled and drawn by the cluster culling pass, the object index is its instance
+            uint clusterObject = atomicAdd(clusterDispatch.objectCounts[LATE_CULLING], 1);
+            if (clusterObject < MAX_CLUSTER_WORKGROUPS) {
+                atomicAdd(clusterDispatch.dispatches[LATE_CULLING].x, 1);
+                clusterDispatch.dispatches[LATE_CULLING].y = 1;
+                clusterDispatch.dispatches[LATE_CULLING].z = 1;
+            }
+            instanceIndexBuffer.objectIndices[CLUSTER_INSTANCES_OFFSET + LATE_CULLING * MAX_OBJECTS + clusterObject] = index;
+        } else {
+            // Every instance of the mesh LOD writes the same values, only the instance count needs to be atomic
+            uint drawIndex = getDrawIndex(LATE_CULLING, meshDraw.indexType, obj.meshSlot, lod);
+            uint firstInstance = LATE_CULLING * MAX_INSTANCES + meshLOD.firstInstance;
+            uint instance = atomicAdd(drawIndirectCommands.commands[drawIndex].instanceCount, 1);
+            drawIndirectCommands.commands[drawIndex].indexCount = meshLOD.indexCount;
+            drawIndirectCommands.commands[drawIndex].firstIndex = meshLOD.firstIndex;
+            drawIndirectCommands.commands[drawIndex].vertexOffset = meshDraw.vertexOffset;
+            drawIndirectCommands.commands[drawIndex].firstInstance = firstInstance;
+
+            if ((cullingData.parameters.flags & CULLING_MATERIAL_BINNING_BIT) != 0) {
+                // The instance is only known once every bin of the draw is counted
+                atomicAdd(materialBins.binInstances[drawIndex * MATERIAL_BINS + getMaterialBin(obj.material)], 1);
+                uint stagedObject = atomicAdd(materialBins.stagedCounts[LATE_CULLING], 1);
+                if (stagedObject % MATERIAL_BINNING_WORKGROUP_SIZE == 0) {
+                    atomicAdd(materialBins.scatterDispatches[LATE_CULLING].x, 1);
+                    materialBins.scatterDispatches[LATE_CULLING].y = 1;
+                    materialBins.scatterDispatches[LATE_CULLING].z = 1;
+                }
+                materialBins.stagedObjects[LATE_CULLING * MAX_OBJECTS + stagedObject] = index;
+            } else {
+                instanceIndexBuffer.objectIndices[firstInstance + instance] = index;
+            }
+        }
+
+        drawRecordBuffer.drawRecords[index].material = obj.material;
+        drawRecordBuffer.drawRecords[index].lod = lod;
+        drawRecordBuffer.drawRecords[index].vertexFormat = meshDraw.vertexFormat;
+
+        // Quantized positions are normalized in the AABB of the mesh, the vertex shader only has to unpack them
+        mat4x3 modelViewMatrix;
+        modelViewMatrix[0] = vec3(viewSpaceTransform[0]) * meshDraw.positionScale.x;
+        modelViewMatrix[1] = vec3(viewSpaceTransform[1]) * meshDraw.positionScale.y;
+        modelViewMatrix[2] = vec3(viewSpaceTransform[2]) * meshDraw.positionScale.z;
+        modelViewMatrix[3] = vec3(viewSpaceTransform * vec4(meshDraw.positionOffset, 1.0));
+        drawRecordBuffer.drawRecords[index].modelViewMatrix = modelViewMatrix;
+    }
+}
+
+#endif // CULLING_PASS_INC_GLSL
@@ -1,15 +1,21 @@
 #version 460
 
-#include "structs.inc.glsl"
+#include "common.inc.glsl"
 
 layout(set = 1, binding = 0, scalar) readonly buffer DrawRecordBuffer {
     DrawRecord drawRecords[];
 };
 
-layout(push_constant) uniform ProjectionMatrix
+layout(set = 1, binding = 1, scalar) readonly buffer InstanceIndexBuffer {
+    uint objectIndices[];
+};
+
+layout(push_constant) uniform GBufferParameters
 {
-    mat4 matrix;
-} projection;
+    mat4 projection;
+    VertexBuffer vertices; // geometry arena, gl_VertexIndex already includes the vertex offset of the mesh
+    QuantizedVertexBuffer quantizedVertices; // same arena, the vertex offsets of quantized meshes count 16 byte vertices
+} parameters;
 
 layout(location = 0) out vec3 outNormal;
 layout(location = 1) out vec2 outUV;
@@ -17,13 +23,14 @@ layout(location = 2) out flat Material outMaterial; // TODO: benchmark bindless
 
 void main()
 {
-    DrawRecord drawRecord = drawRecords[gl_DrawID];
+    // One draw per mesh, records are indexed by object, see culling_pass.inc.glsl
+    DrawRecord drawRecord = drawRecords[objectIndices[gl_InstanceIndex]];
 
-    uint index = drawRecord.indexBuffer.indices[gl_VertexIndex];
-    vec3 viewPosition = drawRecord.modelViewMatrix * vec4(drawRecord.vertexBuffer.vertices[index].position, 1.0);
-    gl_Position = projection.matrix * vec4(viewPosition, 1.0);
+    VertexInput vertex = fetchVertex(parameters.vertices, parameters.quantizedVertices, drawRecord.vertexFormat, gl_VertexIndex);
+    vec3 viewPosition = drawRecord.modelViewMatrix * vec4(vertex.position, 1.0);
+    gl_Position = parameters.projection * vec4(viewPosition, 1.0);
 
-    outNormal = drawRecord.vertexBuffer.vertices[index].normal;
-    outUV = drawRecord.vertexBuffer.vertices[index].uv;
+    outNormal = getNormalMatrix(mat3(drawRecord.modelViewMatrix)) * vertex.normal; // view space, like the lights
+    outUV = vertex.uv;
     outMaterial = drawRecord.material;
 }
@@ -0,0 +1,47 @@
+#ifndef LIGHTS_INC_GLSL
+#define LIGHTS_INC_GLSL
+
+#extension GL_EXT_scalar_block_layout : require
+
+// Froxel grid of the clustered shading, must match the constants of VulkanRHI
+// The screen is split in tiles, the view depth in exponential slices so the clusters stay roughly cubic
+#define LIGHT_CLUSTERS_X 16
+#define LIGHT_CLUSTERS_Y 9
+#define LIGHT_CLUSTERS_Z 24
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTERS_X * LIGHT_CLUSTERS_Y * LIGHT_CLUSTERS_Z)
+// The extra lights of a cluster are dropped
+#define MAX_LIGHTS_PER_CLUSTER 256
+
+// LightType
+#define LIGHT_TYPE_POINT 0
+#define LIGHT_TYPE_SPOT 1
+
+// See VulkanRHI::GPULight, gathered from the LightComponents every frame
+struct Light {
+    vec3 position; // view space
+    float range;
+    vec3 color; // premultiplied by the intensity
+    uint type;
+    vec3 direction; // view space, spot only
+    float cosOuterAngle;
+    float cosInnerAngle;
+};
+
+uint getLightCluster(uvec3 coords)
+{
+    return (coords.z * LIGHT_CLUSTERS_Y + coords.y) * LIGHT_CLUSTERS_X + coords.x;
+}
+
+// slice = log(depth / near) / log(far / near) * LIGHT_CLUSTERS_Z
+vec2 getLightSliceParameters(float near, float far)
+{
+    float scale = LIGHT_CLUSTERS_Z / log(far / near);
+    return vec2(scale, -log(near) * scale);
+}
+
+uint getLightSlice(float viewDepth, vec2 sliceParameters)
+{
+    return uint(clamp(log(viewDepth) * sliceParameters.x + sliceParameters.y, 0.0, LIGHT_CLUSTERS_Z - 1.0));
+}
+
+#endif // LIGHTS_INC_GLSL
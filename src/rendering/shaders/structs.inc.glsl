@@ -17,20 +17,34 @@ layout(buffer_reference, scalar) readonly buffer VertexBuffer
     VertexInput vertices[];
 };
 
-layout(buffer_reference, scalar) readonly buffer IndexBuffer
+// See QuantizedVertexData in quantized_vertex.hpp
+struct QuantizedVertexInput
 {
-    uint16_t indices[];
+    uvec2 position; // unorm16 x, y, z and padding
+    uint normal; // snorm16 octahedral encoding
+    uint uv; // half floats
 };
 
+layout(buffer_reference, scalar) readonly buffer QuantizedVertexBuffer
+{
+    QuantizedVertexInput vertices[];
+};
+
+// Geometry::VertexFormat and Geometry::IndexType
+#define VERTEX_FORMAT_FULL 0
+#define VERTEX_FORMAT_QUANTIZED 1
+#define INDEX_TYPE_UINT16 0
+#define INDEX_TYPE_UINT32 1
+
 struct Material {
     uint albedoTexture;
 };
 
 struct DrawRecord {
-    VertexBuffer vertexBuffer;
-    IndexBuffer indexBuffer;
     Material material;
-    mat4x3 modelViewMatrix;
+    uint lod; // picked by the culling pass
+    uint vertexFormat;
+    mat4x3 modelViewMatrix; // includes the dequantization of quantized positions
 };
 
 struct TransformData {
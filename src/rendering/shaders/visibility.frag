@@ -0,0 +1,14 @@
+#version 460
+
+#include "structs.inc.glsl"
+#include "culling.inc.glsl"
+
+layout(location = 0) flat in uint inInstance;
+
+layout(location = 0) out uint outID;
+
+// Everything else is rebuilt by visibility_resolve.comp, once per pixel
+void main()
+{
+    outID = (inInstance << VISIBILITY_TRIANGLE_BITS) | uint(gl_PrimitiveID);
+}
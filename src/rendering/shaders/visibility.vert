@@ -0,0 +1,33 @@
+#version 460
+
+#include "common.inc.glsl"
+
+// Same draws, descriptor sets and push constants as default_gbuffer_deferred.vert, only the position and the instance are kept
+
+layout(set = 1, binding = 0, scalar) readonly buffer DrawRecordBuffer {
+    DrawRecord drawRecords[];
+};
+
+layout(set = 1, binding = 1, scalar) readonly buffer InstanceIndexBuffer {
+    uint objectIndices[];
+};
+
+layout(push_constant) uniform GBufferParameters
+{
+    mat4 projection;
+    VertexBuffer vertices;
+    QuantizedVertexBuffer quantizedVertices;
+} parameters;
+
+layout(location = 0) out flat uint outInstance;
+
+void main()
+{
+    DrawRecord drawRecord = drawRecords[objectIndices[gl_InstanceIndex]];
+
+    VertexInput vertex = fetchVertex(parameters.vertices, parameters.quantizedVertices, drawRecord.vertexFormat, gl_VertexIndex);
+    vec3 viewPosition = drawRecord.modelViewMatrix * vec4(vertex.position, 1.0);
+    gl_Position = parameters.projection * vec4(viewPosition, 1.0);
+
+    outInstance = uint(gl_InstanceIndex);
+}
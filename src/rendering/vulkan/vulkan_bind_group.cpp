@@ -11,6 +11,7 @@ namespace NH3D {
     NH3D_ASSERT(info.bindingTypes.size != 0, "Binding types list cannot be empty");
 
     const VkDevice device = static_cast<const VulkanRHI&>(rhi).getVkDevice();
+    const uint32 framesInFlight = rhi.getFramesInFlight();
 
     static std::vector<VkDescriptorSetLayoutBinding> descriptorBindings {};
     descriptorBindings.resize(info.bindingTypes.size);
@@ -66,7 +67,7 @@ namespace NH3D {
     poolSizes.clear();
 
     for (auto [descriptorType, count] : descriptorTypeCounts) {
-        poolSizes.emplace_back(VkDescriptorPoolSize { descriptorType, IRHI::MaxFramesInFlight * count });
+        poolSizes.emplace_back(VkDescriptorPoolSize { descriptorType, framesInFlight * count });
 
         if (info.finalBindingCount > 1 && descriptorType == info.bindingTypes.data[info.bindingTypes.size - 1]) {
             poolSizes.back().descriptorCount *= info.finalBindingCount;
@@ -76,7 +77,7 @@ namespace NH3D {
     VkDescriptorPoolCreateInfo poolCreateInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
-        .maxSets = IRHI::MaxFramesInFlight,
+        .maxSets = framesInFlight,
         .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
         .pPoolSizes = poolSizes.data(),
     };
@@ -87,35 +88,33 @@ namespace NH3D {
     }
 
     // Allocate descriptor sets
-    std::array<VkDescriptorSetLayout, IRHI::MaxFramesInFlight> layouts;
-    layouts.fill(layout);
+    const std::vector<VkDescriptorSetLayout> layouts(framesInFlight, layout);
 
     VkDescriptorSetAllocateInfo allocInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = pool,
-        .descriptorSetCount = IRHI::MaxFramesInFlight,
+        .descriptorSetCount = framesInFlight,
         .pSetLayouts = layouts.data(),
     };
 
-    std::array<uint32, IRHI::MaxFramesInFlight> bindingSizes;
-    bindingSizes.fill(info.finalBindingCount);
+    const std::vector<uint32> bindingSizes(framesInFlight, info.finalBindingCount);
     const VkDescriptorSetVariableDescriptorCountAllocateInfo varDescCountInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
-        .descriptorSetCount = bindingSizes.size(),
+        .descriptorSetCount = static_cast<uint32>(bindingSizes.size()),
         .pDescriptorCounts = bindingSizes.data(),
     };
     if (info.finalBindingCount > 1) {
         allocInfo.pNext = &varDescCountInfo;
     }
 
-    DescriptorSets descriptorSets {};
+    DescriptorSets descriptorSets { framesInFlight };
     if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSets.sets[0]) != VK_SUCCESS) {
         NH3D_ABORT_VK("Failed to allocate Vulkan descriptor sets");
     }
 
     FrameResource<VkDescriptorImageInfo> textureInfos;
     FrameResource<VkDescriptorBufferInfo> bufferInfos;
-    for (uint32 i = 0; i < IRHI::MaxFramesInFlight; ++i) {
+    for (uint32 i = 0; i < framesInFlight; ++i) {
 
         descriptorSets.updates[i] = new VkWriteDescriptorSet[MaxRegisteredBindingUpdates * 2];
         descriptorSets.textureInfos[i] = new VkDescriptorImageInfo[MaxRegisteredBindingUpdates];
@@ -127,7 +126,7 @@ namespace NH3D {
 
 void VulkanBindGroup::release(const IRHI& rhi, DescriptorSets& descriptorSets, BindGroupMetadata& metadata)
 {
-    for (uint32 i = 0; i < IRHI::MaxFramesInFlight; ++i) {
+    for (uint32 i = 0; i < descriptorSets.sets.size(); ++i) {
         delete[] descriptorSets.updates[i];
         delete[] descriptorSets.textureInfos[i];
         delete[] descriptorSets.bufferInfos[i];
@@ -147,13 +146,13 @@ void VulkanBindGroup::release(const IRHI& rhi, DescriptorSets& descriptorSets, B
 
 bool VulkanBindGroup::valid(const DescriptorSets& descriptorSets, const BindGroupMetadata& metadata)
 {
-    return descriptorSets.sets[0] != nullptr && metadata.layout != nullptr && metadata.pool != nullptr;
+    return descriptorSets.sets.size() > 0 && descriptorSets.sets[0] != nullptr && metadata.layout != nullptr && metadata.pool != nullptr;
 }
 
 [[nodiscard]] VkDescriptorSet VulkanBindGroup::getUpdatedDescriptorSet(
     const VkDevice device, const DescriptorSets& descriptorSets, const uint32_t frameInFlightId)
 {
-    NH3D_ASSERT(frameInFlightId < IRHI::MaxFramesInFlight, "Requested out of bound descriptor set");
+    NH3D_ASSERT(frameInFlightId < descriptorSets.sets.size(), "Requested out of bound descriptor set");
 
     if (descriptorSets.updateCounts[frameInFlightId] == 0) {
         return descriptorSets.sets[frameInFlightId];
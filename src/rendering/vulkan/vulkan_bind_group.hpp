@@ -11,6 +11,19 @@
 namespace NH3D {
 
 struct DescriptorSets {
+    DescriptorSets() = default;
+
+    explicit DescriptorSets(const uint32 framesInFlight)
+        : sets { framesInFlight }
+        , updates { framesInFlight }
+        , updateCounts { framesInFlight }
+        , textureInfos { framesInFlight }
+        , textureInfoCounts { framesInFlight }
+        , bufferInfos { framesInFlight }
+        , bufferInfoCounts { framesInFlight }
+    {
+    }
+
     FrameResource<VkDescriptorSet> sets;
 
 private:
@@ -77,7 +90,7 @@ struct VulkanBindGroup {
     static inline void registerBufferedUpdate(const DescriptorSets& descriptorSets, const T& info, const VkDescriptorType type,
         const uint32 binding, const uint32 dstArrayElement = 0)
     {
-        for (uint32 i = 0; i < IRHI::MaxFramesInFlight; ++i) {
+        for (uint32 i = 0; i < descriptorSets.sets.size(); ++i) {
             VkWriteDescriptorSet descWrite = createWriteDescriptorSet(descriptorSets.sets[i], info, type, binding, dstArrayElement);
 
             // That sucks, if textureInfos or bufferInfos are reallocated, the pointer in descWrite becomes invalid
@@ -0,0 +1,199 @@
+#include "vulkan_bindless_table.hpp"
+#include <algorithm>
+#include <rendering/vulkan/vulkan_rhi.hpp>
+#include <rendering/vulkan/vulkan_timeline.hpp>
+
+namespace NH3D {
+
+// Left for the other sets of the pipeline layouts, they count towards the same per stage limits
+static constexpr uint32 ReservedDescriptorCount = 32;
+
+VulkanBindlessTable::VulkanBindlessTable(VulkanRHI* const rhi)
+    : _rhi { rhi }
+{
+    VkPhysicalDeviceVulkan12Properties properties12 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES };
+    VkPhysicalDeviceProperties2 properties { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &properties12 };
+    vkGetPhysicalDeviceProperties2(rhi->getGPU(), &properties);
+
+    const auto clampCapacity = [](const uint32 maxCount, const uint32 perStageLimit, const uint32 perSetLimit) {
+        return std::min({ maxCount, perStageLimit - std::min(perStageLimit, ReservedDescriptorCount), perSetLimit });
+    };
+    _samplerCapacity = clampCapacity(MaxSamplerCount, properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+        properties12.maxDescriptorSetUpdateAfterBindSamplers);
+    _sampledImageCapacity = clampCapacity(MaxSampledImageCount, properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        properties12.maxDescriptorSetUpdateAfterBindSampledImages);
+    _storageImageCapacity = clampCapacity(MaxStorageImageCount, properties12.maxPerStageDescriptorUpdateAfterBindStorageImages,
+        properties12.maxDescriptorSetUpdateAfterBindStorageImages);
+    NH3D_ASSERT(_samplerCapacity > 0 && _sampledImageCapacity > 0 && _storageImageCapacity > 0, "Unsupported bindless descriptor limits");
+
+    // The graphics and compute stages sample the same textures (GBuffer pass, visibility buffer resolve...)
+    const VkShaderStageFlags stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+    const VkDescriptorSetLayoutBinding bindings[] = {
+        {
+            .binding = SamplerBinding,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = _samplerCapacity,
+            .stageFlags = stageFlags,
+        },
+        {
+            .binding = SampledImageBinding,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = _sampledImageCapacity,
+            .stageFlags = stageFlags,
+        },
+        {
+            .binding = StorageImageBinding,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = _storageImageCapacity,
+            .stageFlags = stageFlags,
+        },
+    };
+
+    // Most slots are never written, the shaders only index the ones of live resources
+    const VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+        | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    const VkDescriptorBindingFlags bindingFlags[] = { flags, flags, flags };
+    const VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(std::size(bindingFlags)),
+        .pBindingFlags = bindingFlags,
+    };
+
+    const VkDescriptorSetLayoutCreateInfo layoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsCreateInfo,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = static_cast<uint32_t>(std::size(bindings)),
+        .pBindings = bindings,
+    };
+
+    const VkDevice device = rhi->getVkDevice();
+    if (vkCreateDescriptorSetLayout(device, &layoutCreateInfo, nullptr, &_layout) != VK_SUCCESS) {
+        NH3D_ABORT_VK("Failed to create Vulkan bindless descriptor set layout");
+    }
+
+    const VkDescriptorPoolSize poolSizes[] = {
+        { VK_DESCRIPTOR_TYPE_SAMPLER, _samplerCapacity },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, _sampledImageCapacity },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _storageImageCapacity },
+    };
+    const VkDescriptorPoolCreateInfo poolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = static_cast<uint32_t>(std::size(poolSizes)),
+        .pPoolSizes = poolSizes,
+    };
+
+    if (vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &_pool) != VK_SUCCESS) {
+        NH3D_ABORT_VK("Failed to create Vulkan bindless descriptor pool");
+    }
+
+    const VkDescriptorSetAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = _pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &_layout,
+    };
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, &_descriptorSet) != VK_SUCCESS) {
+        NH3D_ABORT_VK("Failed to allocate Vulkan bindless descriptor set");
+    }
+
+    NH3D_LOG("Bindless table: " << _sampledImageCapacity << " sampled images, " << _storageImageCapacity << " storage images, "
+                                << _samplerCapacity << " samplers");
+}
+
+VulkanBindlessTable::~VulkanBindlessTable()
+{
+    const VkDevice device = _rhi->getVkDevice();
+    vkDestroyDescriptorPool(device, _pool, nullptr);
+    vkDestroyDescriptorSetLayout(device, _layout, nullptr);
+}
+
+[[nodiscard]] uint32 VulkanBindlessTable::addSampler(const VkSampler sampler)
+{
+    NH3D_ASSERT(_samplerCount < _samplerCapacity, "Bindless table sampler capacity exceeded");
+
+    const VkDescriptorImageInfo samplerInfo {
+        .sampler = sampler,
+        .imageView = VK_NULL_HANDLE,
+        .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    const VkWriteDescriptorSet descWrite {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = _descriptorSet,
+        .dstBinding = SamplerBinding,
+        .dstArrayElement = _samplerCount,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+        .pImageInfo = &samplerInfo,
+    };
+    vkUpdateDescriptorSets(_rhi->getVkDevice(), 1, &descWrite, 0, nullptr);
+
+    return _samplerCount++;
+}
+
+void VulkanBindlessTable::setSampledImage(const uint32 index, const VkImageView view)
+{
+    // The texture handles aren't bounded, running out of slots isn't a programming error
+    if (index >= _sampledImageCapacity) {
+        NH3D_ABORT("Bindless table sampled image capacity exceeded (" << _sampledImageCapacity << " slots)");
+    }
+    writeImage(SampledImageBinding, index, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+void VulkanBindlessTable::setStorageImage(const uint32 index, const VkImageView view)
+{
+    NH3D_ASSERT(index < _storageImageCapacity, "Bindless table storage image capacity exceeded");
+    writeImage(StorageImageBinding, index, view, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+void VulkanBindlessTable::replaceSampledImage(const uint32 index, const VkImageView view)
+{
+    NH3D_ASSERT(index < _sampledImageCapacity, "Bindless table sampled image capacity exceeded");
+
+    // Only the frames submitted so far may sample the previous view, the one being recorded picks up the write at submission
+    _replacements.emplace_back(Replacement {
+        .index = index,
+        .view = view,
+        .retireValue = _rhi->getGraphicsTimeline().getSubmittedValue(),
+    });
+}
+
+void VulkanBindlessTable::cancelReplacement(const uint32 index)
+{
+    std::erase_if(_replacements, [index](const Replacement& replacement) { return replacement.index == index; });
+}
+
+void VulkanBindlessTable::flush()
+{
+    const uint64 retiredValue = _rhi->getGraphicsTimeline().getRetiredValue();
+    uint32 appliedCount = 0;
+    while (appliedCount < _replacements.size() && _replacements[appliedCount].retireValue <= retiredValue) {
+        const Replacement& replacement = _replacements[appliedCount++];
+        writeImage(SampledImageBinding, replacement.index, replacement.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    _replacements.erase(_replacements.begin(), _replacements.begin() + appliedCount);
+}
+
+void VulkanBindlessTable::writeImage(const uint32 binding, const uint32 index, const VkImageView view, const VkImageLayout layout) const
+{
+    const VkDescriptorImageInfo imageInfo {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = view,
+        .imageLayout = layout,
+    };
+    const VkWriteDescriptorSet descWrite {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = _descriptorSet,
+        .dstBinding = binding,
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = binding == StorageImageBinding ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        .pImageInfo = &imageInfo,
+    };
+    vkUpdateDescriptorSets(_rhi->getVkDevice(), 1, &descWrite, 0, nullptr);
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace NH3D {
+
+class VulkanRHI;
+
+// Single descriptor set holding every sampler, sampled image and storage image, the images are indexed by their texture handle
+// The set is shared by the frames in flight instead of being duplicated per frame: a descriptor is written when its resource is
+// created and never touched again while a pending frame may use it. The bindings are UPDATE_AFTER_BIND and
+// UPDATE_UNUSED_WHILE_PENDING, so the writes don't have to wait for the frames that don't use them
+class VulkanBindlessTable {
+    NH3D_NO_COPY_MOVE(VulkanBindlessTable)
+public:
+    static constexpr uint32 SamplerBinding = 0;
+    static constexpr uint32 SampledImageBinding = 1;
+    static constexpr uint32 StorageImageBinding = 2;
+
+    // Upper bounds, clamped to the device limits
+    static constexpr uint32 MaxSamplerCount = 64;
+    static constexpr uint32 MaxSampledImageCount = 1 << 18;
+    static constexpr uint32 MaxStorageImageCount = 1 << 14;
+
+    VulkanBindlessTable() = delete;
+
+    VulkanBindlessTable(VulkanRHI* const rhi);
+
+    ~VulkanBindlessTable();
+
+    [[nodiscard]] inline VkDescriptorSetLayout getLayout() const { return _layout; }
+
+    // The same for every frame, nothing to flush before binding it
+    [[nodiscard]] inline VkDescriptorSet getDescriptorSet() const { return _descriptorSet; }
+
+    [[nodiscard]] inline uint32 getSampledImageCapacity() const { return _sampledImageCapacity; }
+
+    [[nodiscard]] inline uint32 getStorageImageCapacity() const { return _storageImageCapacity; }
+
+    // Returns the index of the sampler in the table, samplers live as long as the table
+    [[nodiscard]] uint32 addSampler(const VkSampler sampler);
+
+    // Written right away, the slot must not be used by a pending frame (newly created texture)
+    void setSampledImage(const uint32 index, const VkImageView view);
+
+    void setStorageImage(const uint32 index, const VkImageView view);
+
+    // Rewrites a slot the pending frames may be sampling (fallback texture...), postponed until the graphics submissions made so far
+    // retired, see flush
+    void replaceSampledImage(const uint32 index, const VkImageView view);
+
+    // Drops the postponed writes of the slot, its view is about to be destroyed
+    void cancelReplacement(const uint32 index);
+
+    // Applies the postponed writes whose frames retired, to be called before submitting a frame
+    void flush();
+
+private:
+    struct Replacement {
+        uint32 index;
+        VkImageView view;
+        uint64 retireValue; // graphics timeline
+    };
+
+    void writeImage(const uint32 binding, const uint32 index, const VkImageView view, const VkImageLayout layout) const;
+
+private:
+    VulkanRHI* _rhi;
+
+    VkDescriptorSetLayout _layout;
+    VkDescriptorPool _pool;
+    VkDescriptorSet _descriptorSet;
+
+    uint32 _samplerCapacity;
+    uint32 _sampledImageCapacity;
+    uint32 _storageImageCapacity;
+    uint32 _samplerCount = 0;
+
+    std::vector<Replacement> _replacements; // in timeline order
+};
+
+}
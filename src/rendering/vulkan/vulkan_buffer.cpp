@@ -1,15 +1,13 @@
 #include "vulkan_buffer.hpp"
+#include <algorithm>
 #include <misc/utils.hpp>
 #include <rendering/core/handle.hpp>
 #include <rendering/vulkan/vulkan_rhi.hpp>
+#include <rendering/vulkan/vulkan_staging_ring.hpp>
 #include <vulkan/vulkan_core.h>
 
 namespace NH3D {
 
-size_t VulkanBuffer::stagingBufferWriteOffset = 0;
-GPUBuffer VulkanBuffer::stagingBuffer = { nullptr };
-BufferAllocationInfo VulkanBuffer::stagingBufferAllocation;
-
 std::pair<GPUBuffer, BufferAllocationInfo> VulkanBuffer::create(IRHI& rhi, const CreateInfo& info)
 {
     VulkanRHI& vrhi = static_cast<VulkanRHI&>(rhi);
@@ -44,38 +42,24 @@ std::pair<GPUBuffer, BufferAllocationInfo> VulkanBuffer::create(IRHI& rhi, const
                 vmaFlushAllocation(vrhi.getAllocator(), allocation, 0, info.initialData.size);
             }
         } else {
-            if (stagingBuffer.buffer == VK_NULL_HANDLE) {
-                auto& bufferManager = vrhi.getBufferManager();
-                Handle<Buffer> stagingBufferHandle = bufferManager.create(vrhi,
-                    {
-                        .size = VulkanBuffer::maxGuaranteedStagingBufferSize,
-                        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                        .memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY,
-                    });
-
-                VulkanBuffer::stagingBuffer = bufferManager.get<GPUBuffer>(stagingBufferHandle);
-                VulkanBuffer::stagingBufferAllocation = bufferManager.get<BufferAllocationInfo>(stagingBufferHandle);
-            }
-
-            if (info.size > maxGuaranteedStagingBufferSize) {
-                NH3D_ABORT("Initial data size is larger than maximum guaranteed staging buffer size.");
-            }
-
-            if (stagingBufferWriteOffset + info.initialData.size > VulkanBuffer::maxGuaranteedStagingBufferSize) {
-                vrhi.flushUploadCommands();
-            }
-            void* mappedAddress = VulkanBuffer::stagingBufferAllocation.allocationInfo.pMappedData;
-            std::memcpy(static_cast<byte*>(mappedAddress) + stagingBufferWriteOffset, info.initialData.data, info.initialData.size);
-
-            vrhi.recordBufferUploadCommands([&info, buffer](VkCommandBuffer cmdBuffer) {
-                VulkanBuffer::copyBuffer(
-                    cmdBuffer, VulkanBuffer::stagingBuffer.buffer, buffer, info.initialData.size, stagingBufferWriteOffset);
-            });
-            stagingBufferWriteOffset += info.initialData.size;
+            upload(vrhi, buffer, info.initialData);
         }
     }
 
-    return { { buffer }, { info.size, allocation, allocationInfo } };
+    return { { buffer }, { info.size, allocation, allocationInfo, getDeviceAddress(vrhi, buffer) } };
+}
+
+void VulkanBuffer::upload(VulkanRHI& rhi, const VkBuffer dstBuffer, const ArrayWrapper<byte> data, const size_t dstOffset)
+{
+    // Large uploads go through the staging ring in several pieces
+    VulkanStagingRing& stagingRing = rhi.getStagingRing();
+    for (size_t chunkOffset = 0; chunkOffset < data.size; chunkOffset += VulkanStagingRing::MaxChunkSize) {
+        const size_t chunkSize = std::min<size_t>(data.size - chunkOffset, VulkanStagingRing::MaxChunkSize);
+        const uint64 stagingOffset = stagingRing.stage({ data.data + chunkOffset, static_cast<uint32>(chunkSize) });
+        rhi.recordBufferUploadCommands(dstBuffer, dstOffset + chunkOffset, chunkSize, [&](VkCommandBuffer commandBuffer) {
+            VulkanBuffer::copyBuffer(commandBuffer, stagingRing.getBuffer(), dstBuffer, chunkSize, stagingOffset, dstOffset + chunkOffset);
+        });
+    }
 }
 
 void VulkanBuffer::release(const IRHI& rhi, GPUBuffer& buffer, BufferAllocationInfo& allocation)
@@ -86,6 +70,7 @@ void VulkanBuffer::release(const IRHI& rhi, GPUBuffer& buffer, BufferAllocationI
     buffer.buffer = nullptr;
     allocation.allocation = nullptr;
     allocation.allocationInfo = {};
+    allocation.deviceAddress = 0;
 }
 
 bool VulkanBuffer::valid(const GPUBuffer buffer, const BufferAllocationInfo& allocation)
@@ -104,6 +89,11 @@ void VulkanBuffer::flush(const VulkanRHI& rhi, const BufferAllocationInfo& alloc
     vmaFlushAllocation(rhi.getAllocator(), allocation.allocation, 0, allocation.allocationInfo.size);
 }
 
+void VulkanBuffer::invalidate(const VulkanRHI& rhi, const BufferAllocationInfo& allocation)
+{
+    vmaInvalidateAllocation(rhi.getAllocator(), allocation.allocation, 0, allocation.allocationInfo.size);
+}
+
 [[nodiscard]] void* VulkanBuffer::getMappedAddress(const VulkanRHI& rhi, const BufferAllocationInfo& allocation)
 {
     return allocation.allocationInfo.pMappedData;
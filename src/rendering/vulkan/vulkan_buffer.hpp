@@ -20,25 +20,16 @@ struct BufferAllocationInfo {
     uint32 allocatedSize; // in bytes, the value returned by VMA allocationInfo.size is unreliable because not all memory is usable safely
     VmaAllocation allocation;
     VmaAllocationInfo allocationInfo;
+    VkDeviceAddress deviceAddress; // queried once at creation, every buffer is created with SHADER_DEVICE_ADDRESS usage
 };
 
 struct VulkanBuffer {
-private:
-    // 128 MB, see https://docs.vulkan.org/spec/latest/chapters/limits.html
-    constexpr static size_t maxGuaranteedStagingBufferSize = 1 << 27;
-    static size_t stagingBufferWriteOffset;
-    static GPUBuffer stagingBuffer;
-    static BufferAllocationInfo stagingBufferAllocation;
-
-public:
     using ResourceType = Buffer;
 
     using HotType = GPUBuffer;
 
     using ColdType = BufferAllocationInfo;
 
-    static void flushedUploadCommands() { stagingBufferWriteOffset = 0; }
-
     struct CreateInfo {
         const uint32 size;
         const VkBufferUsageFlags usage;
@@ -61,8 +52,14 @@ public:
 
     static void flush(const VulkanRHI& rhi, const BufferAllocationInfo& allocation);
 
+    // Makes GPU writes visible to the mapped pointer, no-op for coherent memory
+    static void invalidate(const VulkanRHI& rhi, const BufferAllocationInfo& allocation);
+
     [[nodiscard]] static void* getMappedAddress(const VulkanRHI& rhi, const BufferAllocationInfo& allocation);
 
+    // Copies data through the staging ring, the copy is submitted with the other upload commands
+    static void upload(VulkanRHI& rhi, const VkBuffer dstBuffer, const ArrayWrapper<byte> data, const size_t dstOffset = 0);
+
     static void copyBuffer(VkCommandBuffer commandBuffer, const VkBuffer srcBuffer, const VkBuffer dstBuffer, const size_t size,
         const size_t srcOffset = 0, const size_t dstOffset = 0);
 
@@ -1,20 +1,56 @@
 #include "vulkan_compute_shader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <rendering/vulkan/vulkan_pipeline_cache.hpp>
 #include <rendering/vulkan/vulkan_rhi.hpp>
 
 namespace NH3D {
 
 [[nodiscard]] std::pair<VkPipeline, VkPipelineLayout> VulkanComputeShader::create(const IRHI& rhi, const CreateInfo& info)
 {
-    const VkDevice device = static_cast<const VulkanRHI&>(rhi).getVkDevice();
+    const VulkanRHI& vrhi = static_cast<const VulkanRHI&>(rhi);
+    const VkDevice device = vrhi.getVkDevice();
 
     const VkPipelineLayout pipelineLayout = createPipelineLayout(device, info.descriptorSetsLayouts, info.pushConstantRanges);
 
-    const VkShaderModule shaderModule = loadShaderModule(device, info.computeShaderPath);
+    // Constant i is the uint32 at index i, the workgroup size first
+    static_assert(FirstConstantID == WorkgroupSizeConstantID + 3, "The specialization constants follow the workgroup size");
+    std::vector<uint32> constants { info.workgroupSize.x, info.workgroupSize.y, info.workgroupSize.z };
+    const ArrayWrapper<uint32>& specializationConstants = info.specializationConstants;
+    constants.insert(constants.end(), specializationConstants.data, specializationConstants.data + specializationConstants.size);
+    std::vector<VkSpecializationMapEntry> mapEntries(constants.size());
+    for (uint32 i = 0; i < constants.size(); ++i) {
+        mapEntries[i] = {
+            .constantID = WorkgroupSizeConstantID + i,
+            .offset = static_cast<uint32>(i * sizeof(uint32)),
+            .size = sizeof(uint32),
+        };
+    }
+    const VkSpecializationInfo specializationInfo {
+        .mapEntryCount = static_cast<uint32>(mapEntries.size()),
+        .pMapEntries = mapEntries.data(),
+        .dataSize = constants.size() * sizeof(uint32),
+        .pData = constants.data(),
+    };
+
+    // A binary compiled before the workgroup size became specializable keeps its fixed size and silently breaks the dispatch math
+    const std::vector<uint32> code = loadShaderCode(info.computeShaderPath);
+    const std::vector<uint32> constantIDs = getSpecializationConstantIDs(code);
+    for (uint32 i = 0; i < constants.size(); ++i) {
+        // The unused dimensions of 1D and 2D kernels are left out of the shaders
+        const bool unusedDimension = (i == 1 || i == 2) && constants[i] == 1;
+        if (!unusedDimension && std::find(constantIDs.begin(), constantIDs.end(), mapEntries[i].constantID) == constantIDs.end()) {
+            NH3D_ABORT("Compute shader \"" << info.computeShaderPath << "\" doesn't declare specialization constant "
+                                          << mapEntries[i].constantID << ", its SPIR-V is stale, rebuild the shaders");
+        }
+    }
+    const VkShaderModule shaderModule = createShaderModule(device, code, info.computeShaderPath);
     const VkPipelineShaderStageCreateInfo stageCreateInfo {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .stage = VK_SHADER_STAGE_COMPUTE_BIT,
         .module = shaderModule,
         .pName = "main",
+        .pSpecializationInfo = &specializationInfo,
     };
 
     const VkComputePipelineCreateInfo pipelineCreateInfo {
@@ -23,16 +59,40 @@ namespace NH3D {
         .layout = pipelineLayout,
     };
 
+    const VulkanPipelineCache& pipelineCache = vrhi.getPipelineCache();
+    const auto compilationStartTime = std::chrono::high_resolution_clock::now();
     VkPipeline pipeline;
-    if (vkCreateComputePipelines(device, nullptr, 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS) {
+    if (vkCreateComputePipelines(device, pipelineCache.get(), 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS) {
         NH3D_ABORT_VK("Failed to create Vulkan compute pipeline");
     }
+    const std::chrono::duration<float, std::milli> compilationTime = std::chrono::high_resolution_clock::now() - compilationStartTime;
+    pipelineCache.recordCompilation(compilationTime.count());
 
     vkDestroyShaderModule(device, shaderModule, nullptr);
 
     return { pipeline, pipelineLayout };
 }
 
+VulkanComputeShader::AsyncCreateInfo::AsyncCreateInfo(const CreateInfo& info)
+    : computeShaderPath { info.computeShaderPath }
+    , descriptorSetsLayouts { info.descriptorSetsLayouts.data, info.descriptorSetsLayouts.data + info.descriptorSetsLayouts.size }
+    , pushConstantRanges { info.pushConstantRanges.data, info.pushConstantRanges.data + info.pushConstantRanges.size }
+    , workgroupSize { info.workgroupSize }
+    , specializationConstants { info.specializationConstants.data, info.specializationConstants.data + info.specializationConstants.size }
+{
+}
+
+[[nodiscard]] VulkanComputeShader::CreateInfo VulkanComputeShader::AsyncCreateInfo::get() const
+{
+    return {
+        .computeShaderPath = computeShaderPath,
+        .descriptorSetsLayouts = descriptorSetsLayouts,
+        .pushConstantRanges = pushConstantRanges,
+        .workgroupSize = workgroupSize,
+        .specializationConstants = specializationConstants,
+    };
+}
+
 void VulkanComputeShader::release(const IRHI& rhi, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout)
 {
     VulkanPipeline::release(rhi, pipeline, pipelineLayout);
@@ -50,4 +110,23 @@ void VulkanComputeShader::dispatch(VkCommandBuffer commandBuffer, const VkPipeli
     vkCmdDispatch(commandBuffer, kernelSize.x, kernelSize.y, kernelSize.z);
 }
 
+[[nodiscard]] vec3i VulkanComputeShader::getWorkgroupCount(const vec3u threadCount, const vec3u workgroupSize)
+{
+    return vec3i { (threadCount + workgroupSize - 1u) / workgroupSize };
+}
+
+void VulkanComputeShader::dispatchThreads(
+    VkCommandBuffer commandBuffer, const VkPipeline pipeline, const vec3u threadCount, const vec3u workgroupSize)
+{
+    dispatch(commandBuffer, pipeline, getWorkgroupCount(threadCount, workgroupSize));
+}
+
+void VulkanComputeShader::dispatchIndirect(
+    VkCommandBuffer commandBuffer, const VkPipeline pipeline, const VkBuffer buffer, const VkDeviceSize offset)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+    vkCmdDispatchIndirect(commandBuffer, buffer, offset);
+}
+
 }
\ No newline at end of file
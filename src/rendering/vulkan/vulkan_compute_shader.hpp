@@ -5,19 +5,41 @@
 #include <misc/utils.hpp>
 #include <rendering/core/compute_shader.hpp>
 #include <rendering/vulkan/vulkan_pipeline.hpp>
+#include <vector>
 
 namespace NH3D {
 
 struct VulkanComputeShader : public VulkanPipeline {
     using ResourceType = ComputeShader;
 
+    // Specialization constant IDs, the shaders declare layout(local_size_x_id = 0, local_size_y_id = 1, local_size_z_id = 2) in;
+    static constexpr uint32 WorkgroupSizeConstantID = 0;
+    static constexpr uint32 FirstConstantID = 3;
+
     struct CreateInfo {
         const std::filesystem::path& computeShaderPath;
         const ArrayWrapper<VkDescriptorSetLayout> descriptorSetsLayouts;
         const ArrayWrapper<VkPushConstantRange> pushConstantRanges;
+        // Dispatches have to use the same size, see dispatchThreads
+        const vec3u workgroupSize = { 1, 1, 1 };
+        // Feature toggles (0 or 1) and other tweakables, specialization constants FirstConstantID and onward
+        const ArrayWrapper<uint32> specializationConstants;
     };
     using CreateInfo = CreateInfo;
 
+    // Owning copy of a CreateInfo, for the creations that outlive the data of the caller, see VulkanPipelineCompiler
+    struct AsyncCreateInfo {
+        AsyncCreateInfo(const CreateInfo& info);
+
+        [[nodiscard]] CreateInfo get() const;
+
+        std::filesystem::path computeShaderPath;
+        std::vector<VkDescriptorSetLayout> descriptorSetsLayouts;
+        std::vector<VkPushConstantRange> pushConstantRanges;
+        vec3u workgroupSize;
+        std::vector<uint32> specializationConstants;
+    };
+
     /// "Constructor": used generically by the ResourceManager, must be API agnostic
     [[nodiscard]] static std::pair<VkPipeline, VkPipelineLayout> create(const IRHI& rhi, const CreateInfo& info);
 
@@ -28,6 +50,17 @@ struct VulkanComputeShader : public VulkanPipeline {
     static bool valid(const VkPipeline pipeline, const VkPipelineLayout layout);
 
     static void dispatch(VkCommandBuffer commandBuffer, const VkPipeline pipeline, const vec3i kernelSize);
+
+    // Workgroups covering threadCount invocations
+    [[nodiscard]] static vec3i getWorkgroupCount(const vec3u threadCount, const vec3u workgroupSize);
+
+    // Enough workgroups for threadCount invocations, workgroupSize is the one the pipeline was created with
+    static void dispatchThreads(
+        VkCommandBuffer commandBuffer, const VkPipeline pipeline, const vec3u threadCount, const vec3u workgroupSize);
+
+    // The kernel size is a VkDispatchIndirectCommand at offset in bytes
+    static void dispatchIndirect(
+        VkCommandBuffer commandBuffer, const VkPipeline pipeline, const VkBuffer buffer, const VkDeviceSize offset);
 };
 
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <imgui.h>
 #include <rendering/vulkan/vulkan_bind_group.hpp>
 #include <rendering/vulkan/vulkan_buffer.hpp>
+#include <rendering/vulkan/vulkan_pipeline_compiler.hpp>
 #include <rendering/vulkan/vulkan_rhi.hpp>
 #include <rendering/vulkan/vulkan_shader.hpp>
 #include <rendering/vulkan/vulkan_texture.hpp>
@@ -20,6 +21,9 @@ struct AABBPushConstants {
 
 VulkanDebugDrawer::VulkanDebugDrawer(VulkanRHI* const rhi, const DebugDrawSetupData& setupData)
     : _rhi(rhi)
+    , _uiVertexBuffers { rhi->getFramesInFlight() }
+    , _uiIndexBuffers { rhi->getFramesInFlight() }
+    , _fontDescriptorSets { rhi->getFramesInFlight() }
 {
     ImGui::CreateContext();
 
@@ -70,7 +74,7 @@ VulkanDebugDrawer::VulkanDebugDrawer(VulkanRHI* const rhi, const DebugDrawSetupD
         });
 
     const auto& descriptorSets = bindGroupManager.get<DescriptorSets>(_fontBindGroup);
-    for (int i = 0; i < IRHI::MaxFramesInFlight; ++i) {
+    for (uint32 i = 0; i < _rhi->getFramesInFlight(); ++i) {
         const VkDescriptorImageInfo fontImageInfo {
             .sampler = _fontSampler,
             .imageView = _rhi->getTextureManager().get<ImageView>(fontTexture).view, // Font texture is the first created texture
@@ -138,7 +142,8 @@ VulkanDebugDrawer::VulkanDebugDrawer(VulkanRHI* const rhi, const DebugDrawSetupD
     };
 
     auto& shaderManager = _rhi->getShaderManager();
-    _uiShader = shaderManager.create(*_rhi,
+    VulkanPipelineCompiler& pipelineCompiler = _rhi->getPipelineCompiler();
+    _uiShader = pipelineCompiler.compile(shaderManager,
         {
             .vertexShaderPath = NH3D_DIR "src/rendering/shaders/debug_ui.vert.spv",
             .fragmentShaderPath = NH3D_DIR "src/rendering/shaders/debug_ui.frag.spv",
@@ -159,17 +164,17 @@ VulkanDebugDrawer::VulkanDebugDrawer(VulkanRHI* const rhi, const DebugDrawSetupD
 
     const auto& aabbDescriptorSets = _rhi->getBindGroupManager().get<DescriptorSets>(_objectDataBindGroup);
     auto& bufferManager = _rhi->getBufferManager();
-    for (int i = 0; i < IRHI::MaxFramesInFlight; ++i) {
+    for (uint32 i = 0; i < _rhi->getFramesInFlight(); ++i) {
         VulkanBindGroup::updateDescriptorSet(_rhi->getVkDevice(), aabbDescriptorSets.sets[i],
             VkDescriptorBufferInfo {
-                .buffer = bufferManager.get<GPUBuffer>(setupData.transformDataBuffers[i]).buffer,
+                .buffer = bufferManager.get<GPUBuffer>(setupData.transformDataBuffer).buffer,
                 .offset = 0,
                 .range = VK_WHOLE_SIZE,
             },
             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0);
         VulkanBindGroup::updateDescriptorSet(_rhi->getVkDevice(), aabbDescriptorSets.sets[i],
             VkDescriptorBufferInfo {
-                .buffer = bufferManager.get<GPUBuffer>(setupData.objectAABBsBuffers[i]).buffer,
+                .buffer = bufferManager.get<GPUBuffer>(setupData.objectAABBsBuffer).buffer,
                 .offset = 0,
                 .range = VK_WHOLE_SIZE,
             },
@@ -188,7 +193,7 @@ VulkanDebugDrawer::VulkanDebugDrawer(VulkanRHI* const rhi, const DebugDrawSetupD
         },
     };
 
-    _aabbShader = shaderManager.create(*_rhi,
+    _aabbShader = pipelineCompiler.compile(shaderManager,
         {
             .vertexShaderPath = NH3D_DIR "src/rendering/shaders/debug_aabb.vert.spv",
             .fragmentShaderPath = NH3D_DIR "src/rendering/shaders/debug_aabb.frag.spv",
@@ -211,6 +216,9 @@ void VulkanDebugDrawer::renderAABBs(VkCommandBuffer commandBuffer, const uint32_
     const mat4& projectionMatrix, const uint32 objectCount, const Handle<Texture> depthTexture, const Handle<Texture> renderTarget)
 {
     const VkPipeline pipeline = _rhi->getShaderManager().get<VkPipeline>(_aabbShader);
+    if (pipeline == VK_NULL_HANDLE) {
+        return; // still compiling
+    }
 
     auto& textureManager = _rhi->getTextureManager();
     const auto& rtImageViewData = textureManager.get<ImageView>(renderTarget);
@@ -252,27 +260,68 @@ void VulkanDebugDrawer::renderAABBs(VkCommandBuffer commandBuffer, const uint32_
         });
 }
 
-void VulkanDebugDrawer::renderDebugUI(VkCommandBuffer commandBuffer, const uint32_t frameInFlightId, const Handle<Texture> renderTarget)
+void VulkanDebugDrawer::extractDebugUI(RenderSnapshot::UI& ui)
 {
-    ImDrawData* drawData = ImGui::GetDrawData();
+    static_assert(sizeof(ImDrawIdx) == sizeof(uint16), "The UI is drawn with 16 bits indices");
+
+    ui.vertices.clear();
+    ui.indices.clear();
+    ui.commands.clear();
 
+    const ImDrawData* drawData = ImGui::GetDrawData();
     if (drawData == nullptr || drawData->CmdListsCount == 0) {
         return;
     }
 
-    ImGuiIO& io = ImGui::GetIO();
-    updateBuffers(frameInFlightId);
+    ui.displaySize = vec2 { ImGui::GetIO().DisplaySize.x, ImGui::GetIO().DisplaySize.y };
+
+    int32 vertexOffset = 0;
+    for (int i = 0; i < drawData->CmdListsCount; ++i) {
+        const ImDrawList* drawList = drawData->CmdLists[i];
+
+        const byte* vertices = reinterpret_cast<const byte*>(drawList->VtxBuffer.Data);
+        ui.vertices.insert(ui.vertices.end(), vertices, vertices + drawList->VtxBuffer.Size * sizeof(ImDrawVert));
+        ui.indices.insert(ui.indices.end(), drawList->IdxBuffer.Data, drawList->IdxBuffer.Data + drawList->IdxBuffer.Size);
+
+        for (const ImDrawCmd& drawCmd : drawList->CmdBuffer) {
+            ui.commands.emplace_back(RenderSnapshot::UIDrawCommand {
+                .clipRect = vec4 { drawCmd.ClipRect.x, drawCmd.ClipRect.y, drawCmd.ClipRect.z, drawCmd.ClipRect.w },
+                .indexCount = drawCmd.ElemCount,
+                .vertexOffset = vertexOffset,
+            });
+        }
+        vertexOffset += drawList->VtxBuffer.Size;
+    }
+}
+
+void VulkanDebugDrawer::prepareDebugUI(const uint32 frameInFlightId, const RenderSnapshot::UI& ui)
+{
+    if (ui.commands.empty()) {
+        return;
+    }
+
+    updateBuffers(frameInFlightId, ui);
+    _fontDescriptorSets[frameInFlightId] = VulkanBindGroup::getUpdatedDescriptorSet(
+        _rhi->getVkDevice(), _rhi->getBindGroupManager().get<DescriptorSets>(_fontBindGroup), frameInFlightId);
+}
+
+void VulkanDebugDrawer::renderDebugUI(
+    VkCommandBuffer commandBuffer, const uint32_t frameInFlightId, const RenderSnapshot::UI& ui, const Handle<Texture> renderTarget) const
+{
+    if (ui.commands.empty()) {
+        return;
+    }
 
-    auto& bindGroupManager = _rhi->getBindGroupManager();
     auto& shaderManager = _rhi->getShaderManager();
     auto& bufferManager = _rhi->getBufferManager();
 
     const auto pipeline = shaderManager.get<VkPipeline>(_uiShader);
     const auto pipelineLayout = shaderManager.get<VkPipelineLayout>(_uiShader);
+    if (pipeline == VK_NULL_HANDLE) {
+        return; // still compiling
+    }
 
-    const VkDescriptorSet fontDescriptorSet = VulkanBindGroup::getUpdatedDescriptorSet(
-        _rhi->getVkDevice(), bindGroupManager.get<DescriptorSets>(_fontBindGroup), frameInFlightId);
-    VulkanBindGroup::bind(commandBuffer, { &fontDescriptorSet, 1 }, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout);
+    VulkanBindGroup::bind(commandBuffer, { &_fontDescriptorSets[frameInFlightId], 1 }, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout);
 
     auto& textureManager = _rhi->getTextureManager();
     const auto& rtImageViewData = textureManager.get<ImageView>(renderTarget);
@@ -295,7 +344,7 @@ void VulkanDebugDrawer::renderDebugUI(VkCommandBuffer commandBuffer, const uint3
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
     const ImGuiPushConstants pushConstants {
-        .scale = vec2 { 2.0f / io.DisplaySize.x, 2.0f / io.DisplaySize.y },
+        .scale = 2.0f / ui.displaySize,
         .translate = vec2 { -1.0f, -1.0f },
     };
     vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ImGuiPushConstants), &pushConstants);
@@ -303,8 +352,8 @@ void VulkanDebugDrawer::renderDebugUI(VkCommandBuffer commandBuffer, const uint3
     const VkViewport viewport {
         .x = 0.0f,
         .y = 0.0f,
-        .width = io.DisplaySize.x,
-        .height = io.DisplaySize.y,
+        .width = ui.displaySize.x,
+        .height = ui.displaySize.y,
         .minDepth = 0.0f,
         .maxDepth = 1.0f,
     };
@@ -318,41 +367,32 @@ void VulkanDebugDrawer::renderDebugUI(VkCommandBuffer commandBuffer, const uint3
     const VkDeviceAddress vertexBufferAddress
         = VulkanBuffer::getDeviceAddress(*_rhi, bufferManager.get<GPUBuffer>(_uiVertexBuffers[frameInFlightId]).buffer);
 
-    int32 vertexOffset = 0;
-    int32 indexOffset = 0;
-    for (uint32 i = 0; i < drawData->CmdListsCount; ++i) {
-        const ImDrawList* drawList = drawData->CmdLists[i];
-
-        for (uint32 j = 0; j < drawList->CmdBuffer.Size; ++j) {
-            const ImDrawCmd* drawCmd = &drawList->CmdBuffer[j];
-
-            const VkRect2D scissorRect {
-                .offset = VkOffset2D {
-                    .x = static_cast<int32>(drawCmd->ClipRect.x),
-                    .y = static_cast<int32>(drawCmd->ClipRect.y),
-                },
-                .extent = VkExtent2D {
-                    .width = static_cast<uint32>(drawCmd->ClipRect.z - drawCmd->ClipRect.x),
-                    .height = static_cast<uint32>(drawCmd->ClipRect.w - drawCmd->ClipRect.y),
-                },
-            };
-            vkCmdSetScissor(commandBuffer, 0, 1, &scissorRect);
+    uint32 indexOffset = 0;
+    for (const RenderSnapshot::UIDrawCommand& drawCommand : ui.commands) {
+        const VkRect2D scissorRect {
+            .offset = VkOffset2D {
+                .x = static_cast<int32>(drawCommand.clipRect.x),
+                .y = static_cast<int32>(drawCommand.clipRect.y),
+            },
+            .extent = VkExtent2D {
+                .width = static_cast<uint32>(drawCommand.clipRect.z - drawCommand.clipRect.x),
+                .height = static_cast<uint32>(drawCommand.clipRect.w - drawCommand.clipRect.y),
+            },
+        };
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissorRect);
 
-            vkCmdDrawIndexed(commandBuffer, drawCmd->ElemCount, 1, indexOffset, vertexOffset, 0);
+        vkCmdDrawIndexed(commandBuffer, drawCommand.indexCount, 1, indexOffset, drawCommand.vertexOffset, 0);
 
-            indexOffset += drawCmd->ElemCount;
-        }
-        vertexOffset += drawList->VtxBuffer.Size;
+        indexOffset += drawCommand.indexCount;
     }
 
     vkCmdEndRendering(commandBuffer);
 }
 
-void VulkanDebugDrawer::updateBuffers(const uint32 frameInFlightId)
+void VulkanDebugDrawer::updateBuffers(const uint32 frameInFlightId, const RenderSnapshot::UI& ui)
 {
-    const ImDrawData* drawData = ImGui::GetDrawData();
-    const uint32 vertexBufferSize = static_cast<uint32>(drawData->TotalVtxCount) * sizeof(ImDrawVert);
-    const uint32 indexBufferSize = static_cast<uint32>(drawData->TotalIdxCount) * sizeof(ImDrawIdx);
+    const uint32 vertexBufferSize = static_cast<uint32>(ui.vertices.size());
+    const uint32 indexBufferSize = static_cast<uint32>(ui.indices.size() * sizeof(uint16));
 
     if (vertexBufferSize == 0 || indexBufferSize == 0) {
         return;
@@ -390,22 +430,10 @@ void VulkanDebugDrawer::updateBuffers(const uint32 frameInFlightId)
 
     // Update data
     const auto& vertexBufferAllocation = bufferManager.get<BufferAllocationInfo>(_uiVertexBuffers[frameInFlightId]);
-    ImDrawVert* vertexDst = reinterpret_cast<ImDrawVert*>(
-        VulkanBuffer::getMappedAddress(*_rhi, bufferManager.get<BufferAllocationInfo>(_uiVertexBuffers[frameInFlightId])));
+    std::memcpy(VulkanBuffer::getMappedAddress(*_rhi, vertexBufferAllocation), ui.vertices.data(), vertexBufferSize);
 
     const auto& indexBufferAllocation = bufferManager.get<BufferAllocationInfo>(_uiIndexBuffers[frameInFlightId]);
-    ImDrawIdx* indexDst = reinterpret_cast<ImDrawIdx*>(
-        VulkanBuffer::getMappedAddress(*_rhi, bufferManager.get<BufferAllocationInfo>(_uiIndexBuffers[frameInFlightId])));
-
-    for (int i = 0; i < drawData->CmdListsCount; ++i) {
-        const ImDrawList* drawList = drawData->CmdLists[i];
-
-        std::memcpy(vertexDst, drawList->VtxBuffer.Data, drawList->VtxBuffer.Size * sizeof(ImDrawVert));
-        std::memcpy(indexDst, drawList->IdxBuffer.Data, drawList->IdxBuffer.Size * sizeof(ImDrawIdx));
-
-        vertexDst += drawList->VtxBuffer.Size;
-        indexDst += drawList->IdxBuffer.Size;
-    }
+    std::memcpy(VulkanBuffer::getMappedAddress(*_rhi, indexBufferAllocation), ui.indices.data(), indexBufferSize);
 
     VulkanBuffer::flush(*_rhi, vertexBufferAllocation);
     VulkanBuffer::flush(*_rhi, indexBufferAllocation);
@@ -5,6 +5,7 @@
 #include <rendering/core/bind_group.hpp>
 #include <rendering/core/compute_shader.hpp>
 #include <rendering/core/frame_resource.hpp>
+#include <rendering/core/render_snapshot.hpp>
 #include <rendering/core/rhi.hpp>
 #include <rendering/core/shader.hpp>
 #include <rendering/core/texture.hpp>
@@ -17,8 +18,8 @@ class VulkanRHI;
 struct DebugDrawSetupData {
     VkExtent2D extent;
     VkFormat attachmentFormat;
-    const FrameResource<Handle<Buffer>>& transformDataBuffers;
-    const FrameResource<Handle<Buffer>>& objectAABBsBuffers;
+    Handle<Buffer> transformDataBuffer; // shared by all frames in flight
+    Handle<Buffer> objectAABBsBuffer;
 };
 
 // Encapsulate ImGui debug draw and probably other debug draw stuff in the future
@@ -34,11 +35,18 @@ public:
     void renderAABBs(VkCommandBuffer commandBuffer, const uint32_t frameInFlightId, const mat4& viewMatrix, const mat4& projectionMatrix,
         const uint32 objectCount, const Handle<Texture> depthTexture, const Handle<Texture> renderTarget);
 
-    void renderDebugUI(VkCommandBuffer commandBuffer, const uint32 frameInFlightId, const Handle<Texture> renderTarget);
+    // Copies the ImGui draw data of the last UI frame, main thread
+    static void extractDebugUI(RenderSnapshot::UI& ui);
+
+    // Uploads the UI geometry and updates the descriptors, must be called before the parallel recording
+    void prepareDebugUI(const uint32 frameInFlightId, const RenderSnapshot::UI& ui);
+
+    void renderDebugUI(VkCommandBuffer commandBuffer, const uint32 frameInFlightId, const RenderSnapshot::UI& ui,
+        const Handle<Texture> renderTarget) const;
 
 private:
     // Reallocates if necessary
-    void updateBuffers(const uint32 bufferId);
+    void updateBuffers(const uint32 frameInFlightId, const RenderSnapshot::UI& ui);
 
 private:
     VulkanRHI* const _rhi;
@@ -54,6 +62,7 @@ private:
     // Per-frame buffers
     FrameResource<Handle<Buffer>> _uiVertexBuffers;
     FrameResource<Handle<Buffer>> _uiIndexBuffers;
+    FrameResource<VkDescriptorSet> _fontDescriptorSets;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,371 @@
+#include "vulkan_geometry_arena.hpp"
+#include <misc/math.hpp>
+#include <rendering/core/quantized_vertex.hpp>
+#include <rendering/core/rhi.hpp>
+#include <rendering/vulkan/vulkan_buffer.hpp>
+#include <rendering/vulkan/vulkan_rhi.hpp>
+#include <unordered_map>
+
+namespace NH3D {
+
+NH3D_STATIC_ASSERT(sizeof(VertexData) == 32, "VertexData layout mismatch with the shaders");
+NH3D_STATIC_ASSERT(sizeof(QuantizedVertexData) == 16, "QuantizedVertexData layout mismatch with the shaders");
+NH3D_STATIC_ASSERT(sizeof(Meshlet) == 40, "Meshlet layout mismatch with the shaders");
+
+VulkanGeometryArena::VulkanGeometryArena(VulkanRHI* const rhi)
+    : _rhi { rhi }
+{
+    _buffers = createBuffers();
+}
+
+VulkanGeometryArena::~VulkanGeometryArena()
+{
+    for (const PendingCompaction& compaction : _pendingCompactions) {
+        releaseBuffers(compaction.source);
+    }
+    for (const ReleasedBuffers& releasedBuffers : _releasedBuffers) {
+        releaseBuffers(releasedBuffers.buffers);
+    }
+    releaseBuffers(_buffers);
+}
+
+[[nodiscard]] Handle<Geometry> VulkanGeometryArena::allocate(const Geometry::CreateInfo& info)
+{
+    NH3D_ASSERT(info.vertices.isValid() && info.indices.isValid(), "Empty geometry");
+    NH3D_ASSERT(info.lods.size < Geometry::MaxLODs, "Too many LODs");
+
+    // LOD 0 is the mesh itself, every LOD is packed after the previous one
+    GeometryRange range {
+        .vertexCount = info.vertices.size,
+        .lodCount = info.lods.size + 1,
+        .indexType = info.vertices.size <= NH3D_MAX_T(uint16) + 1u ? Geometry::IndexType::Uint16 : Geometry::IndexType::Uint32,
+        .vertexFormat = info.vertexFormat,
+        .positionBounds = AABB { .min = info.vertices[0].position, .max = info.vertices[0].position },
+    };
+    for (uint32 i = 1; i < info.vertices.size; ++i) {
+        range.positionBounds.min = min(range.positionBounds.min, info.vertices[i].position);
+        range.positionBounds.max = max(range.positionBounds.max, info.vertices[i].position);
+    }
+
+    const auto addLOD = [&range](const uint32 lod, const ArrayWrapper<uint32>& indices, const ArrayWrapper<Meshlet>& meshlets,
+                            const float error) {
+        NH3D_ASSERT(indices.isValid(), "Empty LOD");
+        range.lods[lod] = LODRange {
+            .indexCount = indices.size,
+            .firstIndex = range.indexCount,
+            .firstMeshlet = range.meshletCount,
+            .meshletCount = meshlets.size,
+            .error = error,
+        };
+        range.indexCount += indices.size;
+        range.meshletCount += meshlets.size;
+    };
+    addLOD(0, info.indices, info.meshlets, 0.0f);
+    for (uint32 lod = 1; lod < range.lodCount; ++lod) {
+        const Geometry::LOD& lodInfo = info.lods.data[lod - 1];
+        addLOD(lod, lodInfo.indices, lodInfo.meshlets, lodInfo.error);
+    }
+
+    const uint32 verticesPerSlot = getVerticesPerSlot(range.vertexFormat);
+    const uint32 vertexSlotCount = (range.vertexCount + verticesPerSlot - 1) / verticesPerSlot;
+    RangeAllocator& indexAllocator = getIndexAllocator(range.indexType);
+    const auto tryAllocate = [&](uint32& firstVertexSlot, uint32& firstIndex, uint32& firstMeshlet) {
+        firstVertexSlot = _vertexAllocator.allocate(vertexSlotCount);
+        firstIndex = indexAllocator.allocate(range.indexCount);
+        firstMeshlet = range.meshletCount > 0 ? _meshletAllocator.allocate(range.meshletCount) : 0;
+        if (firstVertexSlot != RangeAllocator::InvalidOffset && firstIndex != RangeAllocator::InvalidOffset
+            && firstMeshlet != RangeAllocator::InvalidOffset) {
+            return true;
+        }
+
+        if (firstVertexSlot != RangeAllocator::InvalidOffset) {
+            _vertexAllocator.free(firstVertexSlot);
+        }
+        if (firstIndex != RangeAllocator::InvalidOffset) {
+            indexAllocator.free(firstIndex);
+        }
+        if (range.meshletCount > 0 && firstMeshlet != RangeAllocator::InvalidOffset) {
+            _meshletAllocator.free(firstMeshlet);
+        }
+        return false;
+    };
+
+    uint32 firstVertexSlot;
+    if (!tryAllocate(firstVertexSlot, range.firstIndex, range.firstMeshlet)) {
+        // Expensive, but only happens when the arenas are full or too fragmented
+        compact();
+        if (!tryAllocate(firstVertexSlot, range.firstIndex, range.firstMeshlet)) {
+            NH3D_ABORT("Geometry arena capacity exceeded");
+        }
+    }
+    range.vertexOffset = static_cast<int32>(firstVertexSlot * verticesPerSlot);
+
+    auto& bufferManager = _rhi->getBufferManager();
+    const VkBuffer vertexBuffer = bufferManager.get<GPUBuffer>(_buffers.vertexBuffer).buffer;
+    if (range.vertexFormat == Geometry::VertexFormat::Quantized) {
+        const std::vector<QuantizedVertexData> quantizedVertices = QuantizedVertexData::quantize(info.vertices, range.positionBounds);
+        VulkanBuffer::upload(*_rhi, vertexBuffer,
+            { reinterpret_cast<const byte*>(quantizedVertices.data()),
+                static_cast<uint32>(quantizedVertices.size() * sizeof(QuantizedVertexData)) },
+            firstVertexSlot * sizeof(VertexData));
+    } else {
+        VulkanBuffer::upload(*_rhi, vertexBuffer,
+            { reinterpret_cast<const byte*>(info.vertices.data), static_cast<uint32>(info.vertices.size * sizeof(VertexData)) },
+            firstVertexSlot * sizeof(VertexData));
+    }
+
+    std::vector<uint16> narrowIndices;
+    const auto uploadLOD = [&](const LODRange& lodRange, const ArrayWrapper<uint32>& indices, const ArrayWrapper<Meshlet>& meshlets) {
+        const uint32 firstIndex = range.firstIndex + lodRange.firstIndex;
+        if (range.indexType == Geometry::IndexType::Uint16) {
+            narrowIndices.assign(indices.data, indices.data + indices.size);
+            VulkanBuffer::upload(*_rhi, bufferManager.get<GPUBuffer>(_buffers.indexBuffer).buffer,
+                { reinterpret_cast<const byte*>(narrowIndices.data()), static_cast<uint32>(narrowIndices.size() * sizeof(uint16)) },
+                firstIndex * sizeof(uint16));
+        } else {
+            VulkanBuffer::upload(*_rhi, bufferManager.get<GPUBuffer>(_buffers.wideIndexBuffer).buffer,
+                { reinterpret_cast<const byte*>(indices.data), static_cast<uint32>(indices.size * sizeof(uint32)) },
+                firstIndex * sizeof(uint32));
+        }
+
+        if (meshlets.size > 0) {
+            VulkanBuffer::upload(*_rhi, bufferManager.get<GPUBuffer>(_buffers.meshletBuffer).buffer,
+                { reinterpret_cast<const byte*>(meshlets.data), static_cast<uint32>(meshlets.size * sizeof(Meshlet)) },
+                (range.firstMeshlet + lodRange.firstMeshlet) * sizeof(Meshlet));
+        }
+    };
+    uploadLOD(range.lods[0], info.indices, info.meshlets);
+    for (uint32 lod = 1; lod < range.lodCount; ++lod) {
+        uploadLOD(range.lods[lod], info.lods.data[lod - 1].indices, info.lods.data[lod - 1].meshlets);
+    }
+
+    Handle<Geometry> handle;
+    if (!_freeHandles.empty()) {
+        handle.index = _freeHandles.back();
+        _freeHandles.pop_back();
+    } else {
+        handle.index = _ranges.size();
+        _ranges.emplace_back();
+    }
+
+    _ranges[handle.index] = range;
+
+    return handle;
+}
+
+void VulkanGeometryArena::release(const Handle<Geometry> handle)
+{
+    NH3D_ASSERT(handle.index < _ranges.size() && _ranges[handle.index].indexCount > 0, "Releasing an invalid geometry handle");
+
+    const uint64 retireValue = _rhi->getGraphicsTimeline().getPendingValue();
+    _releasedGeometries.emplace_back(ReleasedGeometry { .handle = handle, .retireValue = retireValue });
+}
+
+void VulkanGeometryArena::collectReleased()
+{
+    // Released in timeline order, the oldest ones are at the front
+    const uint64 retiredValue = _rhi->getGraphicsTimeline().getRetiredValue();
+    uint32 collectedCount = 0;
+    while (collectedCount < _releasedGeometries.size() && _releasedGeometries[collectedCount].retireValue <= retiredValue) {
+        freeRange(_releasedGeometries[collectedCount++].handle);
+    }
+    _releasedGeometries.erase(_releasedGeometries.begin(), _releasedGeometries.begin() + collectedCount);
+
+    collectedCount = 0;
+    while (collectedCount < _releasedBuffers.size() && _releasedBuffers[collectedCount].retireValue <= retiredValue) {
+        releaseBuffers(_releasedBuffers[collectedCount++].buffers);
+    }
+    _releasedBuffers.erase(_releasedBuffers.begin(), _releasedBuffers.begin() + collectedCount);
+}
+
+void VulkanGeometryArena::recordPendingCopies(const VkCommandBuffer commandBuffer)
+{
+    auto& bufferManager = _rhi->getBufferManager();
+    const uint64 retireValue = _rhi->getGraphicsTimeline().getPendingValue();
+    for (const PendingCompaction& compaction : _pendingCompactions) {
+        const std::pair<Handle<Buffer>, Handle<Buffer>> bufferPairs[] = {
+            { compaction.source.vertexBuffer, compaction.destination.vertexBuffer },
+            { compaction.source.indexBuffer, compaction.destination.indexBuffer },
+            { compaction.source.wideIndexBuffer, compaction.destination.wideIndexBuffer },
+            { compaction.source.meshletBuffer, compaction.destination.meshletBuffer },
+        };
+        for (uint32 i = 0; i < std::size(bufferPairs); ++i) {
+            const std::vector<VkBufferCopy>& copies = compaction.copies[i];
+            if (!copies.empty()) {
+                vkCmdCopyBuffer(commandBuffer, bufferManager.get<GPUBuffer>(bufferPairs[i].first).buffer,
+                    bufferManager.get<GPUBuffer>(bufferPairs[i].second).buffer, copies.size(), copies.data());
+            }
+        }
+
+        // The next compaction copies from these buffers, and the frame reads them right after
+        const VkMemoryBarrier2 barrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+        };
+        const VkDependencyInfo dependencyInfo {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers = &barrier,
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+        // The frames submitted so far may still read the replaced buffers
+        _releasedBuffers.emplace_back(ReleasedBuffers { .buffers = compaction.source, .retireValue = retireValue });
+    }
+    _pendingCompactions.clear();
+}
+
+[[nodiscard]] VkDeviceAddress VulkanGeometryArena::getVertexBufferAddress() const
+{
+    return _rhi->getBufferManager().get<BufferAllocationInfo>(_buffers.vertexBuffer).deviceAddress;
+}
+
+[[nodiscard]] VkBuffer VulkanGeometryArena::getIndexBuffer(const Geometry::IndexType indexType) const
+{
+    const Handle<Buffer> indexBuffer = indexType == Geometry::IndexType::Uint16 ? _buffers.indexBuffer : _buffers.wideIndexBuffer;
+    return _rhi->getBufferManager().get<GPUBuffer>(indexBuffer).buffer;
+}
+
+[[nodiscard]] VkDeviceAddress VulkanGeometryArena::getIndexBufferAddress(const Geometry::IndexType indexType) const
+{
+    const Handle<Buffer> indexBuffer = indexType == Geometry::IndexType::Uint16 ? _buffers.indexBuffer : _buffers.wideIndexBuffer;
+    return _rhi->getBufferManager().get<BufferAllocationInfo>(indexBuffer).deviceAddress;
+}
+
+[[nodiscard]] uint32 VulkanGeometryArena::getVerticesPerSlot(const Geometry::VertexFormat vertexFormat)
+{
+    return vertexFormat == Geometry::VertexFormat::Quantized ? sizeof(VertexData) / sizeof(QuantizedVertexData) : 1;
+}
+
+[[nodiscard]] RangeAllocator& VulkanGeometryArena::getIndexAllocator(const Geometry::IndexType indexType)
+{
+    return indexType == Geometry::IndexType::Uint16 ? _indexAllocator : _wideIndexAllocator;
+}
+
+[[nodiscard]] VkDeviceAddress VulkanGeometryArena::getMeshletBufferAddress() const
+{
+    return _rhi->getBufferManager().get<BufferAllocationInfo>(_buffers.meshletBuffer).deviceAddress;
+}
+
+[[nodiscard]] VulkanGeometryArena::Buffers VulkanGeometryArena::createBuffers() const
+{
+    auto& bufferManager = _rhi->getBufferManager();
+
+    return Buffers {
+        .vertexBuffer = bufferManager.create(*_rhi,
+            {
+                .size = VertexCapacity * sizeof(VertexData),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            }),
+        .indexBuffer = bufferManager.create(*_rhi,
+            {
+                .size = IndexCapacity * sizeof(uint16),
+                .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                    | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            }),
+        .wideIndexBuffer = bufferManager.create(*_rhi,
+            {
+                .size = WideIndexCapacity * sizeof(uint32),
+                .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                    | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            }),
+        .meshletBuffer = bufferManager.create(*_rhi,
+            {
+                .size = MeshletCapacity * sizeof(Meshlet),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            }),
+    };
+}
+
+void VulkanGeometryArena::releaseBuffers(const Buffers& buffers)
+{
+    auto& bufferManager = _rhi->getBufferManager();
+    bufferManager.release(*_rhi, buffers.vertexBuffer);
+    bufferManager.release(*_rhi, buffers.indexBuffer);
+    bufferManager.release(*_rhi, buffers.wideIndexBuffer);
+    bufferManager.release(*_rhi, buffers.meshletBuffer);
+}
+
+void VulkanGeometryArena::freeRange(const Handle<Geometry> handle)
+{
+    GeometryRange& range = _ranges[handle.index];
+    _vertexAllocator.free(range.vertexOffset / getVerticesPerSlot(range.vertexFormat));
+    getIndexAllocator(range.indexType).free(range.firstIndex);
+    if (range.meshletCount > 0) {
+        _meshletAllocator.free(range.firstMeshlet);
+    }
+    range = GeometryRange {};
+    _freeHandles.emplace_back(handle.index);
+}
+
+void VulkanGeometryArena::compact()
+{
+    NH3D_DEBUGLOG("Compacting the geometry arenas");
+
+    // The copies are recorded by the next frame, which waits on the upload timeline: the pending uploads to the current buffers go
+    // out first. The released ranges the frames in flight may still draw are kept and moved like the live ones
+    _rhi->flushUploadCommands();
+    collectReleased();
+
+    const auto compactAllocator = [](RangeAllocator& allocator) {
+        std::unordered_map<uint32, uint32> newOffsets;
+        for (const RangeAllocator::Move& move : allocator.compact()) {
+            newOffsets.emplace(move.oldOffset, move.newOffset);
+        }
+        return newOffsets;
+    };
+    const std::unordered_map<uint32, uint32> vertexOffsets = compactAllocator(_vertexAllocator);
+    const std::unordered_map<uint32, uint32> firstIndices = compactAllocator(_indexAllocator);
+    const std::unordered_map<uint32, uint32> firstWideIndices = compactAllocator(_wideIndexAllocator);
+    const std::unordered_map<uint32, uint32> firstMeshlets = compactAllocator(_meshletAllocator);
+
+    // Copied to new buffers rather than in place, vkCmdCopyBuffer regions can't overlap and the frames in flight read the old ones
+    PendingCompaction compaction { .source = _buffers, .destination = createBuffers() };
+    std::vector<VkBufferCopy>& vertexCopies = compaction.copies[0];
+    std::vector<VkBufferCopy>& indexCopies = compaction.copies[1];
+    std::vector<VkBufferCopy>& wideIndexCopies = compaction.copies[2];
+    std::vector<VkBufferCopy>& meshletCopies = compaction.copies[3];
+    const auto moveRange = [](const std::unordered_map<uint32, uint32>& newOffsets, std::vector<VkBufferCopy>& copies,
+                               const uint32 offset, const uint32 size, const size_t elementSize) {
+        const auto it = newOffsets.find(offset);
+        const uint32 newOffset = it != newOffsets.end() ? it->second : offset;
+        copies.emplace_back(VkBufferCopy {
+            .srcOffset = offset * elementSize,
+            .dstOffset = newOffset * elementSize,
+            .size = size * elementSize,
+        });
+        return newOffset;
+    };
+    for (GeometryRange& range : _ranges) {
+        if (range.indexCount == 0) {
+            continue;
+        }
+
+        const uint32 verticesPerSlot = getVerticesPerSlot(range.vertexFormat);
+        const uint32 firstVertexSlot = moveRange(vertexOffsets, vertexCopies, range.vertexOffset / verticesPerSlot,
+            (range.vertexCount + verticesPerSlot - 1) / verticesPerSlot, sizeof(VertexData));
+        range.vertexOffset = static_cast<int32>(firstVertexSlot * verticesPerSlot);
+        if (range.indexType == Geometry::IndexType::Uint16) {
+            range.firstIndex = moveRange(firstIndices, indexCopies, range.firstIndex, range.indexCount, sizeof(uint16));
+        } else {
+            range.firstIndex = moveRange(firstWideIndices, wideIndexCopies, range.firstIndex, range.indexCount, sizeof(uint32));
+        }
+        if (range.meshletCount > 0) {
+            range.firstMeshlet = moveRange(firstMeshlets, meshletCopies, range.firstMeshlet, range.meshletCount, sizeof(Meshlet));
+        }
+    }
+
+    _buffers = compaction.destination;
+    _pendingCompactions.emplace_back(std::move(compaction));
+
+    ++_version;
+}
+
+}
\ No newline at end of file
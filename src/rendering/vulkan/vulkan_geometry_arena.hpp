@@ -0,0 +1,160 @@
+#pragma once
+
+#include <array>
+#include <core/aabb.hpp>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <rendering/core/buffer.hpp>
+#include <rendering/core/handle.hpp>
+#include <rendering/core/mesh.hpp>
+#include <rendering/core/range_allocator.hpp>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace NH3D {
+
+class VulkanRHI;
+
+// One vertex buffer, one index buffer per index width and one meshlet buffer shared by every mesh, each geometry is a range of
+// the vertex, meshlet and one of the index buffers
+// Every draw of an index width binds the same buffers, so the whole GBuffer pass can go through hardware indexed indirect draws
+class VulkanGeometryArena {
+    NH3D_NO_COPY_MOVE(VulkanGeometryArena)
+public:
+    static constexpr uint32 VertexCapacity = 1 << 21; // 64 MB of VertexData, quantized vertices pack two per VertexData slot
+
+    static constexpr uint32 IndexCapacity = 1 << 23; // 16 MB of uint16 indices
+
+    static constexpr uint32 WideIndexCapacity = 1 << 22; // 16 MB of uint32 indices, only for meshes with more than 65536 vertices
+
+    static constexpr uint32 MeshletCapacity = 1 << 17; // 5 MB of meshlets, more than the index arena can fill
+
+    // Relative to the range of the geometry
+    struct LODRange {
+        uint32 indexCount;
+        uint32 firstIndex;
+        uint32 firstMeshlet;
+        uint32 meshletCount;
+        float error;
+    };
+
+    // In elements, laid out like the matching fields of VkDrawIndexedIndirectCommand
+    // The index and meshlet ranges cover every LOD, LOD 0 first
+    struct GeometryRange {
+        uint32 indexCount; // 0 for dead entries
+        uint32 firstIndex; // in the index buffer of indexType
+        int32 vertexOffset; // in vertices of vertexFormat
+        uint32 vertexCount;
+        uint32 firstMeshlet;
+        uint32 meshletCount; // 0 if the geometry wasn't split in meshlets
+        uint32 lodCount;
+        std::array<LODRange, Geometry::MaxLODs> lods;
+        Geometry::IndexType indexType;
+        Geometry::VertexFormat vertexFormat;
+        AABB positionBounds; // what the quantized positions are normalized to
+    };
+
+    VulkanGeometryArena() = delete;
+
+    VulkanGeometryArena(VulkanRHI* const rhi);
+
+    ~VulkanGeometryArena();
+
+    // Compacts the arenas if they are too fragmented for the new ranges, aborts if they are full
+    [[nodiscard]] Handle<Geometry> allocate(const Geometry::CreateInfo& info);
+
+    // The ranges are only reused once the graphics work that may still draw them retired, the next submission included
+    void release(const Handle<Geometry> handle);
+
+    // Frees the ranges and the buffers replaced by compactions whose graphics timeline value retired
+    void collectReleased();
+
+    [[nodiscard]] inline bool hasPendingCopies() const { return !_pendingCompactions.empty(); }
+
+    // Copies of the compactions since the last frame, to be recorded before anything reads the arenas. The replaced buffers are
+    // released once the submission the commands go to retired, it must be the next graphics submission
+    void recordPendingCopies(const VkCommandBuffer commandBuffer);
+
+    [[nodiscard]] inline const GeometryRange& getRange(const Handle<Geometry> handle) const
+    {
+        NH3D_ASSERT(handle.index < _ranges.size() && _ranges[handle.index].indexCount > 0, "Invalid geometry handle");
+        return _ranges[handle.index];
+    }
+
+    // Bumped by every compaction, the ranges cached elsewhere are stale when it changes
+    [[nodiscard]] inline uint32 getVersion() const { return _version; }
+
+    // Also changes with compactions
+    [[nodiscard]] VkDeviceAddress getVertexBufferAddress() const;
+
+    [[nodiscard]] VkBuffer getIndexBuffer(const Geometry::IndexType indexType) const;
+
+    // Read by the visibility buffer resolve
+    [[nodiscard]] VkDeviceAddress getIndexBufferAddress(const Geometry::IndexType indexType) const;
+
+    // No live geometry needs the uint32 index buffer, its draws can be skipped
+    [[nodiscard]] inline bool hasWideIndices() const { return _wideIndexAllocator.getAllocationCount() > 0; }
+
+    [[nodiscard]] VkDeviceAddress getMeshletBufferAddress() const;
+
+private:
+    struct ReleasedGeometry {
+        Handle<Geometry> handle;
+        uint64 retireValue; // graphics timeline
+    };
+
+    struct Buffers {
+        Handle<Buffer> vertexBuffer;
+        Handle<Buffer> indexBuffer;
+        Handle<Buffer> wideIndexBuffer;
+        Handle<Buffer> meshletBuffer;
+    };
+
+    // Vertex, index, wide index and meshlet buffer copies, from the buffers replaced by the compaction to the new ones
+    struct PendingCompaction {
+        Buffers source;
+        Buffers destination;
+        std::array<std::vector<VkBufferCopy>, 4> copies;
+    };
+
+    struct ReleasedBuffers {
+        Buffers buffers;
+        uint64 retireValue; // graphics timeline
+    };
+
+    // The vertex arena is allocated in VertexData sized slots
+    [[nodiscard]] static uint32 getVerticesPerSlot(const Geometry::VertexFormat vertexFormat);
+
+    [[nodiscard]] RangeAllocator& getIndexAllocator(const Geometry::IndexType indexType);
+
+    [[nodiscard]] Buffers createBuffers() const;
+
+    void releaseBuffers(const Buffers& buffers);
+
+    void freeRange(const Handle<Geometry> handle);
+
+    // Moves every live range to the beginning of new buffers without stalling: the copies are recorded by the next frame, which
+    // reads the new buffers, while the frames in flight keep reading the old ones until they are released. Both sets of buffers
+    // are alive in the meantime, twice the arena memory
+    void compact();
+
+private:
+    VulkanRHI* const _rhi;
+
+    RangeAllocator _vertexAllocator { VertexCapacity };
+    RangeAllocator _indexAllocator { IndexCapacity };
+    RangeAllocator _wideIndexAllocator { WideIndexCapacity };
+    RangeAllocator _meshletAllocator { MeshletCapacity };
+
+    Buffers _buffers; // the vertex and meshlet buffers are read through their device address
+
+    std::vector<GeometryRange> _ranges; // indexed by geometry handle
+    std::vector<uint32> _freeHandles;
+    std::vector<ReleasedGeometry> _releasedGeometries;
+    std::vector<PendingCompaction> _pendingCompactions; // in compaction order, each one copies from the buffers of the previous
+    std::vector<ReleasedBuffers> _releasedBuffers;
+
+    uint32 _version = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,450 @@
+#include "vulkan_gpu_scene.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <misc/utils.hpp>
+#include <rendering/core/quantized_vertex.hpp>
+#include <rendering/core/render_snapshot.hpp>
+#include <rendering/vulkan/vulkan_bind_group.hpp>
+#include <rendering/vulkan/vulkan_buffer.hpp>
+#include <rendering/vulkan/vulkan_compute_shader.hpp>
+#include <rendering/vulkan/vulkan_geometry_arena.hpp>
+#include <rendering/vulkan/vulkan_pipeline_compiler.hpp>
+#include <rendering/vulkan/vulkan_rhi.hpp>
+
+namespace NH3D {
+
+// Must match the scalar layout of gpu_scene_scatter.comp
+NH3D_STATIC_ASSERT(sizeof(VulkanGPUScene::RenderData) == 12, "RenderData layout mismatch with the shaders");
+NH3D_STATIC_ASSERT(sizeof(VulkanGPUScene::MeshDraw) == 44 + 24 * Geometry::MaxLODs, "MeshDraw layout mismatch with the shaders");
+NH3D_STATIC_ASSERT(sizeof(AABB) == 24, "AABB layout mismatch with the shaders");
+NH3D_STATIC_ASSERT(sizeof(TransformComponent) == 40, "TransformComponent layout mismatch with the shaders");
+
+VulkanGPUScene::VulkanGPUScene(VulkanRHI* const rhi)
+    : _rhi { rhi }
+    , _uploadedMeshTableVersions { rhi->getFramesInFlight() }
+    , _meshTableBuffers { rhi->getFramesInFlight() }
+    , _objectUpdateBuffers { rhi->getFramesInFlight() }
+    , _transformUpdateBuffers { rhi->getFramesInFlight() }
+    , _objectUpdateCapacities { rhi->getFramesInFlight() }
+    , _transformUpdateCapacities { rhi->getFramesInFlight() }
+    , _pendingObjectUpdateCounts { rhi->getFramesInFlight() }
+    , _pendingTransformUpdateCounts { rhi->getFramesInFlight() }
+    , _scatterDescriptorSets { rhi->getFramesInFlight() }
+{
+    auto& bufferManager = _rhi->getBufferManager();
+    auto& bindGroupManager = _rhi->getBindGroupManager();
+
+    _renderDataBuffer = bufferManager.create(*_rhi,
+        {
+            .size = sizeof(RenderData) * MaxObjects,
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+        });
+
+    _aabbBuffer = bufferManager.create(*_rhi,
+        {
+            .size = sizeof(AABB) * MaxObjects,
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+        });
+
+    _transformBuffer = bufferManager.create(*_rhi,
+        {
+            .size = sizeof(TransformComponent) * MaxObjects,
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+        });
+
+    const VkDescriptorType objectDataTypes[] = {
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // RenderData buffer
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // AABBs buffer
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // TransformData buffer
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // MeshDraw buffer
+    };
+    _objectDataBindGroup = bindGroupManager.create(*_rhi,
+        {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .bindingTypes = objectDataTypes,
+        });
+
+    // The object buffers are shared by all frames in flight, only the upload buffers and the mesh table are per-frame
+    const auto& objectDataDescriptorSets = bindGroupManager.get<DescriptorSets>(_objectDataBindGroup);
+    for (uint32 i = 0; i < _rhi->getFramesInFlight(); ++i) {
+        _meshTableBuffers[i] = bufferManager.create(*_rhi,
+            {
+                .size = sizeof(MeshDraw) * MaxMeshes,
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            });
+        _uploadedMeshTableVersions[i] = 0;
+
+        const Handle<Buffer> objectDataBuffers[] = { _renderDataBuffer, _aabbBuffer, _transformBuffer, _meshTableBuffers[i] };
+        for (uint32 binding = 0; binding < std::size(objectDataBuffers); ++binding) {
+            VulkanBindGroup::updateDescriptorSet(_rhi->getVkDevice(), objectDataDescriptorSets.sets[i],
+                VkDescriptorBufferInfo {
+                    .buffer = bufferManager.get<GPUBuffer>(objectDataBuffers[binding]).buffer,
+                    .offset = 0,
+                    .range = VK_WHOLE_SIZE,
+                },
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, binding);
+        }
+
+        _objectUpdateCapacities[i] = 0;
+        _transformUpdateCapacities[i] = 0;
+        _pendingObjectUpdateCounts[i] = 0;
+        _pendingTransformUpdateCounts[i] = 0;
+    }
+
+    const VkPushConstantRange scatterPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(ScatterParameters),
+    };
+    const VkDescriptorSetLayout scatterLayouts[] = {
+        bindGroupManager.get<BindGroupMetadata>(_objectDataBindGroup).layout,
+    };
+    _scatterCS = _rhi->getPipelineCompiler().compile(_rhi->getComputeShaderManager(),
+        {
+            .computeShaderPath = NH3D_DIR "src/rendering/shaders/gpu_scene_scatter.comp.spv",
+            .descriptorSetsLayouts = scatterLayouts,
+            .pushConstantRanges = scatterPushConstantRange,
+            .workgroupSize = { ScatterWorkgroupSize, 1, 1 },
+        });
+
+    _entitySlots.reserve(MaxObjects);
+    _objectMeshSlots.resize(MaxObjects, InvalidSlot);
+    _worldAABBs.resize(MaxObjects);
+}
+
+void VulkanGPUScene::update(const uint32 frameInFlightId, const RenderSnapshot& snapshot)
+{
+    _pendingObjectUpdateCounts[frameInFlightId] = 0;
+    _pendingTransformUpdateCounts[frameInFlightId] = 0;
+
+    // The mesh table of this frame may be behind even if nothing changed this frame
+    updateMeshTable(frameInFlightId);
+
+    const std::vector<Entity>& removedEntities = snapshot.removedEntities;
+    const std::vector<RenderSnapshot::ObjectChange>& objectChanges = snapshot.objectChanges;
+
+    if (removedEntities.empty() && objectChanges.empty()) {
+        return;
+    }
+
+    ensureUploadCapacity(frameInFlightId, removedEntities.size() + objectChanges.size(), objectChanges.size());
+
+    auto& bufferManager = _rhi->getBufferManager();
+    const BufferAllocationInfo& objectUpdateAllocation = bufferManager.get<BufferAllocationInfo>(_objectUpdateBuffers[frameInFlightId]);
+    const BufferAllocationInfo& transformUpdateAllocation
+        = bufferManager.get<BufferAllocationInfo>(_transformUpdateBuffers[frameInFlightId]);
+    ObjectUpdate* objectUpdates = reinterpret_cast<ObjectUpdate*>(VulkanBuffer::getMappedAddress(*_rhi, objectUpdateAllocation));
+    TransformUpdate* transformUpdates
+        = reinterpret_cast<TransformUpdate*>(VulkanBuffer::getMappedAddress(*_rhi, transformUpdateAllocation));
+
+    uint32 objectUpdateCount = 0;
+    uint32 transformUpdateCount = 0;
+
+    for (const Entity entity : removedEntities) {
+        if (entity >= _entitySlots.size() || _entitySlots[entity] == InvalidSlot) {
+            continue;
+        }
+
+        // Zeroed render data, the flags mark the slot as dead for the culling pass
+        const uint32 slot = _entitySlots[entity];
+        objectUpdates[objectUpdateCount++] = ObjectUpdate { .slot = slot };
+        releaseMeshSlot(_objectMeshSlots[slot]);
+        _objectMeshSlots[slot] = InvalidSlot;
+        _releasedSlots.emplace_back(slot);
+        _entitySlots[entity] = InvalidSlot;
+        _bvhBuildNeeded = true;
+    }
+
+    // Only drawable entities are extracted, once each
+    for (const RenderSnapshot::ObjectChange& change : objectChanges) {
+        if (change.entity >= _entitySlots.size()) {
+            _entitySlots.resize(change.entity + 1, InvalidSlot);
+        }
+
+        uint32& slot = _entitySlots[change.entity];
+        if (slot == InvalidSlot || (change.flags & DIRTY_RENDER_DATA_BIT) != 0) {
+            if (slot == InvalidSlot) {
+                slot = allocateSlot();
+                _bvhBuildNeeded = true;
+            }
+
+            // Acquired first so that a mesh used by this object only isn't released and reallocated
+            const uint32 meshSlot = acquireMeshSlot(change.mesh);
+            if (_objectMeshSlots[slot] != InvalidSlot) {
+                releaseMeshSlot(_objectMeshSlots[slot]);
+            }
+            _objectMeshSlots[slot] = meshSlot;
+
+            objectUpdates[objectUpdateCount++] = ObjectUpdate {
+                .slot = slot,
+                .renderData = makeRenderData(change.material, meshSlot, change.visible),
+                .aabb = change.mesh.objectAABB,
+                .transform = change.transform,
+            };
+        } else {
+            transformUpdates[transformUpdateCount++] = TransformUpdate { .slot = slot, .transform = change.transform };
+        }
+        setWorldAABB(slot, change.mesh.objectAABB, change.transform);
+    }
+
+    updateBVH();
+
+    _freeSlots.insert(_freeSlots.end(), _releasedSlots.begin(), _releasedSlots.end());
+    _releasedSlots.clear();
+
+    // The culling pass of this frame must see the instance ranges of the new objects
+    updateMeshTable(frameInFlightId);
+
+    if (objectUpdateCount + transformUpdateCount == 0) {
+        return;
+    }
+
+    VulkanBuffer::flush(*_rhi, objectUpdateAllocation);
+    VulkanBuffer::flush(*_rhi, transformUpdateAllocation);
+
+    _pendingObjectUpdateCounts[frameInFlightId] = objectUpdateCount;
+    _pendingTransformUpdateCounts[frameInFlightId] = transformUpdateCount;
+    _scatterDescriptorSets[frameInFlightId] = VulkanBindGroup::getUpdatedDescriptorSet(
+        _rhi->getVkDevice(), _rhi->getBindGroupManager().get<DescriptorSets>(_objectDataBindGroup), frameInFlightId);
+}
+
+void VulkanGPUScene::recordUpdate(VkCommandBuffer commandBuffer, const uint32 frameInFlightId) const
+{
+    const uint32 objectUpdateCount = _pendingObjectUpdateCounts[frameInFlightId];
+    const uint32 transformUpdateCount = _pendingTransformUpdateCounts[frameInFlightId];
+    const uint32 updateCount = objectUpdateCount + transformUpdateCount;
+    if (updateCount == 0) {
+        return;
+    }
+
+    auto& bufferManager = _rhi->getBufferManager();
+    const BufferAllocationInfo& objectUpdateAllocation = bufferManager.get<BufferAllocationInfo>(_objectUpdateBuffers[frameInFlightId]);
+    const BufferAllocationInfo& transformUpdateAllocation
+        = bufferManager.get<BufferAllocationInfo>(_transformUpdateBuffers[frameInFlightId]);
+
+    // The previous frames may still read the object buffers (culling, debug draw)
+    const VkBuffer objectDataBuffers[] = {
+        bufferManager.get<GPUBuffer>(_renderDataBuffer).buffer,
+        bufferManager.get<GPUBuffer>(_aabbBuffer).buffer,
+        bufferManager.get<GPUBuffer>(_transformBuffer).buffer,
+    };
+    for (const VkBuffer buffer : objectDataBuffers) {
+        VulkanBuffer::insertMemoryBarrier(commandBuffer, buffer, VK_ACCESS_2_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+    }
+
+    const auto scatterPipeline = _rhi->getComputeShaderManager().get<VkPipeline>(_scatterCS);
+    const auto scatterPipelineLayout = _rhi->getComputeShaderManager().get<VkPipelineLayout>(_scatterCS);
+    VulkanBindGroup::bind(commandBuffer, _scatterDescriptorSets[frameInFlightId], VK_PIPELINE_BIND_POINT_COMPUTE, scatterPipelineLayout);
+
+    const ScatterParameters scatterParameters {
+        .objectUpdates = objectUpdateAllocation.deviceAddress,
+        .transformUpdates = transformUpdateAllocation.deviceAddress,
+        .objectUpdateCount = objectUpdateCount,
+        .transformUpdateCount = transformUpdateCount,
+    };
+    vkCmdPushConstants(
+        commandBuffer, scatterPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ScatterParameters), &scatterParameters);
+
+    VulkanComputeShader::dispatchThreads(commandBuffer, scatterPipeline, { updateCount, 1, 1 }, { ScatterWorkgroupSize, 1, 1 });
+
+    for (const VkBuffer buffer : objectDataBuffers) {
+        VulkanBuffer::insertMemoryBarrier(commandBuffer, buffer, VK_ACCESS_2_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT);
+    }
+}
+
+[[nodiscard]] uint32 VulkanGPUScene::allocateSlot()
+{
+    if (!_freeSlots.empty()) {
+        const uint32 slot = _freeSlots.back();
+        _freeSlots.pop_back();
+        return slot;
+    }
+
+    if (_slotCount >= MaxObjects) {
+        NH3D_ABORT("GPU scene object capacity exceeded");
+    }
+
+    return _slotCount++;
+}
+
+[[nodiscard]] uint32 VulkanGPUScene::acquireMeshSlot(const Mesh& mesh)
+{
+    const auto [it, inserted] = _meshSlots.try_emplace(mesh.geometry.index, InvalidSlot);
+    if (inserted) {
+        if (!_freeMeshSlots.empty()) {
+            it->second = _freeMeshSlots.back();
+            _freeMeshSlots.pop_back();
+        } else {
+            if (_meshDraws.size() >= MaxMeshes) {
+                NH3D_ABORT("GPU scene mesh capacity exceeded");
+            }
+            it->second = _meshDraws.size();
+            _meshDraws.emplace_back();
+        }
+
+        _meshDraws[it->second] = MeshDraw {};
+        setGeometryRange(_meshDraws[it->second], _rhi->getGeometryArena().getRange(mesh.geometry));
+    }
+
+    ++_meshDraws[it->second].instanceCapacity;
+    ++_meshTableVersion;
+
+    return it->second;
+}
+
+void VulkanGPUScene::setGeometryRange(MeshDraw& meshDraw, const VulkanGeometryArena::GeometryRange& range)
+{
+    meshDraw.vertexOffset = range.vertexOffset;
+    meshDraw.lodCount = range.lodCount;
+    meshDraw.indexType = range.indexType;
+    meshDraw.vertexFormat = range.vertexFormat;
+    const bool quantized = range.vertexFormat == Geometry::VertexFormat::Quantized;
+    meshDraw.positionOffset = quantized ? range.positionBounds.min : vec3 { 0.0f };
+    meshDraw.positionScale = quantized ? QuantizedVertexData::getPositionScale(range.positionBounds) : vec3 { 1.0f };
+    for (uint32 lod = 0; lod < range.lodCount; ++lod) {
+        const VulkanGeometryArena::LODRange& lodRange = range.lods[lod];
+        meshDraw.lods[lod].indexCount = lodRange.indexCount;
+        meshDraw.lods[lod].firstIndex = range.firstIndex + lodRange.firstIndex;
+        meshDraw.lods[lod].firstMeshlet = range.firstMeshlet + lodRange.firstMeshlet;
+        meshDraw.lods[lod].meshletCount = lodRange.meshletCount;
+        meshDraw.lods[lod].error = lodRange.error;
+    }
+}
+
+void VulkanGPUScene::releaseMeshSlot(const uint32 meshSlot)
+{
+    NH3D_ASSERT(_meshDraws[meshSlot].instanceCapacity > 0, "Mesh slot released more times than acquired");
+
+    ++_meshTableVersion;
+    if (--_meshDraws[meshSlot].instanceCapacity > 0) {
+        return;
+    }
+
+    // The previous frames keep their own copy of the mesh table, the slot can be reused right away
+    const auto it = std::find_if(_meshSlots.begin(), _meshSlots.end(), [meshSlot](const auto& entry) { return entry.second == meshSlot; });
+    NH3D_ASSERT(it != _meshSlots.end(), "Released mesh slot isn't mapped to any mesh");
+    _meshSlots.erase(it);
+    _meshDraws[meshSlot] = MeshDraw {};
+    _freeMeshSlots.emplace_back(meshSlot);
+}
+
+void VulkanGPUScene::setWorldAABB(const uint32 slot, const AABB& objectAABB, const TransformComponent& transform)
+{
+    _worldAABBs[slot] = objectAABB.transform(mat4(transform));
+
+    // New slots aren't in the BVH yet, the next build reads _worldAABBs anyway
+    if (!_bvhBuildNeeded) {
+        _bvh.setBounds(slot, _worldAABBs[slot]);
+    }
+}
+
+void VulkanGPUScene::updateBVH()
+{
+    if (!_bvhBuildNeeded) {
+        _bvh.refit();
+        if (_bvh.getCost() <= BVHRebuildCostRatio * _bvh.getBuildCost()) {
+            return;
+        }
+    }
+
+    std::vector<uint32> slots;
+    std::vector<AABB> bounds;
+    slots.reserve(_slotCount);
+    bounds.reserve(_slotCount);
+    for (uint32 slot = 0; slot < _slotCount; ++slot) {
+        if (_objectMeshSlots[slot] != InvalidSlot) {
+            slots.emplace_back(slot);
+            bounds.emplace_back(_worldAABBs[slot]);
+        }
+    }
+
+    _bvh.build(slots, bounds);
+    _bvhBuildNeeded = false;
+}
+
+void VulkanGPUScene::updateMeshTable(const uint32 frameInFlightId)
+{
+    const VulkanGeometryArena& geometryArena = _rhi->getGeometryArena();
+    if (geometryArena.getVersion() != _geometryArenaVersion) {
+        for (const auto& [geometryIndex, meshSlot] : _meshSlots) {
+            setGeometryRange(_meshDraws[meshSlot], geometryArena.getRange(Handle<Geometry> { geometryIndex }));
+        }
+        _geometryArenaVersion = geometryArena.getVersion();
+        ++_meshTableVersion;
+    }
+
+    if (_uploadedMeshTableVersions[frameInFlightId] == _meshTableVersion) {
+        return;
+    }
+
+    uint32 firstInstance = 0;
+    for (MeshDraw& meshDraw : _meshDraws) {
+        for (uint32 lod = 0; lod < meshDraw.lodCount; ++lod) {
+            meshDraw.lods[lod].firstInstance = firstInstance;
+            firstInstance += meshDraw.instanceCapacity;
+        }
+    }
+    NH3D_ASSERT(firstInstance <= MaxInstances, "More instances than objects");
+
+    const BufferAllocationInfo& meshTableAllocation
+        = _rhi->getBufferManager().get<BufferAllocationInfo>(_meshTableBuffers[frameInFlightId]);
+    std::memcpy(VulkanBuffer::getMappedAddress(*_rhi, meshTableAllocation), _meshDraws.data(), _meshDraws.size() * sizeof(MeshDraw));
+    VulkanBuffer::flush(*_rhi, meshTableAllocation);
+
+    _uploadedMeshTableVersions[frameInFlightId] = _meshTableVersion;
+}
+
+[[nodiscard]] VulkanGPUScene::RenderData VulkanGPUScene::makeRenderData(
+    const Material& material, const uint32 meshSlot, const bool visible) const
+{
+    return RenderData {
+        .material = material,
+        .flags = visible ? static_cast<uint32>(OBJECT_VISIBLE_BIT) : 0,
+        .meshSlot = meshSlot,
+    };
+}
+
+void VulkanGPUScene::ensureUploadCapacity(const uint32 frameInFlightId, const uint32 objectUpdateCount, const uint32 transformUpdateCount)
+{
+    // Only this frame's buffers are replaced, its previous submission already completed
+    auto& bufferManager = _rhi->getBufferManager();
+
+    if (objectUpdateCount > _objectUpdateCapacities[frameInFlightId]) {
+        if (_objectUpdateBuffers[frameInFlightId] != InvalidHandle<Buffer>) {
+            bufferManager.release(*_rhi, _objectUpdateBuffers[frameInFlightId]);
+        }
+
+        _objectUpdateCapacities[frameInFlightId] = std::bit_ceil(std::max(objectUpdateCount, 1024U));
+        _objectUpdateBuffers[frameInFlightId] = bufferManager.create(*_rhi,
+            {
+                .size = static_cast<uint32>(sizeof(ObjectUpdate) * _objectUpdateCapacities[frameInFlightId]),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            });
+    }
+
+    if (transformUpdateCount > _transformUpdateCapacities[frameInFlightId]) {
+        if (_transformUpdateBuffers[frameInFlightId] != InvalidHandle<Buffer>) {
+            bufferManager.release(*_rhi, _transformUpdateBuffers[frameInFlightId]);
+        }
+
+        _transformUpdateCapacities[frameInFlightId] = std::bit_ceil(std::max(transformUpdateCount, 1024U));
+        _transformUpdateBuffers[frameInFlightId] = bufferManager.create(*_rhi,
+            {
+                .size = static_cast<uint32>(sizeof(TransformUpdate) * _transformUpdateCapacities[frameInFlightId]),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            });
+    }
+}
+
+}
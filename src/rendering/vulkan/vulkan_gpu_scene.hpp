@@ -0,0 +1,196 @@
+#pragma once
+
+#include <core/aabb.hpp>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <rendering/core/bind_group.hpp>
+#include <rendering/core/buffer.hpp>
+#include <rendering/core/bvh.hpp>
+#include <rendering/core/compute_shader.hpp>
+#include <rendering/core/frame_resource.hpp>
+#include <rendering/core/handle.hpp>
+#include <rendering/core/material.hpp>
+#include <rendering/core/mesh.hpp>
+#include <rendering/vulkan/vulkan_geometry_arena.hpp>
+#include <scene/ecs/components/transform_component.hpp>
+#include <scene/ecs/entity.hpp>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace NH3D {
+
+class VulkanRHI;
+struct RenderSnapshot;
+
+// Persistent GPU copy of the drawable entities (RenderComponent + TransformComponent)
+// Each entity owns a stable slot in the object buffers, only the changes extracted from the scene are uploaded every frame as
+// {slot, payload} records, a compute pass scatters them into the persistent buffers
+// Objects sharing the same mesh and LOD are drawn with a single instanced draw, each mesh owns a slot in the mesh table and a
+// range of MeshDraw::instanceCapacity instances per LOD that the culling pass fills with the visible object indices
+// Objects whose LOD is split in several meshlets are handed to the cluster culling pass instead, one draw per visible meshlet
+// A CPU BVH over the world AABBs of the live slots lets the renderer skip whole regions of the scene before the culling pass
+class VulkanGPUScene {
+    NH3D_NO_COPY_MOVE(VulkanGPUScene)
+public:
+    static constexpr uint32 MaxObjects = 640'000;
+
+    static constexpr uint32 MaxMeshes = 4096;
+
+    static constexpr uint32 MaxInstances = Geometry::MaxLODs * MaxObjects; // every LOD reserves room for all the objects of its mesh
+
+    enum ObjectFlagBits : uint32 {
+        OBJECT_VISIBLE_BIT = 1 << 0,
+    };
+
+    // The geometry is only referenced through the mesh slot, its ranges live in the mesh table
+    struct RenderData {
+        Material material;
+        uint32 flags; // 0 for dead slots
+        uint32 meshSlot;
+    };
+
+    struct MeshLOD {
+        uint32 indexCount;
+        uint32 firstIndex; // in the index arena
+        uint32 firstMeshlet; // in the meshlet arena
+        uint32 meshletCount; // LODs with more than one meshlet are culled and drawn per meshlet
+        uint32 firstInstance; // prefix sum of the instance capacities
+        float error; // object space, compared to the projected size of a pixel by the culling pass
+    };
+
+    // Every LOD gets its own instanced draw and instance range, any object may pick any LOD
+    struct MeshDraw {
+        int32 vertexOffset; // in the vertex arena, shared by the LODs
+        uint32 instanceCapacity; // number of objects using the mesh
+        uint32 lodCount;
+        Geometry::IndexType indexType; // meshes of each index width are drawn from their own range of draws
+        Geometry::VertexFormat vertexFormat;
+        vec3 positionOffset; // dequantization of the positions, identity for full vertices
+        vec3 positionScale;
+        MeshLOD lods[Geometry::MaxLODs];
+    };
+
+    VulkanGPUScene() = delete;
+
+    VulkanGPUScene(VulkanRHI* const rhi);
+
+    // Applies the changes extracted in the snapshot and writes the upload records of the frame
+    void update(const uint32 frameInFlightId, const RenderSnapshot& snapshot);
+
+    // Records the scatter dispatch of the last update, must be recorded before any read of the object buffers
+    // Doesn't touch any CPU state so it can be recorded from any thread
+    void recordUpdate(VkCommandBuffer commandBuffer, const uint32 frameInFlightId) const;
+
+    // Slots are never compacted, dead slots are skipped by the culling pass using RenderData::flags
+    [[nodiscard]] inline uint32 getSlotCount() const { return _slotCount; }
+
+    // One instanced draw per mesh slot, slots of released meshes draw nothing
+    [[nodiscard]] inline uint32 getMeshSlotCount() const { return _meshDraws.size(); }
+
+    [[nodiscard]] inline uint32 getMeshCount() const { return _meshSlots.size(); }
+
+    // RenderData, AABBs and transforms, indexed by slot
+    [[nodiscard]] inline Handle<BindGroup> getObjectDataBindGroup() const { return _objectDataBindGroup; }
+
+    [[nodiscard]] inline Handle<Buffer> getTransformBuffer() const { return _transformBuffer; }
+
+    [[nodiscard]] inline Handle<Buffer> getAABBBuffer() const { return _aabbBuffer; }
+
+    // Compiled asynchronously, see VulkanPipelineCompiler
+    [[nodiscard]] inline Handle<ComputeShader> getScatterShader() const { return _scatterCS; }
+
+    // Items are object slots, up to date with the last update
+    [[nodiscard]] inline const BVH& getBVH() const { return _bvh; }
+
+private:
+    // Full object update, also used to kill the slot of removed entities
+    struct ObjectUpdate {
+        uint32 slot;
+        RenderData renderData;
+        AABB aabb;
+        TransformComponent transform;
+    };
+
+    struct TransformUpdate {
+        uint32 slot;
+        TransformComponent transform;
+    };
+
+    struct ScatterParameters {
+        VkDeviceAddress objectUpdates;
+        VkDeviceAddress transformUpdates;
+        uint32 objectUpdateCount;
+        uint32 transformUpdateCount;
+    };
+    static constexpr uint32 ScatterWorkgroupSize = 64; // one invocation per update
+
+    static constexpr uint32 InvalidSlot = NH3D_MAX_T(uint32);
+
+    // Refitting after movements degrades the BVH, past this ratio of its cost after the last build it gets rebuilt
+    static constexpr float BVHRebuildCostRatio = 1.5f;
+
+private:
+    [[nodiscard]] uint32 allocateSlot();
+
+    [[nodiscard]] RenderData makeRenderData(const Material& material, const uint32 meshSlot, const bool visible) const;
+
+    // Meshes are identified by their geometry, the mesh slot is released with its last object
+    [[nodiscard]] uint32 acquireMeshSlot(const Mesh& mesh);
+
+    // Copies the arena ranges, leaves the instance ranges alone
+    static void setGeometryRange(MeshDraw& meshDraw, const VulkanGeometryArena::GeometryRange& range);
+
+    void releaseMeshSlot(const uint32 meshSlot);
+
+    void setWorldAABB(const uint32 slot, const AABB& objectAABB, const TransformComponent& transform);
+
+    // Rebuilds the BVH when slots were added or removed, refits it otherwise
+    void updateBVH();
+
+    // Recomputes the instance ranges and uploads the mesh table of the frame if it changed since its last upload
+    // The geometry ranges are refreshed as well if the geometry arena was compacted
+    void updateMeshTable(const uint32 frameInFlightId);
+
+    // Reallocates the upload buffers of the frame if necessary
+    void ensureUploadCapacity(const uint32 frameInFlightId, const uint32 objectUpdateCount, const uint32 transformUpdateCount);
+
+private:
+    VulkanRHI* const _rhi;
+
+    std::vector<uint32> _entitySlots; // indexed by entity
+    std::vector<uint32> _freeSlots;
+    std::vector<uint32> _releasedSlots; // freed this frame, recycled only after the upload so a slot never gets two records
+    uint32 _slotCount = 0;
+    std::vector<uint32> _objectMeshSlots; // indexed by object slot
+
+    BVH _bvh;
+    std::vector<AABB> _worldAABBs; // indexed by object slot
+    bool _bvhBuildNeeded = false;
+
+    std::unordered_map<uint32, uint32> _meshSlots; // geometry handle index to mesh slot
+    std::vector<MeshDraw> _meshDraws; // indexed by mesh slot
+    std::vector<uint32> _freeMeshSlots;
+    uint32 _meshTableVersion = 0;
+    uint32 _geometryArenaVersion = 0;
+    FrameResource<uint32> _uploadedMeshTableVersions;
+    FrameResource<Handle<Buffer>> _meshTableBuffers; // CPU written, read by the culling pass
+
+    Handle<Buffer> _renderDataBuffer = InvalidHandle<Buffer>;
+    Handle<Buffer> _aabbBuffer = InvalidHandle<Buffer>;
+    Handle<Buffer> _transformBuffer = InvalidHandle<Buffer>;
+    Handle<BindGroup> _objectDataBindGroup = InvalidHandle<BindGroup>;
+
+    Handle<ComputeShader> _scatterCS = InvalidHandle<ComputeShader>;
+
+    // Per-frame, CPU written and read in place by the scatter pass
+    FrameResource<Handle<Buffer>> _objectUpdateBuffers;
+    FrameResource<Handle<Buffer>> _transformUpdateBuffers;
+    FrameResource<uint32> _objectUpdateCapacities;
+    FrameResource<uint32> _transformUpdateCapacities;
+    FrameResource<uint32> _pendingObjectUpdateCounts;
+    FrameResource<uint32> _pendingTransformUpdateCounts;
+    FrameResource<VkDescriptorSet> _scatterDescriptorSets;
+};
+
+}
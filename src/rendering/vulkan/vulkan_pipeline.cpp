@@ -39,6 +39,11 @@ VkPipelineLayout VulkanPipeline::createPipelineLayout(VkDevice device, const Arr
 }
 
 VkShaderModule VulkanPipeline::loadShaderModule(VkDevice device, const std::filesystem::path& path)
+{
+    return createShaderModule(device, loadShaderCode(path), path);
+}
+
+std::vector<uint32> VulkanPipeline::loadShaderCode(const std::filesystem::path& path)
 {
     if (!path.has_filename() || !std::filesystem::exists(path)) {
         NH3D_ABORT("Shader at \"" << path << "\" does not exist");
@@ -50,14 +55,22 @@ VkShaderModule VulkanPipeline::loadShaderModule(VkDevice device, const std::file
     }
 
     const size_t size = file.tellg();
+    if (size % sizeof(uint32) != 0) {
+        NH3D_ABORT("Shader at \"" << path << "\" is not valid SPIR-V");
+    }
     file.seekg(0);
 
-    std::vector<char> buffer(size);
-    file.read(buffer.data(), size);
+    std::vector<uint32> code(size / sizeof(uint32));
+    file.read(reinterpret_cast<char*>(code.data()), size);
     file.close();
 
+    return code;
+}
+
+VkShaderModule VulkanPipeline::createShaderModule(VkDevice device, const std::vector<uint32>& code, const std::filesystem::path& path)
+{
     const VkShaderModuleCreateInfo moduleCreateInfo {
-        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, .codeSize = size, .pCode = reinterpret_cast<uint32_t*>(buffer.data())
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, .codeSize = code.size() * sizeof(uint32), .pCode = code.data()
     };
 
     VkShaderModule shader;
@@ -67,4 +80,27 @@ VkShaderModule VulkanPipeline::loadShaderModule(VkDevice device, const std::file
     return shader;
 }
 
+std::vector<uint32> VulkanPipeline::getSpecializationConstantIDs(const std::vector<uint32>& code)
+{
+    // After the 5 words of the header, each instruction starts with its word count in the high half and its opcode in the low one
+    static constexpr uint32 HeaderWordCount = 5;
+    static constexpr uint32 OpDecorate = 71;
+    static constexpr uint32 DecorationSpecId = 1;
+
+    std::vector<uint32> constantIDs;
+    for (size_t i = HeaderWordCount; i < code.size();) {
+        const uint32 wordCount = code[i] >> 16;
+        if (wordCount == 0 || i + wordCount > code.size()) {
+            break;
+        }
+
+        // OpDecorate <target> SpecId <constant ID>
+        if ((code[i] & 0xFFFF) == OpDecorate && wordCount == 4 && code[i + 2] == DecorationSpecId) {
+            constantIDs.emplace_back(code[i + 3]);
+        }
+        i += wordCount;
+    }
+    return constantIDs;
+}
+
 }
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <filesystem>
+#include <misc/types.hpp>
 #include <misc/utils.hpp>
 #include <rendering/core/rhi.hpp>
+#include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace NH3D {
@@ -21,6 +23,14 @@ protected:
         const ArrayWrapper<VkPushConstantRange> pushConstantRanges);
 
     static VkShaderModule loadShaderModule(VkDevice device, const std::filesystem::path& path);
+
+    // SPIR-V words of the shader, aborts if it doesn't exist
+    static std::vector<uint32> loadShaderCode(const std::filesystem::path& path);
+
+    static VkShaderModule createShaderModule(VkDevice device, const std::vector<uint32>& code, const std::filesystem::path& path);
+
+    // IDs of the specialization constants declared by the SPIR-V, in declaration order
+    static std::vector<uint32> getSpecializationConstantIDs(const std::vector<uint32>& code);
 };
 
 }
\ No newline at end of file
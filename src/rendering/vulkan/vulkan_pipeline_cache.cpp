@@ -0,0 +1,150 @@
+#include "vulkan_pipeline_cache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <rendering/vulkan/vulkan_rhi.hpp>
+#include <sstream>
+
+namespace NH3D {
+
+VulkanPipelineCache::VulkanPipelineCache(VulkanRHI* const rhi)
+    : _device { rhi->getVkDevice() }
+{
+    VkPhysicalDeviceIDProperties idProperties { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES };
+    VkPhysicalDeviceProperties2 properties { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &idProperties };
+    vkGetPhysicalDeviceProperties2(rhi->getGPU(), &properties);
+    _properties = properties.properties;
+    std::memcpy(_driverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+
+    std::stringstream fileName;
+    fileName << "nh3d_pipeline_cache_" << std::hex << _properties.vendorID << "_" << _properties.deviceID << ".bin";
+    _path = std::filesystem::temp_directory_path() / fileName.str();
+
+    const std::vector<byte> data = load();
+    _warm = !data.empty();
+
+    const VkPipelineCacheCreateInfo cacheCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.data(),
+    };
+    if (vkCreatePipelineCache(_device, &cacheCreateInfo, nullptr, &_cache) != VK_SUCCESS) {
+        NH3D_ABORT_VK("Failed to create the pipeline cache");
+    }
+}
+
+VulkanPipelineCache::~VulkanPipelineCache()
+{
+    save();
+    vkDestroyPipelineCache(_device, _cache, nullptr);
+}
+
+void VulkanPipelineCache::recordCompilation(const float time) const
+{
+    _compiledPipelineCount.fetch_add(1, std::memory_order_relaxed);
+    _compilationTime.fetch_add(time, std::memory_order_relaxed);
+}
+
+[[nodiscard]] VulkanPipelineCache::FileHeader VulkanPipelineCache::makeFileHeader() const
+{
+    FileHeader header {
+        .magic = Magic,
+        .engineVersion = VK_MAKE_VERSION(NH3D_VERSION_MAJOR, NH3D_VERSION_MINOR, NH3D_VERSION_PATCH),
+        .vendorID = _properties.vendorID,
+        .deviceID = _properties.deviceID,
+        .driverUUID = {},
+        .dataSize = 0,
+    };
+    std::memcpy(header.driverUUID, _driverUUID, VK_UUID_SIZE);
+
+    return header;
+}
+
+[[nodiscard]] std::vector<byte> VulkanPipelineCache::load() const
+{
+    std::ifstream file { _path, std::ios::binary };
+    if (!file.is_open()) {
+        NH3D_LOG("No pipeline cache at " << _path << ", starting from an empty one");
+        return {};
+    }
+
+    // Driver or engine updates invalidate the cache, rebuilt from scratch then
+    const FileHeader expectedHeader = makeFileHeader();
+    FileHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+    if (!file || header.magic != expectedHeader.magic || header.engineVersion != expectedHeader.engineVersion
+        || header.vendorID != expectedHeader.vendorID || header.deviceID != expectedHeader.deviceID
+        || std::memcmp(header.driverUUID, expectedHeader.driverUUID, VK_UUID_SIZE) != 0) {
+        NH3D_WARN("Pipeline cache at " << _path << " was written for another device, driver or engine version, ignoring it");
+        return {};
+    }
+
+    // Checked before allocating anything, a corrupted header could claim any size
+    std::error_code error;
+    const uintmax_t fileSize = std::filesystem::file_size(_path, error);
+    if (error || fileSize - sizeof(FileHeader) != header.dataSize) {
+        NH3D_WARN("Pipeline cache at " << _path << " is truncated, ignoring it");
+        return {};
+    }
+
+    std::vector<byte> data(header.dataSize);
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+    if (!file) {
+        NH3D_WARN("Pipeline cache at " << _path << " is truncated, ignoring it");
+        return {};
+    }
+
+    // The driver checks it again, but a mismatch is only reported by a validation error
+    VkPipelineCacheHeaderVersionOne vulkanHeader;
+    if (data.size() < sizeof(vulkanHeader)) {
+        NH3D_WARN("Pipeline cache at " << _path << " is invalid, ignoring it");
+        return {};
+    }
+    std::memcpy(&vulkanHeader, data.data(), sizeof(vulkanHeader));
+    if (vulkanHeader.headerSize < sizeof(vulkanHeader) || vulkanHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        || vulkanHeader.vendorID != _properties.vendorID || vulkanHeader.deviceID != _properties.deviceID
+        || std::memcmp(vulkanHeader.pipelineCacheUUID, _properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        NH3D_WARN("Pipeline cache at " << _path << " doesn't match the device, ignoring it");
+        return {};
+    }
+
+    NH3D_LOG("Loaded the pipeline cache from " << _path << " (" << data.size() / 1024 << " KB)");
+    return data;
+}
+
+void VulkanPipelineCache::save() const
+{
+    size_t dataSize;
+    if (vkGetPipelineCacheData(_device, _cache, &dataSize, nullptr) != VK_SUCCESS) {
+        NH3D_WARN("Failed to get the pipeline cache data");
+        return;
+    }
+    std::vector<byte> data(dataSize);
+    if (vkGetPipelineCacheData(_device, _cache, &dataSize, data.data()) != VK_SUCCESS) {
+        NH3D_WARN("Failed to get the pipeline cache data");
+        return;
+    }
+
+    // Written to a temporary file first, an interrupted save must not leave a truncated cache behind
+    FileHeader header = makeFileHeader();
+    header.dataSize = dataSize;
+    std::filesystem::path temporaryPath = _path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file { temporaryPath, std::ios::binary | std::ios::trunc };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+        file.write(reinterpret_cast<const char*>(data.data()), dataSize);
+        if (!file) {
+            NH3D_WARN("Failed to write the pipeline cache to " << temporaryPath);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, _path, error);
+    if (error) {
+        NH3D_WARN("Failed to save the pipeline cache to " << _path << ": " << error.message());
+    }
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace NH3D {
+
+class VulkanRHI;
+
+// VkPipelineCache persisted across launches, so that only the first launch on a device compiles the pipelines from scratch
+// One file per device, loaded at construction and saved at destruction. The file is ignored when it was written by another
+// driver or engine version, or when its header doesn't match the device
+class VulkanPipelineCache {
+    NH3D_NO_COPY_MOVE(VulkanPipelineCache)
+public:
+    VulkanPipelineCache() = delete;
+
+    VulkanPipelineCache(VulkanRHI* const rhi);
+
+    ~VulkanPipelineCache();
+
+    [[nodiscard]] inline VkPipelineCache get() const { return _cache; }
+
+    // False when the cache started empty
+    [[nodiscard]] inline bool isWarm() const { return _warm; }
+
+    // Time spent in vkCreate*Pipelines, to track the startup cost of the pipelines with and without the cache
+    void recordCompilation(const float time) const;
+
+    [[nodiscard]] inline uint32 getCompiledPipelineCount() const { return _compiledPipelineCount.load(std::memory_order_relaxed); }
+
+    // In milliseconds
+    [[nodiscard]] inline float getCompilationTime() const { return _compilationTime.load(std::memory_order_relaxed); }
+
+private:
+    // Prepended to the data returned by vkGetPipelineCacheData
+    struct FileHeader {
+        uint32 magic;
+        uint32 engineVersion;
+        uint32 vendorID;
+        uint32 deviceID;
+        uint8 driverUUID[VK_UUID_SIZE];
+        uint64 dataSize;
+    };
+
+    static constexpr uint32 Magic = 0x4E483344; // NH3D
+
+    [[nodiscard]] FileHeader makeFileHeader() const;
+
+    // Empty if the file is missing or doesn't match the device
+    [[nodiscard]] std::vector<byte> load() const;
+
+    void save() const;
+
+private:
+    VkDevice _device;
+    VkPhysicalDeviceProperties _properties;
+    uint8 _driverUUID[VK_UUID_SIZE];
+    std::filesystem::path _path;
+
+    VkPipelineCache _cache;
+    bool _warm = false;
+
+    mutable std::atomic<uint32> _compiledPipelineCount = 0;
+    mutable std::atomic<float> _compilationTime = 0.0f;
+};
+
+}
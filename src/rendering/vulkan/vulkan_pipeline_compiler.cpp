@@ -0,0 +1,54 @@
+#include "vulkan_pipeline_compiler.hpp"
+#include <general/thread_pool.hpp>
+#include <rendering/vulkan/vulkan_pipeline_cache.hpp>
+#include <rendering/vulkan/vulkan_rhi.hpp>
+
+namespace NH3D {
+
+VulkanPipelineCompiler::VulkanPipelineCompiler(VulkanRHI* const rhi)
+    : _rhi { rhi }
+    , _pipelineCache { &rhi->getPipelineCache() }
+    , _jobQueue { ThreadPool::getDefaultWorkerCount() }
+{
+}
+
+void VulkanPipelineCompiler::publishCompiled()
+{
+    std::vector<std::function<void()>> compiledPipelines;
+    {
+        std::lock_guard lock { _mutex };
+        compiledPipelines.swap(_compiledPipelines);
+    }
+    if (compiledPipelines.empty()) {
+        return;
+    }
+
+    for (const std::function<void()>& publish : compiledPipelines) {
+        publish();
+    }
+    _pendingCount -= compiledPipelines.size();
+
+    // Wall clock time of the whole batch against the time spent compiling, to keep an eye on the startup regressions
+    if (_pendingCount == 0) {
+        const std::chrono::duration<float, std::milli> batchTime = std::chrono::high_resolution_clock::now() - _batchStartTime;
+        NH3D_LOG("Compiled " << _batchPipelineCount << " pipelines in " << batchTime.count() << " ms on " << _jobQueue.getWorkerCount()
+                             << " threads, " << _pipelineCache->getCompilationTime() << " ms of compilation in total ("
+                             << (_pipelineCache->isWarm() ? "warm" : "cold") << " pipeline cache)");
+    }
+}
+
+void VulkanPipelineCompiler::waitForIdle()
+{
+    waitForCompiled();
+    publishCompiled();
+}
+
+void VulkanPipelineCompiler::waitForCompiled() const { _jobQueue.waitForIdle(); }
+
+void VulkanPipelineCompiler::onCompiled(std::function<void()> publish)
+{
+    std::lock_guard lock { _mutex };
+    _compiledPipelines.emplace_back(std::move(publish));
+}
+
+}
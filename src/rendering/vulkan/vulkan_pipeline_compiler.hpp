@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <general/job_queue.hpp>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <mutex>
+#include <rendering/core/handle.hpp>
+#include <rendering/core/resource_manager.hpp>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace NH3D {
+
+class VulkanRHI;
+class VulkanPipelineCache;
+
+// Compiles the pipelines on background threads, so that the startup cost scales with the core count instead of the pipeline count
+// The handles are returned right away and hold an invalid pipeline until it is compiled and published, the frames wait for the
+// pipelines they need while the debug passes are skipped. Reading the SPIR-V and the driver compilation both happen on the workers
+class VulkanPipelineCompiler {
+    NH3D_NO_COPY_MOVE(VulkanPipelineCompiler)
+public:
+    VulkanPipelineCompiler() = delete;
+
+    VulkanPipelineCompiler(VulkanRHI* const rhi);
+
+    // T is VulkanShader or VulkanComputeShader, the create info is copied
+    template <typename T>
+    [[nodiscard]] Handle<typename T::ResourceType> compile(ResourceManager<T>& manager, const typename T::CreateInfo& info);
+
+    // Moves the compiled pipelines into their resource manager, to be called by the thread that owns the resource managers
+    void publishCompiled();
+
+    // Blocks until every pipeline is compiled, then publishes them
+    void waitForIdle();
+
+    // Blocks until every pipeline is compiled, they still have to be published. Doesn't touch the resource managers
+    void waitForCompiled() const;
+
+    // Compiled and published
+    [[nodiscard]] inline bool isIdle() const { return _pendingCount == 0; }
+
+private:
+    void onCompiled(std::function<void()> publish);
+
+private:
+    const IRHI* _rhi;
+    const VulkanPipelineCache* _pipelineCache;
+
+    std::mutex _mutex;
+    std::vector<std::function<void()>> _compiledPipelines; // protected by _mutex, each one assigns its pipeline to its handle
+
+    // Owner thread only
+    uint32 _pendingCount = 0;
+    uint32 _batchPipelineCount = 0;
+    std::chrono::high_resolution_clock::time_point _batchStartTime;
+
+    JobQueue _jobQueue; // destroyed first, its jobs reference the members above
+};
+
+template <typename T>
+[[nodiscard]] Handle<typename T::ResourceType> VulkanPipelineCompiler::compile(
+    ResourceManager<T>& manager, const typename T::CreateInfo& info)
+{
+    if (_pendingCount == 0) {
+        _batchStartTime = std::chrono::high_resolution_clock::now();
+        _batchPipelineCount = 0;
+    }
+    ++_pendingCount;
+    ++_batchPipelineCount;
+
+    const Handle<typename T::ResourceType> handle = manager.reserve();
+    _jobQueue.submit([this, &manager, handle, asyncInfo = typename T::AsyncCreateInfo { info }] {
+        const std::pair<VkPipeline, VkPipelineLayout> pipeline = T::create(*_rhi, asyncInfo.get());
+        onCompiled([&manager, handle, pipeline] { manager.assign(handle, pipeline.first, pipeline.second); });
+    });
+
+    return handle;
+}
+
+}
@@ -1,7 +1,13 @@
 #include "vulkan_rhi.hpp"
 #include "rendering/core/bind_group.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <general/thread_pool.hpp>
 #include <general/window.hpp>
 #include <misc/math.hpp>
 #include <misc/types.hpp>
@@ -10,16 +16,25 @@
 #include <rendering/core/handle.hpp>
 #include <rendering/core/material.hpp>
 #include <rendering/core/resource_manager.hpp>
+#include <rendering/core/workgroup_tuner.hpp>
 #include <rendering/vulkan/vulkan_bind_group.hpp>
+#include <rendering/vulkan/vulkan_bindless_table.hpp>
 #include <rendering/vulkan/vulkan_buffer.hpp>
 #include <rendering/vulkan/vulkan_compute_shader.hpp>
 #include <rendering/vulkan/vulkan_debug_drawer.hpp>
 #include <rendering/vulkan/vulkan_enums.hpp>
+#include <rendering/vulkan/vulkan_geometry_arena.hpp>
+#include <rendering/vulkan/vulkan_gpu_scene.hpp>
+#include <rendering/vulkan/vulkan_pipeline_cache.hpp>
+#include <rendering/vulkan/vulkan_pipeline_compiler.hpp>
 #include <rendering/vulkan/vulkan_shader.hpp>
+#include <rendering/vulkan/vulkan_staging_ring.hpp>
 #include <rendering/vulkan/vulkan_texture.hpp>
+#include <scene/ecs/components/light_component.hpp>
 #include <scene/ecs/components/render_component.hpp>
 #include <scene/ecs/components/transform_component.hpp>
 #include <scene/scene.hpp>
+#include <sstream>
 #include <unordered_set>
 #include <utility>
 #include <vulkan/vulkan_core.h>
@@ -28,14 +43,16 @@
 
 namespace NH3D {
 
-VulkanRHI::VulkanRHI(const Window& Window)
-    : IRHI {}
+VulkanRHI::VulkanRHI(const Window& Window, const uint32 framesInFlight)
+    : IRHI { framesInFlight }
     , _textureManager { 1000, 100 }
     , _bufferManager { 40000, 400 }
     , _shaderManager { 100, 10 }
     , _computeShaderManager { 100, 10 }
     , _bindGroupManager { 200, 20 }
 {
+    _startupStartTime = std::chrono::high_resolution_clock::now();
+
     _instance = createVkInstance(Window.requiredVulkanExtensions());
 
 #if NH3D_DEBUG
@@ -50,184 +67,219 @@ VulkanRHI::VulkanRHI(const Window& Window)
 
     _device = createLogicalDevice(_gpu, queues);
     _allocator = createVMAAllocator(_instance, _gpu, _device);
+    _pipelineCache = std::make_unique<VulkanPipelineCache>(this);
+    _pipelineCompiler = std::make_unique<VulkanPipelineCompiler>(this);
 
     vkGetDeviceQueue(_device, queues.GraphicsQueueFamilyID, 0, &_graphicsQueue);
     vkGetDeviceQueue(_device, queues.PresentQueueFamilyID, 0, &_presentQueue);
+    vkGetDeviceQueue(_device, queues.TransferQueueFamilyID, 0, &_transferQueue);
+
+    _graphicsTimeline = std::make_unique<VulkanTimeline>(this);
 
-    // Creates the swapchain, get the images, create render/present semaphores, fences, gbuffer RTs and final RTs
+    // Creates the swapchain, get the images, create render/present semaphores
     handleResize();
 
-    _commandPool = createCommandPool(_device, queues.GraphicsQueueFamilyID);
-    allocateCommandBuffers(_device, _commandPool, MaxFramesInFlight, &_commandBuffers[0]);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(_gpu, &properties);
+    _timestampPeriod = properties.limits.timestampComputeAndGraphics ? properties.limits.timestampPeriod : 0.0f;
+
+    if (_timestampPeriod > 0.0f && supportsDeviceExtension(_gpu, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+        _getCalibratedTimestamps
+            = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(vkGetDeviceProcAddr(_device, "vkGetCalibratedTimestampsEXT"));
+    }
+
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(_gpu, &supportedFeatures);
+    _visibilityBufferSupported = supportedFeatures.geometryShader && supportedFeatures.shaderStorageImageExtendedFormats;
+    if (!_visibilityBufferSupported) {
+        NH3D_WARN("The visibility buffer isn't supported by this device, falling back to the GBuffer path");
+    }
+
+    // Next to the pipeline cache, the winners depend on the driver compiler
+    std::stringstream workgroupSizesFileName;
+    workgroupSizesFileName << "nh3d_workgroup_sizes_" << std::hex << properties.vendorID << "_" << properties.deviceID << ".txt";
+    _workgroupTuner = std::make_unique<WorkgroupTuner>(
+        std::filesystem::temp_directory_path() / workgroupSizesFileName.str(), properties.driverVersion);
+
+    _threadPool = std::make_unique<ThreadPool>(ThreadPool::getDefaultWorkerCount());
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        const uint32 threadCount = _threadPool->getThreadCount();
+        _recordingCommandPools[i].resize(threadCount);
+        _passCommandBuffers[i].resize(threadCount * RenderGraph::MaxPasses);
+        for (uint32 threadId = 0; threadId < threadCount; ++threadId) {
+            _recordingCommandPools[i][threadId] = createCommandPool(_device, queues.GraphicsQueueFamilyID);
+            allocateCommandBuffers(_device, _recordingCommandPools[i][threadId], RenderGraph::MaxPasses,
+                &_passCommandBuffers[i][threadId * RenderGraph::MaxPasses]);
+        }
+        allocateCommandBuffers(_device, _recordingCommandPools[i][0], 1, &_uploadAcquireCommandBuffers[i]);
+
+        const VkQueryPoolCreateInfo queryPoolCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2 * RenderGraph::MaxPasses,
+        };
+        if (vkCreateQueryPool(_device, &queryPoolCreateInfo, nullptr, &_timestampQueryPools[i]) != VK_SUCCESS) {
+            NH3D_ABORT_VK("Failed to create timestamp query pool");
+        }
+        vkResetQueryPool(_device, _timestampQueryPools[i], 0, queryPoolCreateInfo.queryCount);
+
+        _pipelineStatisticsQueryPools[i] = VK_NULL_HANDLE;
+        if (supportedFeatures.pipelineStatisticsQuery) {
+            const VkQueryPoolCreateInfo statisticsQueryPoolCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+                .queryCount = 2, // early and late GBuffer passes
+                .pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+                    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT,
+            };
+            if (vkCreateQueryPool(_device, &statisticsQueryPoolCreateInfo, nullptr, &_pipelineStatisticsQueryPools[i]) != VK_SUCCESS) {
+                NH3D_ABORT_VK("Failed to create pipeline statistics query pool");
+            }
+            vkResetQueryPool(_device, _pipelineStatisticsQueryPools[i], 0, statisticsQueryPoolCreateInfo.queryCount);
+        }
+    }
 
     _immediateCommandPool = createCommandPool(_device, queues.GraphicsQueueFamilyID);
     allocateCommandBuffers(_device, _immediateCommandPool, 1, &_immediateCommandBuffer);
-    _immediateAndUploadFence = createFence(_device, false);
 
-    _uploadCommandPool = createCommandPool(_device, queues.GraphicsQueueFamilyID);
-    allocateCommandBuffers(_device, _uploadCommandPool, 1, &_uploadCommandBuffer);
-    beginCommandBuffer(_uploadCommandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    _uploadCommandPool = createCommandPool(_device, queues.TransferQueueFamilyID);
+    allocateCommandBuffers(_device, _uploadCommandPool, UploadBatchCount, _uploadCommandBuffers.data());
+    beginCommandBuffer(_uploadCommandBuffers[0], VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    _uploadTimeline = std::make_unique<VulkanTimeline>(this);
+
+    constexpr uint32 MaxObjects = VulkanGPUScene::MaxObjects;
 
-    constexpr uint32 MaxObjects = 640'000;
+    _stagingRing = std::make_unique<VulkanStagingRing>(this);
+    _geometryArena = std::make_unique<VulkanGeometryArena>(this);
+    _gpuScene = std::make_unique<VulkanGPUScene>(this);
 
-    const VkDescriptorType objectDataTypes[] = {
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // RenderData buffer
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // VisibleFlags buffer
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // AABBs buffer
+    const VkDescriptorType frameDataTypes[] = {
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Culling counters buffer
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Visibility buffer
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Object list buffer
     };
-    _cullingRenderDataBindGroup = _bindGroupManager.create(*this,
+    _cullingFrameDataBindGroup = _bindGroupManager.create(*this,
         {
             .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-            .bindingTypes = objectDataTypes,
+            .bindingTypes = frameDataTypes,
         });
 
-    for (int i = 0; i < IRHI::MaxFramesInFlight; ++i) {
-        _cullingRenderDataBuffers[i] = _bufferManager.create(*this,
-            {
-                .size = sizeof(RenderData) * MaxObjects,
-                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
-            });
-
-        _cullingRenderDataStagingBuffers[i] = _bufferManager.create(*this,
-            {
-                .size = sizeof(RenderData) * MaxObjects,
-                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                .memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY,
-            });
-
-        _cullingVisibleFlagBuffers[i] = _bufferManager.create(*this,
-            {
-                .size = MaxObjects / 8 + 1,
-                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
-            });
-
-        _cullingVisibleFlagStagingBuffers[i] = _bufferManager.create(*this,
-            {
-                .size = MaxObjects / 8 + 1,
-                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                .memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY,
-            });
-
-        _cullingAABBsBuffers[i] = _bufferManager.create(*this,
-            {
-                .size = sizeof(AABB) * MaxObjects,
-                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
-            });
+    // Shared by the frames in flight, the early culling of a frame reads what the late culling of the previous one wrote
+    _visibilityBuffer = _bufferManager.create(*this,
+        {
+            .size = MaxObjects * sizeof(uint32),
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+        });
+    const VkBuffer visibilityBuffer = _bufferManager.get<GPUBuffer>(_visibilityBuffer).buffer;
+    executeImmediateCommandBuffer(
+        [visibilityBuffer](VkCommandBuffer commandBuffer) { vkCmdFillBuffer(commandBuffer, visibilityBuffer, 0, VK_WHOLE_SIZE, 0); });
 
-        _cullingAABBsStagingBuffers[i] = _bufferManager.create(*this,
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        _cullingCounterBuffers[i] = _bufferManager.create(*this,
             {
-                .size = sizeof(AABB) * MaxObjects,
-                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                .memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY,
+                .size = sizeof(CullingCounters),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_TO_CPU,
             });
 
-        const VkBuffer cullingAABBsBuffer = _bufferManager.get<GPUBuffer>(_cullingAABBsBuffers[i]).buffer;
-
-        auto& objectDataDescriptorSets = _bindGroupManager.get<DescriptorSets>(_cullingRenderDataBindGroup);
-        VulkanBindGroup::updateDescriptorSet(_device, objectDataDescriptorSets.sets[i],
+        auto& frameDataDescriptorSets = _bindGroupManager.get<DescriptorSets>(_cullingFrameDataBindGroup);
+        VulkanBindGroup::updateDescriptorSet(_device, frameDataDescriptorSets.sets[i],
             VkDescriptorBufferInfo {
-                .buffer = _bufferManager.get<GPUBuffer>(_cullingRenderDataBuffers[i]).buffer,
+                .buffer = _bufferManager.get<GPUBuffer>(_cullingCounterBuffers[i]).buffer,
                 .offset = 0,
                 .range = VK_WHOLE_SIZE,
             },
             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0);
-        VulkanBindGroup::updateDescriptorSet(_device, objectDataDescriptorSets.sets[i],
+        VulkanBindGroup::updateDescriptorSet(_device, frameDataDescriptorSets.sets[i],
             VkDescriptorBufferInfo {
-                .buffer = _bufferManager.get<GPUBuffer>(_cullingVisibleFlagBuffers[i]).buffer,
+                .buffer = visibilityBuffer,
                 .offset = 0,
                 .range = VK_WHOLE_SIZE,
             },
             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
-        VulkanBindGroup::updateDescriptorSet(_device, objectDataDescriptorSets.sets[i],
-            VkDescriptorBufferInfo {
-                .buffer = _bufferManager.get<GPUBuffer>(_cullingAABBsBuffers[i]).buffer,
-                .offset = 0,
-                .range = VK_WHOLE_SIZE,
-            },
-            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2);
-    }
-
-    const VkDescriptorType frameDataTypes[] = {
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // TransformData buffer
-        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // DrawCounter buffer
-    };
-    _cullingFrameDataBindGroup = _bindGroupManager.create(*this,
-        {
-            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-            .bindingTypes = frameDataTypes,
-        });
 
-    for (int i = 0; i < IRHI::MaxFramesInFlight; ++i) {
-        _cullingTransformBuffers[i] = _bufferManager.create(*this,
+        _objectListBuffers[i] = _bufferManager.create(*this,
             {
-                .size = sizeof(TransformComponent) * MaxObjects,
+                .size = MaxObjects * sizeof(uint32),
                 .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                 .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
             });
-        const VkBuffer cullingTransformBuffer = _bufferManager.get<GPUBuffer>(_cullingTransformBuffers[i]).buffer;
-
-        _cullingDrawCounterBuffers[i] = _bufferManager.create(*this,
-            {
-                .size = sizeof(uint32),
-                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
-                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
-            });
-
-        auto& frameDataDescriptorSets = _bindGroupManager.get<DescriptorSets>(_cullingFrameDataBindGroup);
-        VulkanBindGroup::updateDescriptorSet(_device, frameDataDescriptorSets.sets[i],
-            VkDescriptorBufferInfo {
-                .buffer = _bufferManager.get<GPUBuffer>(_cullingTransformBuffers[i]).buffer,
-                .offset = 0,
-                .range = VK_WHOLE_SIZE,
-            },
-            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0);
         VulkanBindGroup::updateDescriptorSet(_device, frameDataDescriptorSets.sets[i],
             VkDescriptorBufferInfo {
-                .buffer = _bufferManager.get<GPUBuffer>(_cullingDrawCounterBuffers[i]).buffer,
+                .buffer = _bufferManager.get<GPUBuffer>(_objectListBuffers[i]).buffer,
                 .offset = 0,
                 .range = VK_WHOLE_SIZE,
             },
-            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2);
     }
 
-    const VkDescriptorType drawIndirectTypes[] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
+    const VkDescriptorType drawIndirectTypes[] = {
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Per-mesh draws
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Meshlet draws
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Cluster dispatch
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Material bins
+    };
     _drawIndirectCommandBindGroup = _bindGroupManager.create(*this,
         {
             .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
             .bindingTypes = drawIndirectTypes,
         });
-    const VkDescriptorType storageBufferType[] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
+    const VkDescriptorType drawRecordTypes[] = {
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // DrawRecord buffer
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Instance index buffer
+    };
     _drawRecordBindGroup = _bindGroupManager.create(*this,
         {
             .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,
-            .bindingTypes = storageBufferType,
+            .bindingTypes = drawRecordTypes,
         });
-    for (int i = 0; i < IRHI::MaxFramesInFlight; ++i) {
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        // One indexed instanced draw per mesh slot and LOD in each draw list
         _drawIndirectBuffers[i] = _bufferManager.create(*this,
             {
-                .size = MaxObjects * sizeof(VkDrawIndirectCommand),
-                .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .size = DrawListCount * VulkanGPUScene::MaxMeshes * Geometry::MaxLODs * sizeof(VkDrawIndexedIndirectCommand),
+                .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            });
+        // One single instance draw per visible meshlet, drawn with the count written by the cluster culling
+        _meshletDrawBuffers[i] = _bufferManager.create(*this,
+            {
+                .size = MeshletDrawsOffset + DrawListCount * MaxMeshletDraws * sizeof(VkDrawIndexedIndirectCommand),
+                .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            });
+        _clusterDispatchBuffers[i] = _bufferManager.create(*this,
+            {
+                .size = sizeof(ClusterDispatch),
+                .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            });
+        // Instance counts then offsets of every bin of every per-mesh draw, then the objects staged by the culling passes
+        _materialBinBuffers[i] = _bufferManager.create(*this,
+            {
+                .size = sizeof(MaterialBinHeader)
+                    + (DrawListCount * VulkanGPUScene::MaxMeshes * Geometry::MaxLODs * MaterialBinCount + 2 * MaxObjects) * sizeof(uint32),
+                .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                 .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
             });
-        auto& drawIndirectBuffer = _bufferManager.get<GPUBuffer>(_drawIndirectBuffers[i]);
-        auto& drawIndirectAllocation = _bufferManager.get<BufferAllocationInfo>(_drawIndirectBuffers[i]);
 
-        VkPhysicalDeviceProperties properties;
-        vkGetPhysicalDeviceProperties(_gpu, &properties);
-        NH3D_ASSERT(drawIndirectAllocation.allocatedSize / sizeof(VkDrawIndirectCommand) < properties.limits.maxDrawIndirectCount,
+        NH3D_ASSERT(VulkanGPUScene::MaxMeshes * Geometry::MaxLODs < properties.limits.maxDrawIndirectCount,
             "Insufficient max indirect draw count");
+        NH3D_ASSERT(MaxMeshletDraws < properties.limits.maxDrawIndirectCount, "Insufficient max indirect draw count");
 
         auto& drawIndirectDescriptorSets = _bindGroupManager.get<DescriptorSets>(_drawIndirectCommandBindGroup);
-        VulkanBindGroup::updateDescriptorSet(_device, drawIndirectDescriptorSets.sets[i],
-            VkDescriptorBufferInfo {
-                .buffer = drawIndirectBuffer.buffer,
-                .offset = 0,
-                .range = VK_WHOLE_SIZE,
-            },
-            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0);
+        const Handle<Buffer> drawIndirectBuffers[]
+            = { _drawIndirectBuffers[i], _meshletDrawBuffers[i], _clusterDispatchBuffers[i], _materialBinBuffers[i] };
+        for (uint32 binding = 0; binding < std::size(drawIndirectBuffers); ++binding) {
+            VulkanBindGroup::updateDescriptorSet(_device, drawIndirectDescriptorSets.sets[i],
+                VkDescriptorBufferInfo {
+                    .buffer = _bufferManager.get<GPUBuffer>(drawIndirectBuffers[binding]).buffer,
+                    .offset = 0,
+                    .range = VK_WHOLE_SIZE,
+                },
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, binding);
+        }
 
         _drawRecordBuffers[i] = _bufferManager.create(*this,
             {
@@ -236,6 +288,15 @@ VulkanRHI::VulkanRHI(const Window& Window)
                 .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
             });
 
+        // Early and late per-mesh instances, then early and late objects drawn per meshlet, then one instance per meshlet draw
+        // so the visibility buffer can find the draw of a pixel
+        _instanceIndexBuffers[i] = _bufferManager.create(*this,
+            {
+                .size = (2 * (VulkanGPUScene::MaxInstances + MaxObjects) + DrawListCount * MaxMeshletDraws) * sizeof(uint32),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            });
+
         auto& drawRecordDescriptorSets = _bindGroupManager.get<DescriptorSets>(_drawRecordBindGroup);
         VulkanBindGroup::updateDescriptorSet(_device, drawRecordDescriptorSets.sets[i],
             VkDescriptorBufferInfo {
@@ -244,26 +305,31 @@ VulkanRHI::VulkanRHI(const Window& Window)
                 .range = VK_WHOLE_SIZE,
             },
             VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0);
+        VulkanBindGroup::updateDescriptorSet(_device, drawRecordDescriptorSets.sets[i],
+            VkDescriptorBufferInfo {
+                .buffer = _bufferManager.get<GPUBuffer>(_instanceIndexBuffers[i]).buffer,
+                .offset = 0,
+                .range = VK_WHOLE_SIZE,
+            },
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
     }
 
-    const VkDescriptorType textureBindingTypes[] = { VK_DESCRIPTOR_TYPE_SAMPLER, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE };
-    _albedoTextureBindGroup = _bindGroupManager.create(*this,
+    _bindlessTable = std::make_unique<VulkanBindlessTable>(this);
+    _linearSampler = createSampler(_device, true);
+    const uint32 linearSamplerIndex = _bindlessTable->addSampler(_linearSampler);
+    NH3D_ASSERT(linearSamplerIndex == 0, "The shaders expect the linear sampler first, see bindless.inc.glsl");
+
+    // Sampled in place of the textures whose upload isn't completed yet
+    const byte fallbackTexel[] = { 128, 128, 128, 255 };
+    _fallbackTexture = _textureManager.create(*this,
         {
-            .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT, // TODO: update for compute shaders
-            .bindingTypes = textureBindingTypes,
-            .finalBindingCount = 1000,
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .extent = { 1, 1, 1 },
+            .usageFlags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT,
+            .initialData = fallbackTexel,
+            .generateMipMaps = false,
         });
-    _linearSampler = createSampler(_device, true);
-    auto& textureDescriptorSets = _bindGroupManager.get<DescriptorSets>(_albedoTextureBindGroup);
-    for (int i = 0; i < IRHI::MaxFramesInFlight; ++i) {
-        VulkanBindGroup::updateDescriptorSet(_device, textureDescriptorSets.sets[i],
-            VkDescriptorImageInfo {
-                .sampler = _linearSampler,
-                .imageView = VK_NULL_HANDLE,
-                .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-            },
-            VK_DESCRIPTOR_TYPE_SAMPLER, 0);
-    }
 
     const VkDescriptorType deferredShadingBindingTypes[] = {
         VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, // Normal RT
@@ -277,7 +343,76 @@ VulkanRHI::VulkanRHI(const Window& Window)
             .bindingTypes = deferredShadingBindingTypes,
         });
 
+    const VkDescriptorType lightBindingTypes[] = {
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Lights
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, // Light clusters
+    };
+    _lightBindGroup = _bindGroupManager.create(*this,
+        {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .bindingTypes = lightBindingTypes,
+        });
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        _lightBuffers[i] = _bufferManager.create(*this,
+            {
+                .size = MaxLights * sizeof(GPULight),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            });
+        // Fixed size list per cluster, every cluster writes its count so nothing has to be reset
+        _lightClusterBuffers[i] = _bufferManager.create(*this,
+            {
+                .size = LightClusterCount * (1 + MaxLightsPerCluster) * sizeof(uint32),
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+            });
+
+        auto& lightDescriptorSets = _bindGroupManager.get<DescriptorSets>(_lightBindGroup);
+        const Handle<Buffer> lightBuffers[] = { _lightBuffers[i], _lightClusterBuffers[i] };
+        for (uint32 binding = 0; binding < std::size(lightBuffers); ++binding) {
+            VulkanBindGroup::updateDescriptorSet(_device, lightDescriptorSets.sets[i],
+                VkDescriptorBufferInfo {
+                    .buffer = _bufferManager.get<GPUBuffer>(lightBuffers[binding]).buffer,
+                    .offset = 0,
+                    .range = VK_WHOLE_SIZE,
+                },
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, binding);
+        }
+    }
+
+    const VkDescriptorType visibilityResolveBindingTypes[] = {
+        VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, // Visibility RT
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, // Normal RT
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, // Albedo RT
+    };
+    _visibilityResolveBindGroup = _bindGroupManager.create(*this,
+        {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .bindingTypes = visibilityResolveBindingTypes,
+        });
+
+    const VkDescriptorType depthPyramidLevelBindingTypes[] = {
+        VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, // Depth RT or previous level
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, // Level
+    };
+    for (Handle<BindGroup>& bindGroup : _depthPyramidLevelBindGroups) {
+        bindGroup = _bindGroupManager.create(*this,
+            {
+                .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                .bindingTypes = depthPyramidLevelBindingTypes,
+            });
+    }
+
+    const VkDescriptorType depthPyramidBindingTypes[] = { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE };
+    _depthPyramidBindGroup = _bindGroupManager.create(*this,
+        {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .bindingTypes = depthPyramidBindingTypes,
+        });
+
+    buildRenderGraph();
     updateGBufferDescriptorSets();
+    updateDepthPyramidDescriptorSets();
 
     const VkPushConstantRange cullingPushConstantRange {
         .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
@@ -285,10 +420,10 @@ VulkanRHI::VulkanRHI(const Window& Window)
         .size = sizeof(CullingParameters),
     };
 
-    const auto& objectDataMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_cullingRenderDataBindGroup).layout;
+    const auto& objectDataMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_gpuScene->getObjectDataBindGroup()).layout;
     const auto& frameDataMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_cullingFrameDataBindGroup).layout;
     const auto& drawIndirectMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_drawIndirectCommandBindGroup).layout;
-    const auto& textureMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_albedoTextureBindGroup).layout;
+    const VkDescriptorSetLayout bindlessLayout = _bindlessTable->getLayout();
     const auto& drawRecordMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_drawRecordBindGroup).layout;
     const VkDescriptorSetLayout cullingLayouts[] = {
         objectDataMetadataLayout,
@@ -296,71 +431,198 @@ VulkanRHI::VulkanRHI(const Window& Window)
         drawIndirectMetadataLayout,
         drawRecordMetadataLayout,
     };
-    _frustumCullingCS = _computeShaderManager.create(*this,
+    // One invocation per object, the best size depends on the object count and the occupancy of the device
+    const vec3u cullingWorkgroupSizes[] = { { 64, 1, 1 }, { 32, 1, 1 }, { 128, 1, 1 }, { 256, 1, 1 } };
+    const uint32 cullingConstants[] = { LinearWorkgroupSize }; // material binning workgroup size
+    _frustumCullingKernel = createTunedComputeShader("EarlyCulling", cullingWorkgroupSizes,
         {
             .computeShaderPath = NH3D_DIR "src/rendering/shaders/culling.comp.spv",
             .descriptorSetsLayouts = cullingLayouts,
             .pushConstantRanges = cullingPushConstantRange,
+            .specializationConstants = cullingConstants,
+        });
+
+    const auto& depthPyramidMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_depthPyramidBindGroup).layout;
+    const VkDescriptorSetLayout lateCullingLayouts[] = {
+        objectDataMetadataLayout,
+        frameDataMetadataLayout,
+        drawIndirectMetadataLayout,
+        drawRecordMetadataLayout,
+        depthPyramidMetadataLayout,
+    };
+    _lateCullingKernel = createTunedComputeShader("LateCulling", cullingWorkgroupSizes,
+        {
+            .computeShaderPath = NH3D_DIR "src/rendering/shaders/culling_late.comp.spv",
+            .descriptorSetsLayouts = lateCullingLayouts,
+            .pushConstantRanges = cullingPushConstantRange,
+            .specializationConstants = cullingConstants,
+        });
+
+    const VkPushConstantRange clusterCullingPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(ClusterCullingParameters),
+    };
+    _clusterCullingCS = _pipelineCompiler->compile(_computeShaderManager,
+        {
+            .computeShaderPath = NH3D_DIR "src/rendering/shaders/cluster_culling.comp.spv",
+            .descriptorSetsLayouts = cullingLayouts,
+            .pushConstantRanges = clusterCullingPushConstantRange,
+            .workgroupSize = { LinearWorkgroupSize, 1, 1 },
+        });
+
+    const VkPushConstantRange materialBinningPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(MaterialBinningParameters),
+    };
+    _materialBinningCS = _pipelineCompiler->compile(_computeShaderManager,
+        {
+            .computeShaderPath = NH3D_DIR "src/rendering/shaders/material_binning.comp.spv",
+            .descriptorSetsLayouts = cullingLayouts,
+            .pushConstantRanges = materialBinningPushConstantRange,
+            .workgroupSize = { LinearWorkgroupSize, 1, 1 },
+        });
+
+    const VkDescriptorSetLayout depthPyramidLevelLayouts[] = {
+        _bindGroupManager.get<BindGroupMetadata>(_depthPyramidLevelBindGroups[0]).layout,
+    };
+    _depthPyramidCS = _pipelineCompiler->compile(_computeShaderManager,
+        {
+            .computeShaderPath = NH3D_DIR "src/rendering/shaders/depth_pyramid.comp.spv",
+            .descriptorSetsLayouts = depthPyramidLevelLayouts,
+            .workgroupSize = { TileWorkgroupSize, TileWorkgroupSize, 1 },
         });
 
-    const VkPushConstantRange gbufferPushConstantRange { .stageFlags = VK_SHADER_STAGE_VERTEX_BIT, .offset = 0, .size = sizeof(mat4) };
+    const VkPushConstantRange gbufferPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset = 0,
+        .size = sizeof(GBufferParameters),
+    };
 
-    const VkFormat normalRTFormat = _textureManager.get<TextureMetadata>(_gbufferRTs[0].normalRT).format;
-    const VkFormat albedoRTFormat = _textureManager.get<TextureMetadata>(_gbufferRTs[0].albedoRT).format;
     const VulkanShader::ColorAttachmentInfo colorAttachmentInfos[] = {
         {
-            .format = normalRTFormat,
+            .format = NormalRTFormat,
             .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT,
             .blendEnable = false,
         },
         {
-            .format = albedoRTFormat,
+            .format = AlbedoRTFormat,
             .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT,
             .blendEnable = false,
         },
     };
 
-    const VkDescriptorSetLayout gbufferLayouts[] = { textureMetadataLayout, drawRecordMetadataLayout };
-    _gbufferShader = _shaderManager.create(*this,
+    const VkDescriptorSetLayout gbufferLayouts[] = { bindlessLayout, drawRecordMetadataLayout };
+    _gbufferShader = _pipelineCompiler->compile(_shaderManager,
         {
             .vertexShaderPath = NH3D_DIR "src/rendering/shaders/default_gbuffer_deferred.vert.spv",
             .fragmentShaderPath = NH3D_DIR "src/rendering/shaders/default_gbuffer_deferred.frag.spv",
             .colorAttachmentFormats = { colorAttachmentInfos, std::size(colorAttachmentInfos) },
-            .depthAttachmentFormat = VK_FORMAT_D32_SFLOAT,
+            .depthAttachmentFormat = DepthRTFormat,
             .descriptorSetsLayouts = gbufferLayouts,
             .pushConstantRanges = gbufferPushConstantRange,
         });
 
+    // Unused on the devices without the visibility buffer features, see createLogicalDevice
+    if (_visibilityBufferSupported) {
+        // Only the instance and triangle, the attributes are fetched by the resolve pass
+        const VulkanShader::ColorAttachmentInfo visibilityAttachmentInfo {
+            .format = VisibilityRTFormat,
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT,
+            .blendEnable = false,
+        };
+        _visibilityShader = _pipelineCompiler->compile(_shaderManager,
+            {
+                .vertexShaderPath = NH3D_DIR "src/rendering/shaders/visibility.vert.spv",
+                .fragmentShaderPath = NH3D_DIR "src/rendering/shaders/visibility.frag.spv",
+                .colorAttachmentFormats = visibilityAttachmentInfo,
+                .depthAttachmentFormat = DepthRTFormat,
+                .descriptorSetsLayouts = gbufferLayouts,
+                .pushConstantRanges = gbufferPushConstantRange,
+            });
+
+        const VkDescriptorSetLayout visibilityResolveLayouts[] = {
+            objectDataMetadataLayout,
+            drawIndirectMetadataLayout,
+            drawRecordMetadataLayout,
+            bindlessLayout,
+            _bindGroupManager.get<BindGroupMetadata>(_visibilityResolveBindGroup).layout,
+        };
+        const VkPushConstantRange visibilityResolvePushConstantRange {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0,
+            .size = sizeof(VisibilityResolveParameters),
+        };
+        _visibilityResolveCS = _pipelineCompiler->compile(_computeShaderManager,
+            {
+                .computeShaderPath = NH3D_DIR "src/rendering/shaders/visibility_resolve.comp.spv",
+                .descriptorSetsLayouts = visibilityResolveLayouts,
+                .pushConstantRanges = visibilityResolvePushConstantRange,
+                .workgroupSize = { TileWorkgroupSize, TileWorkgroupSize, 1 },
+            });
+    }
+
+    const auto& lightMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_lightBindGroup).layout;
+    const VkPushConstantRange lightCullingPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(LightCullingParameters),
+    };
+    _lightCullingCS = _pipelineCompiler->compile(_computeShaderManager,
+        {
+            .computeShaderPath = NH3D_DIR "src/rendering/shaders/light_culling.comp.spv",
+            .descriptorSetsLayouts = lightMetadataLayout,
+            .pushConstantRanges = lightCullingPushConstantRange,
+            .workgroupSize = { LinearWorkgroupSize, 1, 1 },
+        });
+
     const auto& deferredShadingMetadataLayout = _bindGroupManager.get<BindGroupMetadata>(_deferredShadingBindGroup).layout;
     const VkDescriptorSetLayout deferredShadingLayouts[] = {
         deferredShadingMetadataLayout,
+        lightMetadataLayout,
     };
-    _deferredShadingCS = _computeShaderManager.create(*this,
+    const VkPushConstantRange shadingPushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(ShadingParameters),
+    };
+    // One invocation per pixel, wider tiles trade the cache locality of the light lists for fewer workgroups
+    const vec3u shadingWorkgroupSizes[] = { { 8, 8, 1 }, { 16, 8, 1 }, { 8, 4, 1 }, { 16, 16, 1 } };
+    _deferredShadingKernel = createTunedComputeShader("DeferredShading", shadingWorkgroupSizes,
         {
             .computeShaderPath = NH3D_DIR "src/rendering/shaders/deferred_shading.comp.spv",
             .descriptorSetsLayouts = deferredShadingLayouts,
+            .pushConstantRanges = shadingPushConstantRange,
         });
 
-    std::array<Handle<Texture>, MaxFramesInFlight> depthTextures;
-    for (int i = 0; i < MaxFramesInFlight; ++i) {
-        depthTextures[i] = _gbufferRTs[i].depthRT;
-    }
-
     VkFormat surfaceFormat = _textureManager.get<TextureMetadata>(_swapchainTextures[0]).format;
     _debugDrawer = std::make_unique<VulkanDebugDrawer>(this,
         DebugDrawSetupData {
             .extent = { Window.getWidth(), Window.getHeight() },
             .attachmentFormat = surfaceFormat,
-            .transformDataBuffers = _cullingTransformBuffers,
-            .objectAABBsBuffers = _cullingAABBsBuffers,
+            .transformDataBuffer = _gpuScene->getTransformBuffer(),
+            .objectAABBsBuffer = _gpuScene->getAABBBuffer(),
         });
+
+    // The fallback and debug UI font textures are used without waiting for their upload, the first frame completes them
+    flushUploadCommands();
+    _uploadTimeline->wait(_uploadTimeline->getSubmittedValue());
 }
 
 VulkanRHI::~VulkanRHI()
 {
     vkDeviceWaitIdle(_device);
 
+    // The workers may still be compiling into the resource managers
+    _pipelineCompiler->waitForIdle();
+    _pipelineCompiler.reset();
+
     _debugDrawer.reset();
+    _gpuScene.reset();
+    _geometryArena.reset();
+    _stagingRing.reset();
+    releaseRenderGraph();
 
     vkDestroySampler(_device, _linearSampler, nullptr);
     _textureManager.clear(*this);
@@ -368,9 +630,9 @@ VulkanRHI::~VulkanRHI()
     _shaderManager.clear(*this);
     _computeShaderManager.clear(*this);
     _bindGroupManager.clear(*this);
+    _bindlessTable.reset();
 
-    for (int i = 0; i < MaxFramesInFlight; ++i) {
-        vkDestroyFence(_device, _frameFences[i], nullptr);
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
         vkDestroySemaphore(_device, _presentSemaphores[i], nullptr);
     }
 
@@ -378,10 +640,20 @@ VulkanRHI::~VulkanRHI()
         vkDestroySemaphore(_device, _renderSemaphores[i], nullptr);
     }
 
-    vkDestroyFence(_device, _immediateAndUploadFence, nullptr);
+    _graphicsTimeline.reset();
+    _uploadTimeline.reset();
+    _pipelineCache.reset(); // saved to disk
     vkDestroyCommandPool(_device, _uploadCommandPool, nullptr);
     vkDestroyCommandPool(_device, _immediateCommandPool, nullptr);
-    vkDestroyCommandPool(_device, _commandPool, nullptr);
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        for (const VkCommandPool commandPool : _recordingCommandPools[i]) {
+            vkDestroyCommandPool(_device, commandPool, nullptr);
+        }
+        vkDestroyQueryPool(_device, _timestampQueryPools[i], nullptr);
+        if (_pipelineStatisticsQueryPools[i] != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(_device, _pipelineStatisticsQueryPools[i], nullptr);
+        }
+    }
 
     vmaDestroyAllocator(_allocator);
 
@@ -400,67 +672,154 @@ VulkanRHI::~VulkanRHI()
     NH3D_LOG("Vulkan objects cleanup completed");
 }
 
-void VulkanRHI::recordBufferUploadCommands(const std::function<void(VkCommandBuffer)>& recordFunction) const
+void VulkanRHI::recordBufferUploadCommands(const VkBuffer dstBuffer, const VkDeviceSize dstOffset, const VkDeviceSize size,
+    const std::function<void(VkCommandBuffer)>& recordFunction) const
+{
+    recordUploadCommands(recordFunction);
+
+    // The uploads overwrite the whole range so the graphics queue doesn't have to release it first, its content doesn't matter
+    if (_queues.hasDedicatedTransferQueue()) {
+        _uploadReleaseBarriers.emplace_back(VkBufferMemoryBarrier2 {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+            .dstAccessMask = VK_ACCESS_2_NONE,
+            .srcQueueFamilyIndex = _queues.TransferQueueFamilyID,
+            .dstQueueFamilyIndex = _queues.GraphicsQueueFamilyID,
+            .buffer = dstBuffer,
+            .offset = dstOffset,
+            .size = size,
+        });
+    }
+}
+
+void VulkanRHI::recordUploadCommands(const std::function<void(VkCommandBuffer)>& recordFunction) const
 {
     _uploadsToBeFlushed = true;
-    recordFunction(_uploadCommandBuffer);
+    recordFunction(_uploadCommandBuffers[_uploadTimeline->getSubmittedValue() % UploadBatchCount]);
+}
+
+[[nodiscard]] uint64 VulkanRHI::finishTextureUpload(const VulkanTexture::Upload& upload) const
+{
+    const VkCommandBuffer uploadCommandBuffer = _uploadCommandBuffers[_uploadTimeline->getSubmittedValue() % UploadBatchCount];
+
+    // Stays in TRANSFER_DST_OPTIMAL, the graphics queue acquires it with the same layouts before generating the mips
+    if (_queues.hasDedicatedTransferQueue()) {
+        VulkanTexture::insertMemoryBarrier(uploadCommandBuffer, upload.image, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false, 0, 1, _queues.TransferQueueFamilyID, _queues.GraphicsQueueFamilyID);
+    }
+
+    const uint64 uploadValue = _uploadTimeline->getPendingValue();
+    _pendingTextureUploads.emplace_back(PendingTextureUpload { .upload = upload, .uploadValue = uploadValue });
+    return uploadValue;
 }
 
 void VulkanRHI::flushUploadCommands() const
 {
-    vkEndCommandBuffer(_uploadCommandBuffer);
-    submitCommandBuffer(_graphicsQueue, {}, {}, _uploadCommandBuffer, _immediateAndUploadFence);
+    const VkCommandBuffer uploadCommandBuffer = _uploadCommandBuffers[_uploadTimeline->getSubmittedValue() % UploadBatchCount];
+    if (!_uploadReleaseBarriers.empty()) {
+        const VkDependencyInfo dependencyInfo {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = static_cast<uint32>(_uploadReleaseBarriers.size()),
+            .pBufferMemoryBarriers = _uploadReleaseBarriers.data(),
+        };
+        vkCmdPipelineBarrier2(uploadCommandBuffer, &dependencyInfo);
+
+        // The matching acquire, the semaphore wait of the graphics submission already covers the execution dependency
+        for (VkBufferMemoryBarrier2 barrier : _uploadReleaseBarriers) {
+            barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+            barrier.srcAccessMask = VK_ACCESS_2_NONE;
+            barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+            _uploadAcquireBarriers.emplace_back(barrier);
+        }
+        _uploadReleaseBarriers.clear();
+    }
 
-    vkWaitForFences(_device, 1, &_immediateAndUploadFence, VK_TRUE, NH3D_MAX_T(uint64_t));
-    vkResetFences(_device, 1, &_immediateAndUploadFence);
+    vkEndCommandBuffer(uploadCommandBuffer);
+    submitCommandBuffers(_transferQueue, {}, _uploadTimeline->signalNext(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT), uploadCommandBuffer);
 
     NH3D_DEBUGLOG("Flushed upload commands");
-    VulkanBuffer::flushedUploadCommands();
     _uploadsToBeFlushed = false;
 
-    beginCommandBuffer(_uploadCommandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    // The next command buffer was last submitted UploadBatchCount batches ago, usually long done
+    const uint64 submittedValue = _uploadTimeline->getSubmittedValue();
+    if (submittedValue >= UploadBatchCount) {
+        _uploadTimeline->wait(submittedValue - UploadBatchCount + 1);
+    }
+    beginCommandBuffer(_uploadCommandBuffers[submittedValue % UploadBatchCount], VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 }
 
 void VulkanRHI::executeImmediateCommandBuffer(const std::function<void(VkCommandBuffer)>& recordFunction) const
 {
     beginCommandBuffer(_immediateCommandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
+    recordUploadAcquireBarriers(_immediateCommandBuffer);
     recordFunction(_immediateCommandBuffer);
 
     vkEndCommandBuffer(_immediateCommandBuffer);
-    submitCommandBuffer(_graphicsQueue, {}, {}, _immediateCommandBuffer, _immediateAndUploadFence);
+    const VkSemaphoreSubmitInfo signalSemaphore = _graphicsTimeline->signalNext(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+    submitCommandBuffers(_graphicsQueue, makeUploadWaitSemaphoreInfo(), signalSemaphore, _immediateCommandBuffer);
 
-    vkWaitForFences(_device, 1, &_immediateAndUploadFence, VK_TRUE, NH3D_MAX_T(uint64_t));
-    vkResetFences(_device, 1, &_immediateAndUploadFence);
+    _graphicsTimeline->wait(signalSemaphore.value);
 }
 
 Handle<Texture> VulkanRHI::createTexture(const Texture::CreateInfo& info)
 {
+    std::lock_guard lock { _resourceMutex };
+    const VkImageUsageFlags usageFlags = MapTextureUsageFlags(info.usage);
     Handle<Texture> texture = _textureManager.create(*this,
         {
             .format = MapTextureFormat(info.format),
             .extent = { info.size.x, info.size.y, info.size.z },
-            .usageFlags = MapTextureUsageFlags(info.usage),
+            .usageFlags = usageFlags,
             .aspectFlags = MapTextureAspectFlags(info.aspect),
             .initialData = info.initialData,
             .generateMipMaps = info.generateMipMaps,
         });
 
-    auto& descriptorSets = _bindGroupManager.get<DescriptorSets>(_albedoTextureBindGroup);
-    const VkDescriptorImageInfo imageInfo {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = _textureManager.get<ImageView>(texture).view,
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    VulkanBindGroup::registerBufferedUpdate(descriptorSets, imageInfo, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, texture.index);
+    // Usable right away, the fallback is sampled until the upload is completed by a frame. A handle is only reused once the frames
+    // that may sample its slot retired, see collectReleased. The mip generation makes the texture sampled, see VulkanTexture::create
+    const bool uploading = _textureManager.get<TextureMetadata>(texture).uploadValue > 0;
+    if (info.generateMipMaps || (usageFlags & VK_IMAGE_USAGE_SAMPLED_BIT)) {
+        _bindlessTable->setSampledImage(texture.index, _textureManager.get<ImageView>(uploading ? _fallbackTexture : texture).view);
+        if (uploading) {
+            _pendingTextureBindings.emplace_back(texture);
+        }
+    }
+    if (usageFlags & VK_IMAGE_USAGE_STORAGE_BIT) {
+        _bindlessTable->setStorageImage(texture.index, _textureManager.get<ImageView>(texture).view);
+    }
 
     return texture;
 }
 
-void VulkanRHI::destroyTexture(const Handle<Texture> handle) { _textureManager.release(*this, handle); }
+void VulkanRHI::destroyTexture(const Handle<Texture> handle)
+{
+    std::lock_guard lock { _resourceMutex };
+
+    // The transfer queue may still be writing it, rare enough to wait
+    const uint64 uploadValue = _textureManager.get<TextureMetadata>(handle).uploadValue;
+    if (!_uploadTimeline->isRetired(uploadValue)) {
+        if (uploadValue > _uploadTimeline->getSubmittedValue()) {
+            flushUploadCommands();
+        }
+        _uploadTimeline->wait(uploadValue);
+    }
+    const VkImage image = _textureManager.get<ImageView>(handle).image;
+    std::erase_if(
+        _pendingTextureUploads, [image](const PendingTextureUpload& pendingUpload) { return pendingUpload.upload.image == image; });
+    std::erase(_pendingTextureBindings, handle);
+    _bindlessTable->cancelReplacement(handle.index);
+
+    releaseTexture(handle);
+}
 
 Handle<Buffer> VulkanRHI::createBuffer(const Buffer::CreateInfo& info)
 {
+    std::lock_guard lock { _resourceMutex };
     return _bufferManager.create(*this,
         {
             .size = info.size,
@@ -470,23 +829,76 @@ Handle<Buffer> VulkanRHI::createBuffer(const Buffer::CreateInfo& info)
         });
 }
 
-void VulkanRHI::destroyBuffer(const Handle<Buffer> handle) { _bufferManager.release(*this, handle); }
+void VulkanRHI::destroyBuffer(const Handle<Buffer> handle)
+{
+    std::lock_guard lock { _resourceMutex };
+    releaseBuffer(handle);
+}
 
-// TODO: cache command buffer?
-void VulkanRHI::render(Scene& scene)
+Handle<Geometry> VulkanRHI::createGeometry(const Geometry::CreateInfo& info)
 {
-    if (_uploadsToBeFlushed) {
-        flushUploadCommands();
-    }
+    std::lock_guard lock { _resourceMutex };
+    return _geometryArena->allocate(info);
+}
 
-    if (scene.getMainCamera() == InvalidEntity) {
+void VulkanRHI::destroyGeometry(const Handle<Geometry> handle)
+{
+    std::lock_guard lock { _resourceMutex };
+    _geometryArena->release(handle);
+}
+
+void VulkanRHI::extract(Scene& scene, RenderSnapshot& snapshot)
+{
+    // Stats of the frame the render thread produced the last time it got this snapshot
+    _stats = snapshot.stats;
+    _settings.visibilityBuffer &= _visibilityBufferSupported;
+    snapshot.settings = _settings;
+
+    snapshot.extract(scene);
+    VulkanDebugDrawer::extractDebugUI(snapshot.ui);
+}
+
+void VulkanRHI::render(RenderSnapshot& snapshot)
+{
+    // Resources created from the main thread wait for the recording to be done, but not for the frame in flight and the swapchain
+    std::unique_lock lock { _resourceMutex };
+
+    _pipelineCompiler->publishCompiled();
+    logStartupTime();
+
+    _frameSettings = snapshot.settings;
+    updateWorkgroupTuning();
+    if (!snapshot.hasCamera) {
+        // Nothing to draw, the uploads still go out
+        if (_uploadsToBeFlushed) {
+            flushUploadCommands();
+        }
         return;
     }
 
-    const uint32 frameInFlightId = _frameId % MaxFramesInFlight;
-    if (vkWaitForFences(_device, 1, &_frameFences[frameInFlightId], VK_TRUE, NH3D_MAX_T(uint64)) != VK_SUCCESS) {
-        NH3D_ABORT_VK("GPU stall detected");
+    // First frame on a cold pipeline cache or tuning variants requested, waiting beats dropping frames without presenting anything
+    // The main thread may keep creating resources meanwhile
+    if (!areFramePipelinesReady()) {
+        lock.unlock();
+        _pipelineCompiler->waitForCompiled();
+        lock.lock();
+        _pipelineCompiler->publishCompiled();
+        logStartupTime();
+    }
+
+    // The transient render targets and passes differ between the two modes
+    if (_frameSettings.visibilityBuffer != _visibilityBufferGraph) {
+        vkDeviceWaitIdle(_device);
+        buildRenderGraph();
+        updateGBufferDescriptorSets();
+        updateDepthPyramidDescriptorSets();
     }
+    lock.unlock();
+
+    // Usually already retired, see waitForNextFrame
+    const auto waitStartTime = std::chrono::high_resolution_clock::now();
+    const uint32 frameInFlightId = _frameId % getFramesInFlight();
+    _graphicsTimeline->wait(_frameTimelineValues[frameInFlightId]);
 
     uint32 swapchainImageId;
     VkResult swapchainImageAcquireResult;
@@ -494,203 +906,529 @@ void VulkanRHI::render(Scene& scene)
         swapchainImageAcquireResult = vkAcquireNextImageKHR(
             _device, _swapchain, NH3D_MAX_T(uint64), _presentSemaphores[frameInFlightId], nullptr, &swapchainImageId);
         if (swapchainImageAcquireResult == VK_ERROR_OUT_OF_DATE_KHR || swapchainImageAcquireResult == VK_SUBOPTIMAL_KHR) {
+            std::lock_guard resizeLock { _resourceMutex };
             handleResize();
         } else if (swapchainImageAcquireResult != VK_SUCCESS) {
             NH3D_ABORT_VK("Failed to acquire next swapchain image");
         }
     } while (swapchainImageAcquireResult != VK_SUCCESS);
-    vkResetFences(_device, 1, &_frameFences[frameInFlightId]);
-
-    VkCommandBuffer commandBuffer = _commandBuffers[frameInFlightId];
-
-    beginCommandBuffer(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-
-    // Buffer updates
-    const GPUBuffer& transformBuffer = _bufferManager.get<GPUBuffer>(_cullingTransformBuffers[frameInFlightId]);
-    const BufferAllocationInfo& transformAllocation = _bufferManager.get<BufferAllocationInfo>(_cullingTransformBuffers[frameInFlightId]);
-    TransformComponent* transformDataPtr
-        = reinterpret_cast<TransformComponent*>(VulkanBuffer::getMappedAddress(*this, transformAllocation));
-
-    uint32 objectCount = 0;
-    // TODO: track dirty state properly
-    const bool dirtyRenderingData = _frameId < MaxFramesInFlight;
-    if (dirtyRenderingData) {
-        const GPUBuffer& objectDataStagingBuffer = _bufferManager.get<GPUBuffer>(_cullingRenderDataStagingBuffers[frameInFlightId]);
-        const BufferAllocationInfo& objectDataStagingAllocation
-            = _bufferManager.get<BufferAllocationInfo>(_cullingRenderDataStagingBuffers[frameInFlightId]);
-        RenderData* objectDataPtr = reinterpret_cast<RenderData*>(VulkanBuffer::getMappedAddress(*this, objectDataStagingAllocation));
-
-        const GPUBuffer& aabbStagingBuffer = _bufferManager.get<GPUBuffer>(_cullingAABBsStagingBuffers[frameInFlightId]);
-        AABB* aabbDataPtr = reinterpret_cast<AABB*>(
-            VulkanBuffer::getMappedAddress(*this, _bufferManager.get<BufferAllocationInfo>(_cullingAABBsStagingBuffers[frameInFlightId])));
-
-        for (const auto& [entity, renderComponent, transformComponent] : scene.makeView<RenderComponent, TransformComponent>()) {
-            RenderData objectData;
-
-            const Mesh& mesh = renderComponent.getMesh();
-            const VkBuffer vertexBuffer = _bufferManager.get<GPUBuffer>(mesh.vertexBuffer).buffer;
-            const VkBuffer& indexBuffer = _bufferManager.get<GPUBuffer>(mesh.indexBuffer).buffer;
-            // Buffers used as index/vertex buffers are assumed to be created with the exact size needed
-            const uint32 indexBufferSize = _bufferManager.get<BufferAllocationInfo>(mesh.indexBuffer).allocatedSize;
-            objectData.vertexBuffer = VulkanBuffer::getDeviceAddress(*this, vertexBuffer);
-            objectData.indexBuffer = VulkanBuffer::getDeviceAddress(*this, indexBuffer);
-            objectData.material = renderComponent.getMaterial();
-            objectData.indexCount = indexBufferSize / sizeof(uint16);
-
-            aabbDataPtr[objectCount] = mesh.objectAABB;
-            objectDataPtr[objectCount] = objectData;
-            transformDataPtr[objectCount] = transformComponent;
-            objectCount++;
-        }
+    const std::chrono::duration<float, std::milli> waitTime = std::chrono::high_resolution_clock::now() - waitStartTime;
+    _frameStats.cpuWaitTime = _cpuWaitTime + waitTime.count();
+    _cpuWaitTime = 0.0f;
+
+    lock.lock();
+    readFrameStats(frameInFlightId);
+    collectReleased();
+    _geometryArena->collectReleased();
+    _bindlessTable->flush();
+
+    // The last frame of this frame in flight retired, the GPU is done with every command buffer allocated from its pools
+    for (const VkCommandPool commandPool : _recordingCommandPools[frameInFlightId]) {
+        vkResetCommandPool(_device, commandPool, 0);
+    }
+
+    // Everything that may create resources or update descriptor sets has to happen before the parallel recording
+    _gpuScene->update(frameInFlightId, snapshot);
+    _debugDrawer->prepareDebugUI(frameInFlightId, snapshot.ui);
+
+    const CameraComponent& cameraComponent = snapshot.camera;
+    const TransformComponent& cameraTransform = snapshot.cameraTransform;
+    const Handle<Texture> albedoRT = _renderGraph->getTexture(frameInFlightId, _graphResources.albedoRT);
+    const VkExtent3D rtExtent = _textureManager.get<TextureMetadata>(albedoRT).extent;
+    const float aspectRatio = rtExtent.width / static_cast<float>(rtExtent.height);
+    const mat4 projectionMatrix = cameraComponent.getProjectionMatrix(aspectRatio);
+    const mat4 viewMatrix = inverse(mat4(cameraTransform)); // assumes scale is uniform and non-zero
 
-        const GPUBuffer& aabbBuffer = _bufferManager.get<GPUBuffer>(_cullingAABBsBuffers[frameInFlightId]);
-        VulkanBuffer::copyBuffer(commandBuffer, aabbStagingBuffer.buffer, aabbBuffer.buffer, sizeof(AABB) * objectCount);
+    // Whole subtrees outside the frustum never reach the culling pass, their visibility bits are left as they were which at
+    // worst draws them in the early phase of the frame they come back into view
+    uint32 objectCount = _gpuScene->getSlotCount();
+    if (_frameSettings.bvhCulling) {
+        _bvhCandidates.clear();
+        _gpuScene->getBVH().cull(viewMatrix, FrustumPlanes::fromProjection(projectionMatrix), _bvhCandidates);
 
-        const GPUBuffer& objectDataBuffer = _bufferManager.get<GPUBuffer>(_cullingRenderDataBuffers[frameInFlightId]);
-        VulkanBuffer::copyBuffer(commandBuffer, objectDataStagingBuffer.buffer, objectDataBuffer.buffer, sizeof(RenderData) * objectCount);
+        const BufferAllocationInfo& objectListAllocation = _bufferManager.get<BufferAllocationInfo>(_objectListBuffers[frameInFlightId]);
+        std::memcpy(VulkanBuffer::getMappedAddress(*this, objectListAllocation), _bvhCandidates.data(),
+            _bvhCandidates.size() * sizeof(uint32));
+        VulkanBuffer::flush(*this, objectListAllocation);
 
-        VulkanBuffer::insertMemoryBarrier(commandBuffer, objectDataBuffer.buffer, VK_ACCESS_2_TRANSFER_WRITE_BIT,
-            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+        objectCount = _bvhCandidates.size();
+        _frameStats.bvhCulledCount = _gpuScene->getBVH().getItemCount() - objectCount;
     } else {
-        // Only update transforms
-        // Note that quickView only really improves Debug performance, RelWithDebInfo saw pretty much no difference
-        for (const auto& [entity, transformComponent] : scene.makeQuickView<RenderComponent, TransformComponent>()) {
-            transformDataPtr[objectCount] = transformComponent;
-            objectCount++;
+        _frameStats.bvhCulledCount = 0;
+    }
+
+    _frameStats.lightCount = updateLights(snapshot.lights, frameInFlightId, viewMatrix);
+
+    _frameContext = {
+        .frameInFlightId = frameInFlightId,
+        .swapchainImageId = swapchainImageId,
+        .objectCount = objectCount,
+        .meshSlotCount = _gpuScene->getMeshSlotCount(),
+        .lightCount = _frameStats.lightCount,
+        .vertexBufferAddress = _geometryArena->getVertexBufferAddress(),
+        .indexBuffers = { _geometryArena->getIndexBuffer(Geometry::IndexType::Uint16),
+            _geometryArena->hasWideIndices() ? _geometryArena->getIndexBuffer(Geometry::IndexType::Uint32) : VK_NULL_HANDLE },
+        .indexBufferAddresses = { _geometryArena->getIndexBufferAddress(Geometry::IndexType::Uint16),
+            _geometryArena->hasWideIndices() ? _geometryArena->getIndexBufferAddress(Geometry::IndexType::Uint32) : 0 },
+        .meshletBufferAddress = _geometryArena->getMeshletBufferAddress(),
+        .projectionMatrix = projectionMatrix,
+        .viewMatrix = viewMatrix,
+        .nearPlane = cameraComponent.getNear(),
+        .farPlane = cameraComponent.getFar(),
+        .cullingDescriptorSets = {
+            VulkanBindGroup::getUpdatedDescriptorSet(
+                _device, _bindGroupManager.get<DescriptorSets>(_gpuScene->getObjectDataBindGroup()), frameInFlightId),
+            VulkanBindGroup::getUpdatedDescriptorSet(
+                _device, _bindGroupManager.get<DescriptorSets>(_cullingFrameDataBindGroup), frameInFlightId),
+            VulkanBindGroup::getUpdatedDescriptorSet(
+                _device, _bindGroupManager.get<DescriptorSets>(_drawIndirectCommandBindGroup), frameInFlightId),
+            VulkanBindGroup::getUpdatedDescriptorSet(_device, _bindGroupManager.get<DescriptorSets>(_drawRecordBindGroup), frameInFlightId),
+        },
+        .gbufferDescriptorSets = {
+            _bindlessTable->getDescriptorSet(),
+            VulkanBindGroup::getUpdatedDescriptorSet(_device, _bindGroupManager.get<DescriptorSets>(_drawRecordBindGroup), frameInFlightId),
+        },
+        .shadingDescriptorSet = VulkanBindGroup::getUpdatedDescriptorSet(
+            _device, _bindGroupManager.get<DescriptorSets>(_deferredShadingBindGroup), frameInFlightId),
+        .lightDescriptorSet
+        = VulkanBindGroup::getUpdatedDescriptorSet(_device, _bindGroupManager.get<DescriptorSets>(_lightBindGroup), frameInFlightId),
+        .occlusionCulling = _frameSettings.occlusionCulling,
+        .objectList = _frameSettings.bvhCulling,
+        .materialBinning = _frameSettings.materialBinning,
+        // An error e at distance d covers e * P[1][1] * height / 2 / d pixels
+        .lodErrorScale = _frameSettings.lodErrorThreshold > 0.0f
+            ? projectionMatrix[1][1] * rtExtent.height * 0.5f / _frameSettings.lodErrorThreshold
+            : 0.0f,
+        .ui = &snapshot.ui,
+    };
+    _frameContext.cullingDescriptorSets[4]
+        = VulkanBindGroup::getUpdatedDescriptorSet(_device, _bindGroupManager.get<DescriptorSets>(_depthPyramidBindGroup), frameInFlightId);
+    if (_visibilityBufferGraph) {
+        _frameContext.visibilityResolveDescriptorSets = {
+            _frameContext.cullingDescriptorSets[0],
+            _frameContext.cullingDescriptorSets[2],
+            _frameContext.cullingDescriptorSets[3],
+            _frameContext.gbufferDescriptorSets[0],
+            VulkanBindGroup::getUpdatedDescriptorSet(
+                _device, _bindGroupManager.get<DescriptorSets>(_visibilityResolveBindGroup), frameInFlightId),
+        };
+    }
+    for (uint32 level = 0; level < MaxDepthPyramidLevels; ++level) {
+        _frameContext.depthPyramidDescriptorSets[level] = VulkanBindGroup::getUpdatedDescriptorSet(
+            _device, _bindGroupManager.get<DescriptorSets>(_depthPyramidLevelBindGroups[level]), frameInFlightId);
+    }
+
+    const Handle<Texture> swapchainTexture = _swapchainTextures[swapchainImageId];
+    _renderGraph->bindTexture(frameInFlightId, _graphResources.swapchain,
+        {
+            .handle = swapchainTexture,
+            .image = _textureManager.get<ImageView>(swapchainTexture).image,
+            .aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        });
+
+    // Each pass gets its own primary command buffer allocated from the recording thread's pool, the submission order only
+    // depends on the pass order, not on which thread recorded what. The first slot is for the upload acquire barriers
+    const uint32 passCount = _renderGraph->getCompiledPassCount();
+    std::array<VkCommandBuffer, RenderGraph::MaxPasses + 1> frameCommandBuffers;
+    VkCommandBuffer* passCommandBuffers = frameCommandBuffers.data() + 1;
+    const VkQueryPool timestampQueryPool = _timestampQueryPools[frameInFlightId];
+    const auto recordPass = [this, frameInFlightId, timestampQueryPool, passCommandBuffers](const uint32 passId, const uint32 threadId) {
+        const VkCommandBuffer commandBuffer = _passCommandBuffers[frameInFlightId][threadId * RenderGraph::MaxPasses + passId];
+        beginCommandBuffer(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, false);
+        if (_timestampPeriod > 0.0f) {
+            vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, timestampQueryPool, 2 * passId);
+        }
+        _renderGraph->recordPass(passId, commandBuffer, frameInFlightId);
+        if (_timestampPeriod > 0.0f) {
+            vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, timestampQueryPool, 2 * passId + 1);
+        }
+        vkEndCommandBuffer(commandBuffer);
+        passCommandBuffers[passId] = commandBuffer;
+    };
+
+    const auto recordingStartTime = std::chrono::high_resolution_clock::now();
+    if (_frameSettings.parallelCommandRecording) {
+        _threadPool->parallelFor(passCount, recordPass);
+    } else {
+        for (uint32 passId = 0; passId < passCount; ++passId) {
+            recordPass(passId, _threadPool->getWorkerCount());
         }
     }
-    VulkanBuffer::flush(*this, transformAllocation);
-
-    // Reset the culling draw counter
-    const VkBuffer drawCountBuffer = _bufferManager.get<GPUBuffer>(_cullingDrawCounterBuffers[frameInFlightId]).buffer;
-    vkCmdFillBuffer(commandBuffer, drawCountBuffer, 0, sizeof(uint32), 0);
-    VulkanBuffer::insertMemoryBarrier(commandBuffer, drawCountBuffer, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-        VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
-
-    // Update visible flags buffer
-    const uint32 visibleFlagsBufferSize = (objectCount + (sizeof(uint32) << 3) - 1) / (sizeof(uint32) << 3) * sizeof(uint32);
-    const GPUBuffer& visibleFlagStagingBuffer = _bufferManager.get<GPUBuffer>(_cullingVisibleFlagStagingBuffers[frameInFlightId]);
-    const BufferAllocationInfo& visibleFlagStagingAllocation
-        = _bufferManager.get<BufferAllocationInfo>(_cullingVisibleFlagStagingBuffers[frameInFlightId]);
-    const GPUBuffer& visibleFlagBuffer = _bufferManager.get<GPUBuffer>(_cullingVisibleFlagBuffers[frameInFlightId]);
-
-    void* visibleFlagsPtr = VulkanBuffer::getMappedAddress(*this, visibleFlagStagingAllocation);
-    std::memcpy(visibleFlagsPtr, scene.getRawVisibleFlags(), visibleFlagsBufferSize);
-    VulkanBuffer::copyBuffer(commandBuffer, visibleFlagStagingBuffer.buffer, visibleFlagBuffer.buffer, visibleFlagsBufferSize);
-    VulkanBuffer::insertMemoryBarrier(commandBuffer, visibleFlagBuffer.buffer, VK_ACCESS_2_TRANSFER_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
-
-    // Compute updated culling parameters
-    const Entity mainCameraEntity = scene.getMainCamera();
-    const CameraComponent& cameraComponent = scene.get<CameraComponent>(mainCameraEntity);
-    const TransformComponent& cameraTransform = scene.get<TransformComponent>(mainCameraEntity);
-    const VkExtent3D rtExtent = _textureManager.get<TextureMetadata>(_gbufferRTs[frameInFlightId].albedoRT).extent;
-    const float aspectRatio = rtExtent.width / static_cast<float>(rtExtent.height);
+    const std::chrono::duration<float, std::milli> recordingTime = std::chrono::high_resolution_clock::now() - recordingStartTime;
+    _frameStats.commandRecordingTime = recordingTime.count();
+    _frameStats.meshCount = _gpuScene->getMeshCount();
+    _timestampedPassCounts[frameInFlightId] = _timestampPeriod > 0.0f ? passCount : 0;
 
-    const mat4 projectionMatrix = cameraComponent.getProjectionMatrix(aspectRatio);
-    const mat4 viewMatrix = inverse(mat4(cameraTransform)); // assumes scale is uniform and non-zero
+    // Everything the main thread or this frame uploaded so far, the frame waits on it GPU side
+    if (_uploadsToBeFlushed) {
+        flushUploadCommands();
+    }
+    const uint64 retiredUploadValue = _uploadTimeline->getRetiredValue();
+    uint32 firstCommandBuffer = 1;
+    if (!_uploadAcquireBarriers.empty() || !_pendingTextureBindings.empty() || _geometryArena->hasPendingCopies()
+        || (!_pendingTextureUploads.empty() && _pendingTextureUploads.front().uploadValue <= retiredUploadValue)) {
+        const VkCommandBuffer acquireCommandBuffer = _uploadAcquireCommandBuffers[frameInFlightId];
+        beginCommandBuffer(acquireCommandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, false);
+        recordUploadAcquireBarriers(acquireCommandBuffer);
+        // The frame was recorded against the compacted arenas, their content is copied before it runs
+        _geometryArena->recordPendingCopies(acquireCommandBuffer);
+        recordTextureUploadCompletions(acquireCommandBuffer, retiredUploadValue);
+        vkEndCommandBuffer(acquireCommandBuffer);
+        frameCommandBuffers[0] = acquireCommandBuffer;
+        firstCommandBuffer = 0;
+    }
+
+    const std::array<VkSemaphoreSubmitInfo, 2> waitSemaphores {
+        makeSemaphoreSubmitInfo(_presentSemaphores[frameInFlightId], VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT),
+        makeUploadWaitSemaphoreInfo(),
+    };
+    const std::array<VkSemaphoreSubmitInfo, 2> signalSemaphores {
+        makeSemaphoreSubmitInfo(_renderSemaphores[swapchainImageId], VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT),
+        _graphicsTimeline->signalNext(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT),
+    };
+    submitCommandBuffers(_graphicsQueue, waitSemaphores, signalSemaphores,
+        { frameCommandBuffers.data() + firstCommandBuffer, passCount + 1 - firstCommandBuffer });
+    _frameTimelineValues[frameInFlightId] = signalSemaphores[1].value;
+    lock.unlock();
 
-    // Frustum culling dispatch
-    const auto cullingPipeline = _computeShaderManager.get<VkPipeline>(_frustumCullingCS);
-    const auto cullingPipelineLayout = _computeShaderManager.get<VkPipelineLayout>(_frustumCullingCS);
-    const VkDescriptorSet cullingDescriptorSets[] = {
-        VulkanBindGroup::getUpdatedDescriptorSet(
-            _device, _bindGroupManager.get<DescriptorSets>(_cullingRenderDataBindGroup), frameInFlightId),
-        VulkanBindGroup::getUpdatedDescriptorSet(
-            _device, _bindGroupManager.get<DescriptorSets>(_cullingFrameDataBindGroup), frameInFlightId),
-        VulkanBindGroup::getUpdatedDescriptorSet(
-            _device, _bindGroupManager.get<DescriptorSets>(_drawIndirectCommandBindGroup), frameInFlightId),
-        VulkanBindGroup::getUpdatedDescriptorSet(_device, _bindGroupManager.get<DescriptorSets>(_drawRecordBindGroup), frameInFlightId),
+    const VkPresentInfoKHR presentInfo {
+        .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+        .waitSemaphoreCount = 1,
+        .pWaitSemaphores = &_renderSemaphores[swapchainImageId],
+        .swapchainCount = 1,
+        .pSwapchains = &_swapchain,
+        .pImageIndices = &swapchainImageId,
     };
+    {
+        // The present queue may be the one the main thread flushes the uploads to
+        std::lock_guard queueLock { _queueMutex };
+        vkQueuePresentKHR(_presentQueue, &presentInfo);
+    }
+
+    _inputTimestamps[frameInFlightId] = _inputTimestamp;
+    _submittedFrameIds[frameInFlightId] = _frameId;
+    ++_frameId;
 
-    VulkanBindGroup::bind(commandBuffer, cullingDescriptorSets, VK_PIPELINE_BIND_POINT_COMPUTE, cullingPipelineLayout);
+    snapshot.stats = _frameStats;
+}
+
+void VulkanRHI::waitForNextFrame()
+{
+    const auto waitStartTime = std::chrono::high_resolution_clock::now();
+
+    // The low latency mode waits for the previous frame instead, so nothing is queued when the input is sampled. The frames retire
+    // in order, waiting for a frame also waits for the ones before it
+    const uint32 framesInFlight = getFramesInFlight();
+    const uint32 frameInFlightId = _frameSettings.lowLatency ? (_frameId + framesInFlight - 1) % framesInFlight : _frameId % framesInFlight;
+    _graphicsTimeline->wait(_frameTimelineValues[frameInFlightId]);
+
+    const std::chrono::duration<float, std::milli> waitTime = std::chrono::high_resolution_clock::now() - waitStartTime;
+    _cpuWaitTime = waitTime.count();
+    _inputTimestamp = getDeviceTimestamp();
+}
+
+uint32 VulkanRHI::updateLights(
+    const std::vector<RenderSnapshot::Light>& snapshotLights, const uint32 frameInFlightId, const mat4& viewMatrix)
+{
+    const BufferAllocationInfo& lightAllocation = _bufferManager.get<BufferAllocationInfo>(_lightBuffers[frameInFlightId]);
+    GPULight* const lights = static_cast<GPULight*>(VulkanBuffer::getMappedAddress(*this, lightAllocation));
+
+    // Few enough to be gathered every frame, the view space transform saves it to the culling and shading passes
+    uint32 lightCount = 0;
+    for (const auto& [light, transform] : snapshotLights) {
+        if (lightCount == MaxLights) {
+            break;
+        }
+
+        lights[lightCount++] = GPULight {
+            .position = vec3 { viewMatrix * vec4 { transform.position(), 1.0f } },
+            .range = light.range,
+            .color = light.color * light.intensity,
+            .type = static_cast<uint32>(light.type),
+            .direction = mat3 { viewMatrix } * (transform.rotation() * vec3 { 0.0f, 0.0f, 1.0f }),
+            .cosOuterAngle = std::cos(light.outerConeAngle),
+            .cosInnerAngle = std::cos(light.innerConeAngle),
+        };
+    }
+    VulkanBuffer::flush(*this, lightAllocation);
+
+    return lightCount;
+}
+
+void VulkanRHI::readFrameStats(const uint32 frameInFlightId)
+{
+    // Nothing was rendered with these resources yet
+    if (_frameId < getFramesInFlight()) {
+        return;
+    }
+
+    const BufferAllocationInfo& countersAllocation = _bufferManager.get<BufferAllocationInfo>(_cullingCounterBuffers[frameInFlightId]);
+    VulkanBuffer::invalidate(*this, countersAllocation);
+    const CullingCounters& counters = *static_cast<const CullingCounters*>(VulkanBuffer::getMappedAddress(*this, countersAllocation));
+    _frameStats.earlyDrawCount = counters.drawCounts[0];
+    _frameStats.lateDrawCount = counters.drawCounts[1];
+    _frameStats.frustumCulledCount = counters.frustumCulledCount;
+    _frameStats.occlusionCulledCount = counters.occlusionCulledCount;
+    _frameStats.meshletDrawCount = counters.meshletDrawCount;
+    _frameStats.clusterCulledCount = counters.clusterCulledCount;
+    std::copy(std::begin(counters.lodDrawCounts), std::end(counters.lodDrawCounts), _frameStats.lodDrawCounts.begin());
+
+    const VkQueryPool statisticsQueryPool = _pipelineStatisticsQueryPools[frameInFlightId];
+    if (statisticsQueryPool != VK_NULL_HANDLE) {
+        // Per query, in the order of the statistics bits: input assembly primitives then vertex shader invocations
+        std::array<uint64, 4> statistics;
+        if (vkGetQueryPoolResults(_device, statisticsQueryPool, 0, 2, sizeof(statistics), statistics.data(), 2 * sizeof(uint64),
+                VK_QUERY_RESULT_64_BIT)
+            == VK_SUCCESS) {
+            _frameStats.inputAssemblyPrimitives = statistics[0] + statistics[2];
+            _frameStats.vertexShaderInvocations = statistics[1] + statistics[3];
+        }
+        vkResetQueryPool(_device, statisticsQueryPool, 0, 2);
+    }
+
+    const uint32 passCount = _timestampedPassCounts[frameInFlightId];
+    if (passCount == 0) {
+        return;
+    }
+
+    std::array<uint64, 2 * RenderGraph::MaxPasses> timestamps;
+    if (vkGetQueryPoolResults(_device, _timestampQueryPools[frameInFlightId], 0, 2 * passCount, sizeof(timestamps), timestamps.data(),
+            sizeof(uint64), VK_QUERY_RESULT_64_BIT)
+        == VK_SUCCESS) {
+        _frameStats.passTimings.resize(passCount);
+        for (uint32 passId = 0; passId < passCount; ++passId) {
+            _frameStats.passTimings[passId] = {
+                .name = _renderGraph->getPassName(passId),
+                .time = (timestamps[2 * passId + 1] - timestamps[2 * passId]) * _timestampPeriod * 1e-6f,
+            };
+        }
+        _workgroupTuner->recordPassTimings(_frameStats.passTimings);
+
+        // The passes may overlap
+        uint64 frameStart = NH3D_MAX_T(uint64);
+        uint64 frameEnd = 0;
+        for (uint32 passId = 0; passId < passCount; ++passId) {
+            frameStart = std::min(frameStart, timestamps[2 * passId]);
+            frameEnd = std::max(frameEnd, timestamps[2 * passId + 1]);
+        }
+
+        // Only the gap between consecutive frames tells how long the GPU waited for the CPU
+        const uint32 frameId = _submittedFrameIds[frameInFlightId];
+        if (_lastFrameEndTimestamp != 0 && frameId == _lastTimedFrameId + 1) {
+            _frameStats.gpuIdleTime
+                = frameStart > _lastFrameEndTimestamp ? (frameStart - _lastFrameEndTimestamp) * _timestampPeriod * 1e-6f : 0.0f;
+        }
+        _lastTimedFrameId = frameId;
+        _lastFrameEndTimestamp = frameEnd;
 
-    // Update culling parameters buffer
+        // The end of the GPU work is as close to the present as the timestamps go, the compositor and vsync delays aren't included
+        const uint64 inputTimestamp = _inputTimestamps[frameInFlightId];
+        _frameStats.inputLatency
+            = inputTimestamp != 0 && frameEnd > inputTimestamp ? (frameEnd - inputTimestamp) * _timestampPeriod * 1e-6f : 0.0f;
+    }
+    vkResetQueryPool(_device, _timestampQueryPools[frameInFlightId], 0, 2 * passCount);
+}
+
+void VulkanRHI::recordCullingPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext, const bool latePhase) const
+{
+    const uint32 cullingKernel = latePhase ? _lateCullingKernel : _frustumCullingKernel;
+    const Handle<ComputeShader> cullingCS = getTunedComputeShader(cullingKernel);
+    const auto cullingPipeline = _computeShaderManager.get<VkPipeline>(cullingCS);
+    const auto cullingPipelineLayout = _computeShaderManager.get<VkPipelineLayout>(cullingCS);
+    const uint32 descriptorSetCount = latePhase ? frameContext.cullingDescriptorSets.size() : frameContext.cullingDescriptorSets.size() - 1;
+    VulkanBindGroup::bind(commandBuffer, { frameContext.cullingDescriptorSets.data(), descriptorSetCount }, VK_PIPELINE_BIND_POINT_COMPUTE,
+        cullingPipelineLayout);
+
+    const TextureMetadata& depthPyramidMetadata
+        = _textureManager.get<TextureMetadata>(_renderGraph->getTexture(frameContext.frameInFlightId, _graphResources.depthPyramid));
     const CullingParameters cullingParameters {
-        .viewMatrix = viewMatrix,
-        .frustumPlanes = getFrustumPlanes(projectionMatrix),
-        .objectCount = objectCount,
+        .viewMatrix = frameContext.viewMatrix,
+        .projection = { frameContext.projectionMatrix[0][0], frameContext.projectionMatrix[1][1], frameContext.projectionMatrix[2][2],
+            frameContext.projectionMatrix[3][2] },
+        .frustumPlanes = FrustumPlanes::fromProjection(frameContext.projectionMatrix),
+        .objectCount = frameContext.objectCount,
+        .flags = (frameContext.occlusionCulling ? CULLING_OCCLUSION_BIT : 0U) | (frameContext.objectList ? CULLING_OBJECT_LIST_BIT : 0U)
+            | (frameContext.materialBinning ? CULLING_MATERIAL_BINNING_BIT : 0U),
+        .depthPyramidLevelCount = VulkanTexture::getMipLevelCount(depthPyramidMetadata.extent),
+        .lodErrorScale = frameContext.lodErrorScale,
     };
-
     vkCmdPushConstants(commandBuffer, cullingPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullingParameters), &cullingParameters);
 
-    const vec3i cullingKernelSize { std::ceil(objectCount / 64.f), 1, 1 };
-    VulkanComputeShader::dispatch(commandBuffer, cullingPipeline, cullingKernelSize);
-    VulkanBuffer::insertMemoryBarrier(commandBuffer, drawCountBuffer, VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_READ_BIT,
-        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT);
+    VulkanComputeShader::dispatchThreads(
+        commandBuffer, cullingPipeline, { frameContext.objectCount, 1, 1 }, _workgroupTuner->getWorkgroupSize(cullingKernel));
+}
 
-    const GPUBuffer& drawIndirectBuffer = _bufferManager.get<GPUBuffer>(_drawIndirectBuffers[frameInFlightId]);
-    VulkanBuffer::insertMemoryBarrier(commandBuffer, drawIndirectBuffer.buffer, VK_ACCESS_2_SHADER_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT);
+void VulkanRHI::recordClusterCullingPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext, const bool latePhase) const
+{
+    const auto clusterCullingPipeline = _computeShaderManager.get<VkPipeline>(_clusterCullingCS);
+    const auto clusterCullingPipelineLayout = _computeShaderManager.get<VkPipelineLayout>(_clusterCullingCS);
+    // Same sets as the early culling, the depth pyramid isn't used
+    const uint32 descriptorSetCount = frameContext.cullingDescriptorSets.size() - 1;
+    VulkanBindGroup::bind(commandBuffer, { frameContext.cullingDescriptorSets.data(), descriptorSetCount }, VK_PIPELINE_BIND_POINT_COMPUTE,
+        clusterCullingPipelineLayout);
+
+    const ClusterCullingParameters clusterCullingParameters {
+        .frustumPlanes = FrustumPlanes::fromProjection(frameContext.projectionMatrix),
+        .meshlets = frameContext.meshletBufferAddress,
+        .latePhase = latePhase,
+    };
+    vkCmdPushConstants(commandBuffer, clusterCullingPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ClusterCullingParameters),
+        &clusterCullingParameters);
+
+    // One workgroup per object, counted by the culling pass of the same phase
+    const VkBuffer clusterDispatchBuffer
+        = _bufferManager.get<GPUBuffer>(_renderGraph->getBuffer(frameContext.frameInFlightId, _graphResources.clusterDispatch)).buffer;
+    VulkanComputeShader::dispatchIndirect(commandBuffer, clusterCullingPipeline, clusterDispatchBuffer,
+        (latePhase ? 1 : 0) * sizeof(VkDispatchIndirectCommand));
+}
 
-    const GPUBuffer& drawRecordBuffer = _bufferManager.get<GPUBuffer>(_drawRecordBuffers[frameInFlightId]);
-    VulkanBuffer::insertMemoryBarrier(commandBuffer, drawRecordBuffer.buffer, VK_ACCESS_2_SHADER_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT);
+void VulkanRHI::recordMaterialBinningPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext, const bool latePhase) const
+{
+    // The culling pass wrote the instances directly
+    if (!frameContext.materialBinning) {
+        return;
+    }
 
-    auto graphicsPipeline = _shaderManager.get<VkPipeline>(_gbufferShader);
-    auto graphicsLayout = _shaderManager.get<VkPipelineLayout>(_gbufferShader);
+    const auto materialBinningPipeline = _computeShaderManager.get<VkPipeline>(_materialBinningCS);
+    const auto materialBinningPipelineLayout = _computeShaderManager.get<VkPipelineLayout>(_materialBinningCS);
+    const uint32 descriptorSetCount = frameContext.cullingDescriptorSets.size() - 1;
+    VulkanBindGroup::bind(commandBuffer, { frameContext.cullingDescriptorSets.data(), descriptorSetCount }, VK_PIPELINE_BIND_POINT_COMPUTE,
+        materialBinningPipelineLayout);
 
-    const VkDescriptorSet graphicsDescriptorSets[] = {
-        VulkanBindGroup::getUpdatedDescriptorSet(_device, _bindGroupManager.get<DescriptorSets>(_albedoTextureBindGroup), frameInFlightId),
-        VulkanBindGroup::getUpdatedDescriptorSet(_device, _bindGroupManager.get<DescriptorSets>(_drawRecordBindGroup), frameInFlightId),
+    MaterialBinningParameters materialBinningParameters {
+        .latePhase = latePhase,
+        .meshSlotCount = frameContext.meshSlotCount,
+        .scatter = 0,
     };
-    VulkanBindGroup::bind(commandBuffer, graphicsDescriptorSets, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsLayout);
+    vkCmdPushConstants(commandBuffer, materialBinningPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MaterialBinningParameters),
+        &materialBinningParameters);
+
+    // Bin offsets of every draw of both index widths
+    const uint32 drawCount = 2 * frameContext.meshSlotCount * Geometry::MaxLODs;
+    VulkanComputeShader::dispatchThreads(commandBuffer, materialBinningPipeline, { drawCount, 1, 1 }, { LinearWorkgroupSize, 1, 1 });
+
+    const VkBuffer materialBinBuffer
+        = _bufferManager.get<GPUBuffer>(_renderGraph->getBuffer(frameContext.frameInFlightId, _graphResources.materialBins)).buffer;
+    VulkanBuffer::insertMemoryBarrier(commandBuffer, materialBinBuffer, VK_ACCESS_2_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+    // One invocation per staged object, counted by the culling pass of the same phase
+    materialBinningParameters.scatter = 1;
+    vkCmdPushConstants(commandBuffer, materialBinningPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MaterialBinningParameters),
+        &materialBinningParameters);
+    VulkanComputeShader::dispatchIndirect(commandBuffer, materialBinningPipeline, materialBinBuffer,
+        offsetof(MaterialBinHeader, scatterDispatches) + (latePhase ? 1 : 0) * sizeof(VkDispatchIndirectCommand));
+}
 
-    const auto& albedoRTImageViewData = _textureManager.get<ImageView>(_gbufferRTs[frameInFlightId].albedoRT);
-    const auto& albedoRTMetadata = _textureManager.get<TextureMetadata>(_gbufferRTs[frameInFlightId].albedoRT);
-    VulkanTexture::insertMemoryBarrier(commandBuffer, albedoRTImageViewData.image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
-        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+void VulkanRHI::recordGBufferPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext, const bool latePhase) const
+{
+    const uint32 frameInFlightId = frameContext.frameInFlightId;
 
-    const auto& normalRTImageViewData = _textureManager.get<ImageView>(_gbufferRTs[frameInFlightId].normalRT);
-    const auto& normalRTMetadata = _textureManager.get<TextureMetadata>(_gbufferRTs[frameInFlightId].normalRT);
-    VulkanTexture::insertMemoryBarrier(commandBuffer, normalRTImageViewData.image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
-        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    const Handle<Shader> shader = _visibilityBufferGraph ? _visibilityShader : _gbufferShader;
+    auto graphicsPipeline = _shaderManager.get<VkPipeline>(shader);
+    auto graphicsLayout = _shaderManager.get<VkPipelineLayout>(shader);
+    VulkanBindGroup::bind(commandBuffer, frameContext.gbufferDescriptorSets, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsLayout);
 
-    const auto& depthRTViewData = _textureManager.get<ImageView>(_gbufferRTs[frameInFlightId].depthRT);
-    const auto& depthRTMetadata = _textureManager.get<TextureMetadata>(_gbufferRTs[frameInFlightId].depthRT);
-    VulkanTexture::insertMemoryBarrier(commandBuffer, depthRTViewData.image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
-        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
-        VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
-        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_UNDEFINED, true);
+    const Handle<Texture> depthRT = _renderGraph->getTexture(frameInFlightId, _graphResources.depthRT);
+    const auto& depthRTMetadata = _textureManager.get<TextureMetadata>(depthRT);
+    const auto& depthRTViewData = _textureManager.get<ImageView>(depthRT);
 
-    vkCmdPushConstants(commandBuffer, graphicsLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mat4), &projectionMatrix);
+    const GBufferParameters gbufferParameters {
+        .projection = frameContext.projectionMatrix,
+        .vertices = frameContext.vertexBufferAddress,
+        .quantizedVertices = frameContext.vertexBufferAddress,
+    };
+    vkCmdPushConstants(commandBuffer, graphicsLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GBufferParameters), &gbufferParameters);
 
-    const VkRenderingAttachmentInfo colorAttachmentsInfo[] = {
+    // The late phase draws on top of the early one
+    const VkAttachmentLoadOp loadOp = latePhase ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+    const auto getView = [&](const RGTexture texture) {
+        return _textureManager.get<ImageView>(_renderGraph->getTexture(frameInFlightId, texture)).view;
+    };
+    const VkRenderingAttachmentInfo visibilityAttachmentInfo {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = _visibilityBufferGraph ? getView(_graphResources.visibilityRT) : VK_NULL_HANDLE,
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .loadOp = loadOp,
+        .clearValue = {
+            .color = { .uint32 = { 0xFFFFFFFF } }, // VISIBILITY_INVALID_ID
+        },
+    };
+    const VkRenderingAttachmentInfo gbufferAttachmentsInfo[] = {
         {
             .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
-            .imageView = normalRTImageViewData.view,
+            .imageView = _visibilityBufferGraph ? VK_NULL_HANDLE : getView(_graphResources.normalRT),
             .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .loadOp = loadOp,
             .clearValue = {
                 .color = { .float32 = { 0.0f, 0.0f, 0.0f, 0.0f } },
             },
         },
         {
             .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
-            .imageView = albedoRTImageViewData.view,
+            .imageView = _visibilityBufferGraph ? VK_NULL_HANDLE : getView(_graphResources.albedoRT),
             .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .loadOp = loadOp,
             .clearValue = {
                 .color = { .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } },
             },
         },
     };
 
-    NH3D_ASSERT(objectCount <= _bufferManager.get<BufferAllocationInfo>(_drawIndirectBuffers[frameInFlightId]).allocatedSize
-                / sizeof(VkDrawIndirectCommand),
-        "Draw indirect buffer too small for the number of objects");
+    const VkQueryPool statisticsQueryPool = _pipelineStatisticsQueryPools[frameInFlightId];
+    const uint32 statisticsQuery = latePhase ? 1 : 0;
+    if (statisticsQueryPool != VK_NULL_HANDLE) {
+        vkCmdBeginQuery(commandBuffer, statisticsQueryPool, statisticsQuery, 0);
+    }
+
+    // One indexed instanced draw per mesh slot and LOD, the ones without visible instances have an instance count of 0
+    // Then the meshlets that passed the cluster culling, their count is written by the GPU
+    // Both lists are repeated for the meshes with 32 bit indices, unless there are none
+    const uint32 phase = latePhase ? 1 : 0;
+    const VkBuffer drawIndirectBuffer
+        = _bufferManager.get<GPUBuffer>(_renderGraph->getBuffer(frameInFlightId, _graphResources.drawIndirect)).buffer;
+    const VkBuffer meshletDrawBuffer
+        = _bufferManager.get<GPUBuffer>(_renderGraph->getBuffer(frameInFlightId, _graphResources.meshletDraws)).buffer;
+    const auto meshDrawBatch = [&](const uint32 drawList, const VkIndexType indexType) {
+        return VulkanShader::IndirectDrawBatch {
+            .drawIndirectBuffer = drawIndirectBuffer,
+            .drawIndirectCountBuffer = VK_NULL_HANDLE,
+            .maxDrawCount = frameContext.meshSlotCount * Geometry::MaxLODs,
+            .drawIndirectOffset = drawList * VulkanGPUScene::MaxMeshes * Geometry::MaxLODs * sizeof(VkDrawIndexedIndirectCommand),
+            .indexBuffer = frameContext.indexBuffers[drawList % 2],
+            .indexType = indexType,
+        };
+    };
+    const auto meshletDrawBatch = [&](const uint32 drawList, const VkIndexType indexType) {
+        return VulkanShader::IndirectDrawBatch {
+            .drawIndirectBuffer = meshletDrawBuffer,
+            .drawIndirectCountBuffer = meshletDrawBuffer,
+            .maxDrawCount = MaxMeshletDraws,
+            .drawIndirectOffset = MeshletDrawsOffset + drawList * MaxMeshletDraws * sizeof(VkDrawIndexedIndirectCommand),
+            .drawIndirectCountOffset = drawList * sizeof(uint32),
+            .indexBuffer = frameContext.indexBuffers[drawList % 2],
+            .indexType = indexType,
+        };
+    };
+    const VulkanShader::IndirectDrawBatch drawBatches[] = {
+        meshDrawBatch(2 * phase, VK_INDEX_TYPE_UINT16),
+        meshletDrawBatch(2 * phase, VK_INDEX_TYPE_UINT16),
+        meshDrawBatch(2 * phase + 1, VK_INDEX_TYPE_UINT32),
+        meshletDrawBatch(2 * phase + 1, VK_INDEX_TYPE_UINT32),
+    };
+    const uint32 drawBatchCount = frameContext.indexBuffers[1] != VK_NULL_HANDLE ? 4 : 2;
     VulkanShader::multiDrawIndirect(commandBuffer, graphicsPipeline, {
-                .drawIndirectBuffer = drawIndirectBuffer.buffer,
-                .drawIndirectCountBuffer = drawCountBuffer,
-                .maxDrawCount = objectCount, // Good enough for now
+                .batches = { drawBatches, drawBatchCount },
                 .drawParams = { 
-                    .extent = { albedoRTMetadata.extent.width, albedoRTMetadata.extent.height },
-                    .colorAttachments = colorAttachmentsInfo,
+                    .extent = { depthRTMetadata.extent.width, depthRTMetadata.extent.height },
+                    .colorAttachments = _visibilityBufferGraph ? ArrayWrapper<VkRenderingAttachmentInfo> { visibilityAttachmentInfo }
+                                                               : ArrayWrapper<VkRenderingAttachmentInfo> { gbufferAttachmentsInfo },
                     .depthAttachment = {
                         .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
                         .imageView = depthRTViewData.view,
                         .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-                        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                        .loadOp = loadOp,
                         .clearValue = {
                             .depthStencil = { 1.0f, 0 }, // 0 for reverse depth?
                         },
@@ -698,95 +1436,129 @@ void VulkanRHI::render(Scene& scene)
                 },
             });
 
-    VulkanTexture::insertMemoryBarrier(commandBuffer, normalRTImageViewData.image, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    VulkanTexture::insertMemoryBarrier(commandBuffer, albedoRTImageViewData.image, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_SHADER_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    if (statisticsQueryPool != VK_NULL_HANDLE) {
+        vkCmdEndQuery(commandBuffer, statisticsQueryPool, statisticsQuery);
+    }
+}
 
-    constexpr bool EnableDebugDraw = true;
-    VkAccessFlags2 depthRtDstAccess = VK_ACCESS_2_SHADER_READ_BIT;
-    VkPipelineStageFlags2 depthRtDstStage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
-    if (EnableDebugDraw) {
-        // If debug drawing is enabled, we need to transition the depth RT back to depth attachment layout for the AABB drawer
-        // Note: assumes read only depth
-        depthRtDstAccess |= VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
-        depthRtDstStage |= VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+void VulkanRHI::recordDepthPyramidPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const
+{
+    // The late phase still binds the pyramid but doesn't read it
+    if (!frameContext.occlusionCulling) {
+        return;
     }
 
-    VulkanTexture::insertMemoryBarrier(commandBuffer, depthRTViewData.image, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, depthRtDstAccess, depthRtDstStage,
-        VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true);
+    const Handle<Texture> depthPyramid = _renderGraph->getTexture(frameContext.frameInFlightId, _graphResources.depthPyramid);
+    const VkImage depthPyramidImage = _textureManager.get<ImageView>(depthPyramid).image;
+    const VkExtent3D extent = _textureManager.get<TextureMetadata>(depthPyramid).extent;
+    const uint32 levelCount = VulkanTexture::getMipLevelCount(extent);
+
+    const auto depthPyramidPipeline = _computeShaderManager.get<VkPipeline>(_depthPyramidCS);
+    const auto depthPyramidPipelineLayout = _computeShaderManager.get<VkPipelineLayout>(_depthPyramidCS);
+    for (uint32 level = 0; level < levelCount; ++level) {
+        if (level > 0) {
+            // The graph only synchronizes the whole pass, the previous level has to be written before being read
+            VulkanTexture::insertMemoryBarrier(commandBuffer, depthPyramidImage, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, false, level - 1, 1);
+        }
 
-    // Clearing is not necessary I believe
-    const auto& finalRTImageViewData = _textureManager.get<ImageView>(_finalRTs[frameInFlightId]);
-    const auto& finalRTMetadata = _textureManager.get<TextureMetadata>(_finalRTs[frameInFlightId]);
-    VulkanTexture::insertMemoryBarrier(commandBuffer, finalRTImageViewData.image, VK_ACCESS_2_TRANSFER_READ_BIT,
-        VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-        VK_IMAGE_LAYOUT_GENERAL);
+        VulkanBindGroup::bind(
+            commandBuffer, frameContext.depthPyramidDescriptorSets[level], VK_PIPELINE_BIND_POINT_COMPUTE, depthPyramidPipelineLayout);
 
-    const auto deferredShadingPipeline = _computeShaderManager.get<VkPipeline>(_deferredShadingCS);
-    const auto deferredShadingPipelineLayout = _computeShaderManager.get<VkPipelineLayout>(_deferredShadingCS);
+        const uint32 width = std::max(extent.width >> level, 1u);
+        const uint32 height = std::max(extent.height >> level, 1u);
+        VulkanComputeShader::dispatchThreads(
+            commandBuffer, depthPyramidPipeline, { width, height, 1 }, { TileWorkgroupSize, TileWorkgroupSize, 1 });
+    }
+}
 
-    const VkDescriptorSet shadingDescriptorSets[] = {
-        VulkanBindGroup::getUpdatedDescriptorSet(
-            _device, _bindGroupManager.get<DescriptorSets>(_deferredShadingBindGroup), frameInFlightId),
+void VulkanRHI::recordVisibilityResolvePass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const
+{
+    const Handle<Texture> normalRT = _renderGraph->getTexture(frameContext.frameInFlightId, _graphResources.normalRT);
+    const auto& normalRTMetadata = _textureManager.get<TextureMetadata>(normalRT);
+
+    const auto resolvePipeline = _computeShaderManager.get<VkPipeline>(_visibilityResolveCS);
+    const auto resolvePipelineLayout = _computeShaderManager.get<VkPipelineLayout>(_visibilityResolveCS);
+    VulkanBindGroup::bind(
+        commandBuffer, frameContext.visibilityResolveDescriptorSets, VK_PIPELINE_BIND_POINT_COMPUTE, resolvePipelineLayout);
+
+    const VisibilityResolveParameters parameters {
+        .projection = frameContext.projectionMatrix,
+        .vertices = frameContext.vertexBufferAddress,
+        .quantizedVertices = frameContext.vertexBufferAddress,
+        .indices = frameContext.indexBufferAddresses,
     };
-    VulkanBindGroup::bind(commandBuffer, shadingDescriptorSets, VK_PIPELINE_BIND_POINT_COMPUTE, deferredShadingPipelineLayout);
-    const vec3i shadingKernelSize { std::ceil(finalRTMetadata.extent.width / 8.f), std::ceil(finalRTMetadata.extent.height / 8.f), 1 };
+    vkCmdPushConstants(
+        commandBuffer, resolvePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(VisibilityResolveParameters), &parameters);
 
-    VulkanComputeShader::dispatch(commandBuffer, deferredShadingPipeline, shadingKernelSize);
+    const vec3u pixelCount { normalRTMetadata.extent.width, normalRTMetadata.extent.height, 1 };
+    VulkanComputeShader::dispatchThreads(commandBuffer, resolvePipeline, pixelCount, { TileWorkgroupSize, TileWorkgroupSize, 1 });
+}
 
-    VulkanTexture::insertMemoryBarrier(commandBuffer, finalRTImageViewData.image, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_BLIT_BIT,
-        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+void VulkanRHI::recordLightCullingPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const
+{
+    const auto lightCullingPipeline = _computeShaderManager.get<VkPipeline>(_lightCullingCS);
+    const auto lightCullingPipelineLayout = _computeShaderManager.get<VkPipelineLayout>(_lightCullingCS);
+    VulkanBindGroup::bind(commandBuffer, frameContext.lightDescriptorSet, VK_PIPELINE_BIND_POINT_COMPUTE, lightCullingPipelineLayout);
+
+    const LightCullingParameters parameters {
+        .projectionScale = { frameContext.projectionMatrix[0][0], frameContext.projectionMatrix[1][1] },
+        .near = frameContext.nearPlane,
+        .far = frameContext.farPlane,
+        .lightCount = frameContext.lightCount,
+    };
+    vkCmdPushConstants(
+        commandBuffer, lightCullingPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(LightCullingParameters), &parameters);
 
-    const auto& scImageViewData = _textureManager.get<ImageView>(_swapchainTextures[swapchainImageId]);
-    const auto& scMetadata = _textureManager.get<TextureMetadata>(_swapchainTextures[swapchainImageId]);
-    VulkanTexture::insertMemoryBarrier(commandBuffer, scImageViewData.image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
-        VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    VulkanTexture::blit(commandBuffer, finalRTImageViewData.image, finalRTMetadata.extent, scImageViewData.image, scMetadata.extent);
+    // One invocation per cluster, the empty ones still have to write their count
+    VulkanComputeShader::dispatchThreads(commandBuffer, lightCullingPipeline, { LightClusterCount, 1, 1 }, { LinearWorkgroupSize, 1, 1 });
+}
 
-    if (EnableDebugDraw) {
-        VulkanTexture::insertMemoryBarrier(commandBuffer, scImageViewData.image, VK_ACCESS_2_TRANSFER_WRITE_BIT,
-            VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT,
-            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        // _debugDrawer->renderAABBs(commandBuffer, frameInFlightId, viewMatrix, projectionMatrix, objectCount,
-        //     _gbufferRTs[frameInFlightId].depthRT, _swapchainTextures[swapchainImageId]);
-
-        // VulkanTexture::insertMemoryBarrier(commandBuffer, scImageViewData.image, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-        //     VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-        //     VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        //     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-        _debugDrawer->renderDebugUI(commandBuffer, frameInFlightId, _swapchainTextures[swapchainImageId]);
-
-        VulkanTexture::insertMemoryBarrier(commandBuffer, scImageViewData.image, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
-            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    } else {
-        VulkanTexture::insertMemoryBarrier(commandBuffer, scImageViewData.image, VK_ACCESS_2_TRANSFER_WRITE_BIT,
-            VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    }
+void VulkanRHI::recordShadingPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const
+{
+    // Clearing is not necessary I believe
+    const Handle<Texture> finalRT = _renderGraph->getTexture(frameContext.frameInFlightId, _graphResources.finalRT);
+    const auto& finalRTMetadata = _textureManager.get<TextureMetadata>(finalRT);
 
-    vkEndCommandBuffer(commandBuffer);
-    submitCommandBuffer(_graphicsQueue, makeSemaphoreSubmitInfo(_presentSemaphores[frameInFlightId], VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT),
-        makeSemaphoreSubmitInfo(_renderSemaphores[swapchainImageId], VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT), commandBuffer,
-        _frameFences[frameInFlightId]);
+    const Handle<ComputeShader> deferredShadingCS = getTunedComputeShader(_deferredShadingKernel);
+    const auto deferredShadingPipeline = _computeShaderManager.get<VkPipeline>(deferredShadingCS);
+    const auto deferredShadingPipelineLayout = _computeShaderManager.get<VkPipelineLayout>(deferredShadingCS);
+    const VkDescriptorSet shadingDescriptorSets[] = { frameContext.shadingDescriptorSet, frameContext.lightDescriptorSet };
+    VulkanBindGroup::bind(commandBuffer, shadingDescriptorSets, VK_PIPELINE_BIND_POINT_COMPUTE, deferredShadingPipelineLayout);
 
-    const VkPresentInfoKHR presentInfo {
-        .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &_renderSemaphores[swapchainImageId],
-        .swapchainCount = 1,
-        .pSwapchains = &_swapchain,
-        .pImageIndices = &swapchainImageId,
+    const vec3 sunDirection { 0.5f, 1.0f, -0.3f }; // world space, the only directional light for now
+    const ShadingParameters parameters {
+        .inverseProjection = inverse(frameContext.projectionMatrix),
+        .sunDirection = normalize(mat3 { frameContext.viewMatrix } * sunDirection),
+        .near = frameContext.nearPlane,
+        .far = frameContext.farPlane,
     };
-    vkQueuePresentKHR(_presentQueue, &presentInfo);
+    vkCmdPushConstants(
+        commandBuffer, deferredShadingPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ShadingParameters), &parameters);
+    const vec3u pixelCount { finalRTMetadata.extent.width, finalRTMetadata.extent.height, 1 };
 
-    ++_frameId;
+    VulkanComputeShader::dispatchThreads(
+        commandBuffer, deferredShadingPipeline, pixelCount, _workgroupTuner->getWorkgroupSize(_deferredShadingKernel));
+}
+
+void VulkanRHI::recordBlitPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const
+{
+    const Handle<Texture> finalRT = _renderGraph->getTexture(frameContext.frameInFlightId, _graphResources.finalRT);
+    const auto& finalRTImageViewData = _textureManager.get<ImageView>(finalRT);
+    const auto& finalRTMetadata = _textureManager.get<TextureMetadata>(finalRT);
+
+    const auto& scImageViewData = _textureManager.get<ImageView>(_swapchainTextures[frameContext.swapchainImageId]);
+    const auto& scMetadata = _textureManager.get<TextureMetadata>(_swapchainTextures[frameContext.swapchainImageId]);
+    VulkanTexture::blit(commandBuffer, finalRTImageViewData.image, finalRTMetadata.extent, scImageViewData.image, scMetadata.extent);
+}
+
+void VulkanRHI::recordDebugUIPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const
+{
+    // _debugDrawer->renderAABBs(commandBuffer, frameContext.frameInFlightId, frameContext.viewMatrix, frameContext.projectionMatrix,
+    //     frameContext.objectCount, depthRT, _swapchainTextures[frameContext.swapchainImageId]);
+    _debugDrawer->renderDebugUI(
+        commandBuffer, frameContext.frameInFlightId, *frameContext.ui, _swapchainTextures[frameContext.swapchainImageId]);
 }
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL vulkanValidationCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
@@ -906,17 +1678,29 @@ std::pair<VkPhysicalDevice, VulkanRHI::PhysicalDeviceQueueFamilyID> VulkanRHI::s
 
             queues = {};
             for (int32_t queueId = 0; queueId < familyCount; ++queueId) {
+                const VkQueueFlags queueFlags = queueData[queueId].queueFlags;
                 if (queues.GraphicsQueueFamilyID == NH3D_MAX_T(decltype(queues.GraphicsQueueFamilyID))
-                    && queueData[queueId].queueFlags & requiredQueueFlags) {
+                    && (queueFlags & requiredQueueFlags) == requiredQueueFlags) {
                     queues.GraphicsQueueFamilyID = queueId;
                 }
 
                 if (queues.PresentQueueFamilyID == NH3D_MAX_T(decltype(queues.PresentQueueFamilyID))) {
                     VkBool32 supported;
                     vkGetPhysicalDeviceSurfaceSupportKHR(availableGpus[i], queueId, surface, &supported);
-                    queues.PresentQueueFamilyID = queueId;
+                    if (supported) {
+                        queues.PresentQueueFamilyID = queueId;
+                    }
+                }
+
+                // Usually backed by the copy engines, the uploads then run alongside the frames
+                if (queues.TransferQueueFamilyID == NH3D_MAX_T(decltype(queues.TransferQueueFamilyID))
+                    && (queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT)) == VK_QUEUE_TRANSFER_BIT) {
+                    queues.TransferQueueFamilyID = queueId;
                 }
             }
+            if (queues.TransferQueueFamilyID == NH3D_MAX_T(decltype(queues.TransferQueueFamilyID))) {
+                queues.TransferQueueFamilyID = queues.GraphicsQueueFamilyID;
+            }
 
             if (queues.isValid()) {
                 deviceId = i;
@@ -932,13 +1716,16 @@ std::pair<VkPhysicalDevice, VulkanRHI::PhysicalDeviceQueueFamilyID> VulkanRHI::s
     VkPhysicalDevice gpu = availableGpus[deviceId];
 
     NH3D_LOG("Selected Vulkan device: " << selectedDeviceName);
+    if (queues.hasDedicatedTransferQueue()) {
+        NH3D_LOG("Using a dedicated transfer queue for the uploads");
+    }
 
     return { availableGpus[deviceId], queues };
 }
 
 VkDevice VulkanRHI::createLogicalDevice(const VkPhysicalDevice gpu, const PhysicalDeviceQueueFamilyID queues) const
 {
-    std::unordered_set<uint32> queueIndices { queues.GraphicsQueueFamilyID, queues.PresentQueueFamilyID };
+    std::unordered_set<uint32> queueIndices { queues.GraphicsQueueFamilyID, queues.PresentQueueFamilyID, queues.TransferQueueFamilyID };
 
     const float priority = 1.f;
     std::vector<VkDeviceQueueCreateInfo> queuesCreateInfo {};
@@ -953,7 +1740,16 @@ VkDevice VulkanRHI::createLogicalDevice(const VkPhysicalDevice gpu, const Physic
         queuesCreateInfo.emplace_back(queueCreateInfo);
     }
 
-    VkPhysicalDeviceFeatures features {};
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(gpu, &supportedFeatures);
+
+    const VkPhysicalDeviceFeatures features {
+        .geometryShader = supportedFeatures.geometryShader, // optional, gl_PrimitiveID in fragment shaders, see visibility.frag
+        .multiDrawIndirect = VK_TRUE,
+        // Optional, the visibility buffer resolve writes the GBuffer formats
+        .shaderStorageImageExtendedFormats = supportedFeatures.shaderStorageImageExtendedFormats,
+        .pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery, // optional, only used for stats
+    };
     VkPhysicalDeviceVulkan11Features features11 {
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
         .storageBuffer16BitAccess = VK_TRUE,
@@ -967,11 +1763,14 @@ VkDevice VulkanRHI::createLogicalDevice(const VkPhysicalDevice gpu, const Physic
         .descriptorIndexing = VK_TRUE,
         .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
         .descriptorBindingStorageImageUpdateAfterBind = VK_TRUE,
+        .descriptorBindingUpdateUnusedWhilePending = VK_TRUE, // bindless table, see VulkanBindlessTable
         .descriptorBindingPartiallyBound = VK_TRUE,
         .descriptorBindingVariableDescriptorCount = VK_TRUE,
         .runtimeDescriptorArray = VK_TRUE,
         .scalarBlockLayout = VK_TRUE,
         .uniformBufferStandardLayout = VK_TRUE,
+        .hostQueryReset = VK_TRUE,
+        .timelineSemaphore = VK_TRUE, // upload tracking
         .bufferDeviceAddress = VK_TRUE,
         // descriptorBindingUniformBufferUpdateAfterBind seems to be poorly supported, see
         // https://vulkan.gpuinfo.org/listfeaturescore12.php
@@ -983,15 +1782,19 @@ VkDevice VulkanRHI::createLogicalDevice(const VkPhysicalDevice gpu, const Physic
         .dynamicRendering = VK_TRUE,
     };
 
-    const char* swapchainExt = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    std::vector<const char*> extensions { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    // Optional, only used for the latency stats
+    if (supportsDeviceExtension(gpu, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+        extensions.emplace_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+    }
 
     const VkDeviceCreateInfo deviceCreateInfo {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         .pNext = &features13,
         .queueCreateInfoCount = static_cast<uint32_t>(queuesCreateInfo.size()),
         .pQueueCreateInfos = queuesCreateInfo.data(),
-        .enabledExtensionCount = 1,
-        .ppEnabledExtensionNames = &swapchainExt,
+        .enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
+        .ppEnabledExtensionNames = extensions.data(),
         .pEnabledFeatures = &features,
     };
 
@@ -1005,6 +1808,32 @@ VkDevice VulkanRHI::createLogicalDevice(const VkPhysicalDevice gpu, const Physic
     return device;
 }
 
+[[nodiscard]] bool VulkanRHI::supportsDeviceExtension(const VkPhysicalDevice gpu, const char* extensionName)
+{
+    uint32 extensionCount;
+    vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions { extensionCount };
+    vkEnumerateDeviceExtensionProperties(gpu, nullptr, &extensionCount, extensions.data());
+
+    return std::any_of(extensions.begin(), extensions.end(),
+        [extensionName](const VkExtensionProperties& extension) { return std::strcmp(extension.extensionName, extensionName) == 0; });
+}
+
+[[nodiscard]] uint64 VulkanRHI::getDeviceTimestamp() const
+{
+    if (_getCalibratedTimestamps == nullptr) {
+        return 0;
+    }
+
+    const VkCalibratedTimestampInfoEXT timestampInfo {
+        .sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT,
+        .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT,
+    };
+    uint64 timestamp;
+    uint64 maxDeviation;
+    return _getCalibratedTimestamps(_device, 1, &timestampInfo, &timestamp, &maxDeviation) == VK_SUCCESS ? timestamp : 0;
+}
+
 std::pair<VkSwapchainKHR, VkFormat> VulkanRHI::createSwapchain(const VkDevice device, const VkPhysicalDevice gpu,
     const VkSurfaceKHR surface, const PhysicalDeviceQueueFamilyID queues, const VkSwapchainKHR previousSwapchain) const
 {
@@ -1135,21 +1964,6 @@ VkSemaphore VulkanRHI::createSemaphore(const VkDevice device) const
     return semaphore;
 }
 
-VkFence VulkanRHI::createFence(const VkDevice device, const bool signaled) const
-{
-    const VkFenceCreateInfo fenceCreateInfo {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        .flags = signaled ? VK_FENCE_CREATE_SIGNALED_BIT : VkFenceCreateFlags {},
-    };
-
-    VkFence fence;
-    if (vkCreateFence(device, &fenceCreateInfo, nullptr, &fence) != VK_SUCCESS) {
-        NH3D_ABORT_VK("Failed to create Vulkan fence");
-    }
-
-    return fence;
-}
-
 void VulkanRHI::beginCommandBuffer(
     const VkCommandBuffer commandBuffer, const VkCommandBufferUsageFlags flags, const bool resetCommandBuffer) const
 {
@@ -1171,32 +1985,88 @@ VkSemaphoreSubmitInfo VulkanRHI::makeSemaphoreSubmitInfo(const VkSemaphore semap
     return {
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
         .semaphore = semaphore,
-        .value = 1,
+        .value = 0,
         .stageMask = stageMask,
         .deviceIndex = 0,
     };
 }
 
-void VulkanRHI::submitCommandBuffer(const VkQueue queue, const VkSemaphoreSubmitInfo& waitSemaphore,
-    const VkSemaphoreSubmitInfo& signalSemaphore, const VkCommandBuffer commandBuffer, const VkFence fence) const
+void VulkanRHI::submitCommandBuffers(const VkQueue queue, const ArrayWrapper<VkSemaphoreSubmitInfo> waitSemaphores,
+    const ArrayWrapper<VkSemaphoreSubmitInfo> signalSemaphores, const ArrayWrapper<VkCommandBuffer> commandBuffers) const
 {
-    const VkCommandBufferSubmitInfo cbSubmitInfo {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
-        .commandBuffer = commandBuffer,
-        .deviceMask = 0,
-    };
+    std::vector<VkCommandBufferSubmitInfo> cbSubmitInfos;
+    cbSubmitInfos.reserve(commandBuffers.size);
+    for (uint32 i = 0; i < commandBuffers.size; ++i) {
+        cbSubmitInfos.emplace_back(VkCommandBufferSubmitInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+            .commandBuffer = commandBuffers.data[i],
+            .deviceMask = 0,
+        });
+    }
 
     const VkSubmitInfo2 submitInfo {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
-        .waitSemaphoreInfoCount = waitSemaphore.semaphore ? 1u : 0u,
-        .pWaitSemaphoreInfos = &waitSemaphore,
-        .commandBufferInfoCount = commandBuffer ? 1u : 0u,
-        .pCommandBufferInfos = &cbSubmitInfo,
-        .signalSemaphoreInfoCount = signalSemaphore.semaphore ? 1u : 0u,
-        .pSignalSemaphoreInfos = &signalSemaphore,
+        .waitSemaphoreInfoCount = waitSemaphores.size,
+        .pWaitSemaphoreInfos = waitSemaphores.data,
+        .commandBufferInfoCount = static_cast<uint32>(cbSubmitInfos.size()),
+        .pCommandBufferInfos = cbSubmitInfos.data(),
+        .signalSemaphoreInfoCount = signalSemaphores.size,
+        .pSignalSemaphoreInfos = signalSemaphores.data,
+    };
+
+    std::lock_guard lock { _queueMutex };
+    vkQueueSubmit2(queue, 1, &submitInfo, VK_NULL_HANDLE);
+}
+
+void VulkanRHI::recordUploadAcquireBarriers(const VkCommandBuffer commandBuffer) const
+{
+    if (_uploadAcquireBarriers.empty()) {
+        return;
+    }
+
+    const VkDependencyInfo dependencyInfo {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .bufferMemoryBarrierCount = static_cast<uint32>(_uploadAcquireBarriers.size()),
+        .pBufferMemoryBarriers = _uploadAcquireBarriers.data(),
     };
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+    _uploadAcquireBarriers.clear();
+}
+
+[[nodiscard]] VkSemaphoreSubmitInfo VulkanRHI::makeUploadWaitSemaphoreInfo() const
+{
+    // 0 before the first flush
+    return _uploadTimeline->makeWaitInfo(_uploadTimeline->getSubmittedValue(), VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+}
+
+void VulkanRHI::recordTextureUploadCompletions(const VkCommandBuffer commandBuffer, const uint64 retiredUploadValue)
+{
+    uint32 completedCount = 0;
+    for (; completedCount < _pendingTextureUploads.size(); ++completedCount) {
+        const PendingTextureUpload& pendingUpload = _pendingTextureUploads[completedCount];
+        if (pendingUpload.uploadValue > retiredUploadValue) {
+            break;
+        }
+
+        if (_queues.hasDedicatedTransferQueue()) {
+            VulkanTexture::insertMemoryBarrier(commandBuffer, pendingUpload.upload.image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
+                VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false, 0, 1, _queues.TransferQueueFamilyID,
+                _queues.GraphicsQueueFamilyID);
+        }
+        VulkanTexture::recordUploadCompletion(commandBuffer, pendingUpload.upload);
+    }
+    _pendingTextureUploads.erase(_pendingTextureUploads.begin(), _pendingTextureUploads.begin() + completedCount);
 
-    vkQueueSubmit2(queue, 1, &submitInfo, fence);
+    // The pending frames may still sample the fallback in these slots, the bindless table rewrites them once they retired
+    std::erase_if(_pendingTextureBindings, [&](const Handle<Texture> texture) {
+        if (_textureManager.get<TextureMetadata>(texture).uploadValue > retiredUploadValue) {
+            return false;
+        }
+
+        _bindlessTable->replaceSampledImage(texture.index, _textureManager.get<ImageView>(texture).view);
+        return true;
+    });
 }
 
 VmaAllocator VulkanRHI::createVMAAllocator(const VkInstance instance, const VkPhysicalDevice gpu, const VkDevice device) const
@@ -1238,37 +2108,38 @@ VkSampler VulkanRHI::createSampler(const VkDevice device, const bool linear) con
     return sampler;
 }
 
-VulkanRHI::FrustumPlanes VulkanRHI::getFrustumPlanes(const mat4& projectionMatrix) const
+void VulkanRHI::releaseTexture(const Handle<Texture> handle)
 {
-    FrustumPlanes frustumPlanes;
-
-    // Dropping the Y component for left and right planes as it is zero, and the X component for top and bottom planes as it is zero
-
-    frustumPlanes.left = vec2 {
-        projectionMatrix[0][3] + projectionMatrix[0][0],
-        // projectionMatrix[1][3] + projectionMatrix[1][0],
-        projectionMatrix[2][3] + projectionMatrix[2][0],
-    };
-
-    frustumPlanes.right = vec2 {
-        projectionMatrix[0][3] - projectionMatrix[0][0],
-        // projectionMatrix[1][3] - projectionMatrix[1][0],
-        projectionMatrix[2][3] - projectionMatrix[2][0],
-    };
+    _releasedTextures.emplace_back(ReleasedTexture { .handle = handle, .retireValue = _graphicsTimeline->getPendingValue() });
+}
 
-    frustumPlanes.top = vec2 {
-        // projectionMatrix[0][3] - projectionMatrix[0][1],
-        projectionMatrix[1][3] + projectionMatrix[1][1], // sign flipped due to Vulkan NDC
-        projectionMatrix[2][3] - projectionMatrix[2][1],
-    };
+void VulkanRHI::releaseBuffer(const Handle<Buffer> handle)
+{
+    _releasedBuffers.emplace_back(ReleasedBuffer { .handle = handle, .retireValue = _graphicsTimeline->getPendingValue() });
+}
 
-    frustumPlanes.bottom = vec2 {
-        // projectionMatrix[0][3] + projectionMatrix[0][1],
-        projectionMatrix[1][3] - projectionMatrix[1][1], // sign flipped due to Vulkan NDC
-        projectionMatrix[2][3] + projectionMatrix[2][1],
-    };
+void VulkanRHI::collectReleased()
+{
+    const uint64 retiredValue = _graphicsTimeline->getRetiredValue();
+    const VkImageView fallbackView = _textureManager.get<ImageView>(_fallbackTexture).view;
+
+    uint32 collectedCount = 0;
+    while (collectedCount < _releasedTextures.size() && _releasedTextures[collectedCount].retireValue <= retiredValue) {
+        const Handle<Texture> handle = _releasedTextures[collectedCount++].handle;
+        // Nothing pending samples the slot anymore, it doesn't keep pointing to the destroyed view until the handle is reused
+        _bindlessTable->cancelReplacement(handle.index);
+        if (handle.index < _bindlessTable->getSampledImageCapacity()) {
+            _bindlessTable->setSampledImage(handle.index, fallbackView);
+        }
+        _textureManager.release(*this, handle);
+    }
+    _releasedTextures.erase(_releasedTextures.begin(), _releasedTextures.begin() + collectedCount);
 
-    return frustumPlanes;
+    collectedCount = 0;
+    while (collectedCount < _releasedBuffers.size() && _releasedBuffers[collectedCount].retireValue <= retiredValue) {
+        _bufferManager.release(*this, _releasedBuffers[collectedCount++].handle);
+    }
+    _releasedBuffers.erase(_releasedBuffers.begin(), _releasedBuffers.begin() + collectedCount);
 }
 
 void VulkanRHI::handleResize()
@@ -1278,21 +2149,15 @@ void VulkanRHI::handleResize()
     // Cleanup
     if (_swapchain != nullptr) {
         for (const Handle<Texture> texture : _swapchainTextures) {
-            _textureManager.release(*this, texture);
+            releaseTexture(texture);
         }
 
         for (VkSemaphore renderSemaphore : _renderSemaphores) {
             vkDestroySemaphore(_device, renderSemaphore, nullptr);
         }
 
-        for (int i = 0; i < MaxFramesInFlight; ++i) {
+        for (uint32 i = 0; i < getFramesInFlight(); ++i) {
             vkDestroySemaphore(_device, _presentSemaphores[i], nullptr);
-            vkDestroyFence(_device, _frameFences[i], nullptr);
-
-            _textureManager.release(*this, _gbufferRTs[i].albedoRT);
-            _textureManager.release(*this, _gbufferRTs[i].normalRT);
-            _textureManager.release(*this, _gbufferRTs[i].depthRT);
-            _textureManager.release(*this, _finalRTs[i]);
         }
     }
 
@@ -1325,64 +2190,451 @@ void VulkanRHI::handleResize()
     for (int i = 0; i < _renderSemaphores.size(); ++i) {
         _renderSemaphores[i] = createSemaphore(_device);
     }
-    for (int i = 0; i < MaxFramesInFlight; ++i) {
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
         _presentSemaphores[i] = createSemaphore(_device);
-        _frameFences[i] = createFence(_device, true);
     }
 
-    // Octahedron normal projection
-    const VkFormat normalRTFormat = VK_FORMAT_A2B10G10R10_UNORM_PACK32;
-    // Fairly low precision acceptable for cartoonish rendering
-    const VkFormat albedoRTFormat = VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+    // The transient render targets follow the swapchain extent
+    if (_renderGraph != nullptr) {
+        buildRenderGraph();
+        updateGBufferDescriptorSets();
+        updateDepthPyramidDescriptorSets();
+    }
+}
 
-    for (int i = 0; i < MaxFramesInFlight; ++i) {
-        _gbufferRTs[i].normalRT = _textureManager.create(*this,
-            {
-                .format = normalRTFormat,
-                .extent = { framebufferExtent.width, framebufferExtent.height, 1 },
-                .usageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                .aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT,
-            });
+void VulkanRHI::buildRenderGraph()
+{
+    releaseRenderGraph();
 
-        _gbufferRTs[i].albedoRT = _textureManager.create(*this,
-            {
-                .format = albedoRTFormat,
-                .extent = { framebufferExtent.width, framebufferExtent.height, 1 },
-                .usageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                .aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT,
-            });
+    const VkExtent3D swapchainExtent = _textureManager.get<TextureMetadata>(_swapchainTextures[0]).extent;
+    const VkExtent2D rtExtent { swapchainExtent.width, swapchainExtent.height };
 
-        _gbufferRTs[i].depthRT = _textureManager.create(*this,
-            {
-                .format = VK_FORMAT_D32_SFLOAT,
-                .extent = { framebufferExtent.width, framebufferExtent.height, 1 },
-                .usageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                .aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT,
-            });
+    _visibilityBufferGraph = _frameSettings.visibilityBuffer;
 
-        _finalRTs[i] = _textureManager.create(*this,
+    _renderGraph = std::make_unique<RenderGraph>(getFramesInFlight());
+    RenderGraph& graph = *_renderGraph;
+    _graphResources = {
+        .normalRT = graph.createTexture("NormalRT", { .format = NormalRTFormat, .extent = rtExtent }),
+        .albedoRT = graph.createTexture("AlbedoRT", { .format = AlbedoRTFormat, .extent = rtExtent }),
+        .depthRT = graph.createTexture("DepthRT", { .format = DepthRTFormat, .extent = rtExtent }),
+        .finalRT = graph.createTexture("FinalRT", { .format = FinalRTFormat, .extent = rtExtent }),
+        .depthPyramid = graph.createTexture("DepthPyramid",
             {
-                .format = VK_FORMAT_R16G16B16A16_SFLOAT, // Alpha?
-                .extent = { framebufferExtent.width, framebufferExtent.height, 1 },
-                .usageFlags = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-                .aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT,
-            });
+                .format = DepthPyramidFormat,
+                .extent = rtExtent,
+                .mipLevels = VulkanTexture::getMipLevelCount(swapchainExtent),
+            }),
+        .swapchain = graph.importTexture("Swapchain", { .finalAccess = RGAccess::Present }),
+        // Read back on the CPU for the stats once the frame retired
+        .cullingCounters = graph.importBuffer("CullingCounters", { .finalAccess = RGAccess::HostRead }),
+        // Written by the previous frame's late culling
+        .visibility = graph.importBuffer("Visibility", { .initialAccess = RGAccess::ComputeStorageReadWrite }),
+        .drawIndirect = graph.importBuffer("DrawIndirect", {}),
+        .meshletDraws = graph.importBuffer("MeshletDraws", {}),
+        .clusterDispatch = graph.importBuffer("ClusterDispatch", {}),
+        .materialBins = graph.importBuffer("MaterialBins", {}),
+        .drawRecords = graph.importBuffer("DrawRecords", {}),
+        .instanceIndices = graph.importBuffer("InstanceIndices", {}),
+        .lightClusters = graph.importBuffer("LightClusters", {}),
+    };
+    // A texture no pass uses would have no usage flags
+    if (_visibilityBufferGraph) {
+        _graphResources.visibilityRT = graph.createTexture("VisibilityRT", { .format = VisibilityRTFormat, .extent = rtExtent });
+    }
+    const FrameGraphResources& res = _graphResources;
+
+    // The persistent GPU scene synchronizes its own scatter uploads
+    graph.addPass({
+        .name = "GPUSceneUpdate",
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 frameInFlightId) { _gpuScene->recordUpdate(commandBuffer, frameInFlightId); },
+        .sideEffects = true,
+    });
+
+    // The culling passes only increment the instance counts of the draws, the meshlet draws only need their counts reset
+    const RenderGraph::BufferAccess resetBuffers[] = {
+        { res.cullingCounters, RGAccess::TransferWrite },
+        { res.drawIndirect, RGAccess::TransferWrite },
+        { res.meshletDraws, RGAccess::TransferWrite },
+        { res.clusterDispatch, RGAccess::TransferWrite },
+        { res.materialBins, RGAccess::TransferWrite },
+    };
+    graph.addPass({
+        .name = "ResetCullingCounters",
+        .buffers = resetBuffers,
+        .record =
+            [this](VkCommandBuffer commandBuffer, const RenderGraph& renderGraph, const uint32 frameInFlightId) {
+                const VkBuffer cullingCountersBuffer
+                    = _bufferManager.get<GPUBuffer>(renderGraph.getBuffer(frameInFlightId, _graphResources.cullingCounters)).buffer;
+                vkCmdFillBuffer(commandBuffer, cullingCountersBuffer, 0, sizeof(CullingCounters), 0);
+                const VkBuffer drawIndirectBuffer
+                    = _bufferManager.get<GPUBuffer>(renderGraph.getBuffer(frameInFlightId, _graphResources.drawIndirect)).buffer;
+                vkCmdFillBuffer(commandBuffer, drawIndirectBuffer, 0, VK_WHOLE_SIZE, 0);
+                const VkBuffer meshletDrawBuffer
+                    = _bufferManager.get<GPUBuffer>(renderGraph.getBuffer(frameInFlightId, _graphResources.meshletDraws)).buffer;
+                vkCmdFillBuffer(commandBuffer, meshletDrawBuffer, 0, MeshletDrawsOffset, 0);
+                const VkBuffer clusterDispatchBuffer
+                    = _bufferManager.get<GPUBuffer>(renderGraph.getBuffer(frameInFlightId, _graphResources.clusterDispatch)).buffer;
+                vkCmdFillBuffer(commandBuffer, clusterDispatchBuffer, 0, VK_WHOLE_SIZE, 0);
+                // The staged objects are overwritten
+                const VkBuffer materialBinBuffer
+                    = _bufferManager.get<GPUBuffer>(renderGraph.getBuffer(frameInFlightId, _graphResources.materialBins)).buffer;
+                vkCmdFillBuffer(commandBuffer, materialBinBuffer, 0,
+                    sizeof(MaterialBinHeader)
+                        + DrawListCount * VulkanGPUScene::MaxMeshes * Geometry::MaxLODs * MaterialBinCount * sizeof(uint32),
+                    0);
+            },
+    });
+
+    // Only needs the lights of the frame, runs early so the shading doesn't wait for it
+    const RenderGraph::BufferAccess lightCullingBuffers[] = { { res.lightClusters, RGAccess::ComputeStorageWrite } };
+    graph.addPass({
+        .name = "LightCulling",
+        .buffers = lightCullingBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordLightCullingPass(commandBuffer, _frameContext); },
+    });
+
+    // Early phase: draw what was visible last frame
+    const RenderGraph::BufferAccess earlyCullingBuffers[] = {
+        { res.cullingCounters, RGAccess::ComputeStorageReadWrite },
+        { res.visibility, RGAccess::ComputeStorageRead },
+        { res.drawIndirect, RGAccess::ComputeStorageReadWrite },
+        { res.clusterDispatch, RGAccess::ComputeStorageReadWrite },
+        { res.materialBins, RGAccess::ComputeStorageReadWrite },
+        { res.drawRecords, RGAccess::ComputeStorageWrite },
+        { res.instanceIndices, RGAccess::ComputeStorageWrite },
+    };
+    graph.addPass({
+        .name = "EarlyCulling",
+        .buffers = earlyCullingBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordCullingPass(commandBuffer, _frameContext, false); },
+    });
+
+    // Both phases cull the meshlets of the objects their culling pass selected
+    const RenderGraph::BufferAccess clusterCullingBuffers[] = {
+        { res.cullingCounters, RGAccess::ComputeStorageReadWrite },
+        { res.clusterDispatch, RGAccess::IndirectRead },
+        { res.clusterDispatch, RGAccess::ComputeStorageRead },
+        { res.meshletDraws, RGAccess::ComputeStorageReadWrite },
+        { res.drawRecords, RGAccess::ComputeStorageRead },
+        { res.instanceIndices, RGAccess::ComputeStorageReadWrite }, // one instance per meshlet draw
+    };
+    graph.addPass({
+        .name = "EarlyClusterCulling",
+        .buffers = clusterCullingBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordClusterCullingPass(commandBuffer, _frameContext, false); },
+    });
+
+    // Groups the per-mesh instances of the phase by material, the GBuffer pass draws the same commands
+    const RenderGraph::BufferAccess materialBinningBuffers[] = {
+        { res.materialBins, RGAccess::ComputeStorageReadWrite },
+        { res.materialBins, RGAccess::IndirectRead },
+        { res.drawIndirect, RGAccess::ComputeStorageRead },
+        { res.drawRecords, RGAccess::ComputeStorageRead },
+        { res.instanceIndices, RGAccess::ComputeStorageWrite },
+    };
+    graph.addPass({
+        .name = "EarlyMaterialBinning",
+        .buffers = materialBinningBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordMaterialBinningPass(commandBuffer, _frameContext, false); },
+    });
+
+    // The visibility buffer mode writes the GBuffer in VisibilityResolve instead
+    const RenderGraph::TextureAccess earlyGBufferTextures[] = {
+        { res.normalRT, RGAccess::ColorAttachmentWrite },
+        { res.albedoRT, RGAccess::ColorAttachmentWrite },
+        { res.depthRT, RGAccess::DepthAttachmentWrite },
+    };
+    const RenderGraph::TextureAccess earlyVisibilityTextures[] = {
+        { res.visibilityRT, RGAccess::ColorAttachmentWrite },
+        { res.depthRT, RGAccess::DepthAttachmentWrite },
+    };
+    const RenderGraph::BufferAccess gbufferBuffers[] = {
+        { res.drawIndirect, RGAccess::IndirectRead },
+        { res.meshletDraws, RGAccess::IndirectRead },
+        { res.drawRecords, RGAccess::VertexStorageRead },
+        { res.instanceIndices, RGAccess::VertexStorageRead },
+    };
+    graph.addPass({
+        .name = "EarlyGBuffer",
+        .textures = _visibilityBufferGraph ? ArrayWrapper<RenderGraph::TextureAccess> { earlyVisibilityTextures }
+                                           : ArrayWrapper<RenderGraph::TextureAccess> { earlyGBufferTextures },
+        .buffers = gbufferBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordGBufferPass(commandBuffer, _frameContext, false); },
+    });
+
+    const RenderGraph::TextureAccess depthPyramidTextures[] = {
+        { res.depthRT, RGAccess::ComputeSampledRead },
+        { res.depthPyramid, RGAccess::ComputeStorageWrite },
+    };
+    graph.addPass({
+        .name = "DepthPyramid",
+        .textures = depthPyramidTextures,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordDepthPyramidPass(commandBuffer, _frameContext); },
+    });
+
+    // Late phase: test everything else against the pyramid, draw what was disoccluded and update the visibility for the next frame
+    const RenderGraph::TextureAccess lateCullingTextures[] = { { res.depthPyramid, RGAccess::ComputeSampledRead } };
+    const RenderGraph::BufferAccess lateCullingBuffers[] = {
+        { res.cullingCounters, RGAccess::ComputeStorageReadWrite },
+        { res.visibility, RGAccess::ComputeStorageReadWrite },
+        { res.drawIndirect, RGAccess::ComputeStorageReadWrite },
+        { res.clusterDispatch, RGAccess::ComputeStorageReadWrite },
+        { res.materialBins, RGAccess::ComputeStorageReadWrite },
+        { res.drawRecords, RGAccess::ComputeStorageWrite },
+        { res.instanceIndices, RGAccess::ComputeStorageWrite },
+    };
+    graph.addPass({
+        .name = "LateCulling",
+        .textures = lateCullingTextures,
+        .buffers = lateCullingBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordCullingPass(commandBuffer, _frameContext, true); },
+    });
+
+    graph.addPass({
+        .name = "LateClusterCulling",
+        .buffers = clusterCullingBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordClusterCullingPass(commandBuffer, _frameContext, true); },
+    });
+
+    graph.addPass({
+        .name = "LateMaterialBinning",
+        .buffers = materialBinningBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordMaterialBinningPass(commandBuffer, _frameContext, true); },
+    });
+
+    const RenderGraph::TextureAccess lateGBufferTextures[] = {
+        { res.normalRT, RGAccess::ColorAttachmentReadWrite },
+        { res.albedoRT, RGAccess::ColorAttachmentReadWrite },
+        { res.depthRT, RGAccess::DepthAttachmentReadWrite },
+    };
+    const RenderGraph::TextureAccess lateVisibilityTextures[] = {
+        { res.visibilityRT, RGAccess::ColorAttachmentReadWrite },
+        { res.depthRT, RGAccess::DepthAttachmentReadWrite },
+    };
+    graph.addPass({
+        .name = "LateGBuffer",
+        .textures = _visibilityBufferGraph ? ArrayWrapper<RenderGraph::TextureAccess> { lateVisibilityTextures }
+                                           : ArrayWrapper<RenderGraph::TextureAccess> { lateGBufferTextures },
+        .buffers = gbufferBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordGBufferPass(commandBuffer, _frameContext, true); },
+    });
+
+    // Attributes and textures of the visible triangles, once per pixel
+    const RenderGraph::TextureAccess visibilityResolveTextures[] = {
+        { res.visibilityRT, RGAccess::ComputeSampledRead },
+        { res.normalRT, RGAccess::ComputeStorageWrite },
+        { res.albedoRT, RGAccess::ComputeStorageWrite },
+    };
+    const RenderGraph::BufferAccess visibilityResolveBuffers[] = {
+        { res.meshletDraws, RGAccess::ComputeStorageRead },
+        { res.drawRecords, RGAccess::ComputeStorageRead },
+        { res.instanceIndices, RGAccess::ComputeStorageRead },
+    };
+    if (_visibilityBufferGraph) {
+        graph.addPass({
+            .name = "VisibilityResolve",
+            .textures = visibilityResolveTextures,
+            .buffers = visibilityResolveBuffers,
+            .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                          const uint32 /*frameInFlightId*/) { recordVisibilityResolvePass(commandBuffer, _frameContext); },
+        });
     }
 
-    if (_deferredShadingBindGroup != InvalidHandle<BindGroup>) {
-        updateGBufferDescriptorSets();
+    const RenderGraph::TextureAccess shadingTextures[] = {
+        { res.normalRT, RGAccess::ComputeSampledRead },
+        { res.albedoRT, RGAccess::ComputeSampledRead },
+        { res.depthRT, RGAccess::ComputeSampledRead },
+        { res.finalRT, RGAccess::ComputeStorageWrite },
+    };
+    const RenderGraph::BufferAccess shadingBuffers[] = { { res.lightClusters, RGAccess::ComputeStorageRead } };
+    graph.addPass({
+        .name = "DeferredShading",
+        .textures = shadingTextures,
+        .buffers = shadingBuffers,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordShadingPass(commandBuffer, _frameContext); },
+    });
+
+    const RenderGraph::TextureAccess blitTextures[] = {
+        { res.finalRT, RGAccess::TransferRead },
+        { res.swapchain, RGAccess::TransferWrite },
+    };
+    graph.addPass({
+        .name = "Blit",
+        .textures = blitTextures,
+        .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                      const uint32 /*frameInFlightId*/) { recordBlitPass(commandBuffer, _frameContext); },
+    });
+
+    if (EnableDebugDraw) {
+        const RenderGraph::TextureAccess debugUITextures[] = { { res.swapchain, RGAccess::ColorAttachmentReadWrite } };
+        graph.addPass({
+            .name = "DebugUI",
+            .textures = debugUITextures,
+            .record = [this](VkCommandBuffer commandBuffer, const RenderGraph&,
+                          const uint32 /*frameInFlightId*/) { recordDebugUIPass(commandBuffer, _frameContext); },
+        });
+    }
+
+    graph.compile();
+
+    // Transient textures of the same aliasing group never overlap and share one allocation, large enough for the biggest of them
+    const std::vector<RenderGraph::TransientTexture>& transientTextures = graph.getTransientTextures();
+    std::vector<VkMemoryRequirements> groupRequirements(
+        graph.getAliasingGroupCount(), VkMemoryRequirements { .size = 0, .alignment = 1, .memoryTypeBits = NH3D_MAX_T(uint32) });
+    for (const RenderGraph::TransientTexture& texture : transientTextures) {
+        const VkImageCreateInfo imageCreateInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = texture.info.format,
+            .extent = { texture.info.extent.width, texture.info.extent.height, 1 },
+            .mipLevels = texture.info.mipLevels,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = texture.usage,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+        const VkDeviceImageMemoryRequirements requirementsInfo {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS,
+            .pCreateInfo = &imageCreateInfo,
+        };
+        VkMemoryRequirements2 requirements { .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2 };
+        vkGetDeviceImageMemoryRequirements(_device, &requirementsInfo, &requirements);
+
+        VkMemoryRequirements& groupRequirement = groupRequirements[texture.aliasingGroup];
+        groupRequirement.size = std::max(groupRequirement.size, requirements.memoryRequirements.size);
+        groupRequirement.alignment = std::max(groupRequirement.alignment, requirements.memoryRequirements.alignment);
+        groupRequirement.memoryTypeBits &= requirements.memoryRequirements.memoryTypeBits;
+    }
+
+    const VmaAllocationCreateInfo allocCreateInfo {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+        .requiredFlags = VkMemoryPropertyFlags { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT },
+    };
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        _transientAllocations[i].resize(groupRequirements.size());
+        for (uint32 group = 0; group < groupRequirements.size(); ++group) {
+            NH3D_ASSERT(groupRequirements[group].memoryTypeBits != 0, "Aliased textures don't have any compatible memory type");
+            if (vmaAllocateMemory(_allocator, &groupRequirements[group], &allocCreateInfo, &_transientAllocations[i][group], nullptr)
+                != VK_SUCCESS) {
+                NH3D_ABORT_VK("Failed to allocate render graph transient memory");
+            }
+        }
+
+        for (const RenderGraph::TransientTexture& texture : transientTextures) {
+            const bool isDepth = (texture.usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0;
+            const VkImageAspectFlags aspect = isDepth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+            const Handle<Texture> handle = _textureManager.create(*this,
+                {
+                    .format = texture.info.format,
+                    .extent = { texture.info.extent.width, texture.info.extent.height, 1 },
+                    .usageFlags = texture.usage,
+                    .aspectFlags = aspect,
+                    .mipLevels = texture.info.mipLevels,
+                    .aliasingAllocation = _transientAllocations[i][texture.aliasingGroup],
+                });
+            _transientTextures[i].emplace_back(handle);
+            graph.bindTexture(i, texture.texture,
+                {
+                    .handle = handle,
+                    .image = _textureManager.get<ImageView>(handle).image,
+                    .aspect = aspect,
+                });
+        }
+
+        // The pyramid levels are written one at a time
+        const ImageView& depthPyramidViewData = _textureManager.get<ImageView>(graph.getTexture(i, res.depthPyramid));
+        const uint32 depthPyramidLevelCount = VulkanTexture::getMipLevelCount(swapchainExtent);
+        NH3D_ASSERT(depthPyramidLevelCount <= MaxDepthPyramidLevels, "Too many depth pyramid levels for the swapchain extent");
+        for (uint32 level = 0; level < depthPyramidLevelCount; ++level) {
+            const VkImageViewCreateInfo viewCreateInfo {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = depthPyramidViewData.image,
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = DepthPyramidFormat,
+                .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = level,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            };
+            VkImageView view;
+            if (vkCreateImageView(_device, &viewCreateInfo, nullptr, &view) != VK_SUCCESS) {
+                NH3D_ABORT_VK("Failed to create depth pyramid level view");
+            }
+            _depthPyramidLevelViews[i].emplace_back(view);
+        }
+
+        const std::pair<RGBuffer, Handle<Buffer>> importedBuffers[] = {
+            { res.cullingCounters, _cullingCounterBuffers[i] },
+            { res.visibility, _visibilityBuffer },
+            { res.drawIndirect, _drawIndirectBuffers[i] },
+            { res.meshletDraws, _meshletDrawBuffers[i] },
+            { res.clusterDispatch, _clusterDispatchBuffers[i] },
+            { res.materialBins, _materialBinBuffers[i] },
+            { res.drawRecords, _drawRecordBuffers[i] },
+            { res.instanceIndices, _instanceIndexBuffers[i] },
+            { res.lightClusters, _lightClusterBuffers[i] },
+        };
+        for (const auto& [buffer, handle] : importedBuffers) {
+            graph.bindBuffer(i, buffer, { .handle = handle, .buffer = _bufferManager.get<GPUBuffer>(handle).buffer });
+        }
+    }
+
+    // The pass indices changed, the pending timestamps can't be matched to them anymore
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        vkResetQueryPool(_device, _timestampQueryPools[i], 0, 2 * RenderGraph::MaxPasses);
+    }
+    _timestampedPassCounts = {};
+}
+
+void VulkanRHI::releaseRenderGraph()
+{
+    // Only called once the device is idle, the memory is freed right away and the textures bound to it are destroyed with the
+    // other released ones
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        for (const VkImageView view : _depthPyramidLevelViews[i]) {
+            vkDestroyImageView(_device, view, nullptr);
+        }
+        _depthPyramidLevelViews[i].clear();
+
+        for (const Handle<Texture> texture : _transientTextures[i]) {
+            releaseTexture(texture);
+        }
+        _transientTextures[i].clear();
+
+        for (const VmaAllocation allocation : _transientAllocations[i]) {
+            vmaFreeMemory(_allocator, allocation);
+        }
+        _transientAllocations[i].clear();
     }
+
+    _renderGraph.reset();
 }
 
 void VulkanRHI::updateGBufferDescriptorSets()
 {
     auto& deferredShadingDescriptorSets = _bindGroupManager.get<DescriptorSets>(_deferredShadingBindGroup);
 
-    for (int i = 0; i < IRHI::MaxFramesInFlight; ++i) {
-        const auto& normalRTImageViewData = _textureManager.get<ImageView>(_gbufferRTs[i].normalRT);
-        const auto& albedoRTImageViewData = _textureManager.get<ImageView>(_gbufferRTs[i].albedoRT);
-        const auto& depthRTImageViewData = _textureManager.get<ImageView>(_gbufferRTs[i].depthRT);
-        const auto& finalRTImageViewData = _textureManager.get<ImageView>(_finalRTs[i]);
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        const auto& normalRTImageViewData = _textureManager.get<ImageView>(_renderGraph->getTexture(i, _graphResources.normalRT));
+        const auto& albedoRTImageViewData = _textureManager.get<ImageView>(_renderGraph->getTexture(i, _graphResources.albedoRT));
+        const auto& depthRTImageViewData = _textureManager.get<ImageView>(_renderGraph->getTexture(i, _graphResources.depthRT));
+        const auto& finalRTImageViewData = _textureManager.get<ImageView>(_renderGraph->getTexture(i, _graphResources.finalRT));
 
         VulkanBindGroup::updateDescriptorSet(_device, deferredShadingDescriptorSets.sets[i],
             VkDescriptorImageInfo {
@@ -1402,7 +2654,7 @@ void VulkanRHI::updateGBufferDescriptorSets()
             VkDescriptorImageInfo {
                 .sampler = VK_NULL_HANDLE,
                 .imageView = depthRTImageViewData.view,
-                .imageLayout = VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
             },
             VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2);
         VulkanBindGroup::updateDescriptorSet(_device, deferredShadingDescriptorSets.sets[i],
@@ -1412,6 +2664,189 @@ void VulkanRHI::updateGBufferDescriptorSets()
                 .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
             },
             VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 3);
+
+        if (!_visibilityBufferGraph) {
+            continue;
+        }
+
+        auto& visibilityResolveDescriptorSets = _bindGroupManager.get<DescriptorSets>(_visibilityResolveBindGroup);
+        const auto& visibilityRTImageViewData = _textureManager.get<ImageView>(_renderGraph->getTexture(i, _graphResources.visibilityRT));
+        VulkanBindGroup::updateDescriptorSet(_device, visibilityResolveDescriptorSets.sets[i],
+            VkDescriptorImageInfo {
+                .sampler = VK_NULL_HANDLE,
+                .imageView = visibilityRTImageViewData.view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            },
+            VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 0);
+        VulkanBindGroup::updateDescriptorSet(_device, visibilityResolveDescriptorSets.sets[i],
+            VkDescriptorImageInfo {
+                .sampler = VK_NULL_HANDLE,
+                .imageView = normalRTImageViewData.view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            },
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1);
+        VulkanBindGroup::updateDescriptorSet(_device, visibilityResolveDescriptorSets.sets[i],
+            VkDescriptorImageInfo {
+                .sampler = VK_NULL_HANDLE,
+                .imageView = albedoRTImageViewData.view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            },
+            VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2);
+    }
+}
+void VulkanRHI::updateDepthPyramidDescriptorSets()
+{
+    const auto& depthPyramidDescriptorSets = _bindGroupManager.get<DescriptorSets>(_depthPyramidBindGroup);
+
+    for (uint32 i = 0; i < getFramesInFlight(); ++i) {
+        const auto& depthRTImageViewData = _textureManager.get<ImageView>(_renderGraph->getTexture(i, _graphResources.depthRT));
+        const auto& depthPyramidImageViewData = _textureManager.get<ImageView>(_renderGraph->getTexture(i, _graphResources.depthPyramid));
+
+        VulkanBindGroup::updateDescriptorSet(_device, depthPyramidDescriptorSets.sets[i],
+            VkDescriptorImageInfo {
+                .sampler = VK_NULL_HANDLE,
+                .imageView = depthPyramidImageViewData.view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            },
+            VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 0);
+
+        // Each level is reduced from the previous one, the first from the depth buffer itself
+        const std::vector<VkImageView>& levelViews = _depthPyramidLevelViews[i];
+        for (uint32 level = 0; level < levelViews.size(); ++level) {
+            const auto& levelDescriptorSets = _bindGroupManager.get<DescriptorSets>(_depthPyramidLevelBindGroups[level]);
+            VulkanBindGroup::updateDescriptorSet(_device, levelDescriptorSets.sets[i],
+                VkDescriptorImageInfo {
+                    .sampler = VK_NULL_HANDLE,
+                    .imageView = level == 0 ? depthRTImageViewData.view : levelViews[level - 1],
+                    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+                },
+                VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 0);
+            VulkanBindGroup::updateDescriptorSet(_device, levelDescriptorSets.sets[i],
+                VkDescriptorImageInfo {
+                    .sampler = VK_NULL_HANDLE,
+                    .imageView = levelViews[level],
+                    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+                },
+                VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1);
+        }
+    }
+}
+
+[[nodiscard]] bool VulkanRHI::areFramePipelinesReady()
+{
+    if (!_pipelineCompiler->isIdle()) {
+        const auto isShaderValid = [this](const Handle<Shader> shader) {
+            return VulkanShader::valid(_shaderManager.get<VkPipeline>(shader), _shaderManager.get<VkPipelineLayout>(shader));
+        };
+        if (!isShaderValid(_gbufferShader)) {
+            return false;
+        }
+        // Not compiled on the devices without the visibility buffer
+        if (_visibilityBufferSupported
+            && (!isShaderValid(_visibilityShader)
+                || !VulkanComputeShader::valid(_computeShaderManager.get<VkPipeline>(_visibilityResolveCS),
+                    _computeShaderManager.get<VkPipelineLayout>(_visibilityResolveCS)))) {
+            return false;
+        }
+
+        const Handle<ComputeShader> computeShaders[] = {
+            getTunedComputeShader(_frustumCullingKernel),
+            getTunedComputeShader(_lateCullingKernel),
+            _clusterCullingCS,
+            _materialBinningCS,
+            _depthPyramidCS,
+            _lightCullingCS,
+            getTunedComputeShader(_deferredShadingKernel),
+            _gpuScene->getScatterShader(),
+        };
+        for (const Handle<ComputeShader> computeShader : computeShaders) {
+            if (!VulkanComputeShader::valid(_computeShaderManager.get<VkPipeline>(computeShader),
+                    _computeShaderManager.get<VkPipelineLayout>(computeShader))) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void VulkanRHI::logStartupTime()
+{
+    if (_startupTimeLogged || !_pipelineCompiler->isIdle()) {
+        return;
+    }
+    _startupTimeLogged = true;
+
+    // To keep an eye on the startup regressions, compared between cold and warm pipeline caches
+    const std::chrono::duration<float, std::milli> startupTime = std::chrono::high_resolution_clock::now() - _startupStartTime;
+    NH3D_LOG("Renderer startup took " << startupTime.count() << " ms (" << (_pipelineCache->isWarm() ? "warm" : "cold")
+                                      << " pipeline cache)");
+}
+
+[[nodiscard]] uint32 VulkanRHI::createTunedComputeShader(
+    const std::string& name, const ArrayWrapper<vec3u> candidates, const VulkanComputeShader::CreateInfo& info)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(_gpu, &properties);
+    const VkPhysicalDeviceLimits& limits = properties.limits;
+
+    std::vector<vec3u> supportedCandidates;
+    for (uint32 i = 0; i < candidates.size; ++i) {
+        const vec3u size = candidates.data[i];
+        if (size.x * size.y * size.z <= limits.maxComputeWorkGroupInvocations && size.x <= limits.maxComputeWorkGroupSize[0]
+            && size.y <= limits.maxComputeWorkGroupSize[1] && size.z <= limits.maxComputeWorkGroupSize[2]) {
+            supportedCandidates.emplace_back(size);
+        }
+    }
+    NH3D_ASSERT(!supportedCandidates.empty() && supportedCandidates[0] == candidates.data[0],
+        "The default workgroup size of a tuned compute shader has to be supported by every device");
+
+    const uint32 kernelId = _workgroupTuner->addKernel(name, supportedCandidates);
+    NH3D_ASSERT(kernelId == _tunedComputeShaders.size(), "The tuned compute shaders are indexed by kernel ID");
+    _tunedComputeShaders.emplace_back(TunedComputeShader {
+        .createInfo = { info },
+        .variants = std::vector<Handle<ComputeShader>>(supportedCandidates.size(), InvalidHandle<ComputeShader>),
+    });
+    compileTunedComputeShader(kernelId, _workgroupTuner->getSelectedCandidate(kernelId));
+
+    return kernelId;
+}
+
+void VulkanRHI::compileTunedComputeShader(const uint32 kernelId, const uint32 candidateId)
+{
+    TunedComputeShader& shader = _tunedComputeShaders[kernelId];
+    if (shader.variants[candidateId] != InvalidHandle<ComputeShader>) {
+        return;
     }
+
+    VulkanComputeShader::AsyncCreateInfo variantInfo = shader.createInfo;
+    variantInfo.workgroupSize = _workgroupTuner->getCandidate(kernelId, candidateId);
+    shader.variants[candidateId] = _pipelineCompiler->compile(_computeShaderManager, variantInfo.get());
+}
+
+[[nodiscard]] Handle<ComputeShader> VulkanRHI::getTunedComputeShader(const uint32 kernelId) const
+{
+    return _tunedComputeShaders[kernelId].variants[_workgroupTuner->getSelectedCandidate(kernelId)];
+}
+
+void VulkanRHI::updateWorkgroupTuning()
+{
+    if (_frameSettings.workgroupTuning == _workgroupTuning) {
+        return;
+    }
+    _workgroupTuning = _frameSettings.workgroupTuning;
+
+    if (!_workgroupTuning) {
+        _workgroupTuner->stopTuning();
+        return;
+    }
+
+    // Every candidate is timed on the current scene, the frames wait for the variants they select to be compiled
+    for (uint32 kernelId = 0; kernelId < _tunedComputeShaders.size(); ++kernelId) {
+        for (uint32 candidateId = 0; candidateId < _workgroupTuner->getCandidateCount(kernelId); ++candidateId) {
+            compileTunedComputeShader(kernelId, candidateId);
+        }
+    }
+    _workgroupTuner->startTuning();
+}
 }
-}
\ No newline at end of file
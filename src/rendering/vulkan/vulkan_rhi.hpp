@@ -1,48 +1,71 @@
 #pragma once
 
 #include "general/window.hpp"
+#include <chrono>
 #include <core/aabb.hpp>
 #include <cstdint>
 #include <functional>
 #include <misc/types.hpp>
 #include <misc/utils.hpp>
+#include <mutex>
 #include <rendering/core/bind_group.hpp>
 #include <rendering/core/buffer.hpp>
 #include <rendering/core/compute_shader.hpp>
 #include <rendering/core/frame_resource.hpp>
+#include <rendering/core/frustum_culler.hpp>
 #include <rendering/core/handle.hpp>
 #include <rendering/core/material.hpp>
+#include <rendering/core/mesh.hpp>
+#include <rendering/core/render_snapshot.hpp>
 #include <rendering/core/resource_manager.hpp>
 #include <rendering/core/rhi.hpp>
 #include <rendering/core/shader.hpp>
 #include <rendering/core/texture.hpp>
+#include <rendering/render_graph/render_graph.hpp>
 #include <rendering/vulkan/vulkan_bind_group.hpp>
 #include <rendering/vulkan/vulkan_buffer.hpp>
 #include <rendering/vulkan/vulkan_compute_shader.hpp>
 #include <rendering/vulkan/vulkan_enums.hpp>
 #include <rendering/vulkan/vulkan_shader.hpp>
 #include <rendering/vulkan/vulkan_texture.hpp>
+#include <rendering/vulkan/vulkan_timeline.hpp>
+#include <string>
 #include <utility>
+#include <vector>
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_core.h>
 
 namespace NH3D {
 
+class VulkanBindlessTable;
 class VulkanDebugDrawer;
+class VulkanGeometryArena;
+class VulkanGPUScene;
+class VulkanPipelineCache;
+class VulkanPipelineCompiler;
+class VulkanStagingRing;
+class WorkgroupTuner;
+class ThreadPool;
 
 class VulkanRHI : public IRHI {
     NH3D_NO_COPY_MOVE(VulkanRHI)
 public:
     VulkanRHI() = delete;
 
-    // Window used for surface creation
-    VulkanRHI(const Window& window);
+    // Window used for surface creation, framesInFlight between 1 and MaxFramesInFlight
+    VulkanRHI(const Window& window, const uint32 framesInFlight = DefaultFramesInFlight);
 
     ~VulkanRHI();
 
     [[nodiscard]] inline VkDevice getVkDevice() const { return _device; }
 
+    [[nodiscard]] inline VkPhysicalDevice getGPU() const { return _gpu; }
+
+    [[nodiscard]] inline const VulkanPipelineCache& getPipelineCache() const { return *_pipelineCache; }
+
+    [[nodiscard]] inline VulkanPipelineCompiler& getPipelineCompiler() { return *_pipelineCompiler; }
+
     [[nodiscard]] inline VmaAllocator getAllocator() const { return _allocator; }
 
     [[nodiscard]] inline ResourceManager<VulkanTexture>& getTextureManager() { return _textureManager; }
@@ -55,10 +78,30 @@ public:
 
     [[nodiscard]] inline ResourceManager<VulkanBindGroup>& getBindGroupManager() { return _bindGroupManager; }
 
-    void recordBufferUploadCommands(const std::function<void(VkCommandBuffer)>& recordFunction) const;
+    [[nodiscard]] inline const VulkanGeometryArena& getGeometryArena() const { return *_geometryArena; }
+
+    [[nodiscard]] inline VulkanStagingRing& getStagingRing() { return *_stagingRing; }
+
+    // The recorded commands write [dstOffset, dstOffset + size) of dstBuffer, that range is handed over to the graphics queue
+    void recordBufferUploadCommands(const VkBuffer dstBuffer, const VkDeviceSize dstOffset, const VkDeviceSize size,
+        const std::function<void(VkCommandBuffer)>& recordFunction) const;
+
+    // Records into the upload batch, the commands may only touch resources that aren't used by the graphics queue yet
+    void recordUploadCommands(const std::function<void(VkCommandBuffer)>& recordFunction) const;
 
+    // To be called once the commands filling the first mip level of the image are recorded, the rest of the upload is recorded by
+    // the first frame after the batch retired, see VulkanTexture::recordUploadCompletion. Returns the upload batch value
+    [[nodiscard]] uint64 finishTextureUpload(const VulkanTexture::Upload& upload) const;
+
+    // Submits the recorded uploads to the transfer queue without waiting, the next graphics submissions wait on them GPU side
     void flushUploadCommands() const;
 
+    // Signaled by every graphics submission (frames, immediate command buffers), also tags the deferred releases
+    [[nodiscard]] inline const VulkanTimeline& getGraphicsTimeline() const { return *_graphicsTimeline; }
+
+    // Signaled by the flushed upload batches, the batch being recorded signals getPendingValue()
+    [[nodiscard]] inline const VulkanTimeline& getUploadTimeline() const { return *_uploadTimeline; }
+
     void executeImmediateCommandBuffer(const std::function<void(VkCommandBuffer)>& recordFunction) const;
 
     virtual Handle<Texture> createTexture(const Texture::CreateInfo& info) override;
@@ -69,43 +112,209 @@ public:
 
     virtual void destroyBuffer(const Handle<Buffer> handle) override;
 
-    virtual void render(Scene& scene) override;
+    virtual Handle<Geometry> createGeometry(const Geometry::CreateInfo& info) override;
+
+    virtual void destroyGeometry(const Handle<Geometry> handle) override;
+
+    virtual void extract(Scene& scene, RenderSnapshot& snapshot) override;
+
+    virtual void render(RenderSnapshot& snapshot) override;
+
+    virtual void waitForNextFrame() override;
 
 private:
     struct PhysicalDeviceQueueFamilyID {
         uint32 GraphicsQueueFamilyID = NH3D_MAX_T(uint32);
         uint32 PresentQueueFamilyID = NH3D_MAX_T(uint32);
+        uint32 TransferQueueFamilyID = NH3D_MAX_T(uint32); // transfer only family if there is one, the graphics one otherwise
 
         bool isValid() const { return GraphicsQueueFamilyID != NH3D_MAX_T(uint32) && PresentQueueFamilyID != NH3D_MAX_T(uint32); }
-    };
 
-    struct RenderData {
-        VkDeviceAddress vertexBuffer;
-        VkDeviceAddress indexBuffer;
-        Material material;
-        uint32 indexCount;
+        bool hasDedicatedTransferQueue() const { return TransferQueueFamilyID != GraphicsQueueFamilyID; }
     };
 
+    // Upload command buffers in flight on the transfer queue, recording a new batch only waits when they are all pending
+    static constexpr uint32 UploadBatchCount = 4;
+
     struct DrawRecord {
-        VkDeviceAddress vertexBuffer;
-        VkDeviceAddress indexBuffer;
         Material material;
-        mat4x3 modelViewMatrix;
+        uint32 lod; // picked by the culling pass
+        Geometry::VertexFormat vertexFormat;
+        mat4x3 modelViewMatrix; // includes the dequantization of quantized positions
     };
 
-    struct FrustumPlanes {
-        vec2 left;
-        vec2 right;
-        vec2 bottom;
-        vec2 top;
+    enum CullingFlagBits : uint32 {
+        CULLING_OCCLUSION_BIT = 1 << 0,
+        CULLING_OBJECT_LIST_BIT = 1 << 1, // the invocations read their slot from the object list instead of using their index
+        CULLING_MATERIAL_BINNING_BIT = 1 << 2, // the per-mesh instances are staged for the material binning pass
     };
 
     struct CullingParameters {
         mat4 viewMatrix;
-        FrustumPlanes frustumPlanes; // small optimization: assumes infinite far plane and assume d=0 for near plane
+        vec4 projection; // P[0][0], P[1][1], P[2][2], P[3][2], enough for a symmetric perspective projection
+        FrustumPlanes frustumPlanes; // shared with the CPU FrustumCuller
+        uint32 objectCount; // slots, or entries of the object list
+        uint32 flags; // CullingFlagBits
+        uint32 depthPyramidLevelCount;
+        float lodErrorScale; // size in pixels of an error seen at distance 1 over the error threshold, 0 forces LOD 0
+    };
+
+    struct GBufferParameters {
+        mat4 projection;
+        VkDeviceAddress vertices; // geometry arena, the indices are fetched by the input assembler
+        VkDeviceAddress quantizedVertices; // same address, read as QuantizedVertexData
+    };
+
+    // Rebuilds the GBuffer from the visibility buffer, see visibility_resolve.comp
+    struct VisibilityResolveParameters {
+        mat4 projection;
+        VkDeviceAddress vertices;
+        VkDeviceAddress quantizedVertices;
+        std::array<VkDeviceAddress, 2> indices; // per Geometry::IndexType
+    };
+
+    // See Light in lights.inc.glsl
+    struct GPULight {
+        vec3 position; // view space
+        float range;
+        vec3 color; // premultiplied by the intensity
+        uint32 type; // LightType
+        vec3 direction; // view space, spot only
+        float cosOuterAngle;
+        float cosInnerAngle;
+    };
+
+    struct LightCullingParameters {
+        vec2 projectionScale; // P[0][0], P[1][1]
+        float near;
+        float far;
+        uint32 lightCount;
+    };
+
+    struct ShadingParameters {
+        mat4 inverseProjection;
+        vec3 sunDirection; // view space, toward the sun
+        float near; // depth range of the light cluster slices
+        float far;
+    };
+
+    // Meshlets of the objects selected by the culling pass of the same phase, see cluster_culling.comp
+    struct ClusterCullingParameters {
+        FrustumPlanes frustumPlanes;
+        VkDeviceAddress meshlets;
+        uint32 latePhase;
+    };
+
+    // Both dispatches of material_binning.comp, the bin offsets of every draw of the phase then the scatter of the staged objects
+    struct MaterialBinningParameters {
+        uint32 latePhase;
+        uint32 meshSlotCount;
+        uint32 scatter;
+    };
+
+    struct CullingCounters {
+        uint32 drawCounts[2]; // drawn instances, early and late
+        uint32 frustumCulledCount;
+        uint32 occlusionCulledCount;
+        uint32 meshletDrawCount;
+        uint32 clusterCulledCount;
+        uint32 lodDrawCounts[Geometry::MaxLODs]; // visible objects, both phases
+    };
+
+    // Header of the cluster dispatch buffer, written by the culling passes
+    struct ClusterDispatch {
+        VkDispatchIndirectCommand dispatches[2]; // early and late
+        uint32 objectCounts[2];
+    };
+
+    // Header of the material bin buffer, followed by the bins of every per-mesh draw then the staged objects of both phases
+    struct MaterialBinHeader {
+        uint32 stagedCounts[2]; // early and late
+        VkDispatchIndirectCommand scatterDispatches[2];
+    };
+
+    // Per phase and index width, in both the meshlet draw buffer and the culling shaders
+    static constexpr uint32 MaxMeshletDraws = 262'144;
+
+    // The draws are split in lists per phase and index width, early 16 bit indices first
+    static constexpr uint32 DrawListCount = 4;
+
+    // The meshlet draw buffer starts with the draw count of each list
+    static constexpr VkDeviceSize MeshletDrawsOffset = DrawListCount * sizeof(uint32);
+
+    // Bins of the instances of every per-mesh draw, keyed by the albedo texture, must match culling.inc.glsl
+    static constexpr uint32 MaterialBinCount = 32;
+
+    static constexpr uint32 MaxDepthPyramidLevels = 16;
+
+    // Froxel grid of the clustered shading, must match lights.inc.glsl
+    static constexpr uint32 LightClusterCountX = 16;
+    static constexpr uint32 LightClusterCountY = 9;
+    static constexpr uint32 LightClusterCountZ = 24; // exponential depth slices
+    static constexpr uint32 LightClusterCount = LightClusterCountX * LightClusterCountY * LightClusterCountZ;
+    static constexpr uint32 MaxLightsPerCluster = 256;
+    static constexpr uint32 MaxLights = 16'384; // per frame, the extra lights are dropped
+
+    // Everything the passes need, resolved before the parallel recording so that it doesn't touch any shared mutable state
+    struct FrameContext {
+        uint32 frameInFlightId;
+        uint32 swapchainImageId;
         uint32 objectCount;
+        uint32 meshSlotCount;
+        uint32 lightCount;
+        VkDeviceAddress vertexBufferAddress;
+        std::array<VkBuffer, 2> indexBuffers; // per Geometry::IndexType, no uint32 one if no geometry uses it
+        std::array<VkDeviceAddress, 2> indexBufferAddresses;
+        VkDeviceAddress meshletBufferAddress;
+        mat4 projectionMatrix;
+        mat4 viewMatrix;
+        float nearPlane;
+        float farPlane;
+        std::array<VkDescriptorSet, 5> cullingDescriptorSets; // the depth pyramid set is only used by the late phase
+        std::array<VkDescriptorSet, 2> gbufferDescriptorSets; // bindless table and draw records
+        VkDescriptorSet shadingDescriptorSet;
+        VkDescriptorSet lightDescriptorSet; // light culling and shading
+        std::array<VkDescriptorSet, 5> visibilityResolveDescriptorSets; // visibility buffer mode only
+        std::array<VkDescriptorSet, MaxDepthPyramidLevels> depthPyramidDescriptorSets;
+        bool occlusionCulling;
+        bool objectList; // objectCount entries of the BVH candidates in the object list of the frame
+        bool materialBinning;
+        float lodErrorScale;
+        const RenderSnapshot::UI* ui; // valid until render() returns
     };
 
+    // Logical resources of the frame graph, the physical ones are bound per frame in flight
+    struct FrameGraphResources {
+        RGTexture normalRT;
+        RGTexture albedoRT;
+        RGTexture depthRT;
+        RGTexture visibilityRT; // visibility buffer mode only
+        RGTexture finalRT;
+        RGTexture depthPyramid;
+        RGTexture swapchain;
+        RGBuffer cullingCounters;
+        RGBuffer visibility;
+        RGBuffer drawIndirect;
+        RGBuffer meshletDraws;
+        RGBuffer clusterDispatch;
+        RGBuffer materialBins;
+        RGBuffer drawRecords;
+        RGBuffer instanceIndices;
+        RGBuffer lightClusters;
+    };
+
+    static constexpr bool EnableDebugDraw = true;
+
+    // Octahedron normal projection
+    static constexpr VkFormat NormalRTFormat = VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+    // Fairly low precision acceptable for cartoonish rendering
+    static constexpr VkFormat AlbedoRTFormat = VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+    static constexpr VkFormat DepthRTFormat = VK_FORMAT_D32_SFLOAT;
+    // Instance and triangle of every pixel, see visibility.frag
+    static constexpr VkFormat VisibilityRTFormat = VK_FORMAT_R32_UINT;
+    static constexpr VkFormat FinalRTFormat = VK_FORMAT_R16G16B16A16_SFLOAT; // Alpha?
+    static constexpr VkFormat DepthPyramidFormat = VK_FORMAT_R32_SFLOAT;
+
 private:
     VkInstance createVkInstance(std::vector<const char*>&& requiredWindowExtensions) const;
 
@@ -116,6 +325,11 @@ private:
 
     VkDevice createLogicalDevice(const VkPhysicalDevice gpu, const PhysicalDeviceQueueFamilyID queues) const;
 
+    [[nodiscard]] static bool supportsDeviceExtension(const VkPhysicalDevice gpu, const char* extensionName);
+
+    // Current time in the domain of the GPU timestamps, 0 without VK_EXT_calibrated_timestamps
+    [[nodiscard]] uint64 getDeviceTimestamp() const;
+
     std::pair<VkSwapchainKHR, VkFormat> createSwapchain(const VkDevice device, const VkPhysicalDevice gpu, const VkSurfaceKHR surface,
         const PhysicalDeviceQueueFamilyID queues, const VkSwapchainKHR previousSwapchain = nullptr) const;
 
@@ -126,26 +340,94 @@ private:
 
     VkSemaphore createSemaphore(const VkDevice device) const;
 
-    VkFence createFence(const VkDevice device, const bool signaled) const;
-
     void beginCommandBuffer(
         const VkCommandBuffer commandBuffer, const VkCommandBufferUsageFlags flags, const bool resetCommandBuffer = true) const;
 
+    // Binary semaphores, see VulkanTimeline for the timeline ones
     VkSemaphoreSubmitInfo makeSemaphoreSubmitInfo(const VkSemaphore semaphore, const VkPipelineStageFlags2 stageMask) const;
 
-    void submitCommandBuffer(const VkQueue queue, const VkSemaphoreSubmitInfo& waitSemaphore, const VkSemaphoreSubmitInfo& signalSemaphore,
-        const VkCommandBuffer commandBuffer, const VkFence fence) const;
+    // Command buffers are executed in the order of the array
+    void submitCommandBuffers(const VkQueue queue, const ArrayWrapper<VkSemaphoreSubmitInfo> waitSemaphores,
+        const ArrayWrapper<VkSemaphoreSubmitInfo> signalSemaphores, const ArrayWrapper<VkCommandBuffer> commandBuffers) const;
+
+    // Graphics side of the ownership transfers of the flushed uploads, to be recorded before anything reads them
+    void recordUploadAcquireBarriers(const VkCommandBuffer commandBuffer) const;
+
+    // Every graphics submission waits on the last flushed upload batch
+    [[nodiscard]] VkSemaphoreSubmitInfo makeUploadWaitSemaphoreInfo() const;
+
+    // Graphics side of the texture uploads retired by retiredUploadValue, their textures are bound from the next frame on
+    void recordTextureUploadCompletions(const VkCommandBuffer commandBuffer, const uint64 retiredUploadValue);
 
     VmaAllocator createVMAAllocator(const VkInstance instance, const VkPhysicalDevice gpu, const VkDevice device) const;
 
     VkSampler createSampler(const VkDevice device, const bool linear) const;
 
-    FrustumPlanes getFrustumPlanes(const mat4& projectionMatrix) const;
+    // Released once the graphics work that may still use it retired, the next submission included, see collectReleased
+    void releaseTexture(const Handle<Texture> handle);
+
+    void releaseBuffer(const Handle<Buffer> handle);
+
+    // Releases the textures and buffers whose graphics timeline value retired, their sampled image slot goes back to the fallback
+    void collectReleased();
 
     void handleResize();
 
+    // Declares the frame passes, compiles the graph and allocates the transient textures, depends on the swapchain extent
+    // The passes depend on RenderSettings::visibilityBuffer
+    void buildRenderGraph();
+
+    void releaseRenderGraph();
+
     void updateGBufferDescriptorSets();
 
+    void updateDepthPyramidDescriptorSets();
+
+    // The pipelines every frame depends on are compiled and published, the debug ones are checked by the debug drawer
+    [[nodiscard]] bool areFramePipelinesReady();
+
+    // Once, when the pipelines compiled at startup are published
+    void logStartupTime();
+
+    // Registers the kernel to the workgroup tuner and compiles its selected variant, returns the kernel ID. The candidates the device
+    // doesn't support are dropped, the first one is the default
+    [[nodiscard]] uint32 createTunedComputeShader(
+        const std::string& name, const ArrayWrapper<vec3u> candidates, const VulkanComputeShader::CreateInfo& info);
+
+    void compileTunedComputeShader(const uint32 kernelId, const uint32 candidateId);
+
+    // Variant of the selected workgroup size
+    [[nodiscard]] Handle<ComputeShader> getTunedComputeShader(const uint32 kernelId) const;
+
+    // Starts or stops the tuning with RenderSettings::workgroupTuning, all the variants are compiled when it starts
+    void updateWorkgroupTuning();
+
+    // Culling counters and pass timings of the last frame that used this frame in flight, that frame must be retired
+    void readFrameStats(const uint32 frameInFlightId);
+
+    // Gathers the lights of the snapshot into the light buffer of the frame, returns the light count
+    uint32 updateLights(const std::vector<RenderSnapshot::Light>& snapshotLights, const uint32 frameInFlightId, const mat4& viewMatrix);
+
+    void recordCullingPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext, const bool latePhase) const;
+
+    void recordClusterCullingPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext, const bool latePhase) const;
+
+    void recordMaterialBinningPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext, const bool latePhase) const;
+
+    void recordGBufferPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext, const bool latePhase) const;
+
+    void recordDepthPyramidPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const;
+
+    void recordVisibilityResolvePass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const;
+
+    void recordLightCullingPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const;
+
+    void recordShadingPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const;
+
+    void recordBlitPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const;
+
+    void recordDebugUIPass(VkCommandBuffer commandBuffer, const FrameContext& frameContext) const;
+
 private:
     VkInstance _instance;
 #if NH3D_DEBUG
@@ -158,62 +440,157 @@ private:
 
     VkDevice _device;
     VmaAllocator _allocator;
+    Uptr<VulkanPipelineCache> _pipelineCache; // used by every pipeline creation
+    Uptr<VulkanPipelineCompiler> _pipelineCompiler; // the pipelines are published at the start of render
 
     VkQueue _graphicsQueue;
     VkQueue _presentQueue;
+    VkQueue _transferQueue; // the graphics queue without a dedicated transfer family
 
     mutable VkSwapchainKHR _swapchain = {}; // Needs to be recreated on resize
     mutable std::vector<Handle<Texture>> _swapchainTextures;
 
-    VkCommandPool _commandPool;
     VkCommandPool _immediateCommandPool;
     VkCommandBuffer _immediateCommandBuffer;
-    VkCommandPool _uploadCommandPool;
-    VkCommandBuffer _uploadCommandBuffer;
+    VkCommandPool _uploadCommandPool; // transfer family
+    std::array<VkCommandBuffer, UploadBatchCount> _uploadCommandBuffers;
     mutable bool _uploadsToBeFlushed = false;
-    VkFence _immediateAndUploadFence; // Used for immediate command buffer submission & beginning of frame uploads
-
-    FrameResource<VkCommandBuffer> _commandBuffers;
-    FrameResource<VkFence> _frameFences;
-    FrameResource<VkSemaphore> _presentSemaphores;
+    // Upload batch N signals N + 1, the graphics submissions wait on it GPU side
+    Uptr<VulkanTimeline> _uploadTimeline;
+    // Ownership transfers of the uploaded ranges, only with a dedicated transfer queue. The release barriers are recorded at the end
+    // of the batch, the acquire ones by the next graphics submission
+    mutable std::vector<VkBufferMemoryBarrier2> _uploadReleaseBarriers;
+    mutable std::vector<VkBufferMemoryBarrier2> _uploadAcquireBarriers;
+    struct PendingTextureUpload {
+        VulkanTexture::Upload upload;
+        uint64 uploadValue;
+    };
+    mutable std::vector<PendingTextureUpload> _pendingTextureUploads; // in upload order
+    std::vector<Handle<Texture>> _pendingTextureBindings; // bound to the fallback texture until their upload is completed
+    Handle<Texture> _fallbackTexture = InvalidHandle<Texture>; // grey, not in the bindless table
+    // The frames in flight may still use the destroyed resources, their handles aren't reused before they're released
+    struct ReleasedTexture {
+        Handle<Texture> handle;
+        uint64 retireValue; // graphics timeline
+    };
+    struct ReleasedBuffer {
+        Handle<Buffer> handle;
+        uint64 retireValue; // graphics timeline
+    };
+    std::vector<ReleasedTexture> _releasedTextures; // in timeline order
+    std::vector<ReleasedBuffer> _releasedBuffers; // in timeline order
+
+    // One pool per recording thread per frame in flight, command buffers are indexed by [threadId * RenderGraph::MaxPasses + pass]
+    Uptr<ThreadPool> _threadPool;
+    FrameResource<std::vector<VkCommandPool>> _recordingCommandPools { getFramesInFlight() };
+    FrameResource<std::vector<VkCommandBuffer>> _passCommandBuffers { getFramesInFlight() };
+    // First command buffer of the frame when there are uploads to acquire
+    FrameResource<VkCommandBuffer> _uploadAcquireCommandBuffers { getFramesInFlight() };
+    FrameResource<VkQueryPool> _timestampQueryPools { getFramesInFlight() }; // two timestamps per pass
+    FrameResource<uint32> _timestampedPassCounts { getFramesInFlight() };
+    // Vertex throughput of the early and late GBuffer passes
+    FrameResource<VkQueryPool> _pipelineStatisticsQueryPools { getFramesInFlight() };
+    float _timestampPeriod = 0.0f; // in nanoseconds, 0 if the graphics queue doesn't support timestamps
+    bool _visibilityBufferSupported = false; // geometryShader and shaderStorageImageExtendedFormats, forces the GBuffer path otherwise
+    PFN_vkGetCalibratedTimestampsEXT _getCalibratedTimestamps = nullptr; // optional, only used for the input latency
+    uint64 _inputTimestamp = 0; // device time when the input of the next frame is sampled, see waitForNextFrame
+    FrameResource<uint64> _inputTimestamps { getFramesInFlight() };
+    FrameResource<uint32> _submittedFrameIds { getFramesInFlight() };
+    uint32 _lastTimedFrameId = 0;
+    uint64 _lastFrameEndTimestamp = 0; // end of the GPU work of _lastTimedFrameId, for the GPU idle time
+    float _cpuWaitTime = 0.0f; // spent in waitForNextFrame
+
+    // Render thread copies, the main thread ones are exchanged with the snapshots
+    RenderSettings _frameSettings;
+    RenderStats _frameStats;
+
+    // Taken by the resource creation and destruction, which may happen on the main thread at any time, and by render() outside of
+    // the frame in flight wait, the swapchain acquire and the present. Recursive since the frame itself creates resources (upload
+    // buffers)
+    std::recursive_mutex _resourceMutex;
+    // The queues may be shared (transfer and graphics, present and graphics), their submissions are serialized. Taken last
+    mutable std::mutex _queueMutex;
+
+    // Only the swapchain acquire and present use binary semaphores, everything else is tracked by the timelines
+    Uptr<VulkanTimeline> _graphicsTimeline;
+    FrameResource<uint64> _frameTimelineValues { getFramesInFlight() }; // graphics timeline value of the last frame of each frame in flight
+    FrameResource<VkSemaphore> _presentSemaphores { getFramesInFlight() };
     std::vector<VkSemaphore> _renderSemaphores;
 
     VkSampler _linearSampler;
+    // Every texture descriptor, indexed by the texture handle
+    Uptr<VulkanBindlessTable> _bindlessTable;
     mutable ResourceManager<VulkanTexture> _textureManager;
     mutable ResourceManager<VulkanBuffer> _bufferManager;
     mutable ResourceManager<VulkanShader> _shaderManager;
     mutable ResourceManager<VulkanComputeShader> _computeShaderManager;
     mutable ResourceManager<VulkanBindGroup> _bindGroupManager;
-    Handle<ComputeShader> _frustumCullingCS = InvalidHandle<ComputeShader>;
-    // Vertices/Indices/Material/AABB + visible flags
-    Handle<BindGroup> _cullingRenderDataBindGroup = InvalidHandle<BindGroup>;
-    FrameResource<Handle<Buffer>> _cullingRenderDataBuffers = {};
-    FrameResource<Handle<Buffer>> _cullingRenderDataStagingBuffers = {};
-    FrameResource<Handle<Buffer>> _cullingVisibleFlagBuffers = {};
-    FrameResource<Handle<Buffer>> _cullingVisibleFlagStagingBuffers = {};
-    FrameResource<Handle<Buffer>> _cullingAABBsBuffers = {};
-    FrameResource<Handle<Buffer>> _cullingAABBsStagingBuffers = {};
-    Handle<BindGroup> _cullingFrameDataBindGroup = InvalidHandle<BindGroup>;
-    FrameResource<Handle<Buffer>> _cullingTransformBuffers = {};
-    FrameResource<Handle<Buffer>> _cullingDrawCounterBuffers = {}; // vkCmdFillBuffer
-
-    struct GBuffer {
-        Handle<Texture> normalRT;
-        Handle<Texture> albedoRT;
-        Handle<Texture> depthRT;
+    Uptr<VulkanStagingRing> _stagingRing;
+    // Vertices and indices of every mesh
+    Uptr<VulkanGeometryArena> _geometryArena;
+    // Persistent Material/AABB/Transform per object, updated incrementally
+    Uptr<VulkanGPUScene> _gpuScene;
+
+    // Workgroup sizes of the compute passes that aren't tuned, specialization constants of their shaders
+    static constexpr uint32 LinearWorkgroupSize = 64;
+    static constexpr uint32 TileWorkgroupSize = 8;
+
+    // Compute pipeline with a variant per candidate workgroup size of its kernel, only the selected one is compiled outside of tuning
+    struct TunedComputeShader {
+        VulkanComputeShader::AsyncCreateInfo createInfo; // the workgroup size is set per variant
+        std::vector<Handle<ComputeShader>> variants; // InvalidHandle until compiled
     };
-    FrameResource<GBuffer> _gbufferRTs;
+    Uptr<WorkgroupTuner> _workgroupTuner; // winners persisted per device
+    std::vector<TunedComputeShader> _tunedComputeShaders; // indexed by kernel ID
+    bool _workgroupTuning = false; // setting of the last frame
+
+    std::chrono::high_resolution_clock::time_point _startupStartTime;
+    bool _startupTimeLogged = false;
+
+    uint32 _frustumCullingKernel = 0;
+    uint32 _lateCullingKernel = 0;
+    Handle<ComputeShader> _clusterCullingCS = InvalidHandle<ComputeShader>;
+    Handle<ComputeShader> _materialBinningCS = InvalidHandle<ComputeShader>;
+    Handle<BindGroup> _cullingFrameDataBindGroup = InvalidHandle<BindGroup>;
+    FrameResource<Handle<Buffer>> _cullingCounterBuffers { getFramesInFlight() }; // vkCmdFillBuffer, read back for stats
+    Handle<Buffer> _visibilityBuffer = InvalidHandle<Buffer>; // per object, persistent across frames
+    FrameResource<Handle<Buffer>> _objectListBuffers { getFramesInFlight() }; // CPU written, slots that survived the BVH culling
+    std::vector<uint32> _bvhCandidates; // reused every frame
+
+    Handle<ComputeShader> _depthPyramidCS = InvalidHandle<ComputeShader>;
+    std::array<Handle<BindGroup>, MaxDepthPyramidLevels> _depthPyramidLevelBindGroups = {}; // level i - 1 to level i
+    FrameResource<std::vector<VkImageView>> _depthPyramidLevelViews { getFramesInFlight() };
+    Handle<BindGroup> _depthPyramidBindGroup = InvalidHandle<BindGroup>; // whole pyramid, read by the late culling
+
+    Uptr<RenderGraph> _renderGraph;
+    FrameGraphResources _graphResources;
+    FrameResource<std::vector<VmaAllocation>> _transientAllocations { getFramesInFlight() }; // one per aliasing group
+    FrameResource<std::vector<Handle<Texture>>> _transientTextures { getFramesInFlight() };
+    bool _visibilityBufferGraph = false; // mode the render graph was built for
+    FrameContext _frameContext; // written before recording, read by the passes
 
     Handle<Shader> _gbufferShader = InvalidHandle<Shader>;
+    Handle<Shader> _visibilityShader = InvalidHandle<Shader>; // same draws as the GBuffer shader, writes the visibility RT
     Handle<BindGroup> _drawIndirectCommandBindGroup = InvalidHandle<BindGroup>;
-    FrameResource<Handle<Buffer>> _drawIndirectBuffers = {}; // GPU written
+    FrameResource<Handle<Buffer>> _drawIndirectBuffers { getFramesInFlight() }; // GPU written
+    FrameResource<Handle<Buffer>> _meshletDrawBuffers { getFramesInFlight() }; // GPU written, counts then early and late draws
+    FrameResource<Handle<Buffer>> _clusterDispatchBuffers { getFramesInFlight() }; // GPU written, see ClusterDispatch
+    FrameResource<Handle<Buffer>> _materialBinBuffers { getFramesInFlight() }; // GPU written, see MaterialBinHeader
     Handle<BindGroup> _drawRecordBindGroup = InvalidHandle<BindGroup>;
-    FrameResource<Handle<Buffer>> _drawRecordBuffers = {}; // GPU written
-    Handle<BindGroup> _albedoTextureBindGroup = InvalidHandle<BindGroup>;
+    FrameResource<Handle<Buffer>> _drawRecordBuffers { getFramesInFlight() }; // GPU written
+    FrameResource<Handle<Buffer>> _instanceIndexBuffers { getFramesInFlight() }; // GPU written, object index of every drawn instance
+
+    Handle<ComputeShader> _visibilityResolveCS = InvalidHandle<ComputeShader>;
+    Handle<BindGroup> _visibilityResolveBindGroup = InvalidHandle<BindGroup>;
+
+    Handle<ComputeShader> _lightCullingCS = InvalidHandle<ComputeShader>;
+    Handle<BindGroup> _lightBindGroup = InvalidHandle<BindGroup>;
+    FrameResource<Handle<Buffer>> _lightBuffers { getFramesInFlight() }; // CPU written, see GPULight
+    // GPU written, light count then light indices of every cluster
+    FrameResource<Handle<Buffer>> _lightClusterBuffers { getFramesInFlight() };
 
-    Handle<ComputeShader> _deferredShadingCS = InvalidHandle<ComputeShader>;
+    uint32 _deferredShadingKernel = 0;
     Handle<BindGroup> _deferredShadingBindGroup = InvalidHandle<BindGroup>;
-    FrameResource<Handle<Texture>> _finalRTs = {};
 
     Uptr<VulkanDebugDrawer> _debugDrawer;
 
@@ -1,11 +1,14 @@
 #include "vulkan_shader.hpp"
+#include <chrono>
+#include <rendering/vulkan/vulkan_pipeline_cache.hpp>
 #include <rendering/vulkan/vulkan_rhi.hpp>
 
 namespace NH3D {
 
 [[nodiscard]] std::pair<VkPipeline, VkPipelineLayout> VulkanShader::create(const IRHI& rhi, const ShaderInfo& shaderInfo)
 {
-    const VkDevice device = static_cast<const VulkanRHI&>(rhi).getVkDevice();
+    const VulkanRHI& vrhi = static_cast<const VulkanRHI&>(rhi);
+    const VkDevice device = vrhi.getVkDevice();
 
     const VkPipelineLayout pipelineLayout = createPipelineLayout(device, shaderInfo.descriptorSetsLayouts, shaderInfo.pushConstantRanges);
 
@@ -145,10 +148,14 @@ namespace NH3D {
         .layout = pipelineLayout,
     };
 
+    const VulkanPipelineCache& pipelineCache = vrhi.getPipelineCache();
+    const auto compilationStartTime = std::chrono::high_resolution_clock::now();
     VkPipeline pipeline;
-    if (vkCreateGraphicsPipelines(device, nullptr, 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(device, pipelineCache.get(), 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS) {
         NH3D_ABORT_VK("Failed to create graphics pipeline");
     }
+    const std::chrono::duration<float, std::milli> compilationTime = std::chrono::high_resolution_clock::now() - compilationStartTime;
+    pipelineCache.recordCompilation(compilationTime.count());
 
     vkDestroyShaderModule(device, vertexShader, nullptr);
     vkDestroyShaderModule(device, fragmentShader, nullptr);
@@ -156,6 +163,43 @@ namespace NH3D {
     return { pipeline, pipelineLayout };
 }
 
+VulkanShader::AsyncCreateInfo::AsyncCreateInfo(const ShaderInfo& shaderInfo)
+    : vertexShaderPath { shaderInfo.vertexShaderPath }
+    , fragmentShaderPath { shaderInfo.fragmentShaderPath }
+    , bindingDescriptions { shaderInfo.vertexInputInfo.bindingDescriptions.data,
+        shaderInfo.vertexInputInfo.bindingDescriptions.data + shaderInfo.vertexInputInfo.bindingDescriptions.size }
+    , attributeDescriptions { shaderInfo.vertexInputInfo.attributeDescriptions.data,
+        shaderInfo.vertexInputInfo.attributeDescriptions.data + shaderInfo.vertexInputInfo.attributeDescriptions.size }
+    , cullMode { shaderInfo.cullMode }
+    , primitiveTopology { shaderInfo.primitiveTopology }
+    , colorAttachmentFormats { shaderInfo.colorAttachmentFormats.data,
+        shaderInfo.colorAttachmentFormats.data + shaderInfo.colorAttachmentFormats.size }
+    , depthAttachmentFormat { shaderInfo.depthAttachmentFormat }
+    , stencilAttachmentFormat { shaderInfo.stencilAttachmentFormat }
+    , descriptorSetsLayouts { shaderInfo.descriptorSetsLayouts.data,
+        shaderInfo.descriptorSetsLayouts.data + shaderInfo.descriptorSetsLayouts.size }
+    , pushConstantRanges { shaderInfo.pushConstantRanges.data, shaderInfo.pushConstantRanges.data + shaderInfo.pushConstantRanges.size }
+    , enableDepthWrite { shaderInfo.enableDepthWrite }
+{
+}
+
+[[nodiscard]] VulkanShader::ShaderInfo VulkanShader::AsyncCreateInfo::get() const
+{
+    return {
+        .vertexShaderPath = vertexShaderPath,
+        .fragmentShaderPath = fragmentShaderPath,
+        .vertexInputInfo = { .bindingDescriptions = bindingDescriptions, .attributeDescriptions = attributeDescriptions },
+        .cullMode = cullMode,
+        .primitiveTopology = primitiveTopology,
+        .colorAttachmentFormats = colorAttachmentFormats,
+        .depthAttachmentFormat = depthAttachmentFormat,
+        .stencilAttachmentFormat = stencilAttachmentFormat,
+        .descriptorSetsLayouts = descriptorSetsLayouts,
+        .pushConstantRanges = pushConstantRanges,
+        .enableDepthWrite = enableDepthWrite,
+    };
+}
+
 void VulkanShader::release(const IRHI& rhi, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout)
 {
     VulkanPipeline::release(rhi, pipeline, pipelineLayout);
@@ -195,8 +239,32 @@ void VulkanShader::multiDrawIndirect(VkCommandBuffer commandBuffer, const VkPipe
 
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-    vkCmdDrawIndirectCount(
-        commandBuffer, params.drawIndirectBuffer, 0, params.drawIndirectCountBuffer, 0, params.maxDrawCount, sizeof(VkDrawIndirectCommand));
+    VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+    VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+    for (uint32 i = 0; i < params.batches.size; ++i) {
+        const IndirectDrawBatch& batch = params.batches[i];
+        if (batch.indexBuffer != VK_NULL_HANDLE && (batch.indexBuffer != boundIndexBuffer || batch.indexType != boundIndexType)) {
+            vkCmdBindIndexBuffer(commandBuffer, batch.indexBuffer, 0, batch.indexType);
+            boundIndexBuffer = batch.indexBuffer;
+            boundIndexType = batch.indexType;
+        }
+
+        if (batch.indexBuffer != VK_NULL_HANDLE) {
+            if (batch.drawIndirectCountBuffer != VK_NULL_HANDLE) {
+                vkCmdDrawIndexedIndirectCount(commandBuffer, batch.drawIndirectBuffer, batch.drawIndirectOffset,
+                    batch.drawIndirectCountBuffer, batch.drawIndirectCountOffset, batch.maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+            } else {
+                vkCmdDrawIndexedIndirect(commandBuffer, batch.drawIndirectBuffer, batch.drawIndirectOffset, batch.maxDrawCount,
+                    sizeof(VkDrawIndexedIndirectCommand));
+            }
+        } else if (batch.drawIndirectCountBuffer != VK_NULL_HANDLE) {
+            vkCmdDrawIndirectCount(commandBuffer, batch.drawIndirectBuffer, batch.drawIndirectOffset, batch.drawIndirectCountBuffer,
+                batch.drawIndirectCountOffset, batch.maxDrawCount, sizeof(VkDrawIndirectCommand));
+        } else {
+            vkCmdDrawIndirect(
+                commandBuffer, batch.drawIndirectBuffer, batch.drawIndirectOffset, batch.maxDrawCount, sizeof(VkDrawIndirectCommand));
+        }
+    }
 
     vkCmdEndRendering(commandBuffer);
 }
@@ -6,6 +6,7 @@
 #include <misc/utils.hpp>
 #include <rendering/core/shader.hpp>
 #include <rendering/vulkan/vulkan_pipeline.hpp>
+#include <vector>
 
 namespace NH3D {
 
@@ -46,6 +47,26 @@ struct VulkanShader : public VulkanPipeline {
     };
     using CreateInfo = ShaderInfo;
 
+    // Owning copy of a ShaderInfo, for the creations that outlive the data of the caller, see VulkanPipelineCompiler
+    struct AsyncCreateInfo {
+        AsyncCreateInfo(const ShaderInfo& shaderInfo);
+
+        [[nodiscard]] ShaderInfo get() const;
+
+        std::filesystem::path vertexShaderPath;
+        std::filesystem::path fragmentShaderPath;
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+        VkCullModeFlags cullMode;
+        VkPrimitiveTopology primitiveTopology;
+        std::vector<ColorAttachmentInfo> colorAttachmentFormats;
+        VkFormat depthAttachmentFormat;
+        VkFormat stencilAttachmentFormat;
+        std::vector<VkDescriptorSetLayout> descriptorSetsLayouts;
+        std::vector<VkPushConstantRange> pushConstantRanges;
+        bool enableDepthWrite;
+    };
+
     /// "Constructor": used generically by the ResourceManager, must be API agnostic
     [[nodiscard]] static std::pair<VkPipeline, VkPipelineLayout> create(const IRHI& rhi, const ShaderInfo& shaderInfo);
 
@@ -61,10 +82,19 @@ struct VulkanShader : public VulkanPipeline {
         const VkRenderingAttachmentInfo stencilAttachment;
     };
 
-    struct MultiDrawParameters {
+    struct IndirectDrawBatch {
         const VkBuffer drawIndirectBuffer;
-        const VkBuffer drawIndirectCountBuffer;
+        const VkBuffer drawIndirectCountBuffer; // VK_NULL_HANDLE to always issue maxDrawCount draws
         const uint32 maxDrawCount;
+        const VkDeviceSize drawIndirectOffset = 0; // in bytes
+        const VkDeviceSize drawIndirectCountOffset = 0; // in bytes
+        const VkBuffer indexBuffer = VK_NULL_HANDLE; // the commands are VkDrawIndexedIndirectCommand if set
+        const VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+    };
+
+    // Every batch is drawn in the same rendering with the same pipeline, the index buffer is only rebound when it changes
+    struct MultiDrawParameters {
+        const ArrayWrapper<IndirectDrawBatch> batches;
         const DrawParameters& drawParams;
     };
 
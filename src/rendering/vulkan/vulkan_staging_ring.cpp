@@ -0,0 +1,48 @@
+#include "vulkan_staging_ring.hpp"
+#include <cstring>
+#include <rendering/vulkan/vulkan_buffer.hpp>
+#include <rendering/vulkan/vulkan_rhi.hpp>
+
+namespace NH3D {
+
+VulkanStagingRing::VulkanStagingRing(VulkanRHI* const rhi)
+    : _rhi { rhi }
+{
+    auto& bufferManager = _rhi->getBufferManager();
+    _bufferHandle = bufferManager.create(*_rhi,
+        {
+            .size = Capacity,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY,
+        });
+    _buffer = bufferManager.get<GPUBuffer>(_bufferHandle).buffer;
+    _mappedAddress = static_cast<byte*>(VulkanBuffer::getMappedAddress(*_rhi, bufferManager.get<BufferAllocationInfo>(_bufferHandle)));
+}
+
+VulkanStagingRing::~VulkanStagingRing() { _rhi->getBufferManager().release(*_rhi, _bufferHandle); }
+
+[[nodiscard]] uint64 VulkanStagingRing::stage(const ArrayWrapper<byte> data)
+{
+    NH3D_ASSERT(data.size <= MaxChunkSize, "Staged uploads must be split in chunks");
+
+    const VulkanTimeline& uploadTimeline = _rhi->getUploadTimeline();
+    _allocator.reclaim(uploadTimeline.getRetiredValue());
+    uint64 offset = _allocator.allocate(data.size, Alignment, uploadTimeline.getPendingValue());
+    while (offset == RingAllocator::InvalidOffset) {
+        // Genuinely exhausted, the oldest regions may even belong to the batch being recorded
+        const uint64 oldestRetireValue = _allocator.getOldestRetireValue();
+        if (oldestRetireValue == uploadTimeline.getPendingValue()) {
+            _rhi->flushUploadCommands();
+        }
+        NH3D_DEBUGLOG("Staging ring exhausted, waiting for the upload batch " << oldestRetireValue);
+        uploadTimeline.wait(oldestRetireValue);
+
+        _allocator.reclaim(oldestRetireValue);
+        offset = _allocator.allocate(data.size, Alignment, uploadTimeline.getPendingValue());
+    }
+
+    std::memcpy(_mappedAddress + offset, data.data, data.size);
+    return offset;
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <rendering/core/buffer.hpp>
+#include <rendering/core/handle.hpp>
+#include <rendering/core/ring_allocator.hpp>
+#include <vulkan/vulkan_core.h>
+
+namespace NH3D {
+
+class VulkanRHI;
+
+// Staging memory of every upload, suballocated in upload order and reclaimed once the upload batch that reads a region retired
+// Uploads larger than MaxChunkSize have to be split by the caller, so that a single upload never needs the whole ring
+class VulkanStagingRing {
+    NH3D_NO_COPY_MOVE(VulkanStagingRing)
+public:
+    // 128 MB, see https://docs.vulkan.org/spec/latest/chapters/limits.html
+    static constexpr uint64 Capacity = 1 << 27;
+
+    static constexpr uint64 MaxChunkSize = Capacity / 4;
+
+    // Enough for the texel size of every format, the buffer to image copies need aligned offsets
+    static constexpr uint64 Alignment = 16;
+
+    VulkanStagingRing() = delete;
+
+    VulkanStagingRing(VulkanRHI* const rhi);
+
+    ~VulkanStagingRing();
+
+    // Copies data to the ring and returns its offset in getBuffer(), the region belongs to the upload batch being recorded
+    // Only blocks when the ring is full of regions whose batch is still in flight
+    [[nodiscard]] uint64 stage(const ArrayWrapper<byte> data);
+
+    [[nodiscard]] inline VkBuffer getBuffer() const { return _buffer; }
+
+private:
+    VulkanRHI* _rhi;
+    RingAllocator _allocator { Capacity };
+
+    Handle<Buffer> _bufferHandle;
+    VkBuffer _buffer;
+    byte* _mappedAddress;
+};
+
+}
@@ -2,6 +2,7 @@
 #include "rendering/core/rhi.hpp"
 #include <misc/utils.hpp>
 #include <rendering/vulkan/vulkan_rhi.hpp>
+#include <rendering/vulkan/vulkan_staging_ring.hpp>
 #include <vulkan/vulkan_core.h>
 
 namespace NH3D {
@@ -61,7 +62,7 @@ uint32 channelCount(const VkFormat format)
         .imageType = info.extent.depth == 1 ? VK_IMAGE_TYPE_2D : VK_IMAGE_TYPE_3D,
         .format = info.format,
         .extent = info.extent,
-        .mipLevels = info.generateMipMaps ? static_cast<uint32_t>(floor(log2(std::max(info.extent.width, info.extent.height))) + 1) : 1,
+        .mipLevels = info.generateMipMaps ? getMipLevelCount(info.extent) : info.mipLevels,
         .arrayLayers = 1, // TODO: use that for 3D textures?
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .tiling = VK_IMAGE_TILING_OPTIMAL,
@@ -77,8 +78,12 @@ uint32 channelCount(const VkFormat format)
     };
 
     VkImage image;
-    VmaAllocation allocation;
-    if (vmaCreateImage(vrhi.getAllocator(), &imageCreateInfo, &allocCreateInfo, &image, &allocation, nullptr) != VK_SUCCESS) {
+    VmaAllocation allocation = info.aliasingAllocation;
+    if (allocation != nullptr) {
+        if (vmaCreateAliasingImage(vrhi.getAllocator(), allocation, &imageCreateInfo, &image) != VK_SUCCESS) {
+            NH3D_ABORT_VK("VMA aliasing image creation failed");
+        }
+    } else if (vmaCreateImage(vrhi.getAllocator(), &imageCreateInfo, &allocCreateInfo, &image, &allocation, nullptr) != VK_SUCCESS) {
         NH3D_ABORT_VK("VMA image creation failed");
     }
 
@@ -101,86 +106,18 @@ uint32 channelCount(const VkFormat format)
     }
 
     // TODO: handle initial data/texture size mismatch for other formats? (see below)
+    uint64 uploadValue = 0;
     if (info.initialData.data != nullptr
         && info.initialData.size == info.extent.width * info.extent.height * info.extent.depth * channelCount(info.format)) {
-        // TODO: use the existing staging buffer but submit the copy right away if mip mapping is required
-        auto [stagingBuffer, stagingAllocation] = VulkanBuffer::create(rhi,
+        uploadValue = upload(vrhi,
             {
-                .size = info.initialData.size,
-                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                .memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY,
-                .initialData = {
-                    info.initialData.data,
-                    info.initialData.size,
-                },
-            });
-        // TODO: I'm writing bytes but what if the format is not 8-bit based? Might need to adjust that
-        vrhi.executeImmediateCommandBuffer([&](VkCommandBuffer commandBuffer) {
-            VulkanTexture::insertMemoryBarrier(commandBuffer, image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
-                VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                VK_IMAGE_LAYOUT_UNDEFINED, false, 0, 1);
-
-            const VkBufferImageCopy copyRegion {
-                .bufferOffset = 0,
-                .bufferRowLength = 0,
-                .bufferImageHeight = 0,
-                .imageSubresource = {
-                    .aspectMask = info.aspectFlags,
-                    .mipLevel = 0,
-                    .baseArrayLayer = 0,
-                    .layerCount = 1,
-                },
-                .imageOffset = { 0, 0, 0 },
-                .imageExtent = info.extent,
-            };
-            vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
-
-            if (info.generateMipMaps) {
-                for (uint32 i = 1; i < imageCreateInfo.mipLevels; ++i) {
-                    const VkImageBlit blit {
-                    .srcSubresource = { .aspectMask = info.aspectFlags, .mipLevel = i - 1, .baseArrayLayer = 0, .layerCount = 1, },
-                    .srcOffsets = { { 0, 0, 0 },
-                        {
-                            std::max(1, static_cast<int>(info.extent.width) >> (i - 1)),
-                            std::max(1, static_cast<int>(info.extent.height) >> (i - 1)),
-                            static_cast<int>(info.extent.depth), }, },
-                    .dstSubresource = { .aspectMask = info.aspectFlags, .mipLevel = i, .baseArrayLayer = 0, .layerCount = 1, },
-                    .dstOffsets = { { 0, 0, 0 },
-                        {
-                            std::max(1, static_cast<int>(info.extent.width) >> i),
-                            std::max(1, static_cast<int>(info.extent.height) >> i),
-                            static_cast<int>(info.extent.depth), }, },
-                };
-
-                    // Prepare previous mip level for reading & next mip level for writing
-                    VulkanTexture::insertMemoryBarrier(commandBuffer, image, VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false, i - 1, 1);
-                    VulkanTexture::insertMemoryBarrier(commandBuffer, image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
-                        VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        VK_IMAGE_LAYOUT_UNDEFINED, false, i, 1);
-
-                    vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        1, &blit, VK_FILTER_LINEAR);
-
-                    // Transition previous mip level to SHADER_READ_ONLY_OPTIMAL
-                    VulkanTexture::insertMemoryBarrier(commandBuffer, image, VK_ACCESS_2_TRANSFER_READ_BIT,
-                        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
-                        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false, i - 1, 1);
-                }
-                VulkanTexture::insertMemoryBarrier(commandBuffer, image, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                    VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false, imageCreateInfo.mipLevels - 1,
-                    1);
-            } else {
-                VulkanTexture::insertMemoryBarrier(commandBuffer, image, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                    VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
-                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false, 0, 1);
-            }
-        });
-
-        VulkanBuffer::release(rhi, stagingBuffer, stagingAllocation);
+                .image = image,
+                .extent = info.extent,
+                .aspectFlags = info.aspectFlags,
+                .mipLevels = imageCreateInfo.mipLevels,
+                .generateMipMaps = info.generateMipMaps,
+            },
+            info.initialData);
     }
 
     return {
@@ -192,6 +129,8 @@ uint32 channelCount(const VkFormat format)
             .format = info.format,
             .extent = info.extent,
             .allocation = allocation,
+            .aliased = info.aliasingAllocation != nullptr,
+            .uploadValue = uploadValue,
         },
     };
 }
@@ -233,6 +172,14 @@ void VulkanTexture::release(const IRHI& rhi, ImageView& imageViewData, TextureMe
         imageViewData.view = nullptr;
     }
 
+    if (metadata.aliased) {
+        // The memory is released by the owner of the allocation
+        vkDestroyImage(vrhi.getVkDevice(), imageViewData.image, nullptr);
+        imageViewData.image = nullptr;
+        metadata.allocation = nullptr;
+        return;
+    }
+
     if (metadata.allocation == nullptr) {
         // Either a swapchain image or weird ass bug
         imageViewData.image = nullptr;
@@ -254,7 +201,8 @@ bool VulkanTexture::valid(const ImageView& imageViewData, const TextureMetadata&
 
 void VulkanTexture::insertMemoryBarrier(VkCommandBuffer commandBuffer, const VkImage image, const VkAccessFlags2 srcAccessMask,
     const VkPipelineStageFlags2 srcStageMask, const VkAccessFlags2 dstAccessMask, const VkPipelineStageFlags2 dstStageMask,
-    const VkImageLayout newLayout, const VkImageLayout oldLayout, const bool isDepth, const uint32_t baseMipLevel, const uint32_t mipLevels)
+    const VkImageLayout newLayout, const VkImageLayout oldLayout, const bool isDepth, const uint32_t baseMipLevel, const uint32_t mipLevels,
+    const uint32 srcQueueFamilyIndex, const uint32 dstQueueFamilyIndex)
 {
     const VkImageMemoryBarrier2 barrier { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
         .srcStageMask = srcStageMask,
@@ -263,6 +211,8 @@ void VulkanTexture::insertMemoryBarrier(VkCommandBuffer commandBuffer, const VkI
         .dstAccessMask = dstAccessMask,
         .oldLayout = oldLayout,
         .newLayout = newLayout,
+        .srcQueueFamilyIndex = srcQueueFamilyIndex,
+        .dstQueueFamilyIndex = dstQueueFamilyIndex,
         .image = image,
         .subresourceRange = {
             .aspectMask = static_cast<VkImageAspectFlags>(isDepth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT),
@@ -280,6 +230,102 @@ void VulkanTexture::insertMemoryBarrier(VkCommandBuffer commandBuffer, const VkI
     vkCmdPipelineBarrier2(commandBuffer, &depInfo);
 }
 
+uint32 VulkanTexture::getMipLevelCount(const VkExtent3D extent)
+{
+    return static_cast<uint32>(floor(log2(std::max(extent.width, extent.height)))) + 1;
+}
+
+[[nodiscard]] uint64 VulkanTexture::upload(VulkanRHI& rhi, const Upload& textureUpload, const ArrayWrapper<byte> data)
+{
+    // TODO: I'm writing bytes but what if the format is not 8-bit based? Might need to adjust that
+    const VkExtent3D extent = textureUpload.extent;
+    const size_t rowSize = data.size / (extent.height * extent.depth);
+
+    // Large textures are staged a few rows at a time
+    VulkanStagingRing& stagingRing = rhi.getStagingRing();
+    const uint32 rowsPerChunk = std::max<uint32>(VulkanStagingRing::MaxChunkSize / rowSize, 1);
+    for (uint32 z = 0; z < extent.depth; ++z) {
+        for (uint32 y = 0; y < extent.height; y += rowsPerChunk) {
+            const uint32 rowCount = std::min(extent.height - y, rowsPerChunk);
+            const size_t dataOffset = (z * extent.height + y) * rowSize;
+            const uint64 stagingOffset = stagingRing.stage({ data.data + dataOffset, static_cast<uint32>(rowCount * rowSize) });
+
+            rhi.recordUploadCommands([&](VkCommandBuffer commandBuffer) {
+                if (z == 0 && y == 0) {
+                    VulkanTexture::insertMemoryBarrier(commandBuffer, textureUpload.image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
+                        VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        VK_IMAGE_LAYOUT_UNDEFINED, false, 0, 1);
+                }
+
+                const VkBufferImageCopy copyRegion {
+                    .bufferOffset = stagingOffset,
+                    .bufferRowLength = 0,
+                    .bufferImageHeight = 0,
+                    .imageSubresource = {
+                        .aspectMask = textureUpload.aspectFlags,
+                        .mipLevel = 0,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                    .imageOffset = { 0, static_cast<int32>(y), static_cast<int32>(z) },
+                    .imageExtent = { extent.width, rowCount, 1 },
+                };
+                vkCmdCopyBufferToImage(
+                    commandBuffer, stagingRing.getBuffer(), textureUpload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+            });
+        }
+    }
+
+    return rhi.finishTextureUpload(textureUpload);
+}
+
+void VulkanTexture::recordUploadCompletion(VkCommandBuffer commandBuffer, const Upload& upload)
+{
+    if (!upload.generateMipMaps) {
+        VulkanTexture::insertMemoryBarrier(commandBuffer, upload.image, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false, 0, 1);
+        return;
+    }
+
+    const VkExtent3D extent = upload.extent;
+    for (uint32 i = 1; i < upload.mipLevels; ++i) {
+        const VkImageBlit blit {
+            .srcSubresource = { .aspectMask = upload.aspectFlags, .mipLevel = i - 1, .baseArrayLayer = 0, .layerCount = 1, },
+            .srcOffsets = { { 0, 0, 0 },
+                {
+                    std::max(1, static_cast<int>(extent.width) >> (i - 1)),
+                    std::max(1, static_cast<int>(extent.height) >> (i - 1)),
+                    static_cast<int>(extent.depth), }, },
+            .dstSubresource = { .aspectMask = upload.aspectFlags, .mipLevel = i, .baseArrayLayer = 0, .layerCount = 1, },
+            .dstOffsets = { { 0, 0, 0 },
+                {
+                    std::max(1, static_cast<int>(extent.width) >> i),
+                    std::max(1, static_cast<int>(extent.height) >> i),
+                    static_cast<int>(extent.depth), }, },
+        };
+
+        // Prepare previous mip level for reading & next mip level for writing
+        VulkanTexture::insertMemoryBarrier(commandBuffer, upload.image, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false, i - 1, 1);
+        VulkanTexture::insertMemoryBarrier(commandBuffer, upload.image, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_UNDEFINED, false, i, 1);
+
+        vkCmdBlitImage(commandBuffer, upload.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, upload.image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+        // Transition previous mip level to SHADER_READ_ONLY_OPTIMAL
+        VulkanTexture::insertMemoryBarrier(commandBuffer, upload.image, VK_ACCESS_2_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false, i - 1, 1);
+    }
+    VulkanTexture::insertMemoryBarrier(commandBuffer, upload.image, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false, upload.mipLevels - 1, 1);
+}
+
 void VulkanTexture::blit(
     VkCommandBuffer commandBuffer, const VkImage srcImage, const VkExtent3D srcExtent, VkImage dstImage, const VkExtent3D dstExtent)
 {
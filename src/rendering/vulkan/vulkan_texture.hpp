@@ -21,6 +21,8 @@ struct TextureMetadata {
     VkFormat format;
     VkExtent3D extent;
     VmaAllocation allocation = nullptr;
+    bool aliased = false; // The allocation is shared with other textures and owned by whoever created it
+    uint64 uploadValue = 0; // Upload batch that fills the texture, 0 without initial data
 };
 
 struct VulkanTexture {
@@ -38,9 +40,20 @@ struct VulkanTexture {
         const VkImageAspectFlags aspectFlags;
         const ArrayWrapper<byte> initialData;
         const bool generateMipMaps : 1;
+        const uint32 mipLevels = 1; // Ignored if generateMipMaps, the mips are then left for the user to fill
+        const VmaAllocation aliasingAllocation = nullptr; // If not null, the image is bound to this allocation instead of a new one
     };
     using CreateInfo = CreateInfo;
 
+    // The transfer queue only fills the first mip level, the rest is recorded on the graphics queue once the copy retired
+    struct Upload {
+        VkImage image;
+        VkExtent3D extent;
+        VkImageAspectFlags aspectFlags;
+        uint32 mipLevels;
+        bool generateMipMaps;
+    };
+
     /// "Constructors / Destructors": used generically by the ResourceManager, must be API agnostic
     [[nodiscard]] static std::pair<ImageView, TextureMetadata> create(IRHI& rhi, const CreateInfo& info);
 
@@ -51,10 +64,21 @@ struct VulkanTexture {
     static bool valid(const ImageView& imageViewData, const TextureMetadata& metadata);
 
     /// Helper functions
+    // The queue family indices are only set for ownership transfers
     static void insertMemoryBarrier(VkCommandBuffer commandBuffer, const VkImage image, const VkAccessFlags2 srcAccessMask,
         const VkPipelineStageFlags2 srcStageMask, const VkAccessFlags2 dstAccessMask, const VkPipelineStageFlags2 dstStageMask,
         const VkImageLayout newLayout, const VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED, const bool isDepth = false,
-        const uint32_t baseMipLevel = 0, const uint32_t mipLevels = VK_REMAINING_MIP_LEVELS);
+        const uint32_t baseMipLevel = 0, const uint32_t mipLevels = VK_REMAINING_MIP_LEVELS,
+        const uint32 srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, const uint32 dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+
+    [[nodiscard]] static uint32 getMipLevelCount(const VkExtent3D extent);
+
+    // Copies data to the first mip level through the staging buffer, returns the upload batch value
+    [[nodiscard]] static uint64 upload(VulkanRHI& rhi, const Upload& textureUpload, const ArrayWrapper<byte> data);
+
+    // Graphics queue side of the upload, the first mip level is in TRANSFER_DST_OPTIMAL and every level ends up in
+    // SHADER_READ_ONLY_OPTIMAL
+    static void recordUploadCompletion(VkCommandBuffer commandBuffer, const Upload& upload);
 
     static void blit(
         VkCommandBuffer commandBuffer, const VkImage srcImage, const VkExtent3D srcExtent, VkImage dstImage, const VkExtent3D dstExtent);
@@ -0,0 +1,82 @@
+#include "vulkan_timeline.hpp"
+#include <rendering/vulkan/vulkan_rhi.hpp>
+
+namespace NH3D {
+
+VulkanTimeline::VulkanTimeline(VulkanRHI* const rhi)
+    : _device { rhi->getVkDevice() }
+{
+    const VkSemaphoreTypeCreateInfo typeCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    const VkSemaphoreCreateInfo semCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &typeCreateInfo,
+    };
+
+    if (vkCreateSemaphore(_device, &semCreateInfo, nullptr, &_semaphore) != VK_SUCCESS) {
+        NH3D_ABORT_VK("Failed to create Vulkan timeline semaphore");
+    }
+}
+
+VulkanTimeline::~VulkanTimeline() { vkDestroySemaphore(_device, _semaphore, nullptr); }
+
+[[nodiscard]] VkSemaphoreSubmitInfo VulkanTimeline::signalNext(const VkPipelineStageFlags2 stageMask)
+{
+    const uint64 value = _submittedValue.fetch_add(1, std::memory_order_relaxed) + 1;
+    return {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+        .semaphore = _semaphore,
+        .value = value,
+        .stageMask = stageMask,
+        .deviceIndex = 0,
+    };
+}
+
+[[nodiscard]] VkSemaphoreSubmitInfo VulkanTimeline::makeWaitInfo(const uint64 value, const VkPipelineStageFlags2 stageMask) const
+{
+    NH3D_ASSERT(value <= getSubmittedValue(), "Waiting on a timeline value that was never submitted");
+    return {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+        .semaphore = _semaphore,
+        .value = value,
+        .stageMask = stageMask,
+        .deviceIndex = 0,
+    };
+}
+
+[[nodiscard]] uint64 VulkanTimeline::getRetiredValue() const
+{
+    uint64 value;
+    vkGetSemaphoreCounterValue(_device, _semaphore, &value);
+    _retiredValue.store(value, std::memory_order_relaxed);
+    return value;
+}
+
+[[nodiscard]] bool VulkanTimeline::isRetired(const uint64 value) const
+{
+    return value <= _retiredValue.load(std::memory_order_relaxed) || value <= getRetiredValue();
+}
+
+void VulkanTimeline::wait(const uint64 value) const
+{
+    if (isRetired(value)) {
+        return;
+    }
+
+    NH3D_ASSERT(value <= getSubmittedValue(), "Waiting on a timeline value that was never submitted");
+    const VkSemaphoreWaitInfo waitInfo {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &_semaphore,
+        .pValues = &value,
+    };
+    if (vkWaitSemaphores(_device, &waitInfo, NH3D_MAX_T(uint64)) != VK_SUCCESS) {
+        NH3D_ABORT_VK("GPU stall detected");
+    }
+    _retiredValue.store(value, std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <misc/types.hpp>
+#include <misc/utils.hpp>
+#include <vulkan/vulkan_core.h>
+
+namespace NH3D {
+
+class VulkanRHI;
+
+// Timeline semaphore counting the submissions of a queue, the Nth submission that signals it signals N
+// Whether some GPU work is done boils down to comparing its value with the last retired one, which is cached so that most queries
+// don't even reach the driver
+// The signals of a timeline must execute in increasing order, every queue that signals gets its own
+class VulkanTimeline {
+    NH3D_NO_COPY_MOVE(VulkanTimeline)
+public:
+    VulkanTimeline() = delete;
+
+    VulkanTimeline(VulkanRHI* const rhi);
+
+    ~VulkanTimeline();
+
+    // Value of the last submission
+    [[nodiscard]] inline uint64 getSubmittedValue() const { return _submittedValue.load(std::memory_order_relaxed); }
+
+    // Value that the next submission will signal
+    [[nodiscard]] inline uint64 getPendingValue() const { return getSubmittedValue() + 1; }
+
+    // To be passed to the next submission, counted as submitted from then on
+    [[nodiscard]] VkSemaphoreSubmitInfo signalNext(const VkPipelineStageFlags2 stageMask);
+
+    // Waiting on a value that was already retired is free
+    [[nodiscard]] VkSemaphoreSubmitInfo makeWaitInfo(const uint64 value, const VkPipelineStageFlags2 stageMask) const;
+
+    [[nodiscard]] uint64 getRetiredValue() const;
+
+    [[nodiscard]] bool isRetired(const uint64 value) const;
+
+    // Blocks until the submission of value is done, it must be submitted
+    void wait(const uint64 value) const;
+
+private:
+    VkDevice _device;
+    VkSemaphore _semaphore;
+
+    std::atomic<uint64> _submittedValue = 0;
+    mutable std::atomic<uint64> _retiredValue = 0; // may lag behind the semaphore
+};
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <misc/math.hpp>
+#include <misc/types.hpp>
+
+namespace NH3D {
+
+enum class LightType : uint32 {
+    Point,
+    Spot, // along the +Z axis of the entity
+};
+
+// Positioned by the TransformComponent of the entity, its scale is ignored
+// Gathered by the renderer every frame, so it can be written directly without marking the entity dirty
+struct LightComponent {
+    LightType type = LightType::Point;
+    vec3 color { 1.0f };
+    float intensity = 1.0f;
+    float range = 10.0f; // no contribution past it, bounds the clusters the light is binned in
+    float innerConeAngle = 0.0f; // spot only, half angles in radians, full intensity inside the inner cone
+    float outerConeAngle = 0.7853982f; // 45°
+};
+
+}
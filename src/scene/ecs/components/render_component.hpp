@@ -24,8 +24,6 @@ private:
 
     Material _material;
 
-    // TODO: static SparseSet ref to set dirty flag?
-
     // Handle<Shader> _shader;
 };
 
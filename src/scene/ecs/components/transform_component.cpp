@@ -35,6 +35,7 @@ void TransformComponent::setPosition(Scene& scene, const Entity self, const vec3
 {
     for (const Entity entity : scene.getSubtree(self)) {
         scene.get<TransformComponent>(entity)._position = position;
+        scene.markRenderDirty(entity, DIRTY_TRANSFORM_BIT);
     }
 }
 
@@ -42,6 +43,7 @@ void TransformComponent::setRotation(Scene& scene, const Entity self, const quat
 {
     for (const Entity entity : scene.getSubtree(self)) {
         scene.get<TransformComponent>(entity)._rotation = rotation;
+        scene.markRenderDirty(entity, DIRTY_TRANSFORM_BIT);
     }
 }
 
@@ -49,6 +51,7 @@ void TransformComponent::setScale(Scene& scene, const Entity self, const vec3& s
 {
     for (const Entity entity : scene.getSubtree(self)) {
         scene.get<TransformComponent>(entity)._scale = scale;
+        scene.markRenderDirty(entity, DIRTY_TRANSFORM_BIT);
     }
 }
 
@@ -56,6 +59,7 @@ void TransformComponent::translate(Scene& scene, const Entity self, const vec3&
 {
     for (const Entity entity : scene.getSubtree(self)) {
         scene.get<TransformComponent>(entity)._position += translation;
+        scene.markRenderDirty(entity, DIRTY_TRANSFORM_BIT);
     }
 }
 
@@ -63,6 +67,7 @@ void TransformComponent::rotate(Scene& scene, const Entity self, const quat& rot
 {
     for (const Entity entity : scene.getSubtree(self)) {
         scene.get<TransformComponent>(entity)._rotation = rotation * scene.get<TransformComponent>(entity)._rotation;
+        scene.markRenderDirty(entity, DIRTY_TRANSFORM_BIT);
     }
 }
 
@@ -70,6 +75,7 @@ void TransformComponent::scale(Scene& scene, const Entity self, const vec3& scal
 {
     for (const Entity entity : scene.getSubtree(self)) {
         scene.get<TransformComponent>(entity)._scale *= scale;
+        scene.markRenderDirty(entity, DIRTY_TRANSFORM_BIT);
     }
 }
 
@@ -33,6 +33,16 @@ public:
         return _data[dataIndex] & (1U << bitIndex);
     }
 
+    // Sets the 32 flags [32 * wordIndex, 32 * wordIndex + 32) at once, doesn't grow the bitset so distinct words can be written
+    // from different threads
+    inline void setWord(const size_t wordIndex, const uint32 flags)
+    {
+        NH3D_ASSERT(wordIndex < _data.size(), "Out of bound DynamicBitset access");
+        _data[wordIndex] = flags;
+    }
+
+    inline void reserve(const size_t bitCapacity) { ensureCapacity(bitCapacity); }
+
     [[nodiscard]] inline const void* data() const { return reinterpret_cast<const void*>(_data.data()); }
 
 private:
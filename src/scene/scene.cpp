@@ -12,12 +12,14 @@ Scene::Scene(IRHI& rhi)
 {
     _entityMasks.reserve(400'000);
     _availableEntities.reserve(2'000);
+    _renderDirtyFlags.reserve(400'000);
 }
 
 Scene::Scene(IRHI& rhi, const std::filesystem::path& filePath)
 {
     _entityMasks.reserve(400'000);
     _availableEntities.reserve(2'000);
+    _renderDirtyFlags.reserve(400'000);
 
     // TODO: pre-allocate a loading struct with strings for errors & warnings/tinygltf::Model/vectors for mesh data pre-allocated
 }
@@ -33,6 +35,9 @@ void Scene::remove(const Entity entity)
 
     SubtreeView subtree = getSubtree(entity);
     for (const Entity e : subtree) {
+        if (ComponentMasks::checkComponents(_entityMasks[e], _setMap.mask<RenderComponent>())) {
+            markRenderRemoved(e);
+        }
         _setMap.remove(e, _entityMasks[e]);
         _entityMasks[e] = SparseSetMap::InvalidEntityMask;
         _availableEntities.emplace_back(e);
@@ -67,6 +72,7 @@ void Scene::setVisibleFlag(const Entity entity, const bool flag)
 {
     NH3D_ASSERT(isValidEntity(entity), "Attempting to set visible flag of an invalid entity");
     _setMap.setFlag<RenderComponent>(entity, flag);
+    markRenderDirty(entity, DIRTY_RENDER_DATA_BIT);
 }
 
 [[nodiscard]] bool Scene::isVisible(const Entity entity)
@@ -77,4 +83,31 @@ void Scene::setVisibleFlag(const Entity entity, const bool flag)
 
 [[nodiscard]] const void* Scene::getRawVisibleFlags() { return _setMap.getRawFlags<RenderComponent>(); }
 
+[[nodiscard]] const std::vector<Entity>& Scene::getDirtyRenderEntities() const { return _dirtyRenderEntities; }
+
+[[nodiscard]] const std::vector<Entity>& Scene::getRemovedRenderEntities() const { return _removedRenderEntities; }
+
+[[nodiscard]] RenderDirtyFlags Scene::consumeRenderDirtyFlags(const Entity entity)
+{
+    NH3D_ASSERT(entity < _renderDirtyFlags.size(), "Attempting to consume the render changes of a non-existant entity");
+
+    return std::exchange(_renderDirtyFlags[entity], 0);
+}
+
+void Scene::clearRenderChanges()
+{
+    // Flags that weren't consumed are dropped along with the list
+    for (const Entity entity : _dirtyRenderEntities) {
+        _renderDirtyFlags[entity] = 0;
+    }
+    _dirtyRenderEntities.clear();
+    _removedRenderEntities.clear();
+}
+
+void Scene::markRenderRemoved(const Entity entity)
+{
+    _removedRenderEntities.emplace_back(entity);
+    _renderDirtyFlags[entity] = 0;
+}
+
 }
@@ -6,6 +6,7 @@
 #include <scene/ecs/component_view.hpp>
 #include <scene/ecs/components/camera_component.hpp>
 #include <scene/ecs/components/hierarchy_component.hpp>
+#include <scene/ecs/components/transform_component.hpp>
 #include <scene/ecs/entity.hpp>
 #include <scene/ecs/hierarchy_sparse_set.hpp>
 #include <scene/ecs/sparse_set.hpp>
@@ -17,6 +18,15 @@ namespace NH3D {
 
 class IRHI;
 
+// Render related changes of an entity since the renderer last consumed them
+using RenderDirtyFlags = uint8;
+
+enum RenderDirtyFlagBits : uint8 {
+    DIRTY_TRANSFORM_BIT = 1 << 0,
+    // Mesh, material or visibility changed, or the entity just became drawable
+    DIRTY_RENDER_DATA_BIT = 1 << 1,
+};
+
 // TODO: scene cloning for in editor play mode
 class Scene {
     NH3D_NO_COPY_MOVE(Scene)
@@ -59,14 +69,34 @@ public:
 
     [[nodiscard]] const void* getRawVisibleFlags();
 
+    // Has to be called when writing render data through get<T>(), the TransformComponent setters already take care of it
+    inline void markRenderDirty(const Entity entity, const RenderDirtyFlags flags);
+
+    // Entities with pending render changes, may contain entities that aren't drawable anymore
+    [[nodiscard]] const std::vector<Entity>& getDirtyRenderEntities() const;
+
+    // Entities that lost their RenderComponent or TransformComponent, or were removed altogether
+    [[nodiscard]] const std::vector<Entity>& getRemovedRenderEntities() const;
+
+    // Returns the pending changes of the entity and resets them
+    [[nodiscard]] RenderDirtyFlags consumeRenderDirtyFlags(const Entity entity);
+
+    void clearRenderChanges();
+
 private:
     [[nodiscard]] bool isValidEntity(const Entity entity) const;
 
+    void markRenderRemoved(const Entity entity);
+
 private:
     SparseSetMap _setMap;
     std::vector<ComponentMask> _entityMasks;
     std::vector<uint32> _availableEntities;
 
+    std::vector<RenderDirtyFlags> _renderDirtyFlags;
+    std::vector<Entity> _dirtyRenderEntities;
+    std::vector<Entity> _removedRenderEntities;
+
     Entity _mainCamera = InvalidEntity;
 
     HierarchySparseSet _hierarchy;
@@ -95,6 +125,7 @@ template <NotHierarchyComponent... Ts> inline Entity Scene::create(Ts&&... compo
     } else {
         entity = _entityMasks.size();
         _entityMasks.emplace_back(0);
+        _renderDirtyFlags.emplace_back(0);
     }
 
     add(entity, std::forward<Ts>(components)...);
@@ -110,6 +141,11 @@ template <NotHierarchyComponent... Ts> inline void Scene::add(const Entity entit
 
     _entityMasks[entity] |= mask;
 
+    // The entity may have just become drawable, the full render data has to be (re)uploaded
+    if ((mask & _setMap.mask<RenderComponent, TransformComponent>()) != 0) {
+        markRenderDirty(entity, DIRTY_TRANSFORM_BIT | DIRTY_RENDER_DATA_BIT);
+    }
+
     if (ComponentMasks::checkComponents(mask, _setMap.mask<CameraComponent>()) && _mainCamera == InvalidEntity) {
         _mainCamera = entity;
     }
@@ -126,11 +162,25 @@ template <NotHierarchyComponent... Ts> inline void Scene::clearComponents(const
     NH3D_ASSERT(isValidEntity(entity), "Attempting to clear components of an invalid entity");
     NH3D_ASSERT(checkComponents<Ts...>(entity), "Entity mask is missing components to delete");
 
+    if ((_setMap.mask<Ts...>() & _setMap.mask<RenderComponent, TransformComponent>()) != 0 && checkComponents<RenderComponent>(entity)) {
+        markRenderRemoved(entity);
+    }
+
     (_setMap.remove<Ts>(entity), ...);
 
     _entityMasks[entity] ^= _setMap.mask<Ts...>();
 }
 
+inline void Scene::markRenderDirty(const Entity entity, const RenderDirtyFlags flags)
+{
+    NH3D_ASSERT(isValidEntity(entity), "Attempting to mark an invalid entity as dirty");
+
+    if (_renderDirtyFlags[entity] == 0) {
+        _dirtyRenderEntities.emplace_back(entity);
+    }
+    _renderDirtyFlags[entity] |= flags;
+}
+
 template <NotHierarchyComponent LeadType, NotHierarchyComponent... Ts>
 [[nodiscard]] inline ComponentView<true, LeadType, Ts...> Scene::makeView()
 {
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <general/thread_pool.hpp>
+#include <iostream>
+#include <misc/math.hpp>
+#include <random>
+#include <rendering/core/frustum_culler.hpp>
+
+using namespace NH3D;
+
+template <typename Function> static double measure(const uint32 iterations, const Function& function)
+{
+    function(); // warm up
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    for (uint32 i = 0; i < iterations; ++i) {
+        function();
+    }
+    const std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - startTime;
+    return time.count() / iterations;
+}
+
+// Frustum culling of the maximum number of objects of the GPU scene, scalar reference vs AVX2 vs AVX2 on the thread pool
+int main()
+{
+    constexpr uint32 ObjectCount = 640'000;
+    constexpr uint32 Iterations = 20;
+
+    std::mt19937 generator { 42 };
+    std::uniform_real_distribution<float> position { -500.0f, 500.0f };
+    std::uniform_real_distribution<float> unit { -1.0f, 1.0f };
+
+    FrustumCuller culler;
+    culler.resize(ObjectCount);
+    for (uint32 i = 0; i < ObjectCount; ++i) {
+        const mat4 transform = rotate(translate(mat4 { 1.0f }, vec3 { position(generator), position(generator), position(generator) }),
+            glm::pi<float>() * unit(generator), normalize(vec3 { unit(generator), 1.0f, unit(generator) }));
+        culler.setObject(i, transform, AABB { .min = vec3 { -1.0f }, .max = vec3 { 1.0f } });
+    }
+
+    const FrustumPlanes frustum = FrustumPlanes::fromProjection(perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 1000.0f));
+    const mat4 view = lookAt(vec3 { 0.0f }, vec3 { 0.0f, 0.0f, 1.0f }, vec3 { 0.0f, 1.0f, 0.0f });
+    ThreadPool threadPool { ThreadPool::getDefaultWorkerCount() };
+
+    DynamicBitset reference { ObjectCount };
+    DynamicBitset visibility { ObjectCount };
+    const double scalarTime = measure(Iterations, [&] { culler.cullScalar(view, frustum, reference); });
+    const double simdTime = measure(Iterations, [&] { culler.cull(view, frustum, visibility); });
+    const double threadedTime = measure(Iterations, [&] { culler.cull(threadPool, view, frustum, visibility); });
+
+    uint32 visibleCount = 0;
+    uint32 mismatchCount = 0;
+    for (uint32 i = 0; i < ObjectCount; ++i) {
+        visibleCount += reference[i];
+        mismatchCount += reference[i] != visibility[i];
+    }
+
+    std::cout << "FrustumCuller: " << ObjectCount << " objects, " << visibleCount << " visible, " << mismatchCount
+              << " mismatches with the scalar reference" << std::endl;
+    std::cout << "    Scalar: " << scalarTime * 1e3 << " ms" << std::endl;
+    std::cout << "    AVX2: " << simdTime * 1e3 << " ms (x" << scalarTime / simdTime << ")" << std::endl;
+    std::cout << "    AVX2, " << threadPool.getThreadCount() << " threads: " << threadedTime * 1e3 << " ms (x" << scalarTime / threadedTime
+              << ")" << std::endl;
+
+    return mismatchCount == 0 ? 0 : 1;
+}
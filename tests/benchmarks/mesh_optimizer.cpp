@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <rendering/core/mesh_optimizer.hpp>
+
+using namespace NH3D;
+
+static void printStatistics(const char* name, const VertexCacheStatistics& statistics)
+{
+    std::cout << "    " << name << ": ACMR " << statistics.acmr << ", ATVR " << statistics.atvr << std::endl;
+}
+
+// Cache statistics and optimization throughput on a grid whose triangles were shuffled, like a badly exported mesh
+int main()
+{
+    constexpr uint32 GridSize = 255;
+    constexpr uint32 Iterations = 10;
+
+    std::vector<VertexData> vertices;
+    std::vector<uint32> gridIndices;
+    for (uint32 y = 0; y <= GridSize; ++y) {
+        for (uint32 x = 0; x <= GridSize; ++x) {
+            vertices.emplace_back(VertexData { .position = { x, y, 0.0f }, .normal = { 0.0f, 0.0f, 1.0f } });
+        }
+    }
+    for (uint32 y = 0; y < GridSize; ++y) {
+        for (uint32 x = 0; x < GridSize; ++x) {
+            const uint32 v0 = y * (GridSize + 1) + x;
+            const uint32 v1 = v0 + 1;
+            const uint32 v2 = v0 + GridSize + 1;
+            const uint32 v3 = v2 + 1;
+            gridIndices.insert(gridIndices.end(), { v0, v1, v2, v2, v1, v3 });
+        }
+    }
+
+    std::vector<uint32> triangles(gridIndices.size() / 3);
+    std::iota(triangles.begin(), triangles.end(), 0);
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937 { 42 });
+    std::vector<uint32> indices;
+    for (const uint32 triangle : triangles) {
+        indices.insert(indices.end(), gridIndices.begin() + 3 * triangle, gridIndices.begin() + 3 * triangle + 3);
+    }
+
+    std::vector<uint32> optimized;
+    std::vector<uint32> cacheOptimized;
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    for (uint32 i = 0; i < Iterations; ++i) {
+        cacheOptimized = MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+        optimized = MeshOptimizer::optimizeOverdraw(vertices, cacheOptimized);
+    }
+    const std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - startTime;
+
+    const double triangleCount = static_cast<double>(indices.size() / 3) * Iterations;
+    std::cout << "MeshOptimizer: " << indices.size() / 3 << " triangles, " << vertices.size() << " vertices, FIFO cache of "
+              << MeshOptimizer::DefaultCacheSize << std::endl;
+    printStatistics("Row order", MeshOptimizer::analyzeVertexCache(gridIndices, vertices.size()));
+    printStatistics("Shuffled", MeshOptimizer::analyzeVertexCache(indices, vertices.size()));
+    printStatistics("Vertex cache", MeshOptimizer::analyzeVertexCache(cacheOptimized, vertices.size()));
+    printStatistics("Vertex cache + overdraw", MeshOptimizer::analyzeVertexCache(optimized, vertices.size()));
+    std::cout << "    " << time.count() * 1e3 / Iterations << " ms per optimization, " << triangleCount / time.count() * 1e-6
+              << " Mtriangles/s" << std::endl;
+
+    return 0;
+}
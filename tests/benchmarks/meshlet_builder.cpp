@@ -0,0 +1,48 @@
+#include <chrono>
+#include <iostream>
+#include <rendering/core/meshlet.hpp>
+
+using namespace NH3D;
+
+// Build throughput of Meshlet::build on the largest grid addressable with 16 bit indices
+int main()
+{
+    constexpr uint32 GridSize = 255;
+    constexpr uint32 Iterations = 50;
+
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    for (uint32 y = 0; y <= GridSize; ++y) {
+        for (uint32 x = 0; x <= GridSize; ++x) {
+            // Some relief so that the normal cones aren't all identical
+            const float height = 0.1f * ((x * 7 + y * 13) % 5);
+            vertices.emplace_back(VertexData { .position = { x, y, height }, .normal = { 0.0f, 0.0f, 1.0f } });
+        }
+    }
+    for (uint32 y = 0; y < GridSize; ++y) {
+        for (uint32 x = 0; x < GridSize; ++x) {
+            const uint32 v0 = y * (GridSize + 1) + x;
+            const uint32 v1 = v0 + 1;
+            const uint32 v2 = v0 + GridSize + 1;
+            const uint32 v3 = v2 + 1;
+            indices.insert(indices.end(), { v0, v1, v2, v2, v1, v3 });
+        }
+    }
+
+    // Warm up
+    size_t meshletCount = Meshlet::build(vertices, indices).size();
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    for (uint32 i = 0; i < Iterations; ++i) {
+        meshletCount = Meshlet::build(vertices, indices).size();
+    }
+    const std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - startTime;
+
+    const double triangleCount = static_cast<double>(indices.size() / 3) * Iterations;
+    std::cout << "Meshlet::build: " << indices.size() / 3 << " triangles, " << vertices.size() << " vertices, " << meshletCount
+              << " meshlets" << std::endl;
+    std::cout << "    " << time.count() * 1e3 / Iterations << " ms per build, " << triangleCount / time.count() * 1e-6
+              << " Mtriangles/s" << std::endl;
+
+    return 0;
+}
\ No newline at end of file
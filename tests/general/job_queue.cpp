@@ -0,0 +1,94 @@
+#include <atomic>
+#include <chrono>
+#include <general/job_queue.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace NH3D::Test {
+
+TEST(JobQueueTests, RunsEveryJobOnce)
+{
+    JobQueue queue { 3 };
+    EXPECT_EQ(queue.getWorkerCount(), 3);
+
+    std::vector<std::atomic<uint32>> executions(500);
+    for (uint32 i = 0; i < executions.size(); ++i) {
+        queue.submit([&executions, i] { executions[i].fetch_add(1); });
+    }
+    queue.waitForIdle();
+
+    EXPECT_EQ(queue.getPendingCount(), 0);
+    for (const std::atomic<uint32>& count : executions) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+TEST(JobQueueTests, AtLeastOneWorker)
+{
+    JobQueue queue { 0 };
+    EXPECT_EQ(queue.getWorkerCount(), 1);
+
+    std::atomic<bool> done = false;
+    queue.submit([&] { done = true; });
+    queue.waitForIdle();
+    EXPECT_TRUE(done);
+}
+
+TEST(JobQueueTests, SubmitsDontBlock)
+{
+    JobQueue queue { 1 };
+
+    std::atomic<bool> release = false;
+    std::atomic<uint32> completed = 0;
+    queue.submit([&] {
+        while (!release) {
+            std::this_thread::yield();
+        }
+        completed.fetch_add(1);
+    });
+    queue.submit([&] { completed.fetch_add(1); });
+
+    // The single worker is stuck on the first job, both are still pending
+    EXPECT_EQ(queue.getPendingCount(), 2);
+    EXPECT_EQ(completed.load(), 0);
+
+    release = true;
+    queue.waitForIdle();
+    EXPECT_EQ(completed.load(), 2);
+}
+
+TEST(JobQueueTests, JobsSubmittingJobs)
+{
+    JobQueue queue { 2 };
+
+    std::atomic<uint32> completed = 0;
+    queue.submit([&] {
+        queue.submit([&] { completed.fetch_add(1); });
+        completed.fetch_add(1);
+    });
+
+    // The nested job is queued before the first one completes, waitForIdle covers it
+    queue.waitForIdle();
+    EXPECT_EQ(completed.load(), 2);
+}
+
+TEST(JobQueueTests, DropsQueuedJobsOnDestruction)
+{
+    std::atomic<uint32> completed = 0;
+    {
+        JobQueue queue { 1 };
+        queue.submit([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds { 50 });
+            completed.fetch_add(1);
+        });
+        for (uint32 i = 0; i < 10; ++i) {
+            queue.submit([&] { completed.fetch_add(1); });
+        }
+    }
+
+    // At most the job that was running
+    EXPECT_LE(completed.load(), 1);
+}
+
+}
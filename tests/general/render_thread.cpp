@@ -0,0 +1,84 @@
+#include <atomic>
+#include <general/render_thread.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace NH3D::Test {
+
+TEST(RenderThreadTests, RendersEverySnapshotInOrder)
+{
+    std::vector<uint32> renderedLights;
+    {
+        RenderThread renderThread { [&](RenderSnapshot& snapshot) { renderedLights.emplace_back(snapshot.lights.size()); } };
+        for (uint32 i = 0; i < 100; ++i) {
+            RenderSnapshot& snapshot = renderThread.acquireSnapshot();
+            snapshot.lights.resize(i);
+            renderThread.submitSnapshot();
+        }
+        renderThread.waitForIdle();
+    }
+
+    ASSERT_EQ(renderedLights.size(), 100);
+    for (uint32 i = 0; i < 100; ++i) {
+        EXPECT_EQ(renderedLights[i], i);
+    }
+}
+
+TEST(RenderThreadTests, NeverWritesTheSnapshotBeingRendered)
+{
+    std::atomic<RenderSnapshot*> renderedSnapshot = nullptr;
+    std::atomic<bool> overlap = false;
+    RenderThread renderThread { [&](RenderSnapshot& snapshot) {
+        renderedSnapshot = &snapshot;
+        std::this_thread::sleep_for(std::chrono::microseconds { 200 });
+        renderedSnapshot = nullptr;
+    } };
+
+    for (uint32 i = 0; i < 50; ++i) {
+        RenderSnapshot& snapshot = renderThread.acquireSnapshot();
+        if (renderedSnapshot.load() == &snapshot) {
+            overlap = true;
+        }
+        renderThread.submitSnapshot();
+    }
+    renderThread.waitForIdle();
+
+    EXPECT_FALSE(overlap);
+}
+
+TEST(RenderThreadTests, StatsRoundTrip)
+{
+    RenderThread renderThread { [](RenderSnapshot& snapshot) { snapshot.stats.lightCount = snapshot.lights.size(); } };
+
+    RenderSnapshot& first = renderThread.acquireSnapshot();
+    first.lights.resize(3);
+    renderThread.submitSnapshot();
+    RenderSnapshot& second = renderThread.acquireSnapshot();
+    renderThread.submitSnapshot();
+
+    // The first snapshot comes back once the render thread is done with it
+    EXPECT_EQ(&renderThread.acquireSnapshot(), &first);
+    EXPECT_EQ(first.stats.lightCount, 3);
+    EXPECT_NE(&first, &second);
+    renderThread.submitSnapshot();
+}
+
+TEST(RenderThreadTests, StopsWithPendingSnapshots)
+{
+    std::atomic<uint32> renderCount = 0;
+    {
+        RenderThread renderThread { [&](RenderSnapshot&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+            renderCount.fetch_add(1);
+        } };
+        (void)renderThread.acquireSnapshot();
+        renderThread.submitSnapshot();
+        (void)renderThread.acquireSnapshot();
+        renderThread.submitSnapshot();
+    }
+
+    EXPECT_LE(renderCount.load(), 2);
+}
+
+}
@@ -0,0 +1,59 @@
+#include "mock_rhi.hpp"
+#include <general/resource_mapper.hpp>
+#include <gtest/gtest.h>
+
+namespace NH3D::Test {
+
+// Hands out distinct geometry handles so that shared meshes can be told apart
+class GeometryCountingRHI : public MockRHI {
+public:
+    [[nodiscard]] virtual Handle<Geometry> createGeometry(const Geometry::CreateInfo& info) override
+    {
+        lastVertexFormat = info.vertexFormat;
+        return { createdGeometryCount++ };
+    }
+
+    uint32 createdGeometryCount = 0;
+    Geometry::VertexFormat lastVertexFormat = Geometry::VertexFormat::Full;
+};
+
+TEST(ResourceMapperTests, LoadModelDeduplication)
+{
+    GeometryCountingRHI rhi;
+    ResourceMapper resourceMapper;
+
+    MeshData first;
+    ASSERT_TRUE(resourceMapper.loadModel(rhi, NH3D_DIR "src/editor/assets/cube.glb", first));
+    EXPECT_EQ(rhi.createdGeometryCount, 1);
+
+    for (int i = 0; i < 10; ++i) {
+        MeshData other;
+        ASSERT_TRUE(resourceMapper.loadModel(rhi, NH3D_DIR "src/editor/assets/cube.glb", other));
+        EXPECT_EQ(other.mesh.geometry, first.mesh.geometry);
+    }
+    EXPECT_EQ(rhi.createdGeometryCount, 1);
+
+    // Different vertex data, different mesh
+    MeshData swizzled;
+    ASSERT_TRUE(resourceMapper.loadModel(rhi, NH3D_DIR "src/editor/assets/cube.glb", swizzled, { 0, 1, 2 }));
+    EXPECT_NE(swizzled.mesh.geometry, first.mesh.geometry);
+    EXPECT_EQ(rhi.createdGeometryCount, 2);
+}
+
+TEST(ResourceMapperTests, LoadModelQuantization)
+{
+    GeometryCountingRHI rhi;
+    ResourceMapper resourceMapper;
+
+    MeshData quantized;
+    ASSERT_TRUE(resourceMapper.loadModel(rhi, NH3D_DIR "src/editor/assets/cube.glb", quantized));
+    EXPECT_EQ(rhi.lastVertexFormat, Geometry::VertexFormat::Quantized);
+
+    MeshData full;
+    ASSERT_TRUE(resourceMapper.loadModel(rhi, NH3D_DIR "src/editor/assets/cube.glb", full, { 0, 2, 1 }, false));
+    EXPECT_EQ(rhi.lastVertexFormat, Geometry::VertexFormat::Full);
+    EXPECT_NE(full.mesh.geometry, quantized.mesh.geometry);
+    EXPECT_EQ(rhi.createdGeometryCount, 2);
+}
+
+}
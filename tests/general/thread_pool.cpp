@@ -0,0 +1,74 @@
+#include <atomic>
+#include <general/thread_pool.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace NH3D::Test {
+
+TEST(ThreadPoolTests, RunsEveryTaskOnce)
+{
+    ThreadPool pool { 3 };
+    EXPECT_EQ(pool.getThreadCount(), 4);
+
+    std::vector<std::atomic<uint32>> executions(1000);
+    std::atomic<bool> validThreadIds = true;
+    pool.parallelFor(executions.size(), [&](const uint32 taskId, const uint32 threadId) {
+        executions[taskId].fetch_add(1);
+        if (threadId >= pool.getThreadCount()) {
+            validThreadIds = false;
+        }
+    });
+
+    for (const std::atomic<uint32>& count : executions) {
+        EXPECT_EQ(count.load(), 1);
+    }
+    EXPECT_TRUE(validThreadIds);
+}
+
+TEST(ThreadPoolTests, RepeatedDispatches)
+{
+    ThreadPool pool { 2 };
+
+    std::atomic<uint32> sum = 0;
+    for (uint32 i = 0; i < 200; ++i) {
+        pool.parallelFor(i % 7, [&](const uint32 taskId, const uint32) { sum.fetch_add(taskId + 1); });
+    }
+
+    uint32 expected = 0;
+    for (uint32 i = 0; i < 200; ++i) {
+        const uint32 taskCount = i % 7;
+        expected += taskCount * (taskCount + 1) / 2;
+    }
+    EXPECT_EQ(sum.load(), expected);
+}
+
+TEST(ThreadPoolTests, NoWorkers)
+{
+    ThreadPool pool { 0 };
+    EXPECT_EQ(pool.getThreadCount(), 1);
+
+    std::vector<uint32> order;
+    pool.parallelFor(5, [&](const uint32 taskId, const uint32 threadId) {
+        EXPECT_EQ(threadId, 0);
+        order.emplace_back(taskId);
+    });
+
+    EXPECT_EQ(order, (std::vector<uint32> { 0, 1, 2, 3, 4 }));
+}
+
+TEST(ThreadPoolTests, PerThreadResources)
+{
+    ThreadPool pool { 3 };
+
+    // Tasks of a given thread never overlap, so per-thread data needs no synchronization
+    std::vector<uint32> perThreadCounts(pool.getThreadCount(), 0);
+    pool.parallelFor(4096, [&](const uint32, const uint32 threadId) { ++perThreadCounts[threadId]; });
+
+    uint32 total = 0;
+    for (const uint32 count : perThreadCounts) {
+        total += count;
+    }
+    EXPECT_EQ(total, 4096);
+}
+
+} // namespace NH3D::Test
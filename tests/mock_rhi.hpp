@@ -10,7 +10,10 @@ namespace NH3D {
 
 class MockRHI : public IRHI {
 public:
-    MockRHI() = default;
+    MockRHI()
+        : IRHI { DefaultFramesInFlight }
+    {
+    }
 
     [[nodiscard]] virtual Handle<Texture> createTexture(const Texture::CreateInfo&) override { return InvalidHandle<Texture>; }
 
@@ -20,7 +23,15 @@ public:
 
     virtual void destroyBuffer(const Handle<Buffer>) override { }
 
-    virtual void render(Scene&) override { }
+    [[nodiscard]] virtual Handle<Geometry> createGeometry(const Geometry::CreateInfo&) override { return InvalidHandle<Geometry>; }
+
+    virtual void destroyGeometry(const Handle<Geometry>) override { }
+
+    virtual void extract(Scene&, RenderSnapshot&) override { }
+
+    virtual void render(RenderSnapshot&) override { }
+
+    virtual void waitForNextFrame() override { }
 };
 
 }
\ No newline at end of file
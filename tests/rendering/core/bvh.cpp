@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <misc/math.hpp>
+#include <random>
+#include <rendering/core/bvh.hpp>
+
+namespace NH3D::Test {
+
+// 90 degrees square frustum looking down +z
+static FrustumPlanes makeFrustum() { return FrustumPlanes::fromProjection(perspective(glm::radians(90.0f), 1.0f, 0.1f, 1000.0f)); }
+
+// Unit cubes scattered in a 200m box around the origin, the ids skip every other value like the slots of a GPU scene with holes
+static void makeItems(const uint32 count, std::vector<uint32>& ids, std::vector<AABB>& bounds)
+{
+    std::mt19937 generator { 42 };
+    std::uniform_real_distribution<float> position { -100.0f, 100.0f };
+    for (uint32 i = 0; i < count; ++i) {
+        const vec3 center { position(generator), position(generator), position(generator) };
+        ids.emplace_back(2 * i);
+        bounds.emplace_back(AABB { .min = center - 0.5f, .max = center + 0.5f });
+    }
+}
+
+// Ids of the items whose own AABB intersects the frustum
+static std::vector<uint32> bruteForceCull(
+    const std::vector<uint32>& ids, const std::vector<AABB>& bounds, const mat4& view, const FrustumPlanes& frustum)
+{
+    std::vector<uint32> result;
+    for (uint32 i = 0; i < ids.size(); ++i) {
+        if (frustum.intersect(bounds[i].transform(view)) != FrustumPlanes::Intersection::Outside) {
+            result.emplace_back(ids[i]);
+        }
+    }
+    return result;
+}
+
+static bool isSubset(std::vector<uint32> subset, std::vector<uint32> set)
+{
+    std::sort(subset.begin(), subset.end());
+    std::sort(set.begin(), set.end());
+    return std::includes(set.begin(), set.end(), subset.begin(), subset.end());
+}
+
+TEST(BVHTests, Empty)
+{
+    BVH bvh;
+    bvh.build({}, {});
+
+    std::vector<uint32> visible;
+    bvh.cull(mat4 { 1.0f }, makeFrustum(), visible);
+    EXPECT_TRUE(visible.empty());
+    EXPECT_EQ(bvh.getCost(), 0.0f);
+}
+
+TEST(BVHTests, Structure)
+{
+    std::vector<uint32> ids;
+    std::vector<AABB> bounds;
+    makeItems(10'000, ids, bounds);
+
+    BVH bvh;
+    bvh.build(ids, bounds);
+    const std::vector<BVH::Node>& nodes = bvh.getNodes();
+    ASSERT_FALSE(nodes.empty());
+    EXPECT_EQ(nodes[0].itemCount, ids.size());
+
+    for (const BVH::Node& node : nodes) {
+        if (node.firstChild == 0) {
+            EXPECT_LE(node.itemCount, BVH::MaxLeafSize);
+            continue;
+        }
+
+        // The children split the range of their parent and are contained in it
+        const BVH::Node& left = nodes[node.firstChild];
+        const BVH::Node& right = nodes[node.firstChild + 1];
+        EXPECT_EQ(left.firstItem, node.firstItem);
+        EXPECT_EQ(right.firstItem, left.firstItem + left.itemCount);
+        EXPECT_EQ(left.itemCount + right.itemCount, node.itemCount);
+        for (const BVH::Node* child : { &left, &right }) {
+            for (uint32 axis = 0; axis < 3; ++axis) {
+                EXPECT_GE(child->bounds.min[axis], node.bounds.min[axis]);
+                EXPECT_LE(child->bounds.max[axis], node.bounds.max[axis]);
+            }
+        }
+    }
+
+    // A SAH tree over uniformly scattered boxes is far cheaper than testing everything
+    EXPECT_LT(bvh.getCost(), 0.01f * ids.size());
+}
+
+TEST(BVHTests, CullIsConservative)
+{
+    std::vector<uint32> ids;
+    std::vector<AABB> bounds;
+    makeItems(10'000, ids, bounds);
+    const FrustumPlanes frustum = makeFrustum();
+    const mat4 view = rotate(mat4 { 1.0f }, 0.7f, vec3 { 0.0f, 1.0f, 0.0f });
+
+    BVH bvh;
+    bvh.build(ids, bounds);
+    std::vector<uint32> visible;
+    bvh.cull(view, frustum, visible);
+
+    // Every item in the frustum survives, most of the others are skipped
+    const std::vector<uint32> expected = bruteForceCull(ids, bounds, view, frustum);
+    EXPECT_TRUE(isSubset(expected, visible));
+    EXPECT_LT(visible.size(), 2 * expected.size());
+    EXPECT_LT(visible.size(), ids.size() / 2);
+}
+
+TEST(BVHTests, Refit)
+{
+    std::vector<uint32> ids;
+    std::vector<AABB> bounds;
+    makeItems(1'000, ids, bounds);
+    const FrustumPlanes frustum = makeFrustum();
+    const mat4 view { 1.0f };
+
+    BVH bvh;
+    bvh.build(ids, bounds);
+
+    // Everything moves behind the camera but one item which moves right in front of it
+    for (uint32 i = 0; i < ids.size(); ++i) {
+        bounds[i].min.z = -50.0f;
+        bounds[i].max.z = -49.0f;
+        if (i == 123) {
+            bounds[i] = AABB { .min = vec3 { -0.5f, -0.5f, 50.0f }, .max = vec3 { 0.5f, 0.5f, 51.0f } };
+        }
+        bvh.setBounds(ids[i], bounds[i]);
+    }
+    bvh.refit();
+
+    std::vector<uint32> visible;
+    bvh.cull(view, frustum, visible);
+    EXPECT_TRUE(isSubset(bruteForceCull(ids, bounds, view, frustum), visible));
+    EXPECT_NE(std::find(visible.begin(), visible.end(), ids[123]), visible.end());
+    EXPECT_LE(visible.size(), BVH::MaxLeafSize);
+
+    // Shuffling the positions stretches the old clusters of the tree across the whole scene
+    std::mt19937 generator { 7 };
+    std::shuffle(bounds.begin(), bounds.end(), generator);
+    for (uint32 i = 0; i < ids.size(); ++i) {
+        bvh.setBounds(ids[i], bounds[i]);
+    }
+    bvh.refit();
+    EXPECT_GT(bvh.getCost(), 1.5f * bvh.getBuildCost());
+
+    bvh.build(ids, bounds);
+    EXPECT_EQ(bvh.getCost(), bvh.getBuildCost());
+}
+
+}
@@ -0,0 +1,93 @@
+#include <general/thread_pool.hpp>
+#include <gtest/gtest.h>
+#include <misc/math.hpp>
+#include <random>
+#include <rendering/core/frustum_culler.hpp>
+
+namespace NH3D::Test {
+
+// 90 degrees square frustum looking down +z
+static FrustumPlanes makeFrustum() { return FrustumPlanes::fromProjection(perspective(glm::radians(90.0f), 1.0f, 0.1f, 1000.0f)); }
+
+static const AABB UnitAABB { .min = vec3 { -0.5f }, .max = vec3 { 0.5f } };
+
+// Random rotations, scales and positions around the camera, some of them straddle the frustum planes
+static void fillRandomObjects(FrustumCuller& culler, const uint32 objectCount)
+{
+    std::mt19937 generator { 42 };
+    std::uniform_real_distribution<float> position { -100.0f, 100.0f };
+    std::uniform_real_distribution<float> unit { -1.0f, 1.0f };
+    std::uniform_real_distribution<float> size { 0.1f, 10.0f };
+
+    culler.resize(objectCount);
+    for (uint32 i = 0; i < objectCount; ++i) {
+        const vec3 axis { unit(generator), unit(generator), unit(generator) + 2.0f };
+        const vec3 translation { position(generator), position(generator), position(generator) };
+        const mat4 transform = scale(rotate(translate(mat4 { 1.0f }, translation), glm::pi<float>() * unit(generator), normalize(axis)),
+            vec3 { size(generator), size(generator), size(generator) });
+        culler.setObject(i, transform, UnitAABB);
+    }
+}
+
+TEST(FrustumCullerTests, SingleObjects)
+{
+    const FrustumPlanes frustum = makeFrustum();
+    const mat4 view { 1.0f };
+
+    FrustumCuller culler;
+    culler.resize(6);
+    culler.setObject(0, translate(mat4 { 1.0f }, vec3 { 0.0f, 0.0f, 10.0f }), UnitAABB); // in front
+    culler.setObject(1, translate(mat4 { 1.0f }, vec3 { 0.0f, 0.0f, -10.0f }), UnitAABB); // behind
+    culler.setObject(2, translate(mat4 { 1.0f }, vec3 { -20.0f, 0.0f, 10.0f }), UnitAABB); // left
+    culler.setObject(3, translate(mat4 { 1.0f }, vec3 { 20.0f, 0.0f, 10.0f }), UnitAABB); // right
+    culler.setObject(4, translate(mat4 { 1.0f }, vec3 { 0.0f, 20.0f, 10.0f }), UnitAABB); // above
+    culler.setObject(5, translate(mat4 { 1.0f }, vec3 { 10.2f, 0.0f, 10.0f }), UnitAABB); // straddling the right plane
+
+    DynamicBitset visibility { 0 };
+    culler.cull(view, frustum, visibility);
+    EXPECT_TRUE(visibility[0]);
+    EXPECT_FALSE(visibility[1]);
+    EXPECT_FALSE(visibility[2]);
+    EXPECT_FALSE(visibility[3]);
+    EXPECT_FALSE(visibility[4]);
+    EXPECT_TRUE(visibility[5]);
+
+    // Padding objects are never visible
+    for (uint32 i = 6; i < 32; ++i) {
+        EXPECT_FALSE(visibility[i]);
+    }
+
+    // Turning around
+    culler.cull(rotate(mat4 { 1.0f }, glm::pi<float>(), vec3 { 0.0f, 1.0f, 0.0f }), frustum, visibility);
+    EXPECT_FALSE(visibility[0]);
+    EXPECT_TRUE(visibility[1]);
+}
+
+TEST(FrustumCullerTests, MatchesScalarReference)
+{
+    constexpr uint32 ObjectCount = 100'003; // not a multiple of the batch size
+    const FrustumPlanes frustum = makeFrustum();
+    const mat4 view = lookAt(vec3 { 5.0f, 2.0f, -3.0f }, vec3 { 0.0f, 0.0f, 50.0f }, vec3 { 0.0f, 1.0f, 0.0f });
+
+    FrustumCuller culler;
+    fillRandomObjects(culler, ObjectCount);
+
+    DynamicBitset reference { ObjectCount };
+    culler.cullScalar(view, frustum, reference);
+    DynamicBitset simd { ObjectCount };
+    culler.cull(view, frustum, simd);
+    ThreadPool threadPool { 3 };
+    DynamicBitset threaded { ObjectCount };
+    culler.cull(threadPool, view, frustum, threaded);
+
+    uint32 visibleCount = 0;
+    for (uint32 i = 0; i < ObjectCount; ++i) {
+        ASSERT_EQ(simd[i], reference[i]) << "object " << i;
+        ASSERT_EQ(threaded[i], reference[i]) << "object " << i;
+        visibleCount += reference[i];
+    }
+    EXPECT_GT(visibleCount, 0);
+    EXPECT_LT(visibleCount, ObjectCount);
+}
+
+}
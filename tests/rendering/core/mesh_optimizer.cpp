@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <array>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <random>
+#include <rendering/core/mesh_optimizer.hpp>
+
+namespace NH3D::Test {
+
+// Grid of quads in the z = height plane, facing +z
+static void makeGrid(const uint32 size, const float height, std::vector<VertexData>& vertices, std::vector<uint32>& indices)
+{
+    const uint32 firstVertex = vertices.size();
+    for (uint32 y = 0; y <= size; ++y) {
+        for (uint32 x = 0; x <= size; ++x) {
+            vertices.emplace_back(VertexData { .position = { x, y, height }, .normal = { 0.0f, 0.0f, 1.0f } });
+        }
+    }
+
+    for (uint32 y = 0; y < size; ++y) {
+        for (uint32 x = 0; x < size; ++x) {
+            const uint32 v0 = firstVertex + y * (size + 1) + x;
+            const uint32 v1 = v0 + 1;
+            const uint32 v2 = v0 + size + 1;
+            const uint32 v3 = v2 + 1;
+            indices.insert(indices.end(), { v0, v1, v2, v2, v1, v3 });
+        }
+    }
+}
+
+// Same triangles in a random order, like a badly exported mesh
+static std::vector<uint32> shuffleTriangles(const std::vector<uint32>& indices)
+{
+    std::vector<uint32> triangles(indices.size() / 3);
+    std::iota(triangles.begin(), triangles.end(), 0);
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937 { 42 });
+
+    std::vector<uint32> result;
+    for (const uint32 triangle : triangles) {
+        result.insert(result.end(), indices.begin() + 3 * triangle, indices.begin() + 3 * triangle + 3);
+    }
+    return result;
+}
+
+static std::vector<std::array<uint32, 3>> sortedTriangles(const std::vector<uint32>& indices)
+{
+    std::vector<std::array<uint32, 3>> triangles;
+    for (uint32 i = 0; i < indices.size(); i += 3) {
+        triangles.emplace_back(std::array<uint32, 3> { indices[i], indices[i + 1], indices[i + 2] });
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+TEST(MeshOptimizerTests, AnalyzeDisjointTriangles)
+{
+    const std::vector<uint32> indices { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    const VertexCacheStatistics statistics = MeshOptimizer::analyzeVertexCache(indices, 9);
+    EXPECT_EQ(statistics.transformedVertexCount, 9);
+    EXPECT_FLOAT_EQ(statistics.acmr, 3.0f);
+    EXPECT_FLOAT_EQ(statistics.atvr, 1.0f);
+}
+
+TEST(MeshOptimizerTests, AnalyzeCacheEviction)
+{
+    // The second triangle evicts vertex 0 from a 3 entry cache, the third one reloads it
+    const std::vector<uint32> indices { 0, 1, 2, 1, 2, 3, 2, 3, 0 };
+
+    EXPECT_EQ(MeshOptimizer::analyzeVertexCache(indices, 4, 3).transformedVertexCount, 5);
+    EXPECT_EQ(MeshOptimizer::analyzeVertexCache(indices, 4, 4).transformedVertexCount, 4);
+}
+
+TEST(MeshOptimizerTests, VertexCacheShuffledGrid)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> gridIndices;
+    makeGrid(64, 0.0f, vertices, gridIndices);
+    const std::vector<uint32> indices = shuffleTriangles(gridIndices);
+
+    const std::vector<uint32> optimized = MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    EXPECT_EQ(sortedTriangles(optimized), sortedTriangles(indices));
+
+    const VertexCacheStatistics before = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+    const VertexCacheStatistics after = MeshOptimizer::analyzeVertexCache(optimized, vertices.size());
+    EXPECT_GT(before.acmr, 2.5f);
+    EXPECT_LT(after.acmr, 0.8f);
+    EXPECT_LT(after.atvr, 1.5f);
+}
+
+TEST(MeshOptimizerTests, OverdrawOuterLayerFirst)
+{
+    // Two stacked grids facing +z, the bottom one comes first and is entirely hidden by the top one when seen from above
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeGrid(16, 0.0f, vertices, indices);
+    const uint32 bottomVertexCount = vertices.size();
+    makeGrid(16, 1.0f, vertices, indices);
+
+    const std::vector<uint32> cacheOptimized = MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    const std::vector<uint32> optimized = MeshOptimizer::optimizeOverdraw(vertices, cacheOptimized);
+    ASSERT_EQ(sortedTriangles(optimized), sortedTriangles(indices));
+
+    const auto topTriangleCount = std::count_if(optimized.begin(), optimized.begin() + optimized.size() / 2,
+        [bottomVertexCount](const uint32 vertex) { return vertex >= bottomVertexCount; });
+    EXPECT_EQ(topTriangleCount, optimized.size() / 2);
+
+    // Clustering shouldn't cost much cache efficiency
+    const float cacheOptimizedACMR = MeshOptimizer::analyzeVertexCache(cacheOptimized, vertices.size()).acmr;
+    EXPECT_LT(MeshOptimizer::analyzeVertexCache(optimized, vertices.size()).acmr, 1.25f * cacheOptimizedACMR);
+}
+
+TEST(MeshOptimizerTests, VertexFetchFirstUseOrder)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> gridIndices;
+    makeGrid(8, 0.0f, vertices, gridIndices);
+    vertices.emplace_back(VertexData { .position = { -1.0f, -1.0f, -1.0f } }); // unreferenced
+    const std::vector<VertexData> originalVertices = vertices;
+    const std::vector<uint32> originalIndices = shuffleTriangles(gridIndices);
+
+    std::vector<uint32> indices = originalIndices;
+    MeshOptimizer::optimizeVertexFetch(vertices, indices);
+    ASSERT_EQ(indices.size(), originalIndices.size());
+    EXPECT_EQ(vertices.size(), originalVertices.size() - 1);
+
+    uint32 nextVertex = 0;
+    for (uint32 i = 0; i < indices.size(); ++i) {
+        EXPECT_LE(indices[i], nextVertex);
+        nextVertex = std::max(nextVertex, indices[i] + 1);
+        EXPECT_EQ(vertices[indices[i]].position, originalVertices[originalIndices[i]].position);
+    }
+}
+
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <misc/math.hpp>
+#include <rendering/core/mesh_simplifier.hpp>
+
+namespace NH3D::Test {
+
+// Flat grid of quads in the z = 0 plane, facing +z
+static void makeGrid(const uint32 size, std::vector<VertexData>& vertices, std::vector<uint32>& indices)
+{
+    for (uint32 y = 0; y <= size; ++y) {
+        for (uint32 x = 0; x <= size; ++x) {
+            vertices.emplace_back(VertexData { .position = { x, y, 0.0f }, .normal = { 0.0f, 0.0f, 1.0f } });
+        }
+    }
+
+    for (uint32 y = 0; y < size; ++y) {
+        for (uint32 x = 0; x < size; ++x) {
+            const uint32 v0 = y * (size + 1) + x;
+            const uint32 v1 = v0 + 1;
+            const uint32 v2 = v0 + size + 1;
+            const uint32 v3 = v2 + 1;
+            indices.insert(indices.end(), { v0, v1, v2, v2, v1, v3 });
+        }
+    }
+}
+
+// Closed unit UV sphere without duplicated vertices, so nothing is locked
+static void makeSphere(const uint32 rings, const uint32 segments, std::vector<VertexData>& vertices, std::vector<uint32>& indices)
+{
+    vertices.emplace_back(VertexData { .position = { 0.0f, 0.0f, 1.0f }, .normal = { 0.0f, 0.0f, 1.0f } });
+    for (uint32 ring = 1; ring < rings; ++ring) {
+        const float theta = glm::pi<float>() * ring / rings;
+        for (uint32 segment = 0; segment < segments; ++segment) {
+            const float phi = 2.0f * glm::pi<float>() * segment / segments;
+            const vec3 p { std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta) };
+            vertices.emplace_back(VertexData { .position = p, .normal = p });
+        }
+    }
+    vertices.emplace_back(VertexData { .position = { 0.0f, 0.0f, -1.0f }, .normal = { 0.0f, 0.0f, -1.0f } });
+
+    const auto ringVertex = [segments](const uint32 ring, const uint32 segment) -> uint32 {
+        return 1 + (ring - 1) * segments + segment % segments;
+    };
+    const uint32 southPole = vertices.size() - 1;
+    for (uint32 segment = 0; segment < segments; ++segment) {
+        indices.insert(indices.end(), { 0, ringVertex(1, segment), ringVertex(1, segment + 1) });
+        for (uint32 ring = 1; ring + 1 < rings; ++ring) {
+            const uint32 v0 = ringVertex(ring, segment);
+            const uint32 v1 = ringVertex(ring, segment + 1);
+            const uint32 v2 = ringVertex(ring + 1, segment);
+            const uint32 v3 = ringVertex(ring + 1, segment + 1);
+            indices.insert(indices.end(), { v0, v2, v1, v1, v2, v3 });
+        }
+        indices.insert(indices.end(), { ringVertex(rings - 1, segment), southPole, ringVertex(rings - 1, segment + 1) });
+    }
+}
+
+TEST(MeshSimplifierTests, TargetAboveIndexCount)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeGrid(4, vertices, indices);
+
+    float error;
+    EXPECT_EQ(MeshSimplifier::simplify(vertices, indices, indices.size(), error), indices);
+    EXPECT_EQ(error, 0.0f);
+}
+
+TEST(MeshSimplifierTests, FlatGrid)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeGrid(16, vertices, indices);
+
+    float error;
+    const std::vector<uint32> simplified = MeshSimplifier::simplify(vertices, indices, indices.size() / 2, error);
+    EXPECT_LE(simplified.size(), indices.size() / 2);
+    EXPECT_EQ(simplified.size() % 3, 0);
+    EXPECT_NEAR(error, 0.0f, 1e-3f);
+
+    // Only the interior collapses, the outline and the facing of the grid are kept
+    vec3 min { 1e9f }, max { -1e9f };
+    for (uint32 i = 0; i < simplified.size(); i += 3) {
+        const vec3& p0 = vertices[simplified[i]].position;
+        const vec3& p1 = vertices[simplified[i + 1]].position;
+        const vec3& p2 = vertices[simplified[i + 2]].position;
+        EXPECT_GT(cross(p1 - p0, p2 - p0).z, 0.0f);
+        for (const vec3& p : { p0, p1, p2 }) {
+            min = glm::min(min, p);
+            max = glm::max(max, p);
+        }
+    }
+    EXPECT_EQ(min, vec3(0.0f));
+    EXPECT_EQ(max, vec3(16.0f, 16.0f, 0.0f));
+}
+
+TEST(MeshSimplifierTests, SphereError)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeSphere(32, 64, vertices, indices);
+
+    float error;
+    const std::vector<uint32> simplified = MeshSimplifier::simplify(vertices, indices, indices.size() / 4, error);
+    EXPECT_LE(simplified.size(), indices.size() / 4);
+    EXPECT_GT(error, 0.0f);
+    EXPECT_LT(error, 0.1f);
+}
+
+TEST(MeshSimplifierTests, LODChain)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeSphere(32, 64, vertices, indices);
+
+    const std::vector<MeshLOD> lods = MeshSimplifier::buildLODChain(vertices, indices, 5);
+    ASSERT_GT(lods.size(), 2);
+    EXPECT_LE(lods.size(), 5);
+    EXPECT_EQ(lods[0].indices, indices);
+    EXPECT_EQ(lods[0].error, 0.0f);
+    for (uint32 lod = 1; lod < lods.size(); ++lod) {
+        EXPECT_LT(lods[lod].indices.size(), lods[lod - 1].indices.size());
+        EXPECT_GE(lods[lod].error, lods[lod - 1].error);
+    }
+}
+
+TEST(MeshSimplifierTests, LockedMesh)
+{
+    // Every vertex of a single quad is on the border
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeGrid(1, vertices, indices);
+
+    EXPECT_EQ(MeshSimplifier::buildLODChain(vertices, indices, 5).size(), 1);
+}
+
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <misc/math.hpp>
+#include <rendering/core/meshlet.hpp>
+#include <unordered_set>
+
+namespace NH3D::Test {
+
+// Flat grid of quads in the z = 0 plane, facing +z
+static void makeGrid(const uint32 size, std::vector<VertexData>& vertices, std::vector<uint32>& indices)
+{
+    for (uint32 y = 0; y <= size; ++y) {
+        for (uint32 x = 0; x <= size; ++x) {
+            vertices.emplace_back(VertexData { .position = { x, y, 0.0f }, .normal = { 0.0f, 0.0f, 1.0f } });
+        }
+    }
+
+    for (uint32 y = 0; y < size; ++y) {
+        for (uint32 x = 0; x < size; ++x) {
+            const uint32 v0 = y * (size + 1) + x;
+            const uint32 v1 = v0 + 1;
+            const uint32 v2 = v0 + size + 1;
+            const uint32 v3 = v2 + 1;
+            indices.insert(indices.end(), { v0, v1, v2, v2, v1, v3 });
+        }
+    }
+}
+
+TEST(MeshletTests, EmptyMesh)
+{
+    EXPECT_TRUE(Meshlet::build({}, {}).empty());
+}
+
+TEST(MeshletTests, LimitsAndCoverage)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeGrid(64, vertices, indices);
+
+    const std::vector<Meshlet> meshlets = Meshlet::build(vertices, indices);
+    ASSERT_FALSE(meshlets.empty());
+
+    // Contiguous ranges covering the whole index buffer in order
+    uint32 nextIndex = 0;
+    for (const Meshlet& meshlet : meshlets) {
+        EXPECT_EQ(meshlet.firstIndex, nextIndex);
+        EXPECT_GT(meshlet.triangleCount, 0);
+        EXPECT_LE(meshlet.triangleCount, Meshlet::MaxTriangles);
+
+        std::unordered_set<uint32> uniqueVertices;
+        for (uint32 i = meshlet.firstIndex; i < meshlet.firstIndex + 3 * meshlet.triangleCount; ++i) {
+            uniqueVertices.insert(indices[i]);
+        }
+        EXPECT_LE(uniqueVertices.size(), Meshlet::MaxVertices);
+
+        nextIndex += 3 * meshlet.triangleCount;
+    }
+    EXPECT_EQ(nextIndex, indices.size());
+}
+
+TEST(MeshletTests, BoundingSphere)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeGrid(32, vertices, indices);
+
+    for (const Meshlet& meshlet : Meshlet::build(vertices, indices)) {
+        for (uint32 i = meshlet.firstIndex; i < meshlet.firstIndex + 3 * meshlet.triangleCount; ++i) {
+            EXPECT_LE(distance(vertices[indices[i]].position, meshlet.center), meshlet.radius + 1e-4f);
+        }
+    }
+}
+
+TEST(MeshletTests, FlatMeshletCone)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeGrid(4, vertices, indices);
+
+    const std::vector<Meshlet> meshlets = Meshlet::build(vertices, indices);
+    ASSERT_EQ(meshlets.size(), 1);
+
+    const Meshlet& meshlet = meshlets[0];
+    EXPECT_NEAR(meshlet.coneAxis.z, 1.0f, 1e-5f);
+    EXPECT_NEAR(meshlet.coneCutoff, 0.0f, 1e-5f);
+
+    // Only the front side of the plane is visible
+    EXPECT_FALSE(meshlet.isBackfacing(vec3 { 2.0f, 2.0f, 10.0f }));
+    EXPECT_TRUE(meshlet.isBackfacing(vec3 { 2.0f, 2.0f, -10.0f }));
+    // Close enough to the plane to see it at a grazing angle
+    EXPECT_FALSE(meshlet.isBackfacing(vec3 { 20.0f, 2.0f, -0.5f }));
+}
+
+TEST(MeshletTests, ClosedMeshletConeNeverCulls)
+{
+    // Tetrahedron, the normals span the whole sphere
+    const std::vector<VertexData> vertices = {
+        { .position = { 0.0f, 0.0f, 0.0f } },
+        { .position = { 1.0f, 0.0f, 0.0f } },
+        { .position = { 0.0f, 1.0f, 0.0f } },
+        { .position = { 0.0f, 0.0f, 1.0f } },
+    };
+    const std::vector<uint32> indices = { 0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3 };
+
+    const std::vector<Meshlet> meshlets = Meshlet::build(vertices, indices);
+    ASSERT_EQ(meshlets.size(), 1);
+    EXPECT_EQ(meshlets[0].coneCutoff, 1.0f);
+
+    const vec3 eyes[] = { { 10.0f, 0.0f, 0.0f }, { -10.0f, 0.0f, 0.0f }, { 0.0f, 10.0f, 0.0f }, { 0.0f, 0.0f, -10.0f } };
+    for (const vec3& eye : eyes) {
+        EXPECT_FALSE(meshlets[0].isBackfacing(eye));
+    }
+}
+
+TEST(MeshletTests, DegenerateTriangles)
+{
+    std::vector<VertexData> vertices;
+    std::vector<uint32> indices;
+    makeGrid(2, vertices, indices);
+    indices.insert(indices.end(), { 0, 0, 0, 1, 1, 2 });
+
+    const std::vector<Meshlet> meshlets = Meshlet::build(vertices, indices);
+    ASSERT_EQ(meshlets.size(), 1);
+    EXPECT_EQ(meshlets[0].triangleCount, indices.size() / 3);
+    EXPECT_NEAR(meshlets[0].coneAxis.z, 1.0f, 1e-5f);
+}
+
+}
\ No newline at end of file
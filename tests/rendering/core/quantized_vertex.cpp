@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <misc/math.hpp>
+#include <rendering/core/quantized_vertex.hpp>
+
+namespace NH3D::Test {
+
+TEST(QuantizedVertexTests, Size)
+{
+    EXPECT_EQ(2 * sizeof(QuantizedVertexData), sizeof(VertexData));
+}
+
+TEST(QuantizedVertexTests, RoundTrip)
+{
+    const AABB bounds { .min = { -2.0f, 0.0f, 10.0f }, .max = { 2.0f, 8.0f, 11.0f } };
+
+    std::vector<VertexData> vertices;
+    for (uint32 i = 0; i < 1000; ++i) {
+        const float t = i / 999.0f;
+        const vec3 direction { std::cos(40.0f * t) * std::sin(3.0f * t), std::sin(40.0f * t) * std::sin(3.0f * t), std::cos(3.0f * t) };
+        vertices.emplace_back(VertexData {
+            .position = bounds.min + vec3 { t, 1.0f - t, t * t } * (bounds.max - bounds.min),
+            .normal = direction,
+            .uv = { t, 2.0f * t - 1.0f },
+        });
+    }
+
+    const std::vector<QuantizedVertexData> quantizedVertices = QuantizedVertexData::quantize(vertices, bounds);
+    ASSERT_EQ(quantizedVertices.size(), vertices.size());
+
+    for (uint32 i = 0; i < vertices.size(); ++i) {
+        const VertexData decoded = quantizedVertices[i].decode(bounds);
+
+        // Half a step of 16 bit unorm over the extent of each axis
+        const vec3 positionError = abs(decoded.position - vertices[i].position);
+        EXPECT_LE(positionError.x, 4.0f / 65535.0f);
+        EXPECT_LE(positionError.y, 8.0f / 65535.0f);
+        EXPECT_LE(positionError.z, 1.0f / 65535.0f);
+
+        EXPECT_GT(dot(decoded.normal, normalize(vertices[i].normal)), 0.99999f);
+        EXPECT_NEAR(decoded.uv.x, vertices[i].uv.x, 1e-3f);
+        EXPECT_NEAR(decoded.uv.y, vertices[i].uv.y, 1e-3f);
+    }
+}
+
+TEST(QuantizedVertexTests, FlatBounds)
+{
+    // Planar meshes have a zero extent on one axis
+    const AABB bounds { .min = { 0.0f, 0.0f, 1.0f }, .max = { 1.0f, 1.0f, 1.0f } };
+    const VertexData vertex { .position = { 0.5f, 0.25f, 1.0f }, .normal = { 0.0f, 0.0f, -1.0f }, .uv = { 0.0f, 0.0f } };
+
+    const VertexData decoded = QuantizedVertexData::quantize(vertex, bounds)[0].decode(bounds);
+    EXPECT_NEAR(decoded.position.x, 0.5f, 1e-4f);
+    EXPECT_NEAR(decoded.position.y, 0.25f, 1e-4f);
+    EXPECT_EQ(decoded.position.z, 1.0f);
+    EXPECT_GT(dot(decoded.normal, vertex.normal), 0.99999f);
+}
+
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <rendering/core/range_allocator.hpp>
+
+namespace NH3D::Test {
+
+TEST(RangeAllocatorTests, AllocateUntilFull)
+{
+    RangeAllocator allocator { 100 };
+
+    EXPECT_EQ(allocator.allocate(40), 0);
+    EXPECT_EQ(allocator.allocate(40), 40);
+    EXPECT_EQ(allocator.allocate(40), RangeAllocator::InvalidOffset);
+    EXPECT_EQ(allocator.allocate(20), 80);
+    EXPECT_EQ(allocator.getFreeSize(), 0);
+    EXPECT_EQ(allocator.allocate(1), RangeAllocator::InvalidOffset);
+}
+
+TEST(RangeAllocatorTests, FreeMergesNeighbours)
+{
+    RangeAllocator allocator { 100 };
+
+    const uint32 a = allocator.allocate(25);
+    const uint32 b = allocator.allocate(25);
+    const uint32 c = allocator.allocate(25);
+    const uint32 d = allocator.allocate(25);
+
+    allocator.free(a);
+    allocator.free(c);
+    EXPECT_EQ(allocator.getFreeSize(), 50);
+    EXPECT_EQ(allocator.getLargestFreeRange(), 25);
+
+    // Merges with both a and c
+    allocator.free(b);
+    EXPECT_EQ(allocator.getLargestFreeRange(), 75);
+    EXPECT_EQ(allocator.allocate(75), 0);
+
+    allocator.free(0);
+    allocator.free(d);
+    EXPECT_EQ(allocator.getLargestFreeRange(), 100);
+    EXPECT_EQ(allocator.getAllocationCount(), 0);
+}
+
+TEST(RangeAllocatorTests, FirstFitReusesHoles)
+{
+    RangeAllocator allocator { 100 };
+
+    const uint32 a = allocator.allocate(10);
+    (void)allocator.allocate(10);
+    allocator.free(a);
+
+    EXPECT_EQ(allocator.allocate(5), 0);
+    EXPECT_EQ(allocator.allocate(5), 5);
+    EXPECT_EQ(allocator.allocate(5), 20);
+}
+
+TEST(RangeAllocatorTests, Compaction)
+{
+    RangeAllocator allocator { 100 };
+
+    const uint32 a = allocator.allocate(20);
+    const uint32 b = allocator.allocate(30);
+    const uint32 c = allocator.allocate(20);
+    const uint32 d = allocator.allocate(30);
+    allocator.free(a);
+    allocator.free(c);
+
+    // 40 free units but split in two holes
+    EXPECT_EQ(allocator.allocate(40), RangeAllocator::InvalidOffset);
+
+    const std::vector<RangeAllocator::Move> moves = allocator.compact();
+    ASSERT_EQ(moves.size(), 2);
+    EXPECT_EQ(moves[0].oldOffset, b);
+    EXPECT_EQ(moves[0].newOffset, 0);
+    EXPECT_EQ(moves[0].size, 30);
+    EXPECT_EQ(moves[1].oldOffset, d);
+    EXPECT_EQ(moves[1].newOffset, 30);
+    EXPECT_EQ(moves[1].size, 30);
+
+    EXPECT_EQ(allocator.getLargestFreeRange(), 40);
+    EXPECT_EQ(allocator.allocate(40), 60);
+
+    // The moved ranges are tracked at their new offsets
+    allocator.free(0);
+    allocator.free(30);
+    allocator.free(60);
+    EXPECT_EQ(allocator.getFreeSize(), 100);
+    EXPECT_TRUE(allocator.compact().empty());
+}
+
+}
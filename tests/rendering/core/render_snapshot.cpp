@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <mock_rhi.hpp>
+#include <rendering/core/render_snapshot.hpp>
+#include <scene/ecs/components/render_component.hpp>
+#include <scene/scene.hpp>
+
+namespace NH3D::Test {
+
+TEST(RenderSnapshotTests, NoCameraKeepsTheChanges)
+{
+    MockRHI rhi;
+    Scene scene { rhi };
+    const Entity entity = scene.create(RenderComponent { Mesh {}, Material {} }, TransformComponent {});
+
+    RenderSnapshot snapshot;
+    snapshot.extract(scene);
+    EXPECT_FALSE(snapshot.hasCamera);
+    EXPECT_TRUE(snapshot.objectChanges.empty());
+    EXPECT_EQ(scene.getDirtyRenderEntities().size(), 1);
+
+    scene.create(CameraComponent {}, TransformComponent { vec3 { 1.0f, 2.0f, 3.0f } });
+    snapshot.extract(scene);
+    EXPECT_TRUE(snapshot.hasCamera);
+    EXPECT_EQ(snapshot.cameraTransform.position(), (vec3 { 1.0f, 2.0f, 3.0f }));
+    ASSERT_EQ(snapshot.objectChanges.size(), 1);
+    EXPECT_EQ(snapshot.objectChanges[0].entity, entity);
+}
+
+TEST(RenderSnapshotTests, ConsumesTheChanges)
+{
+    MockRHI rhi;
+    Scene scene { rhi };
+    scene.create(CameraComponent {}, TransformComponent {});
+    const Entity entity = scene.create(RenderComponent { Mesh {}, Material {} }, TransformComponent {});
+    const Entity removed = scene.create(RenderComponent { Mesh {}, Material {} }, TransformComponent {});
+    scene.create(TransformComponent {}); // not drawable
+
+    RenderSnapshot snapshot;
+    snapshot.extract(scene);
+    ASSERT_EQ(snapshot.objectChanges.size(), 2);
+    EXPECT_EQ(snapshot.objectChanges[0].flags, DIRTY_TRANSFORM_BIT | DIRTY_RENDER_DATA_BIT);
+    EXPECT_TRUE(scene.getDirtyRenderEntities().empty());
+
+    // Only what changed since the previous extraction
+    scene.get<TransformComponent>(entity).setPosition(scene, entity, vec3 { 4.0f });
+    scene.remove(removed);
+    snapshot.extract(scene);
+    ASSERT_EQ(snapshot.objectChanges.size(), 1);
+    EXPECT_EQ(snapshot.objectChanges[0].entity, entity);
+    EXPECT_EQ(snapshot.objectChanges[0].flags, DIRTY_TRANSFORM_BIT);
+    EXPECT_EQ(snapshot.objectChanges[0].transform.position(), vec3 { 4.0f });
+    ASSERT_EQ(snapshot.removedEntities.size(), 1);
+    EXPECT_EQ(snapshot.removedEntities[0], removed);
+
+    snapshot.extract(scene);
+    EXPECT_TRUE(snapshot.objectChanges.empty());
+    EXPECT_TRUE(snapshot.removedEntities.empty());
+}
+
+TEST(RenderSnapshotTests, CopiesTheLights)
+{
+    MockRHI rhi;
+    Scene scene { rhi };
+    scene.create(CameraComponent {}, TransformComponent {});
+    scene.create(LightComponent { .intensity = 2.0f }, TransformComponent { vec3 { 1.0f } });
+    scene.create(LightComponent {}); // not positioned
+
+    RenderSnapshot snapshot;
+    snapshot.extract(scene);
+    ASSERT_EQ(snapshot.lights.size(), 1);
+    EXPECT_EQ(snapshot.lights[0].light.intensity, 2.0f);
+    EXPECT_EQ(snapshot.lights[0].transform.position(), vec3 { 1.0f });
+
+    // Copied again every time, not only when they change
+    snapshot.extract(scene);
+    EXPECT_EQ(snapshot.lights.size(), 1);
+}
+
+}
@@ -142,4 +142,28 @@ TEST(ResourceManagerTests, StoreReusesReleasedSlot)
     EXPECT_EQ(resourceManager.get<BufferHotType>(second).hotValue, "B");
 }
 
+TEST(ResourceManagerTests, ReserveThenAssign)
+{
+    ResourceManager<VulkanBuffer> resourceManager { 100, 10 };
+    MockRHI rhi;
+
+    const Handle<Buffer> reserved = resourceManager.reserve();
+    const Handle<Buffer> created = resourceManager.create(rhi, { { "A", true }, { 1 } });
+    EXPECT_NE(reserved.index, created.index);
+    EXPECT_EQ(resourceManager.get<BufferHotType>(reserved).hotValue, "");
+
+    resourceManager.assign(reserved, { "B", true }, { 2 });
+    EXPECT_EQ(resourceManager.get<BufferHotType>(reserved).hotValue, "B");
+    EXPECT_EQ(resourceManager.get<BufferColdType>(reserved).coldValue, 2);
+    EXPECT_EQ(resourceManager.get<BufferHotType>(created).hotValue, "A");
+
+    // Released slots are reserved again with default data
+    resourceManager.release(rhi, reserved);
+    const Handle<Buffer> reused = resourceManager.reserve();
+    EXPECT_EQ(reused.index, reserved.index);
+    EXPECT_EQ(resourceManager.get<BufferColdType>(reused).coldValue, 0);
+
+    EXPECT_DEATH(resourceManager.assign({ 4 }, { "C", true }, { 3 }), ".*FATAL.*");
+}
+
 }
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <rendering/core/ring_allocator.hpp>
+
+namespace NH3D::Test {
+
+TEST(RingAllocatorTests, AllocateUntilFull)
+{
+    RingAllocator allocator { 100 };
+
+    EXPECT_EQ(allocator.allocate(40, 1, 1), 0);
+    EXPECT_EQ(allocator.allocate(40, 1, 1), 40);
+    EXPECT_EQ(allocator.allocate(40, 1, 2), RingAllocator::InvalidOffset);
+    EXPECT_EQ(allocator.allocate(20, 1, 2), 80);
+    EXPECT_EQ(allocator.allocate(1, 1, 2), RingAllocator::InvalidOffset);
+    EXPECT_EQ(allocator.getAllocationCount(), 3);
+    EXPECT_EQ(allocator.getOldestRetireValue(), 1);
+}
+
+TEST(RingAllocatorTests, ReclaimsInOrder)
+{
+    RingAllocator allocator { 100 };
+
+    (void)allocator.allocate(30, 1, 1);
+    (void)allocator.allocate(30, 1, 2);
+    (void)allocator.allocate(30, 1, 3);
+
+    allocator.reclaim(0);
+    EXPECT_EQ(allocator.getAllocationCount(), 3);
+
+    allocator.reclaim(2);
+    EXPECT_EQ(allocator.getAllocationCount(), 1);
+    EXPECT_EQ(allocator.getOldestRetireValue(), 3);
+
+    // Everything reclaimed, starts over from the beginning
+    allocator.reclaim(3);
+    EXPECT_EQ(allocator.getAllocationCount(), 0);
+    EXPECT_EQ(allocator.getOldestRetireValue(), 0);
+    EXPECT_EQ(allocator.allocate(100, 1, 4), 0);
+}
+
+TEST(RingAllocatorTests, WrapsAround)
+{
+    RingAllocator allocator { 100 };
+
+    (void)allocator.allocate(40, 1, 1);
+    (void)allocator.allocate(40, 1, 2);
+    allocator.reclaim(1);
+
+    // 20 free at the end and 40 at the beginning, doesn't fit at the end
+    EXPECT_EQ(allocator.allocate(30, 1, 3), 0);
+    EXPECT_EQ(allocator.allocate(10, 1, 3), 30);
+    EXPECT_EQ(allocator.allocate(1, 1, 3), RingAllocator::InvalidOffset);
+
+    // The padding left at the end goes with the allocation before it
+    allocator.reclaim(2);
+    EXPECT_EQ(allocator.allocate(60, 1, 4), 40);
+}
+
+TEST(RingAllocatorTests, AlignsOffsets)
+{
+    RingAllocator allocator { 100 };
+
+    EXPECT_EQ(allocator.allocate(5, 16, 1), 0);
+    EXPECT_EQ(allocator.allocate(5, 16, 1), 16);
+    EXPECT_EQ(allocator.allocate(5, 4, 1), 24);
+
+    // Aligned past the end, wraps around if the beginning is free
+    (void)allocator.allocate(71, 1, 1);
+    EXPECT_EQ(allocator.allocate(1, 16, 2), RingAllocator::InvalidOffset);
+    allocator.reclaim(1);
+    (void)allocator.allocate(90, 1, 2);
+    (void)allocator.allocate(3, 1, 3);
+    allocator.reclaim(2);
+    EXPECT_EQ(allocator.allocate(8, 16, 4), 0);
+}
+
+TEST(RingAllocatorTests, OversizedAllocation)
+{
+    RingAllocator allocator { 100 };
+
+    EXPECT_EQ(allocator.allocate(101, 1, 1), RingAllocator::InvalidOffset);
+    EXPECT_EQ(allocator.getAllocationCount(), 0);
+}
+
+}
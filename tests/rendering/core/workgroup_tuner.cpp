@@ -0,0 +1,132 @@
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <rendering/core/workgroup_tuner.hpp>
+
+namespace NH3D::Test {
+
+class WorkgroupTunerTests : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        _path = std::filesystem::temp_directory_path()
+            / ("nh3d_workgroup_tuner_test_" + std::string { ::testing::UnitTest::GetInstance()->current_test_info()->name() } + ".txt");
+        std::filesystem::remove(_path);
+    }
+
+    void TearDown() override { std::filesystem::remove(_path); }
+
+    // Runs one candidate worth of frames, the pass time depends on the candidate in use
+    static void timeCandidate(WorkgroupTuner& tuner, const uint32 kernelId, const std::string& passName, const float* candidateTimes)
+    {
+        for (uint32 i = 0; i < WorkgroupTuner::DiscardedFrameCount + WorkgroupTuner::TimedFrameCount; ++i) {
+            tuner.recordPassTimings({ { .name = passName, .time = candidateTimes[tuner.getSelectedCandidate(kernelId)] } });
+        }
+    }
+
+    std::filesystem::path _path;
+};
+
+TEST_F(WorkgroupTunerTests, DefaultsToTheFirstCandidate)
+{
+    WorkgroupTuner tuner { _path, 1 };
+    const vec3u candidates[] = { { 64, 1, 1 }, { 128, 1, 1 } };
+    const uint32 kernelId = tuner.addKernel("Culling", candidates);
+
+    EXPECT_EQ(tuner.getCandidateCount(kernelId), 2);
+    EXPECT_EQ(tuner.getSelectedCandidate(kernelId), 0);
+    EXPECT_EQ(tuner.getWorkgroupSize(kernelId), vec3u(64, 1, 1));
+    EXPECT_FALSE(tuner.isTuning());
+}
+
+TEST_F(WorkgroupTunerTests, PicksTheFastestCandidate)
+{
+    WorkgroupTuner tuner { _path, 1 };
+    const vec3u candidates[] = { { 8, 8, 1 }, { 16, 8, 1 }, { 16, 16, 1 } };
+    const uint32 kernelId = tuner.addKernel("Shading", candidates);
+    const float candidateTimes[] = { 2.0f, 1.0f, 3.0f };
+
+    tuner.startTuning();
+    EXPECT_TRUE(tuner.isTuning());
+    for (uint32 candidateId = 0; candidateId < 3; ++candidateId) {
+        EXPECT_EQ(tuner.getSelectedCandidate(kernelId), candidateId);
+        timeCandidate(tuner, kernelId, "Shading", candidateTimes);
+    }
+
+    EXPECT_FALSE(tuner.isTuning());
+    EXPECT_EQ(tuner.getWorkgroupSize(kernelId), vec3u(16, 8, 1));
+}
+
+TEST_F(WorkgroupTunerTests, IgnoresOtherPasses)
+{
+    WorkgroupTuner tuner { _path, 1 };
+    const vec3u candidates[] = { { 64, 1, 1 }, { 128, 1, 1 } };
+    const uint32 kernelId = tuner.addKernel("Culling", candidates);
+    const float candidateTimes[] = { 1.0f, 1.0f };
+
+    tuner.startTuning();
+    timeCandidate(tuner, kernelId, "Shading", candidateTimes);
+    EXPECT_TRUE(tuner.isTuning());
+    EXPECT_EQ(tuner.getSelectedCandidate(kernelId), 0);
+}
+
+TEST_F(WorkgroupTunerTests, DiscardsTheFirstFrames)
+{
+    WorkgroupTuner tuner { _path, 1 };
+    const vec3u candidates[] = { { 64, 1, 1 }, { 128, 1, 1 } };
+    const uint32 kernelId = tuner.addKernel("Culling", candidates);
+
+    // The second candidate is slower overall but the first one is slow on its discarded frames
+    tuner.startTuning();
+    for (uint32 i = 0; i < WorkgroupTuner::DiscardedFrameCount + WorkgroupTuner::TimedFrameCount; ++i) {
+        tuner.recordPassTimings({ { .name = "Culling", .time = i < WorkgroupTuner::DiscardedFrameCount ? 100.0f : 1.0f } });
+    }
+    for (uint32 i = 0; i < WorkgroupTuner::DiscardedFrameCount + WorkgroupTuner::TimedFrameCount; ++i) {
+        tuner.recordPassTimings({ { .name = "Culling", .time = 2.0f } });
+    }
+
+    EXPECT_FALSE(tuner.isTuning());
+    EXPECT_EQ(tuner.getSelectedCandidate(kernelId), 0);
+}
+
+TEST_F(WorkgroupTunerTests, StopKeepsThePreviousWinners)
+{
+    WorkgroupTuner tuner { _path, 1 };
+    const vec3u candidates[] = { { 64, 1, 1 }, { 128, 1, 1 } };
+    const uint32 kernelId = tuner.addKernel("Culling", candidates);
+    const float candidateTimes[] = { 2.0f, 1.0f };
+
+    tuner.startTuning();
+    timeCandidate(tuner, kernelId, "Culling", candidateTimes);
+    EXPECT_EQ(tuner.getSelectedCandidate(kernelId), 1);
+
+    tuner.stopTuning();
+    EXPECT_FALSE(tuner.isTuning());
+    EXPECT_EQ(tuner.getSelectedCandidate(kernelId), 0);
+}
+
+TEST_F(WorkgroupTunerTests, PersistsTheWinners)
+{
+    const vec3u candidates[] = { { 64, 1, 1 }, { 128, 1, 1 } };
+    const float candidateTimes[] = { 2.0f, 1.0f };
+    {
+        WorkgroupTuner tuner { _path, 1 };
+        const uint32 kernelId = tuner.addKernel("Culling", candidates);
+        tuner.startTuning();
+        timeCandidate(tuner, kernelId, "Culling", candidateTimes);
+        timeCandidate(tuner, kernelId, "Culling", candidateTimes);
+        EXPECT_FALSE(tuner.isTuning());
+    }
+
+    WorkgroupTuner tuner { _path, 1 };
+    EXPECT_EQ(tuner.getWorkgroupSize(tuner.addKernel("Culling", candidates)), vec3u(128, 1, 1));
+
+    // Not a candidate anymore
+    const vec3u otherCandidates[] = { { 32, 1, 1 }, { 64, 1, 1 } };
+    EXPECT_EQ(tuner.getWorkgroupSize(tuner.addKernel("Culling", otherCandidates)), vec3u(32, 1, 1));
+
+    // Tuned for another driver
+    WorkgroupTuner otherVersionTuner { _path, 2 };
+    EXPECT_EQ(otherVersionTuner.getWorkgroupSize(otherVersionTuner.addKernel("Culling", candidates)), vec3u(64, 1, 1));
+}
+
+}
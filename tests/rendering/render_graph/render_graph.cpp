@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include <rendering/render_graph/render_graph.hpp>
+
+namespace NH3D::Test {
+
+static const RenderGraph::RecordFunction EmptyPass = [](VkCommandBuffer, const RenderGraph&, const uint32) { };
+
+static constexpr RenderGraph::TransientTextureInfo ColorRTInfo { .format = VK_FORMAT_R8G8B8A8_UNORM, .extent = { 64, 64 } };
+
+TEST(RenderGraphTests, CullingTest)
+{
+    RenderGraph graph { IRHI::DefaultFramesInFlight };
+    const RGTexture output = graph.importTexture("Output", { .finalAccess = RGAccess::Present });
+    const RGTexture used = graph.createTexture("Used", ColorRTInfo);
+    const RGTexture unused = graph.createTexture("Unused", ColorRTInfo);
+
+    const RenderGraph::TextureAccess writeUsed[] = { { used, RGAccess::ColorAttachmentWrite } };
+    graph.addPass({ .name = "WriteUsed", .textures = writeUsed, .record = EmptyPass });
+
+    const RenderGraph::TextureAccess writeUnused[] = { { unused, RGAccess::ColorAttachmentWrite } };
+    graph.addPass({ .name = "WriteUnused", .textures = writeUnused, .record = EmptyPass });
+
+    graph.addPass({ .name = "SideEffects", .record = EmptyPass, .sideEffects = true });
+
+    const RenderGraph::TextureAccess copy[] = { { used, RGAccess::TransferRead }, { output, RGAccess::TransferWrite } };
+    graph.addPass({ .name = "Copy", .textures = copy, .record = EmptyPass });
+
+    graph.compile();
+
+    ASSERT_EQ(graph.getCompiledPassCount(), 3);
+    EXPECT_EQ(graph.getPassName(0), "WriteUsed");
+    EXPECT_EQ(graph.getPassName(1), "SideEffects");
+    EXPECT_EQ(graph.getPassName(2), "Copy");
+
+    // The culled pass doesn't extend the texture lifetimes nor allocate anything
+    ASSERT_EQ(graph.getTransientTextures().size(), 1);
+    EXPECT_EQ(graph.getTransientTextures()[0].texture.id, used.id);
+    EXPECT_EQ(graph.getTransientTextures()[0].usage, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+}
+
+TEST(RenderGraphTests, OverwrittenResourceTest)
+{
+    RenderGraph graph { IRHI::DefaultFramesInFlight };
+    const RGBuffer output = graph.importBuffer("Output", { .finalAccess = RGAccess::ComputeStorageRead });
+
+    const RenderGraph::BufferAccess write[] = { { output, RGAccess::ComputeStorageWrite } };
+    graph.addPass({ .name = "Overwritten", .buffers = write, .record = EmptyPass });
+    graph.addPass({ .name = "Final", .buffers = write, .record = EmptyPass });
+
+    graph.compile();
+
+    ASSERT_EQ(graph.getCompiledPassCount(), 1);
+    EXPECT_EQ(graph.getPassName(0), "Final");
+}
+
+TEST(RenderGraphTests, BarrierMergingTest)
+{
+    RenderGraph graph { IRHI::DefaultFramesInFlight };
+    const RGBuffer output = graph.importBuffer("Output", { .finalAccess = RGAccess::ComputeStorageRead });
+    const RGBuffer draws = graph.importBuffer("Draws", {});
+
+    const RenderGraph::BufferAccess write[] = { { draws, RGAccess::ComputeStorageWrite } };
+    graph.addPass({ .name = "Write", .buffers = write, .record = EmptyPass });
+
+    const RenderGraph::BufferAccess indirectRead[] = { { draws, RGAccess::IndirectRead }, { output, RGAccess::ComputeStorageWrite } };
+    graph.addPass({ .name = "IndirectRead", .buffers = indirectRead, .record = EmptyPass });
+
+    const RenderGraph::BufferAccess vertexRead[] = {
+        { draws, RGAccess::VertexStorageRead },
+        { output, RGAccess::ComputeStorageReadWrite },
+    };
+    graph.addPass({ .name = "VertexRead", .buffers = vertexRead, .record = EmptyPass });
+
+    graph.compile();
+    ASSERT_EQ(graph.getCompiledPassCount(), 3);
+
+    // Nothing happened before the first write
+    EXPECT_TRUE(graph.getPassBarriers(0).empty());
+
+    // Both reads are covered by the barrier of the first one
+    const std::vector<RenderGraph::Barrier>& readBarriers = graph.getPassBarriers(1);
+    const auto drawsBarrier = std::find_if(
+        readBarriers.begin(), readBarriers.end(), [&](const RenderGraph::Barrier& barrier) { return barrier.resource == draws.id; });
+    ASSERT_NE(drawsBarrier, readBarriers.end());
+    EXPECT_EQ(drawsBarrier->srcStage, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+    EXPECT_EQ(drawsBarrier->srcAccess, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+    EXPECT_EQ(drawsBarrier->dstStage, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT);
+    EXPECT_EQ(drawsBarrier->dstAccess, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+
+    // Only the output read after write remains
+    ASSERT_EQ(graph.getPassBarriers(2).size(), 1);
+    EXPECT_EQ(graph.getPassBarriers(2)[0].resource, output.id);
+}
+
+TEST(RenderGraphTests, LayoutTransitionTest)
+{
+    RenderGraph graph { IRHI::DefaultFramesInFlight };
+    const RGTexture swapchain = graph.importTexture("Swapchain", { .finalAccess = RGAccess::Present });
+    const RGTexture rt = graph.createTexture("RT", ColorRTInfo);
+
+    const RenderGraph::TextureAccess draw[] = { { rt, RGAccess::ColorAttachmentWrite } };
+    graph.addPass({ .name = "Draw", .textures = draw, .record = EmptyPass });
+
+    const RenderGraph::TextureAccess blit[] = { { rt, RGAccess::TransferRead }, { swapchain, RGAccess::TransferWrite } };
+    graph.addPass({ .name = "Blit", .textures = blit, .record = EmptyPass });
+
+    const RenderGraph::TextureAccess ui[] = { { swapchain, RGAccess::ColorAttachmentReadWrite } };
+    graph.addPass({ .name = "UI", .textures = ui, .record = EmptyPass });
+
+    graph.compile();
+    ASSERT_EQ(graph.getCompiledPassCount(), 3);
+
+    ASSERT_EQ(graph.getPassBarriers(0).size(), 1);
+    EXPECT_EQ(graph.getPassBarriers(0)[0].oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+    EXPECT_EQ(graph.getPassBarriers(0)[0].newLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+    // Write-only access, the previous content is discarded
+    ASSERT_EQ(graph.getPassBarriers(1).size(), 2);
+    for (const RenderGraph::Barrier& barrier : graph.getPassBarriers(1)) {
+        if (barrier.resource == rt.id) {
+            EXPECT_EQ(barrier.oldLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+            EXPECT_EQ(barrier.newLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        } else {
+            EXPECT_EQ(barrier.oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+            EXPECT_EQ(barrier.newLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        }
+    }
+
+    // Read-write access, the blit result is preserved
+    ASSERT_EQ(graph.getPassBarriers(2).size(), 1);
+    EXPECT_EQ(graph.getPassBarriers(2)[0].oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    EXPECT_EQ(graph.getPassBarriers(2)[0].srcAccess, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    ASSERT_EQ(graph.getPassFinalBarriers(2).size(), 1);
+    EXPECT_EQ(graph.getPassFinalBarriers(2)[0].oldLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    EXPECT_EQ(graph.getPassFinalBarriers(2)[0].newLayout, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    EXPECT_EQ(graph.getPassFinalBarriers(2)[0].srcAccess, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+}
+
+TEST(RenderGraphTests, ReadWriteAttachmentTest)
+{
+    RenderGraph graph { IRHI::DefaultFramesInFlight };
+    const RGBuffer stats = graph.importBuffer("Stats", { .finalAccess = RGAccess::HostRead });
+    const RGTexture depth = graph.createTexture("Depth", { .format = VK_FORMAT_D32_SFLOAT, .extent = { 64, 64 } });
+    const RGTexture pyramid = graph.createTexture("Pyramid", { .format = VK_FORMAT_R32_SFLOAT, .extent = { 64, 64 }, .mipLevels = 7 });
+
+    const RenderGraph::TextureAccess earlyDraw[] = { { depth, RGAccess::DepthAttachmentWrite } };
+    graph.addPass({ .name = "EarlyDraw", .textures = earlyDraw, .record = EmptyPass });
+
+    const RenderGraph::TextureAccess downsample[] = { { depth, RGAccess::ComputeSampledRead }, { pyramid, RGAccess::ComputeStorageWrite } };
+    graph.addPass({ .name = "Downsample", .textures = downsample, .record = EmptyPass });
+
+    const RenderGraph::TextureAccess lateDraw[] = {
+        { depth, RGAccess::DepthAttachmentReadWrite },
+        { pyramid, RGAccess::FragmentSampledRead },
+    };
+    const RenderGraph::BufferAccess lateDrawStats[] = { { stats, RGAccess::ComputeStorageWrite } };
+    graph.addPass({ .name = "LateDraw", .textures = lateDraw, .buffers = lateDrawStats, .record = EmptyPass });
+
+    graph.compile();
+
+    // The early draw is only needed because the late one keeps the depth content
+    ASSERT_EQ(graph.getCompiledPassCount(), 3);
+
+    ASSERT_EQ(graph.getPassBarriers(2).size(), 2);
+    for (const RenderGraph::Barrier& barrier : graph.getPassBarriers(2)) {
+        if (barrier.isTexture && barrier.resource == depth.id) {
+            EXPECT_EQ(barrier.oldLayout, VK_IMAGE_LAYOUT_GENERAL);
+            EXPECT_EQ(barrier.newLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+            EXPECT_EQ(barrier.srcStage, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+        }
+    }
+
+    // Results read back on the CPU once the graphics timeline value of the frame retired
+    ASSERT_EQ(graph.getPassFinalBarriers(2).size(), 1);
+    EXPECT_EQ(graph.getPassFinalBarriers(2)[0].dstStage, VK_PIPELINE_STAGE_2_HOST_BIT);
+    EXPECT_EQ(graph.getPassFinalBarriers(2)[0].dstAccess, VK_ACCESS_2_HOST_READ_BIT);
+}
+
+TEST(RenderGraphTests, AliasingTest)
+{
+    RenderGraph graph { IRHI::DefaultFramesInFlight };
+    const RGBuffer output = graph.importBuffer("Output", { .finalAccess = RGAccess::ComputeStorageRead });
+    const RGTexture a = graph.createTexture("A", ColorRTInfo);
+    const RGTexture b = graph.createTexture("B", ColorRTInfo);
+    const RGTexture c = graph.createTexture("C", ColorRTInfo);
+
+    const RenderGraph::TextureAccess pass0[] = { { a, RGAccess::ColorAttachmentWrite } };
+    graph.addPass({ .name = "0", .textures = pass0, .record = EmptyPass });
+
+    const RenderGraph::TextureAccess pass1[] = { { a, RGAccess::ComputeSampledRead }, { b, RGAccess::ComputeStorageWrite } };
+    graph.addPass({ .name = "1", .textures = pass1, .record = EmptyPass });
+
+    const RenderGraph::TextureAccess pass2[] = { { b, RGAccess::ComputeSampledRead }, { c, RGAccess::ComputeStorageWrite } };
+    graph.addPass({ .name = "2", .textures = pass2, .record = EmptyPass });
+
+    const RenderGraph::TextureAccess pass3[] = { { c, RGAccess::ComputeSampledRead } };
+    const RenderGraph::BufferAccess pass3Output[] = { { output, RGAccess::ComputeStorageWrite } };
+    graph.addPass({ .name = "3", .textures = pass3, .buffers = pass3Output, .record = EmptyPass });
+
+    graph.compile();
+    ASSERT_EQ(graph.getCompiledPassCount(), 4);
+
+    // A is dead when C is first written, B overlaps with both
+    EXPECT_EQ(graph.getAliasingGroupCount(), 2);
+    const std::vector<RenderGraph::TransientTexture>& transients = graph.getTransientTextures();
+    ASSERT_EQ(transients.size(), 3);
+    const auto groupOf = [&](const RGTexture texture) {
+        return std::find_if(transients.begin(), transients.end(), [&](const auto& transient) { return transient.texture.id == texture.id; })
+            ->aliasingGroup;
+    };
+    EXPECT_EQ(groupOf(a), groupOf(c));
+    EXPECT_NE(groupOf(a), groupOf(b));
+
+    // The first use of C waits for the last read of A
+    const std::vector<RenderGraph::Barrier>& barriers = graph.getPassBarriers(2);
+    const auto cBarrier
+        = std::find_if(barriers.begin(), barriers.end(), [&](const RenderGraph::Barrier& barrier) { return barrier.resource == c.id; });
+    ASSERT_NE(cBarrier, barriers.end());
+    EXPECT_EQ(cBarrier->srcStage, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+    EXPECT_EQ(cBarrier->oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+    EXPECT_EQ(cBarrier->newLayout, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+TEST(RenderGraphTests, InvalidUsageTest)
+{
+    RenderGraph graph { IRHI::DefaultFramesInFlight };
+    const RGTexture rt = graph.createTexture("RT", ColorRTInfo);
+
+    // A texture can't be in two layouts in the same pass
+    const RenderGraph::TextureAccess conflicting[] = { { rt, RGAccess::ColorAttachmentWrite }, { rt, RGAccess::TransferRead } };
+    EXPECT_DEATH(graph.addPass({ .name = "Conflicting", .textures = conflicting, .record = EmptyPass }), ".*FATAL.*");
+
+    EXPECT_DEATH(graph.addPass({ .name = "NoRecord" }), ".*FATAL.*");
+
+    graph.compile();
+    EXPECT_DEATH((void)graph.createTexture("Late", ColorRTInfo), ".*FATAL.*");
+}
+
+}
@@ -58,3 +58,17 @@ TEST(DynamicBitset, DataPointerIsNotNullForNonEmptyBitset)
     EXPECT_NE(raw, nullptr);
     EXPECT_EQ(*reinterpret_cast<const uint32*>(raw), 1U << 3);
 }
+
+TEST(DynamicBitset, SetWord)
+{
+    DynamicBitset bits { 32 };
+    bits.reserve(64);
+
+    bits.setWord(1, 0x80000001U);
+    EXPECT_FALSE(bits[31]);
+    EXPECT_TRUE(bits[32]);
+    EXPECT_FALSE(bits[33]);
+    EXPECT_TRUE(bits[63]);
+
+    EXPECT_DEATH(bits.setWord(2, 1U), ".*FATAL.*");
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include <mock_rhi.hpp>
+#include <algorithm>
+#include <scene/ecs/components/render_component.hpp>
+#include <scene/ecs/components/transform_component.hpp>
 #include <scene/ecs/entity.hpp>
 #include <scene/scene.hpp>
 
@@ -179,4 +182,64 @@ TEST(SceneTests, GetSetMainCamera)
     EXPECT_EQ(scene.getMainCamera(), e1);
 }
 
-} // namespace NH3D::Test
\ No newline at end of file
+TEST(SceneTests, RenderChangeTracking)
+{
+    MockRHI rhi;
+    Scene scene { rhi };
+
+    const Entity e1 = scene.create(TransformComponent {}, RenderComponent { Mesh {}, Material {} });
+    const Entity e2 = scene.create(TransformComponent {}, RenderComponent { Mesh {}, Material {} });
+    const Entity e3 = scene.create(1);
+
+    const std::vector<Entity>& dirty = scene.getDirtyRenderEntities();
+    EXPECT_EQ(dirty.size(), 2);
+    EXPECT_EQ(scene.consumeRenderDirtyFlags(e1), DIRTY_TRANSFORM_BIT | DIRTY_RENDER_DATA_BIT);
+    EXPECT_EQ(scene.consumeRenderDirtyFlags(e1), 0);
+    EXPECT_EQ(scene.consumeRenderDirtyFlags(e3), 0);
+
+    scene.clearRenderChanges();
+    EXPECT_TRUE(scene.getDirtyRenderEntities().empty());
+    EXPECT_EQ(scene.consumeRenderDirtyFlags(e2), 0);
+
+    scene.get<TransformComponent>(e2).translate(scene, e2, vec3 { 1.0f });
+    scene.get<TransformComponent>(e2).setScale(scene, e2, vec3 { 2.0f });
+    EXPECT_EQ(dirty.size(), 1);
+    EXPECT_EQ(scene.consumeRenderDirtyFlags(e2), DIRTY_TRANSFORM_BIT);
+
+    scene.setVisibleFlag(e1, false);
+    EXPECT_EQ(scene.consumeRenderDirtyFlags(e1), DIRTY_RENDER_DATA_BIT);
+    scene.clearRenderChanges();
+
+    EXPECT_DEATH(scene.markRenderDirty(e3 + 1, DIRTY_TRANSFORM_BIT), ".*FATAL.*");
+}
+
+TEST(SceneTests, RenderRemovalTracking)
+{
+    MockRHI rhi;
+    Scene scene { rhi };
+
+    const Entity e1 = scene.create(TransformComponent {}, RenderComponent { Mesh {}, Material {} });
+    const Entity e2 = scene.create(TransformComponent {}, RenderComponent { Mesh {}, Material {} });
+    const Entity e3 = scene.create(TransformComponent {});
+    scene.clearRenderChanges();
+
+    scene.clearComponents<TransformComponent>(e1);
+    scene.remove(e2);
+    scene.remove(e3);
+
+    const std::vector<Entity>& removed = scene.getRemovedRenderEntities();
+    EXPECT_EQ(removed.size(), 2);
+    EXPECT_NE(std::find(removed.begin(), removed.end(), e1), removed.end());
+    EXPECT_NE(std::find(removed.begin(), removed.end(), e2), removed.end());
+
+    // Pending changes of removed entities are dropped
+    EXPECT_EQ(scene.consumeRenderDirtyFlags(e2), 0);
+
+    scene.add(e1, TransformComponent {});
+    EXPECT_EQ(scene.consumeRenderDirtyFlags(e1), DIRTY_TRANSFORM_BIT | DIRTY_RENDER_DATA_BIT);
+
+    scene.clearRenderChanges();
+    EXPECT_TRUE(scene.getRemovedRenderEntities().empty());
+}
+
+} // namespace NH3D::Test